@@ -29,6 +29,13 @@ pg_logging.c
 pg_client.c
 pg_statement.c
 pg_query_cache.c
+pg_id_block.c
+pg_invalidation.c
+pg_row_cache.c
+pg_mem.c
+pg_bias_lock.c
+pg_utf8.c
+pg_hex.c
 "
 
 # Compile each source file with musl-compatible flags
@@ -54,6 +61,8 @@ gcc -shared -fPIC -fno-stack-protector -mno-outline-atomics -nodefaultlibs \
     src/sql_tr_types.o src/sql_tr_quotes.o src/sql_tr_keywords.o \
     src/sql_tr_upsert.o src/pg_config.o src/pg_logging.o \
     src/pg_client.o src/pg_statement.o src/pg_query_cache.o \
+    src/pg_id_block.o src/pg_invalidation.o src/pg_row_cache.o src/pg_mem.o src/pg_bias_lock.o \
+    src/pg_utf8.o src/pg_hex.o \
     -Wl,-rpath,/usr/local/lib/plex-postgresql \
     -Wl,-rpath,/usr/lib/plexmediaserver/lib \
     -L/usr/local/lib/plex-postgresql -l:libpq.so.5 \
@@ -46,8 +46,6 @@
 
 #define WORKER_STACK_SIZE (8 * 1024 * 1024)  // 8MB stack for worker
 #define WORKER_DELEGATION_THRESHOLD 400000   // 400KB - delegate early!
-#define MAX_FAKE_VALUES 256
-#define PG_FAKE_VALUE_MAGIC 0x50475641  // "PGVA"
 
 // ============================================================================
 // Shared Types
@@ -76,13 +74,6 @@ typedef struct {
     int work_done;
 } worker_request_t;
 
-typedef struct {
-    uint32_t magic;      // Magic number to identify our fake values
-    void *pg_stmt;       // Pointer to pg_stmt_t
-    int col_idx;         // Column index
-    int row_idx;         // Row index at time of column_value call
-} pg_fake_value_t;
-
 // ============================================================================
 // Shared Global State (extern declarations)
 // ============================================================================
@@ -168,11 +159,6 @@ extern pthread_cond_t worker_cond_response;
 extern worker_request_t worker_request;
 extern volatile int worker_running;
 
-// Fake value pool
-extern pg_fake_value_t fake_value_pool[MAX_FAKE_VALUES];
-extern unsigned int fake_value_next;
-extern pthread_mutex_t fake_value_mutex;
-
 // Initialization flag
 extern int shim_initialized;
 
@@ -203,9 +189,6 @@ extern const char * volatile last_column_being_accessed;
 extern volatile long global_value_type_calls;
 extern volatile long global_column_type_calls;
 
-// Check if a pointer is one of our fake values
-pg_fake_value_t* pg_check_fake_value(sqlite3_value *pVal);
-
 // Check if path is library.db
 int is_library_db_path(const char *path);
 
@@ -266,6 +249,15 @@ int pg_map_param_index(pg_stmt_t *pg_stmt, sqlite3_stmt *pStmt, int sqlite_idx);
 int contains_binary_bytes(const unsigned char *data, size_t len);
 char* bytes_to_pg_hex(const unsigned char *data, size_t len);
 
+// Binary parameter transfer (int8/float8/bytea sent with paramFormats=1)
+// Resolve server-side $N types for a prepared statement (process-wide cache,
+// PQdescribePrepared on first use; prepared_name NULL = describe through the
+// unnamed statement, conn NULL = cache only). Caller must hold conn->mutex.
+void pg_resolve_param_types(pg_stmt_t *pg_stmt, PGconn *conn, const char *prepared_name);
+// Fill values[] plus pg_stmt->param_lengths/param_formats for one execution.
+// Returns the paramTypes array to pass to PQexecParams (NULL if unknown).
+const Oid* pg_build_exec_params(pg_stmt_t *pg_stmt, const char **values);
+
 EXPORT int my_sqlite3_bind_int(sqlite3_stmt *pStmt, int idx, int val);
 EXPORT int my_sqlite3_bind_int64(sqlite3_stmt *pStmt, int idx, sqlite3_int64 val);
 EXPORT int my_sqlite3_bind_double(sqlite3_stmt *pStmt, int idx, double val);
@@ -6,6 +6,7 @@
  */
 
 #include "db_interpose.h"
+#include "pg_hex.h"
 
 // ============================================================================
 // RACE_DEBUG Macro
@@ -99,17 +100,317 @@ char* bytes_to_pg_hex(const unsigned char *data, size_t len) {
 
     hex[0] = '\\';
     hex[1] = 'x';
-
-    static const char hex_chars[] = "0123456789abcdef";
-    for (size_t i = 0; i < len; i++) {
-        hex[2 + i*2] = hex_chars[(data[i] >> 4) & 0x0F];
-        hex[2 + i*2 + 1] = hex_chars[data[i] & 0x0F];
-    }
+    pg_hex_encode(hex + 2, data, len);  // SIMD for multi-megabyte blobs
     hex[hex_len - 1] = '\0';
 
     return hex;
 }
 
+// ============================================================================
+// Binary Parameter Transfer
+// ============================================================================
+
+// int/int64/double/blob binds keep their native value (param_types/param_native)
+// and are sent with paramFormats=1 when the server resolved a matching $N type:
+// network-order int8/int4/int2/float8/float4, raw bytes for bytea.
+// Everything else - including params that rely on PG inferring a type from an
+// untyped literal (int bound against a TEXT column, etc.) - still goes as text,
+// so server-side semantics are unchanged.
+
+// Server-resolved parameter types live on the shared statement template
+// (pg_statement.c), so one PQdescribePrepared per SQL covers every connection
+// and statement handle. Paths without a named prepared statement (reads go
+// through PQexecParams) pass prepared_name NULL with a connection: the SQL is
+// then parsed into the unnamed statement and described in one pipelined
+// round trip (two without libpq pipelining); the following PQexecParams
+// replaces the unnamed statement anyway. Both parse with the same
+// (unspecified) param types, so the describe fails only where the execution
+// would.
+//
+// Only a parse/type error pins the statement text-only. Connection errors,
+// timeouts, lock waits and missing relations (DDL in flight) are retried on
+// later executions, up to PG_PARAM_DESCRIBE_TRIES times.
+
+// 1 if the SQL itself can't be described - asking again won't help
+static int describe_error_is_permanent(const PGresult *res) {
+    const char *state = res ? PQresultErrorField(res, PG_DIAG_SQLSTATE) : NULL;
+    if (!state || strncmp(state, "42", 2) != 0) return 0;  // Not a syntax/type error
+    return strcmp(state, "42P01") != 0 &&   // undefined_table
+           strcmp(state, "42703") != 0 &&   // undefined_column
+           strcmp(state, "42704") != 0;     // undefined_object
+}
+
+static void describe_failed(pg_stmt_t *pg_stmt, const PGresult *res, PGconn *conn, const char *what) {
+    const char *state = res ? PQresultErrorField(res, PG_DIAG_SQLSTATE) : NULL;
+    if (describe_error_is_permanent(res) || ++pg_stmt->param_describe_failures >= PG_PARAM_DESCRIBE_TRIES) {
+        pg_stmt->param_server_types_known = -1;  // Stays text-only
+    }
+    LOG_DEBUG("PARAM_TYPES: %s failed (sqlstate=%s, %s): %s", what, state ? state : "none",
+              pg_stmt->param_server_types_known < 0 ? "text-only" : "will retry", PQerrorMessage(conn));
+}
+
+// Parse pg_sql into the unnamed statement and describe it. Returns the
+// describe result, or NULL with *err set to the failing result (caller
+// clears both).
+static PGresult* prepare_and_describe_unnamed(pg_stmt_t *pg_stmt, PGconn *conn, PGresult **err) {
+    int n = pg_stmt->param_count;
+    *err = NULL;
+#ifdef LIBPQ_HAS_PIPELINING
+    if (PQpipelineStatus(conn) == PQ_PIPELINE_OFF && PQenterPipelineMode(conn)) {
+        PGresult *prep = NULL, *desc = NULL;
+        int sent = PQsendPrepare(conn, "", pg_stmt->pg_sql, n, NULL) &&
+                   PQsendDescribePrepared(conn, "") &&
+                   PQpipelineSync(conn);
+        // Results: prepare, NULL, describe (PIPELINE_ABORTED if the prepare
+        // failed), NULL, PIPELINE_SYNC
+        while (sent) {
+            PGresult *r = PQgetResult(conn);
+            if (!r) {
+                if (PQstatus(conn) != CONNECTION_OK) break;
+                continue;
+            }
+            if (PQresultStatus(r) == PGRES_PIPELINE_SYNC) {
+                PQclear(r);
+                break;
+            }
+            if (!prep) prep = r;
+            else if (!desc) desc = r;
+            else PQclear(r);
+        }
+        PQexitPipelineMode(conn);
+
+        if (prep && PQresultStatus(prep) == PGRES_COMMAND_OK && desc) {
+            PQclear(prep);
+            return desc;
+        }
+        PQclear(desc);
+        *err = prep;
+        return NULL;
+    }
+#endif
+    PGresult *prep = PQprepare(conn, "", pg_stmt->pg_sql, n, NULL);
+    if (PQresultStatus(prep) != PGRES_COMMAND_OK) {
+        *err = prep;
+        return NULL;
+    }
+    PQclear(prep);
+    return PQdescribePrepared(conn, "");
+}
+
+void pg_resolve_param_types(pg_stmt_t *pg_stmt, PGconn *conn, const char *prepared_name) {
+    if (!pg_stmt || pg_stmt->param_server_types_known) return;
+
+    int n = pg_stmt->param_count;
+    if (n <= 0 || n > pg_stmt->param_cap || pg_stmt->sql_hash == 0) return;
+
+    // Only worth a describe round trip if something is actually bound natively
+    int has_native = 0;
+    for (int i = 0; i < n; i++) {
+        if (pg_stmt->param_types[i] && pg_stmt->param_values[i]) {
+            has_native = 1;
+            break;
+        }
+    }
+    if (!has_native) return;
+
+    if (pg_template_param_types(pg_stmt->sql_hash, n, pg_stmt->param_server_types)) {
+        pg_stmt->param_server_types_known = 1;
+        return;
+    }
+    if (!conn) return;
+
+    PGresult *desc;
+    if (!prepared_name) {
+        if (!pg_stmt->pg_sql) return;
+        PGresult *err = NULL;
+        desc = prepare_and_describe_unnamed(pg_stmt, conn, &err);
+        if (!desc) {
+            describe_failed(pg_stmt, err, conn, "unnamed prepare");
+            PQclear(err);
+            return;
+        }
+        prepared_name = "";
+    } else {
+        desc = PQdescribePrepared(conn, prepared_name);
+    }
+
+    if (PQresultStatus(desc) == PGRES_COMMAND_OK && PQnparams(desc) == n) {
+        for (int i = 0; i < n; i++) {
+            pg_stmt->param_server_types[i] = PQparamtype(desc, i);
+        }
+        pg_template_store_description(pg_stmt->sql_hash, desc);
+        pg_stmt->param_server_types_known = 1;
+        LOG_DEBUG("PARAM_TYPES: resolved %d param types for %s", n, prepared_name);
+    } else if (PQresultStatus(desc) == PGRES_COMMAND_OK) {
+        // Server disagrees on the param count - never usable
+        LOG_DEBUG("PARAM_TYPES: %s has %d params, expected %d", prepared_name, PQnparams(desc), n);
+        pg_stmt->param_server_types_known = -1;
+    } else {
+        describe_failed(pg_stmt, desc, conn, "describe");
+    }
+    PQclear(desc);
+}
+
+static inline void put_be16(char *dst, uint16_t v) {
+    dst[0] = (char)(v >> 8);
+    dst[1] = (char)v;
+}
+
+static inline void put_be32(char *dst, uint32_t v) {
+    dst[0] = (char)(v >> 24);
+    dst[1] = (char)(v >> 16);
+    dst[2] = (char)(v >> 8);
+    dst[3] = (char)v;
+}
+
+static inline void put_be64(char *dst, uint64_t v) {
+    put_be32(dst, (uint32_t)(v >> 32));
+    put_be32(dst + 4, (uint32_t)v);
+}
+
+// Encode one native param for the server-side type. Returns wire length, 0 = send as text.
+static int encode_binary_param(pg_stmt_t *pg_stmt, int i, Oid server_type) {
+    char *wire = pg_stmt->param_wire[i];
+    pg_param_native_t v = pg_stmt->param_native[i];
+
+    if (pg_stmt->param_types[i] == PG_OID_INT8) {
+        switch (server_type) {
+            case PG_OID_INT8:
+                put_be64(wire, (uint64_t)v.i);
+                return 8;
+            case PG_OID_INT4:
+                if (v.i < INT32_MIN || v.i > INT32_MAX) return 0;  // Let PG raise the range error
+                put_be32(wire, (uint32_t)(int32_t)v.i);
+                return 4;
+            case PG_OID_INT2:
+                if (v.i < INT16_MIN || v.i > INT16_MAX) return 0;
+                put_be16(wire, (uint16_t)(int16_t)v.i);
+                return 2;
+            case PG_OID_FLOAT8: {
+                double d = (double)v.i;
+                uint64_t bits;
+                memcpy(&bits, &d, sizeof(bits));
+                put_be64(wire, bits);
+                return 8;
+            }
+            default:
+                return 0;
+        }
+    }
+
+    if (pg_stmt->param_types[i] == PG_OID_FLOAT8) {
+        if (server_type == PG_OID_FLOAT8) {
+            uint64_t bits;
+            memcpy(&bits, &v.d, sizeof(bits));
+            put_be64(wire, bits);
+            return 8;
+        }
+        if (server_type == PG_OID_FLOAT4) {
+            float f = (float)v.d;
+            uint32_t bits;
+            memcpy(&bits, &f, sizeof(bits));
+            put_be32(wire, bits);
+            return 4;
+        }
+    }
+    return 0;
+}
+
+const Oid* pg_build_exec_params(pg_stmt_t *pg_stmt, const char **values) {
+    int n = pg_stmt->param_count;
+    if (n < 0) n = 0;
+    if (n > pg_stmt->param_cap) n = pg_stmt->param_cap;
+
+    int typed = (pg_stmt->param_server_types_known == 1);
+
+    for (int i = 0; i < n; i++) {
+        values[i] = pg_stmt->param_values[i];
+        pg_stmt->param_formats[i] = 0;
+
+        Oid bound = pg_stmt->param_types[i];
+        if (!values[i] || !bound) {
+            pg_stmt->param_lengths[i] = 0;
+            continue;
+        }
+        Oid server_type = typed ? pg_stmt->param_server_types[i] : 0;
+
+        if (bound == PG_OID_BYTEA) {
+            if (server_type == PG_OID_BYTEA) {
+                // Raw bytes, param_lengths[i] was set at bind time
+                pg_stmt->param_formats[i] = 1;
+                continue;
+            }
+            // Server wants something else (or types unknown): fall back to the
+            // \x hex text form once and keep it for later executions
+            char *hex = bytes_to_pg_hex((const unsigned char *)pg_stmt->param_values[i],
+                                        (size_t)pg_stmt->param_lengths[i]);
+            free(pg_stmt->param_values[i]);
+            pg_stmt->param_values[i] = hex;
+            pg_stmt->param_types[i] = 0;
+            pg_stmt->param_lengths[i] = 0;
+            values[i] = hex;
+            continue;
+        }
+
+        int len = encode_binary_param(pg_stmt, i, server_type);
+        if (len > 0) {
+            values[i] = pg_stmt->param_wire[i];
+            pg_stmt->param_lengths[i] = len;
+            pg_stmt->param_formats[i] = 1;
+        } else {
+            pg_stmt->param_lengths[i] = 0;  // Text form in param_buffers
+        }
+    }
+
+    return typed ? pg_stmt->param_server_types : NULL;
+}
+
+// Drop the current value of a parameter slot (and its binary type tag)
+static inline void release_param_value(pg_stmt_t *pg_stmt, int pg_idx) {
+    if (pg_stmt->param_values[pg_idx] && !is_preallocated_buffer(pg_stmt, pg_idx)) {
+        free(pg_stmt->param_values[pg_idx]);
+    }
+    pg_stmt->param_values[pg_idx] = NULL;  // Prevent dangling pointer
+    pg_stmt->param_types[pg_idx] = 0;
+    pg_stmt->param_lengths[pg_idx] = 0;
+    pg_stmt->param_formats[pg_idx] = 0;
+}
+
+// Native int binding. The text form is still kept in param_buffers: it is the
+// fallback wire format and what logging / query cache keys / expanded_sql read.
+static inline void set_param_int64(pg_stmt_t *pg_stmt, int pg_idx, sqlite3_int64 val) {
+    release_param_value(pg_stmt, pg_idx);
+    snprintf(pg_stmt->param_buffers[pg_idx], 32, "%lld", val);
+    pg_stmt->param_values[pg_idx] = pg_stmt->param_buffers[pg_idx];
+    pg_stmt->param_native[pg_idx].i = val;
+    pg_stmt->param_types[pg_idx] = PG_OID_INT8;
+}
+
+static inline void set_param_double(pg_stmt_t *pg_stmt, int pg_idx, double val) {
+    release_param_value(pg_stmt, pg_idx);
+    snprintf(pg_stmt->param_buffers[pg_idx], 32, "%.17g", val);
+    pg_stmt->param_values[pg_idx] = pg_stmt->param_buffers[pg_idx];
+    pg_stmt->param_native[pg_idx].d = val;
+    pg_stmt->param_types[pg_idx] = PG_OID_FLOAT8;
+}
+
+// Native blob binding: raw copy, hex-encoded only if it ends up sent as text
+static inline void set_param_blob(pg_stmt_t *pg_stmt, int pg_idx, const void *val, size_t len) {
+    release_param_value(pg_stmt, pg_idx);
+    if (len > INT32_MAX) {
+        // libpq lengths are int - keep the old hex text path for huge values
+        pg_stmt->param_values[pg_idx] = bytes_to_pg_hex((const unsigned char *)val, len);
+        return;
+    }
+    char *copy = malloc(len + 1);  // NUL keeps stray strlen/%s users in bounds
+    if (!copy) return;
+    memcpy(copy, val, len);
+    copy[len] = '\0';
+    pg_stmt->param_values[pg_idx] = copy;
+    pg_stmt->param_lengths[pg_idx] = (int)len;
+    pg_stmt->param_types[pg_idx] = PG_OID_BYTEA;
+}
+
 // ============================================================================
 // Busy Statement Auto-Reset
 // ============================================================================
@@ -117,7 +418,7 @@ char* bytes_to_pg_hex(const unsigned char *data, size_t len) {
 // CRITICAL FIX v0.9.0: Hybrid busy-wait with exponential backoff + retry
 // 
 // ROOT CAUSE (discovered 2026-01-16):
-// Multiple threads can access the same sqlite3_stmt* concurrently. The pg_stmt->mutex
+// Multiple threads can access the same sqlite3_stmt* concurrently. The pg_stmt->lock
 // protects the pg_stmt structure but NOT the underlying SQLite statement pointer.
 // 
 // RACE CONDITION (TOCTOU - Time Of Check Time Of Use):
@@ -181,6 +482,9 @@ static inline void ensure_stmt_not_busy(sqlite3_stmt *pStmt, pg_stmt_t *pg_stmt)
 // v0.8.9.1 FIX: Don't PQclear here - just mark for re-execution.
 // The PQclear was causing race conditions with concurrent threads.
 // Let step() handle the cleanup safely.
+//
+// Describe-only metadata results are installed with metadata_only_result=2
+// already, so this only matters for results from older code paths.
 static inline void clear_metadata_result_if_needed(pg_stmt_t *pg_stmt) {
     if (pg_stmt && pg_stmt->metadata_only_result && pg_stmt->result) {
         LOG_DEBUG("BIND: Marking metadata-only result for re-execution with bound params");
@@ -202,7 +506,7 @@ int my_sqlite3_bind_int(sqlite3_stmt *pStmt, int idx, int val) {
     pg_stmt_t *pg_stmt = pg_find_any_stmt(pStmt);
 
     // CRITICAL FIX: Lock BEFORE calling SQLite to prevent "bind on busy statement"
-    if (pg_stmt) pthread_mutex_lock(&pg_stmt->mutex);
+    if (pg_stmt) pg_bias_lock(&pg_stmt->lock);
 
     // CRITICAL FIX v0.8.9: Clear metadata-only result so step() will re-execute
     clear_metadata_result_if_needed(pg_stmt);
@@ -217,14 +521,12 @@ int my_sqlite3_bind_int(sqlite3_stmt *pStmt, int idx, int val) {
 
     if (pg_stmt && idx > 0 && idx <= MAX_PARAMS) {
         int pg_idx = pg_map_param_index(pg_stmt, pStmt, idx);
-        if (pg_idx >= 0 && pg_idx < MAX_PARAMS) {
-            // Use pre-allocated buffer instead of strdup
-            snprintf(pg_stmt->param_buffers[pg_idx], 32, "%d", val);
-            pg_stmt->param_values[pg_idx] = pg_stmt->param_buffers[pg_idx];
+        if (pg_idx >= 0 && pg_stmt_reserve_params(pg_stmt, pg_idx + 1)) {
+            set_param_int64(pg_stmt, pg_idx, val);
         }
     }
 
-    if (pg_stmt) pthread_mutex_unlock(&pg_stmt->mutex);
+    if (pg_stmt) pg_bias_unlock(&pg_stmt->lock);
     return rc;
 }
 
@@ -232,7 +534,7 @@ int my_sqlite3_bind_int64(sqlite3_stmt *pStmt, int idx, sqlite3_int64 val) {
     pg_stmt_t *pg_stmt = pg_find_any_stmt(pStmt);
 
     // CRITICAL FIX: Lock BEFORE calling SQLite to prevent "bind on busy statement"
-    if (pg_stmt) pthread_mutex_lock(&pg_stmt->mutex);
+    if (pg_stmt) pg_bias_lock(&pg_stmt->lock);
 
     // CRITICAL FIX v0.8.9: Clear metadata-only result so step() will re-execute
     clear_metadata_result_if_needed(pg_stmt);
@@ -247,14 +549,12 @@ int my_sqlite3_bind_int64(sqlite3_stmt *pStmt, int idx, sqlite3_int64 val) {
 
     if (pg_stmt && idx > 0 && idx <= MAX_PARAMS) {
         int pg_idx = pg_map_param_index(pg_stmt, pStmt, idx);
-        if (pg_idx >= 0 && pg_idx < MAX_PARAMS) {
-            // Use pre-allocated buffer instead of strdup
-            snprintf(pg_stmt->param_buffers[pg_idx], 32, "%lld", val);
-            pg_stmt->param_values[pg_idx] = pg_stmt->param_buffers[pg_idx];
+        if (pg_idx >= 0 && pg_stmt_reserve_params(pg_stmt, pg_idx + 1)) {
+            set_param_int64(pg_stmt, pg_idx, val);
         }
     }
 
-    if (pg_stmt) pthread_mutex_unlock(&pg_stmt->mutex);
+    if (pg_stmt) pg_bias_unlock(&pg_stmt->lock);
     return rc;
 }
 
@@ -262,7 +562,7 @@ int my_sqlite3_bind_double(sqlite3_stmt *pStmt, int idx, double val) {
     pg_stmt_t *pg_stmt = pg_find_any_stmt(pStmt);
 
     // CRITICAL FIX: Lock BEFORE calling SQLite to prevent "bind on busy statement"
-    if (pg_stmt) pthread_mutex_lock(&pg_stmt->mutex);
+    if (pg_stmt) pg_bias_lock(&pg_stmt->lock);
 
     // CRITICAL FIX v0.8.9: Clear metadata-only result so step() will re-execute
     clear_metadata_result_if_needed(pg_stmt);
@@ -277,14 +577,12 @@ int my_sqlite3_bind_double(sqlite3_stmt *pStmt, int idx, double val) {
 
     if (pg_stmt && idx > 0 && idx <= MAX_PARAMS) {
         int pg_idx = pg_map_param_index(pg_stmt, pStmt, idx);
-        if (pg_idx >= 0 && pg_idx < MAX_PARAMS) {
-            // Use pre-allocated buffer instead of strdup
-            snprintf(pg_stmt->param_buffers[pg_idx], 32, "%.17g", val);
-            pg_stmt->param_values[pg_idx] = pg_stmt->param_buffers[pg_idx];
+        if (pg_idx >= 0 && pg_stmt_reserve_params(pg_stmt, pg_idx + 1)) {
+            set_param_double(pg_stmt, pg_idx, val);
         }
     }
 
-    if (pg_stmt) pthread_mutex_unlock(&pg_stmt->mutex);
+    if (pg_stmt) pg_bias_unlock(&pg_stmt->lock);
     return rc;
 }
 
@@ -293,7 +591,7 @@ int my_sqlite3_bind_text(sqlite3_stmt *pStmt, int idx, const char *val,
     pg_stmt_t *pg_stmt = pg_find_any_stmt(pStmt);
 
     // CRITICAL FIX: Lock BEFORE calling SQLite to prevent "bind on busy statement"
-    if (pg_stmt) pthread_mutex_lock(&pg_stmt->mutex);
+    if (pg_stmt) pg_bias_lock(&pg_stmt->lock);
 
     // CRITICAL FIX v0.8.9: Clear metadata-only result so step() will re-execute
     clear_metadata_result_if_needed(pg_stmt);
@@ -309,12 +607,9 @@ int my_sqlite3_bind_text(sqlite3_stmt *pStmt, int idx, const char *val,
     if (pg_stmt && idx > 0 && idx <= MAX_PARAMS && val) {
         int pg_idx = pg_map_param_index(pg_stmt, pStmt, idx);
 
-        if (pg_idx >= 0 && pg_idx < MAX_PARAMS) {
+        if (pg_idx >= 0 && pg_stmt_reserve_params(pg_stmt, pg_idx + 1)) {
             // Free old value only if it was dynamically allocated
-            if (pg_stmt->param_values[pg_idx] && !is_preallocated_buffer(pg_stmt, pg_idx)) {
-                free(pg_stmt->param_values[pg_idx]);
-                pg_stmt->param_values[pg_idx] = NULL;  // Prevent dangling pointer
-            }
+            release_param_value(pg_stmt, pg_idx);
 
             size_t actual_len = (nBytes < 0) ? strlen(val) : (size_t)nBytes;
 
@@ -335,7 +630,7 @@ int my_sqlite3_bind_text(sqlite3_stmt *pStmt, int idx, const char *val,
         }
     }
 
-    if (pg_stmt) pthread_mutex_unlock(&pg_stmt->mutex);
+    if (pg_stmt) pg_bias_unlock(&pg_stmt->lock);
     return rc;
 }
 
@@ -344,7 +639,7 @@ int my_sqlite3_bind_blob(sqlite3_stmt *pStmt, int idx, const void *val,
     pg_stmt_t *pg_stmt = pg_find_any_stmt(pStmt);
 
     // CRITICAL FIX: Lock BEFORE calling SQLite to prevent "bind on busy statement"
-    if (pg_stmt) pthread_mutex_lock(&pg_stmt->mutex);
+    if (pg_stmt) pg_bias_lock(&pg_stmt->lock);
 
     // CRITICAL FIX v0.8.9: Clear metadata-only result so step() will re-execute
     clear_metadata_result_if_needed(pg_stmt);
@@ -359,21 +654,14 @@ int my_sqlite3_bind_blob(sqlite3_stmt *pStmt, int idx, const void *val,
 
     if (pg_stmt && idx > 0 && idx <= MAX_PARAMS && val && nBytes > 0) {
         int pg_idx = pg_map_param_index(pg_stmt, pStmt, idx);
-        if (pg_idx >= 0 && pg_idx < MAX_PARAMS) {
-            if (pg_stmt->param_values[pg_idx] && !is_preallocated_buffer(pg_stmt, pg_idx)) {
-                free(pg_stmt->param_values[pg_idx]);
-                pg_stmt->param_values[pg_idx] = NULL;  // Prevent dangling pointer
-            }
-            // Convert binary data to PostgreSQL hex format for BYTEA columns
-            // This works in text mode (paramFormats=NULL means text mode)
-            LOG_DEBUG("bind_blob: converting %d bytes to hex at idx=%d", nBytes, idx);
-            pg_stmt->param_values[pg_idx] = bytes_to_pg_hex((const unsigned char*)val, (size_t)nBytes);
-            pg_stmt->param_lengths[pg_idx] = 0;  // Use strlen for text mode
-            pg_stmt->param_formats[pg_idx] = 0;  // text mode (hex string)
+        if (pg_idx >= 0 && pg_stmt_reserve_params(pg_stmt, pg_idx + 1)) {
+            // Keep raw bytes - sent as binary bytea, hex-encoded only for text fallback
+            LOG_DEBUG("bind_blob: storing %d raw bytes at idx=%d", nBytes, idx);
+            set_param_blob(pg_stmt, pg_idx, val, (size_t)nBytes);
         }
     }
 
-    if (pg_stmt) pthread_mutex_unlock(&pg_stmt->mutex);
+    if (pg_stmt) pg_bias_unlock(&pg_stmt->lock);
     return rc;
 }
 
@@ -383,7 +671,7 @@ int my_sqlite3_bind_blob64(sqlite3_stmt *pStmt, int idx, const void *val,
     pg_stmt_t *pg_stmt = pg_find_any_stmt(pStmt);
 
     // CRITICAL FIX: Lock BEFORE calling SQLite to prevent "bind on busy statement"
-    if (pg_stmt) pthread_mutex_lock(&pg_stmt->mutex);
+    if (pg_stmt) pg_bias_lock(&pg_stmt->lock);
 
     // CRITICAL FIX v0.8.9: Clear metadata-only result so step() will re-execute
     clear_metadata_result_if_needed(pg_stmt);
@@ -398,20 +686,14 @@ int my_sqlite3_bind_blob64(sqlite3_stmt *pStmt, int idx, const void *val,
 
     if (pg_stmt && idx > 0 && idx <= MAX_PARAMS && val && nBytes > 0) {
         int pg_idx = pg_map_param_index(pg_stmt, pStmt, idx);
-        if (pg_idx >= 0 && pg_idx < MAX_PARAMS) {
-            if (pg_stmt->param_values[pg_idx] && !is_preallocated_buffer(pg_stmt, pg_idx)) {
-                free(pg_stmt->param_values[pg_idx]);
-                pg_stmt->param_values[pg_idx] = NULL;  // Prevent dangling pointer
-            }
-            // Convert binary data to PostgreSQL hex format for BYTEA columns
-            LOG_DEBUG("bind_blob64: converting %llu bytes to hex at idx=%d", (unsigned long long)nBytes, idx);
-            pg_stmt->param_values[pg_idx] = bytes_to_pg_hex((const unsigned char*)val, (size_t)nBytes);
-            pg_stmt->param_lengths[pg_idx] = 0;  // Use strlen for text mode
-            pg_stmt->param_formats[pg_idx] = 0;  // text mode (hex string)
+        if (pg_idx >= 0 && pg_stmt_reserve_params(pg_stmt, pg_idx + 1)) {
+            // Keep raw bytes - sent as binary bytea, hex-encoded only for text fallback
+            LOG_DEBUG("bind_blob64: storing %llu raw bytes at idx=%d", (unsigned long long)nBytes, idx);
+            set_param_blob(pg_stmt, pg_idx, val, (size_t)nBytes);
         }
     }
 
-    if (pg_stmt) pthread_mutex_unlock(&pg_stmt->mutex);
+    if (pg_stmt) pg_bias_unlock(&pg_stmt->lock);
     return rc;
 }
 
@@ -422,7 +704,7 @@ int my_sqlite3_bind_text64(sqlite3_stmt *pStmt, int idx, const char *val,
     pg_stmt_t *pg_stmt = pg_find_any_stmt(pStmt);
 
     // CRITICAL FIX: Lock BEFORE calling SQLite to prevent "bind on busy statement"
-    if (pg_stmt) pthread_mutex_lock(&pg_stmt->mutex);
+    if (pg_stmt) pg_bias_lock(&pg_stmt->lock);
 
     // CRITICAL FIX v0.8.9: Clear metadata-only result so step() will re-execute
     clear_metadata_result_if_needed(pg_stmt);
@@ -437,11 +719,8 @@ int my_sqlite3_bind_text64(sqlite3_stmt *pStmt, int idx, const char *val,
 
     if (pg_stmt && idx > 0 && idx <= MAX_PARAMS && val) {
         int pg_idx = pg_map_param_index(pg_stmt, pStmt, idx);
-        if (pg_idx >= 0 && pg_idx < MAX_PARAMS) {
-            if (pg_stmt->param_values[pg_idx] && !is_preallocated_buffer(pg_stmt, pg_idx)) {
-                free(pg_stmt->param_values[pg_idx]);
-                pg_stmt->param_values[pg_idx] = NULL;  // Prevent dangling pointer
-            }
+        if (pg_idx >= 0 && pg_stmt_reserve_params(pg_stmt, pg_idx + 1)) {
+            release_param_value(pg_stmt, pg_idx);
 
             size_t actual_len = (nBytes == (sqlite3_uint64)-1) ? strlen(val) : (size_t)nBytes;
 
@@ -462,7 +741,7 @@ int my_sqlite3_bind_text64(sqlite3_stmt *pStmt, int idx, const char *val,
         }
     }
 
-    if (pg_stmt) pthread_mutex_unlock(&pg_stmt->mutex);
+    if (pg_stmt) pg_bias_unlock(&pg_stmt->lock);
     return rc;
 }
 
@@ -471,7 +750,7 @@ int my_sqlite3_bind_value(sqlite3_stmt *pStmt, int idx, const sqlite3_value *pVa
     pg_stmt_t *pg_stmt = pg_find_any_stmt(pStmt);
 
     // CRITICAL FIX: Lock BEFORE calling SQLite to prevent "bind on busy statement"
-    if (pg_stmt) pthread_mutex_lock(&pg_stmt->mutex);
+    if (pg_stmt) pg_bias_lock(&pg_stmt->lock);
 
     // CRITICAL FIX v0.8.9: Clear metadata-only result so step() will re-execute
     clear_metadata_result_if_needed(pg_stmt);
@@ -486,29 +765,18 @@ int my_sqlite3_bind_value(sqlite3_stmt *pStmt, int idx, const sqlite3_value *pVa
 
     if (pg_stmt && idx > 0 && idx <= MAX_PARAMS && pValue) {
         int pg_idx = pg_map_param_index(pg_stmt, pStmt, idx);
-        if (pg_idx >= 0 && pg_idx < MAX_PARAMS) {
+        if (pg_idx >= 0 && pg_stmt_reserve_params(pg_stmt, pg_idx + 1)) {
             // Get value type and extract appropriately
             int vtype = sqlite3_value_type(pValue);
-            if (pg_stmt->param_values[pg_idx] && !is_preallocated_buffer(pg_stmt, pg_idx)) {
-                free(pg_stmt->param_values[pg_idx]);
-                pg_stmt->param_values[pg_idx] = NULL;
-            }
+            release_param_value(pg_stmt, pg_idx);
 
             switch (vtype) {
-                case SQLITE_INTEGER: {
-                    sqlite3_int64 v = sqlite3_value_int64(pValue);
-                    char buf[32];
-                    snprintf(buf, sizeof(buf), "%lld", v);
-                    pg_stmt->param_values[pg_idx] = strdup(buf);
+                case SQLITE_INTEGER:
+                    set_param_int64(pg_stmt, pg_idx, sqlite3_value_int64(pValue));
                     break;
-                }
-                case SQLITE_FLOAT: {
-                    double v = sqlite3_value_double(pValue);
-                    char buf[64];
-                    snprintf(buf, sizeof(buf), "%.17g", v);
-                    pg_stmt->param_values[pg_idx] = strdup(buf);
+                case SQLITE_FLOAT:
+                    set_param_double(pg_stmt, pg_idx, sqlite3_value_double(pValue));
                     break;
-                }
                 case SQLITE_TEXT: {
                     const char *v = (const char *)sqlite3_value_text(pValue);
                     if (v) pg_stmt->param_values[pg_idx] = strdup(v);
@@ -518,12 +786,7 @@ int my_sqlite3_bind_value(sqlite3_stmt *pStmt, int idx, const sqlite3_value *pVa
                     int len = sqlite3_value_bytes(pValue);
                     const void *v = sqlite3_value_blob(pValue);
                     if (v && len > 0) {
-                        pg_stmt->param_values[pg_idx] = malloc(len);
-                        if (pg_stmt->param_values[pg_idx]) {
-                            memcpy(pg_stmt->param_values[pg_idx], v, len);
-                        }
-                        pg_stmt->param_lengths[pg_idx] = len;
-                        pg_stmt->param_formats[pg_idx] = 1;  // binary
+                        set_param_blob(pg_stmt, pg_idx, v, (size_t)len);
                     }
                     break;
                 }
@@ -535,7 +798,7 @@ int my_sqlite3_bind_value(sqlite3_stmt *pStmt, int idx, const sqlite3_value *pVa
         }
     }
 
-    if (pg_stmt) pthread_mutex_unlock(&pg_stmt->mutex);
+    if (pg_stmt) pg_bias_unlock(&pg_stmt->lock);
     return rc;
 }
 
@@ -543,7 +806,7 @@ int my_sqlite3_bind_null(sqlite3_stmt *pStmt, int idx) {
     pg_stmt_t *pg_stmt = pg_find_any_stmt(pStmt);
 
     // CRITICAL FIX: Lock BEFORE calling SQLite to prevent "bind on busy statement"
-    if (pg_stmt) pthread_mutex_lock(&pg_stmt->mutex);
+    if (pg_stmt) pg_bias_lock(&pg_stmt->lock);
 
     // CRITICAL FIX v0.8.9: Clear metadata-only result so step() will re-execute
     clear_metadata_result_if_needed(pg_stmt);
@@ -560,14 +823,11 @@ int my_sqlite3_bind_null(sqlite3_stmt *pStmt, int idx) {
 
     if (pg_stmt && idx > 0 && idx <= MAX_PARAMS) {
         int pg_idx = pg_map_param_index(pg_stmt, pStmt, idx);
-        if (pg_idx >= 0 && pg_idx < MAX_PARAMS) {
-            if (pg_stmt->param_values[pg_idx] && !is_preallocated_buffer(pg_stmt, pg_idx)) {
-                free(pg_stmt->param_values[pg_idx]);
-                pg_stmt->param_values[pg_idx] = NULL;
-            }
+        if (pg_idx >= 0 && pg_stmt_reserve_params(pg_stmt, pg_idx + 1)) {
+            release_param_value(pg_stmt, pg_idx);
         }
     }
 
-    if (pg_stmt) pthread_mutex_unlock(&pg_stmt->mutex);
+    if (pg_stmt) pg_bias_unlock(&pg_stmt->lock);
     return rc;
 }
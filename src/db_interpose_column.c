@@ -7,6 +7,9 @@
 
 #include "db_interpose.h"
 #include "pg_query_cache.h"
+#include "pg_mem.h"
+#include "pg_utf8.h"
+#include "pg_hex.h"
 #include <stdatomic.h>
 #include <sys/time.h>
 
@@ -18,51 +21,320 @@
 // to return the exact original SQLite types (e.g., "boolean", "dt_integer(8)")
 // instead of PostgreSQL-derived types (e.g., "INTEGER", "TEXT").
 
-#define DECLTYPE_CACHE_SIZE 1024
-#define DECLTYPE_MAX_KEY_LEN 128
-#define DECLTYPE_MAX_TYPE_LEN 64
+// The table is a perfect hash (hash-and-displace) over every row of
+// the metadata table: keys are split into buckets, and each bucket gets the
+// displacement that lands all its keys on free slots. A lookup is one hash,
+// one slot and one key compare, and no row is ever dropped on collision.
+// Normalized types are resolved at load, so hits return them directly.
 
-typedef struct {
-    char key[DECLTYPE_MAX_KEY_LEN];      // "table_column" key
-    char decltype_val[DECLTYPE_MAX_TYPE_LEN];  // Original SQLite declared type
-    int valid;                            // 1 = valid entry, 0 = empty/invalid
-} decltype_cache_entry_t;
+#define DECLTYPE_EMPTY UINT32_MAX
+#define DECLTYPE_MAX_DISPLACEMENT 4096   // Per bucket, before growing the slot array
 
-static decltype_cache_entry_t decltype_cache[DECLTYPE_CACHE_SIZE];
+typedef struct {
+    uint32_t key;                         // "table_column" offset in strings, DECLTYPE_EMPTY = free
+    uint32_t raw;                         // Original SQLite declared type (offset in strings)
+    const char *normalized;               // normalize_sqlite_decltype(raw) - static string
+} decltype_slot_t;
+
+// Loaded tables are immutable and published through an atomic pointer, so a
+// reload (after plex.sqlite_column_types or the schema changed, in this or
+// another process) never changes entries under a reader. Replaced tables are
+// retired, never freed - reloads are rare.
+typedef struct decltype_table {
+    struct decltype_table *retired_next;
+    uint64_t version;                     // decltype_source_version() at load
+    size_t bytes;                         // Whole allocation (header + arrays + strings)
+    uint32_t bucket_mask;                 // Buckets - 1 (power of 2)
+    uint32_t slot_mask;                   // Slots - 1 (power of 2)
+    int count;
+    uint32_t *displacement;               // Per bucket
+    decltype_slot_t *slots;
+    char *strings;
+} decltype_table_t;
+
+static _Atomic(decltype_table_t *) decltype_table = NULL;
+static decltype_table_t *decltype_retired = NULL;
 static pthread_mutex_t decltype_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
-static int decltype_cache_initialized = 0;
-static int decltype_cache_loaded = 0;  // Have we loaded from DB?
 
-// Hash function for cache lookup
-static unsigned int decltype_hash(const char *str) {
-    unsigned int hash = 5381;
-    int c;
-    while ((c = *str++)) {
-        hash = ((hash << 5) + hash) + (unsigned char)c;
+static const char* normalize_sqlite_decltype(const char *plex_type);
+
+// FNV-1a over the key in pieces, so "table" + "_" + "column" hashes the same
+// as the joined string without building it
+static inline uint64_t decltype_hash_part(uint64_t h, const char *s, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+#define DECLTYPE_HASH_INIT 14695981039346656037ULL
+
+// Final avalanche (splitmix64) - bucket, start and step come from different bits
+static inline uint64_t decltype_hash_final(uint64_t h) {
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+static inline uint32_t decltype_slot_of(uint64_t h, uint32_t d, uint32_t slot_mask) {
+    uint32_t start = (uint32_t)h;
+    uint32_t step = (uint32_t)(h >> 40) | 1;  // Odd - visits every slot of a power of 2
+    return (start + d * step) & slot_mask;
+}
+
+static inline uint32_t decltype_bucket_of(uint64_t h, uint32_t bucket_mask) {
+    return (uint32_t)(h >> 32) & bucket_mask;
+}
+
+static uint32_t decltype_pow2(uint32_t n) {
+    uint32_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+// Changes whenever plex.sqlite_column_types is written or DDL runs
+// (both counters only increase)
+static uint64_t decltype_source_version(void) {
+    return pg_query_cache_table_version("sqlite_column_types") + pg_query_cache_schema_version();
+}
+
+// Key being loaded (offsets into the new table's strings)
+typedef struct {
+    uint32_t key;
+    uint32_t raw;
+    uint64_t hash;
+    int row;                              // Metadata row - the first of duplicates wins
+} decltype_build_key_t;
+
+static const char *decltype_sort_strings;  // Under decltype_cache_mutex
+
+static int decltype_key_cmp(const void *a, const void *b) {
+    const decltype_build_key_t *ka = a, *kb = b;
+    int c = strcmp(decltype_sort_strings + ka->key, decltype_sort_strings + kb->key);
+    return c ? c : ka->row - kb->row;
+}
+
+// Place every key. Returns 0 if some bucket found no displacement.
+static int decltype_place(decltype_table_t *t, const decltype_build_key_t *keys, int n) {
+    uint32_t nbuckets = t->bucket_mask + 1;
+    uint32_t nslots = t->slot_mask + 1;
+    for (uint32_t i = 0; i < nslots; i++) t->slots[i].key = DECLTYPE_EMPTY;
+
+    // Bucket members, largest buckets placed first
+    int *count = calloc(nbuckets + 1, sizeof(int));
+    int *members = malloc((size_t)(n ? n : 1) * sizeof(int));
+    uint32_t *order = malloc(nbuckets * sizeof(uint32_t));
+    if (!count || !members || !order) {
+        free(count);
+        free(members);
+        free(order);
+        return 0;
+    }
+    for (int i = 0; i < n; i++) count[decltype_bucket_of(keys[i].hash, t->bucket_mask) + 1]++;
+    for (uint32_t b = 0; b < nbuckets; b++) count[b + 1] += count[b];  // Start offsets
+    int *fill = calloc(nbuckets, sizeof(int));
+    if (!fill) {
+        free(count);
+        free(members);
+        free(order);
+        return 0;
+    }
+    for (int i = 0; i < n; i++) {
+        uint32_t b = decltype_bucket_of(keys[i].hash, t->bucket_mask);
+        members[count[b] + fill[b]++] = i;
+    }
+    for (uint32_t b = 0; b < nbuckets; b++) order[b] = b;
+    for (uint32_t i = 1; i < nbuckets; i++) {  // Insertion sort by size, descending
+        uint32_t b = order[i];
+        uint32_t j = i;
+        while (j > 0 && fill[order[j - 1]] < fill[b]) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = b;
+    }
+
+    int ok = 1;
+    uint32_t placed[64];
+    for (uint32_t o = 0; o < nbuckets && ok; o++) {
+        uint32_t b = order[o];
+        int size = fill[b];
+        t->displacement[b] = 0;
+        if (size == 0) break;  // The rest are empty too
+        if (size > 64) {
+            ok = 0;
+            break;
+        }
+
+        ok = 0;
+        for (uint32_t d = 0; d < DECLTYPE_MAX_DISPLACEMENT && !ok; d++) {
+            int fits = 1;
+            for (int m = 0; m < size && fits; m++) {
+                uint32_t slot = decltype_slot_of(keys[members[count[b] + m]].hash, d, t->slot_mask);
+                if (t->slots[slot].key != DECLTYPE_EMPTY) fits = 0;
+                for (int q = 0; q < m && fits; q++) {
+                    if (placed[q] == slot) fits = 0;
+                }
+                placed[m] = slot;
+            }
+            if (!fits) continue;
+
+            t->displacement[b] = d;
+            for (int m = 0; m < size; m++) {
+                const decltype_build_key_t *k = &keys[members[count[b] + m]];
+                decltype_slot_t *slot = &t->slots[placed[m]];
+                slot->key = k->key;
+                slot->raw = k->raw;
+                slot->normalized = normalize_sqlite_decltype(t->strings + k->raw);
+            }
+            ok = 1;
+        }
+    }
+
+    free(count);
+    free(fill);
+    free(members);
+    free(order);
+    return ok;
+}
+
+// Build a table from plex.sqlite_column_types rows. NULL on allocation failure.
+static decltype_table_t* build_decltype_table(PGresult *res, uint64_t version) {
+    int num_rows = res ? PQntuples(res) : 0;
+
+    size_t strings_len = 1;
+    for (int i = 0; i < num_rows; i++) {
+        strings_len += (size_t)PQgetlength(res, i, 0) + 1 + (size_t)PQgetlength(res, i, 1) + 1 +
+                       (size_t)PQgetlength(res, i, 2) + 1;
+    }
+    if (strings_len >= DECLTYPE_EMPTY) return NULL;
+
+    decltype_build_key_t *keys = malloc((num_rows > 0 ? (size_t)num_rows : 1) * sizeof(*keys));
+    char *strings = malloc(strings_len);
+    if (!keys || !strings) {
+        free(keys);
+        free(strings);
+        return NULL;
+    }
+
+    // Keys and raw types, then sort to drop duplicate (table, column) rows
+    size_t off = 0;
+    strings[off++] = '\0';
+    int n = 0;
+    for (int i = 0; i < num_rows; i++) {
+        if (PQgetisnull(res, i, 0) || PQgetisnull(res, i, 1) || PQgetisnull(res, i, 2)) continue;
+        keys[n].key = (uint32_t)off;
+        off += (size_t)sprintf(strings + off, "%s_%s", PQgetvalue(res, i, 0), PQgetvalue(res, i, 1)) + 1;
+        keys[n].raw = (uint32_t)off;
+        off += (size_t)sprintf(strings + off, "%s", PQgetvalue(res, i, 2)) + 1;
+        keys[n].hash = decltype_hash_final(
+            decltype_hash_part(DECLTYPE_HASH_INIT, strings + keys[n].key, strlen(strings + keys[n].key)));
+        keys[n].row = i;
+        n++;
+    }
+    decltype_sort_strings = strings;
+    qsort(keys, (size_t)n, sizeof(*keys), decltype_key_cmp);
+    int unique = 0;
+    for (int i = 0; i < n; i++) {
+        if (unique > 0 && strcmp(strings + keys[unique - 1].key, strings + keys[i].key) == 0) continue;
+        keys[unique++] = keys[i];
+    }
+
+    // ~4 keys per bucket, load factor <= 0.5; grow the slots until every
+    // bucket fits (a full 64-bit hash collision would never fit - give up)
+    uint32_t nbuckets = decltype_pow2((uint32_t)(unique / 4 + 1));
+    uint32_t nslots = decltype_pow2((uint32_t)(unique * 2 + 16));
+    decltype_table_t *table = NULL;
+    for (int attempt = 0; attempt < 4 && !table; attempt++, nslots <<= 1, nbuckets <<= 1) {
+        size_t slots_at = (sizeof(decltype_table_t) + nbuckets * sizeof(uint32_t) + 7) & ~(size_t)7;
+        size_t strings_at = slots_at + nslots * sizeof(decltype_slot_t);
+        size_t bytes = strings_at + off;
+        decltype_table_t *t = calloc(1, bytes);
+        if (!t) break;
+        t->version = version;
+        t->bytes = bytes;
+        t->bucket_mask = nbuckets - 1;
+        t->slot_mask = nslots - 1;
+        t->count = unique;
+        t->displacement = (uint32_t *)(t + 1);
+        t->slots = (decltype_slot_t *)((char *)t + slots_at);
+        t->strings = (char *)t + strings_at;
+        memcpy(t->strings, strings, off);
+        if (decltype_place(t, keys, unique)) {
+            table = t;
+        } else {
+            free(t);
+        }
+    }
+    if (!table) {
+        LOG_ERROR("DECLTYPE_CACHE: no perfect hash for %d keys", unique);
+    } else if (unique < n) {
+        LOG_DEBUG("DECLTYPE_CACHE: %d duplicate rows ignored", n - unique);
+    }
+
+    free(keys);
+    free(strings);
+    return table;
+}
+
+// Same entries under a new version (the source couldn't be read)
+static decltype_table_t* clone_decltype_table(const decltype_table_t *old, uint64_t version) {
+    decltype_table_t *t = malloc(old->bytes);
+    if (!t) return NULL;
+    memcpy(t, old, old->bytes);
+    t->retired_next = NULL;
+    t->version = version;
+    t->displacement = (uint32_t *)(t + 1);
+    t->slots = (decltype_slot_t *)((char *)t + ((const char *)old->slots - (const char *)old));
+    t->strings = (char *)t + (old->strings - (const char *)old);
+    return t;
+}
+
+// Lookup of "<table>_<column>" (table may be NULL when column is the whole key)
+static const decltype_slot_t* decltype_table_find(const decltype_table_t *t, const char *table,
+                                                  const char *column) {
+    size_t tlen = table ? strlen(table) : 0;
+    size_t clen = strlen(column);
+    uint64_t h = DECLTYPE_HASH_INIT;
+    if (table) {
+        h = decltype_hash_part(h, table, tlen);
+        h = decltype_hash_part(h, "_", 1);
+    }
+    h = decltype_hash_final(decltype_hash_part(h, column, clen));
+
+    uint32_t d = t->displacement[decltype_bucket_of(h, t->bucket_mask)];
+    const decltype_slot_t *slot = &t->slots[decltype_slot_of(h, d, t->slot_mask)];
+    if (slot->key == DECLTYPE_EMPTY) return NULL;
+
+    const char *key = t->strings + slot->key;
+    if (table) {
+        if (memcmp(key, table, tlen) != 0 || key[tlen] != '_') return NULL;
+        key += tlen + 1;
     }
-    return hash;
+    return strcmp(key, column) == 0 ? slot : NULL;
 }
 
-// Preload all SQLite declared types from metadata table into cache
-// Called once on first decltype request
+// (Re)load all SQLite declared types from metadata table into a new table
+// Called on first decltype request and after the source version changes
 static void preload_decltype_cache(pg_connection_t *pg_conn) {
-    if (decltype_cache_loaded || !pg_conn || !pg_conn->conn) {
+    if (!pg_conn || !pg_conn->conn) {
         return;
     }
 
     pthread_mutex_lock(&decltype_cache_mutex);
-    if (decltype_cache_loaded) {
+    uint64_t version = decltype_source_version();  // Before querying
+    decltype_table_t *old = atomic_load(&decltype_table);
+    if (old && old->version == version) {
         pthread_mutex_unlock(&decltype_cache_mutex);
-        return;
-    }
-
-    // Initialize cache
-    if (!decltype_cache_initialized) {
-        memset(decltype_cache, 0, sizeof(decltype_cache));
-        decltype_cache_initialized = 1;
+        return;  // Another thread reloaded while we waited
     }
 
-    LOG_INFO("DECLTYPE_CACHE: Preloading SQLite declared types from metadata table...");
+    LOG_INFO("DECLTYPE_CACHE: %s SQLite declared types from metadata table...",
+             old ? "Reloading" : "Preloading");
 
     // Query all types from metadata table
     pthread_mutex_lock(&pg_conn->mutex);
@@ -70,60 +342,44 @@ static void preload_decltype_cache(pg_connection_t *pg_conn) {
         "SELECT table_name, column_name, declared_type FROM plex.sqlite_column_types");
     pthread_mutex_unlock(&pg_conn->mutex);
 
+    decltype_table_t *table;
     if (!res || PQresultStatus(res) != PGRES_TUPLES_OK) {
         LOG_ERROR("DECLTYPE_CACHE: Failed to load metadata: %s",
                   res ? PQerrorMessage(pg_conn->conn) : "NULL result");
-        if (res) PQclear(res);
-        decltype_cache_loaded = 1;  // Mark as loaded (even if failed) to avoid retrying
+        // Keep serving what we had (or nothing) at this version to avoid retrying
+        table = old ? clone_decltype_table(old, version) : build_decltype_table(NULL, version);
+    } else {
+        table = build_decltype_table(res, version);
+        if (table) {
+            LOG_INFO("DECLTYPE_CACHE: Loaded %d types (%u slots, %u buckets)",
+                     table->count, table->slot_mask + 1, table->bucket_mask + 1);
+        }
+    }
+    if (res) PQclear(res);
+
+    if (!table) {
         pthread_mutex_unlock(&decltype_cache_mutex);
         return;
     }
+    pg_mem_charge(PG_MEM_DECLTYPE, (ssize_t)table->bytes);  // Retired, never freed
 
-    int num_rows = PQntuples(res);
-    int loaded = 0;
-    int collisions = 0;
-
-    for (int i = 0; i < num_rows; i++) {
-        const char *table = PQgetvalue(res, i, 0);
-        const char *column = PQgetvalue(res, i, 1);
-        const char *decltype_str = PQgetvalue(res, i, 2);
-
-        if (!table || !column || !decltype_str) continue;
-
-        // Create cache key: "table_column"
-        char key[DECLTYPE_MAX_KEY_LEN];
-        snprintf(key, sizeof(key), "%s_%s", table, column);
-
-        // Compute hash and find slot
-        unsigned int hash = decltype_hash(key);
-        int start_idx = hash % DECLTYPE_CACHE_SIZE;
-
-        // Linear probing for collision resolution
-        int found_slot = 0;
-        for (int probe = 0; probe < 8; probe++) {
-            int idx = (start_idx + probe) % DECLTYPE_CACHE_SIZE;
-            if (!decltype_cache[idx].valid) {
-                // Empty slot - use it
-                strncpy(decltype_cache[idx].key, key, DECLTYPE_MAX_KEY_LEN - 1);
-                decltype_cache[idx].key[DECLTYPE_MAX_KEY_LEN - 1] = '\0';
-                strncpy(decltype_cache[idx].decltype_val, decltype_str, DECLTYPE_MAX_TYPE_LEN - 1);
-                decltype_cache[idx].decltype_val[DECLTYPE_MAX_TYPE_LEN - 1] = '\0';
-                decltype_cache[idx].valid = 1;
-                loaded++;
-                found_slot = 1;
-                break;
-            }
-        }
-        if (!found_slot) {
-            collisions++;
-        }
+    atomic_store(&decltype_table, table);
+    if (old) {
+        old->retired_next = decltype_retired;
+        decltype_retired = old;
     }
-
-    PQclear(res);
-    decltype_cache_loaded = 1;
     pthread_mutex_unlock(&decltype_cache_mutex);
+}
 
-    LOG_INFO("DECLTYPE_CACHE: Loaded %d types (%d collisions/overflows)", loaded, collisions);
+// Current table, (re)loading it first if missing or outdated and a
+// connection is available. May return NULL.
+static const decltype_table_t* get_decltype_table(pg_connection_t *pg_conn) {
+    decltype_table_t *table = atomic_load(&decltype_table);
+    if ((!table || table->version != decltype_source_version()) && pg_conn) {
+        preload_decltype_cache(pg_conn);
+        table = atomic_load(&decltype_table);
+    }
+    return table;
 }
 
 // Normalize Plex custom type annotations to standard SQLite types
@@ -233,82 +489,374 @@ static const char* normalize_sqlite_decltype(const char *plex_type) {
     return "TEXT";
 }
 
-// Direct cache lookup by exact table_column key (no parsing)
-// Used when we already know the table name from PQftable()
-// Returns normalized type or NULL if not found
-static const char* lookup_decltype_direct(pg_connection_t *pg_conn, const char *cache_key) {
-    if (!cache_key || !cache_key[0]) {
+// Cache lookup of "<table>_<column>", or of column alone when table is NULL
+// (aliased columns like "devices_id" already are the key)
+// Returns normalized type (static string, do not free) or NULL if not found
+static const char* lookup_sqlite_decltype(pg_connection_t *pg_conn, const char *table, const char *column) {
+    if (!column || !column[0]) {
         return NULL;
     }
 
-    // Ensure cache is loaded
-    if (!decltype_cache_loaded && pg_conn) {
-        preload_decltype_cache(pg_conn);
+    // Ensure cache is loaded and current
+    const decltype_table_t *t = get_decltype_table(pg_conn);
+    if (!t) {
+        return NULL;
+    }
+
+    const decltype_slot_t *slot = decltype_table_find(t, table, column);
+    if (!slot) {
+        LOG_DEBUG("DECLTYPE_LOOKUP: '%s%s%s' not in cache", table ? table : "", table ? "_" : "", column);
+        return NULL;
+    }
+    LOG_DEBUG("DECLTYPE_LOOKUP: found '%s' -> '%s' (normalized to '%s')",
+              t->strings + slot->key, t->strings + slot->raw, slot->normalized);
+    return slot->normalized;
+}
+
+// ============================================================================
+// Relation Name Cache (table OID -> relname, process-wide)
+// ============================================================================
+// The Plex schema is static, so table names are loaded once for the whole
+// configured schema instead of querying pg_class after every SELECT.
+//
+// Readers are lock-free: the map is an immutable open-addressing snapshot
+// published through an atomic pointer. Writers (preload, miss, DDL) build a
+// new snapshot under relname_map_mutex and swap it in. Replaced snapshots are
+// retired, never freed, because readers hold no references - rebuilds only
+// happen on DDL or an OID outside the schema, so the retired list stays tiny.
+
+#define RELNAME_MAX_LEN 64
+
+typedef struct {
+    Oid oid;                             // InvalidOid = empty slot
+    char name[RELNAME_MAX_LEN];          // "" = negative entry (OID is not a relation)
+} relname_entry_t;
+
+typedef struct relname_map {
+    struct relname_map *retired_next;    // Chain of replaced snapshots
+    unsigned int mask;                   // slots - 1 (power of 2)
+    int count;
+    relname_entry_t slots[];
+} relname_map_t;
+
+static _Atomic(relname_map_t *) relname_map = NULL;
+static relname_map_t *relname_retired = NULL;
+static _Atomic uint64_t relname_map_version = 0;  // Schema version of the last full load
+static pthread_mutex_t relname_map_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static inline unsigned int relname_hash(Oid oid) {
+    return (unsigned int)oid * 2654435761u;  // Knuth multiplicative hash
+}
+
+static const relname_entry_t* relname_map_find(const relname_map_t *map, Oid oid) {
+    if (!map) return NULL;
+    for (unsigned int i = relname_hash(oid) & map->mask; ; i = (i + 1) & map->mask) {
+        const relname_entry_t *e = &map->slots[i];
+        if (e->oid == oid) return e;
+        if (e->oid == InvalidOid) return NULL;
     }
+}
 
-    // Look up in cache
-    unsigned int hash = decltype_hash(cache_key);
-    int start_idx = hash % DECLTYPE_CACHE_SIZE;
+static void relname_map_put(relname_map_t *map, Oid oid, const char *name) {
+    unsigned int i = relname_hash(oid) & map->mask;
+    while (map->slots[i].oid != InvalidOid && map->slots[i].oid != oid) {
+        i = (i + 1) & map->mask;
+    }
+    if (map->slots[i].oid == InvalidOid) map->count++;
+    map->slots[i].oid = oid;
+    strncpy(map->slots[i].name, name, RELNAME_MAX_LEN - 1);
+    map->slots[i].name[RELNAME_MAX_LEN - 1] = '\0';
+}
 
-    for (int probe = 0; probe < 8; probe++) {
-        int idx = (start_idx + probe) % DECLTYPE_CACHE_SIZE;
-        if (!decltype_cache[idx].valid) {
-            break;  // Empty slot - not found
+static relname_map_t* relname_map_alloc(int min_entries) {
+    unsigned int slots = 256;
+    while (slots < (unsigned int)min_entries * 2) slots <<= 1;  // Load factor <= 0.5
+    relname_map_t *map = calloc(1, sizeof(relname_map_t) + slots * sizeof(relname_entry_t));
+    if (map) {
+        map->mask = slots - 1;
+        // Replaced maps are retired, never freed - charged for good
+        pg_mem_charge(PG_MEM_DECLTYPE, (ssize_t)(sizeof(relname_map_t) + slots * sizeof(relname_entry_t)));
+    }
+    return map;
+}
+
+// DDL here or in another process bumps the schema version - the next miss
+// then reloads everything
+static int relname_map_is_stale(void) {
+    return atomic_load(&relname_map_version) != pg_query_cache_schema_version();
+}
+
+// Load the schema's relations plus any OIDs in `missing` that are not in it.
+// Must NOT be called while holding pg_conn->mutex.
+static void relname_map_refresh(pg_connection_t *pg_conn, const Oid *missing, int num_missing) {
+    pthread_mutex_lock(&relname_map_mutex);
+
+    relname_map_t *old = atomic_load(&relname_map);
+    int full_reload = !old || relname_map_is_stale();
+
+    // Another thread may have refreshed while we waited
+    if (!full_reload) {
+        int all_found = 1;
+        for (int i = 0; i < num_missing && all_found; i++) {
+            if (!relname_map_find(old, missing[i])) all_found = 0;
+        }
+        if (all_found) {
+            pthread_mutex_unlock(&relname_map_mutex);
+            return;
         }
-        if (strcmp(decltype_cache[idx].key, cache_key) == 0) {
-            const char *raw_type = decltype_cache[idx].decltype_val;
-            const char *normalized = normalize_sqlite_decltype(raw_type);
-            LOG_DEBUG("DECLTYPE_DIRECT: found '%s' -> '%s' (normalized to '%s')",
-                     cache_key, raw_type, normalized);
-            return normalized;
+    }
+    uint64_t version = pg_query_cache_schema_version();  // Before querying (see pg_query_cache.h)
+
+    // One round trip: whole schema (full reload) and/or the specific misses
+    char oid_list[MAX_PARAMS * 12 + 4];
+    int off = snprintf(oid_list, sizeof(oid_list), "{");
+    for (int i = 0; i < num_missing; i++) {
+        off += snprintf(oid_list + off, sizeof(oid_list) - off, "%s%u", i ? "," : "", missing[i]);
+    }
+    snprintf(oid_list + off, sizeof(oid_list) - off, "}");
+
+    const char *params[3] = { pg_config_get()->schema, oid_list, full_reload ? "1" : "0" };
+
+    pthread_mutex_lock(&pg_conn->mutex);
+    PGresult *res = PQexecParams(pg_conn->conn,
+        "SELECT c.oid, c.relname FROM pg_class c JOIN pg_namespace n ON n.oid = c.relnamespace "
+        "WHERE ($3::int = 1 AND n.nspname = $1) OR c.oid = ANY($2::oid[])",
+        3, NULL, params, NULL, NULL, 0);
+    pthread_mutex_unlock(&pg_conn->mutex);
+
+    if (!res || PQresultStatus(res) != PGRES_TUPLES_OK) {
+        LOG_ERROR("RELNAME_CACHE: Query failed: %s",
+                  res ? PQerrorMessage(pg_conn->conn) : "NULL result");
+        if (res) PQclear(res);
+        pthread_mutex_unlock(&relname_map_mutex);
+        return;
+    }
+
+    int num_rows = PQntuples(res);
+    int carried = full_reload || !old ? 0 : old->count;
+    relname_map_t *map = relname_map_alloc(carried + num_rows + num_missing);
+    if (!map) {
+        PQclear(res);
+        pthread_mutex_unlock(&relname_map_mutex);
+        return;
+    }
+
+    if (carried) {
+        for (unsigned int i = 0; i <= old->mask; i++) {
+            if (old->slots[i].oid != InvalidOid) {
+                relname_map_put(map, old->slots[i].oid, old->slots[i].name);
+            }
         }
     }
+    for (int i = 0; i < num_rows; i++) {
+        relname_map_put(map, (Oid)strtoul(PQgetvalue(res, i, 0), NULL, 10), PQgetvalue(res, i, 1));
+    }
+    PQclear(res);
+
+    // OIDs pg_class doesn't know get a negative entry so they don't re-query
+    for (int i = 0; i < num_missing; i++) {
+        if (!relname_map_find(map, missing[i])) relname_map_put(map, missing[i], "");
+    }
 
-    LOG_DEBUG("DECLTYPE_DIRECT: '%s' not in cache", cache_key);
-    return NULL;
+    atomic_store(&relname_map, map);
+    if (full_reload) atomic_store(&relname_map_version, version);
+    if (old) {
+        old->retired_next = relname_retired;
+        relname_retired = old;
+    }
+    pthread_mutex_unlock(&relname_map_mutex);
+
+    LOG_INFO("RELNAME_CACHE: %s - %d relations cached",
+             full_reload ? "loaded schema" : "added missing OIDs", map->count);
 }
 
-// Look up original SQLite declared type from cache
-// col_alias is like "devices_id" or "accounts_auto_select_subtitle"
-// Returns static string (do not free), or NULL if not found
-static const char* lookup_sqlite_decltype(pg_connection_t *pg_conn, const char *col_alias) {
-    if (!col_alias || !col_alias[0]) {
-        return NULL;
+// ============================================================================
+// Result shape (shared per statement template)
+// ============================================================================
+// Column names, type OIDs, affinities, source tables and decltypes depend
+// only on the SQL and on the decltype table, so they are resolved once per
+// template and shared by every statement handle and thread running that SQL
+// (pg_shape_t, pg_statement.h). A shape is current while its version equals
+// decltype_source_version(); after DDL or a sqlite_column_types change the
+// next statement to need it rebuilds it from its own result.
+
+// Declared type of a result column (static string, never NULL)
+static const char* compute_column_decltype(pg_connection_t *pg_conn, const char *col_name,
+                                           Oid oid, const char *table, const char *pg_sql) {
+    // STEP 1: Try looking up using column name as-is (for aliased columns like "devices_id")
+    const char *cached_type = lookup_sqlite_decltype(pg_conn, NULL, col_name);
+
+    // STEP 2: If not found and we have a resolved table name, try table_column format
+    if (!cached_type && table) {
+        // Column name is bare (e.g., "extra_data"), look up "table_column"
+        cached_type = lookup_sqlite_decltype(pg_conn, table, col_name);
+        if (cached_type) {
+            LOG_DEBUG("DECLTYPE_RESOLVED: bare col '%s' -> table '%s' -> '%s'",
+                      col_name, table, cached_type);
+        }
     }
 
-    // Ensure cache is loaded
-    if (!decltype_cache_loaded && pg_conn) {
-        preload_decltype_cache(pg_conn);
+    // STEP 3: If found in cache, return the original SQLite declared type
+    if (cached_type) {
+        LOG_DEBUG("DECLTYPE_CACHED: col='%s' -> '%s' sql=%.300s",
+                 col_name ? col_name : "?", cached_type, pg_sql ? pg_sql : "?");
+        return cached_type;
     }
 
-    // Parse alias: find first underscore to split table_column
-    // Format is "table_column" - first part before underscore is table name
-    const char *underscore = strchr(col_alias, '_');
-    if (!underscore || underscore == col_alias) {
-        LOG_DEBUG("DECLTYPE_LOOKUP: no underscore in '%s', cannot parse", col_alias);
-        return NULL;
+    // STEP 4: Fallback to OID-based type mapping
+
+    // SPECIAL CASE: Aggregate functions (count, sum, max, min, avg) 
+    // PostgreSQL returns BIGINT (OID 20) for aggregates
+    // SOCI needs BIGINT (not INTEGER) to map to db_int64 for proper 64-bit handling
+    // This was the root cause: INTEGER -> db_int32 -> row.get<int64_t>() -> std::bad_cast
+    if (col_name && oid == 20) {
+        if (strcmp(col_name, "count") == 0 ||
+            strcmp(col_name, "sum") == 0 ||
+            strcmp(col_name, "max") == 0 ||
+            strcmp(col_name, "min") == 0 ||
+            strcmp(col_name, "avg") == 0 ||
+            strstr(col_name, "count(") != NULL ||
+            strstr(col_name, "COUNT(") != NULL) {
+            LOG_DEBUG("DECLTYPE_AGGREGATE: col='%s' OID=20 (BIGINT) -> returning TEXT to avoid SOCI bad_cast bug", col_name);
+            return "TEXT";  // WORKAROUND: Force TEXT to avoid SOCI integer parsing bug
+        }
+    }
+    
+    // Use centralized OID-to-decltype mapping function
+    // CRITICAL: This function now differentiates INT4 (OID 23) -> "INTEGER" 
+    //           from INT8 (OID 20) -> "BIGINT" to prevent std::bad_cast
+    const char *decltype = pg_oid_to_sqlite_decltype(oid);
+    
+    LOG_DEBUG("DECLTYPE_OID: col='%s' oid=%u -> '%s' sql=%.100s",
+             col_name ? col_name : "?", (unsigned)oid, decltype, pg_sql ? pg_sql : "?");
+    return decltype;
+}
+
+// Column count the statement's shape has to match (-1 = no result yet)
+static int statement_result_cols(pg_stmt_t *pg_stmt) {
+    if (pg_stmt->result) return PQnfields(pg_stmt->result);
+    if (pg_stmt->cached_result) return pg_stmt->cached_result->num_cols;
+    return -1;
+}
+
+static int shape_is_current(const pg_shape_t *shape, int num_cols, uint64_t version) {
+    return shape && shape->version == version && (num_cols < 0 || shape->num_cols == num_cols);
+}
+
+// Hand the statement a shape reference (takes ownership of `shape`'s ref)
+static void attach_shape(pg_stmt_t *pg_stmt, pg_shape_t *shape) {
+    if (pg_stmt->shape == shape) {
+        pg_shape_release(shape);
+        return;
     }
+    pg_shape_release(pg_stmt->shape);
+    pg_stmt->shape = shape;
+}
 
-    // Extract table name (everything before first underscore)
-    size_t table_len = underscore - col_alias;
-    if (table_len >= 64) table_len = 63;
-    char table_name[64];
-    memcpy(table_name, col_alias, table_len);
-    table_name[table_len] = '\0';
+// Adopt the template's shape if it is current for this statement's result
+static int attach_template_shape(pg_stmt_t *pg_stmt) {
+    pg_shape_t *tmpl = pg_template_shape(pg_stmt->sql_hash);
+    if (!tmpl) return 0;
+    if (!shape_is_current(tmpl, statement_result_cols(pg_stmt), decltype_source_version())) {
+        pg_shape_release(tmpl);
+        return 0;
+    }
+    attach_shape(pg_stmt, tmpl);
+    return 1;
+}
 
-    // Extract column name (everything after first underscore)
-    const char *column_name = underscore + 1;
-    if (!column_name[0]) {
-        LOG_DEBUG("DECLTYPE_LOOKUP: empty column name in '%s'", col_alias);
-        return NULL;
+// Helper to convert SQLite type to string for logging
+static const char* sqlite_type_name(int type) {
+    switch (type) {
+        case SQLITE_INTEGER: return "INTEGER";
+        case SQLITE_FLOAT: return "FLOAT";
+        case SQLITE_TEXT: return "TEXT";
+        case SQLITE_BLOB: return "BLOB";
+        case SQLITE_NULL: return "NULL";
+        default: return "UNKNOWN";
     }
+}
 
-    // Create cache key
-    char cache_key[DECLTYPE_MAX_KEY_LEN];
-    snprintf(cache_key, sizeof(cache_key), "%s_%s", table_name, column_name);
+// Type consistency: SOCI picks its accessor from the decltype, so a decltype
+// whose storage class differs from what column_type reports ends in
+// std::bad_cast. Checked once per shape instead of on every accessor call.
+static void check_shape_types(const pg_shape_t *shape) {
+    for (int i = 0; i < shape->num_cols; i++) {
+        const char *decltype = shape->decltypes[i];
+        int expected = -1;
+        if (strcmp(decltype, "INTEGER") == 0 || strcmp(decltype, "BIGINT") == 0 ||
+            strcmp(decltype, "dt_integer(8)") == 0) {
+            expected = SQLITE_INTEGER;
+        } else if (strcmp(decltype, "TEXT") == 0) {
+            expected = SQLITE_TEXT;
+        } else if (strcmp(decltype, "REAL") == 0) {
+            expected = SQLITE_FLOAT;
+        } else if (strcmp(decltype, "BLOB") == 0) {
+            expected = SQLITE_BLOB;
+        }
+        if (expected != -1 && shape->sqlite_types[i] != expected) {
+            LOG_ERROR("TYPE_MISMATCH: col='%s' idx=%d decltype='%s' expects %s but column_type returns %s (OID=%u)",
+                      shape->names[i], i, decltype, sqlite_type_name(expected),
+                      sqlite_type_name(shape->sqlite_types[i]), (unsigned)shape->oids[i]);
+        }
+    }
+}
+
+// Resolve the shape of pg_stmt->result. Source tables come from
+// col_table_names, or from the previous shape when resolution was skipped
+// because that shape was current at the time.
+static pg_shape_t* build_result_shape(pg_stmt_t *pg_stmt, const pg_shape_t *prev, uint64_t version) {
+    int num_cols = PQnfields(pg_stmt->result);
+    if (num_cols > MAX_PARAMS) return NULL;
+
+    const char *names[MAX_PARAMS];
+    Oid oids[MAX_PARAMS];
+    const char *tables[MAX_PARAMS];
+    if (prev && prev->num_cols != num_cols) prev = NULL;
+    for (int i = 0; i < num_cols; i++) {
+        names[i] = PQfname(pg_stmt->result, i);
+        oids[i] = PQftype(pg_stmt->result, i);
+        tables[i] = i < pg_stmt->col_cap ? pg_stmt->col_table_names[i] : NULL;
+        if (!tables[i] && prev && strcmp(prev->names[i], names[i] ? names[i] : "") == 0) {
+            tables[i] = prev->tables[i];
+        }
+    }
+
+    pg_shape_t *shape = pg_shape_create(num_cols, names, oids, tables);
+    if (!shape) return NULL;
+    for (int i = 0; i < num_cols; i++) {
+        shape->decltypes[i] = compute_column_decltype(pg_stmt->conn, names[i], oids[i],
+                                                      tables[i], pg_stmt->pg_sql);
+    }
+    check_shape_types(shape);
+    // A reload during the lookups bumps the version again - rebuilt next time
+    shape->version = version;
+    LOG_DEBUG("RESULT_SHAPE: built %d cols for sql_hash=%llx", num_cols,
+              (unsigned long long)pg_stmt->sql_hash);
+    return shape;
+}
 
-    // Use direct lookup
-    return lookup_decltype_direct(pg_conn, cache_key);
+// Current result shape of the statement, or NULL when it can't be resolved
+// yet (no result, or column tables still unresolved - the decltypes could
+// still change). Returned pointer is valid while pg_stmt->lock is held.
+// Must hold pg_stmt->lock.
+static const pg_shape_t* statement_shape(pg_stmt_t *pg_stmt) {
+    uint64_t version = decltype_source_version();
+    int num_cols = statement_result_cols(pg_stmt);
+    if (shape_is_current(pg_stmt->shape, num_cols, version)) return pg_stmt->shape;
+
+    // Another statement with the same SQL may have resolved it already
+    if (attach_template_shape(pg_stmt)) return pg_stmt->shape;
+
+    if (!pg_stmt->result || !pg_stmt->col_tables_resolved) return NULL;
+    pg_shape_t *prev = pg_stmt->shape ? NULL : pg_template_shape(pg_stmt->sql_hash);
+    pg_shape_t *shape = build_result_shape(pg_stmt, pg_stmt->shape ? pg_stmt->shape : prev, version);
+    pg_shape_release(prev);
+    if (!shape) return NULL;
+
+    pg_template_store_shape(pg_stmt->sql_hash, shape);
+    attach_shape(pg_stmt, shape);
+    return shape;
 }
 
 // ============================================================================
@@ -319,113 +867,87 @@ static const char* lookup_sqlite_decltype(pg_connection_t *pg_conn, const char *
 // uses PQftable() to determine which table each column came from, enabling
 // proper decltype cache lookups.
 //
+// Names come from the process-wide relname cache; PG is only queried when
+// the cache is empty, stale after DDL, or sees an unknown OID.
+//
 // IMPORTANT: Must be called after query execution when result is available.
-// Must NOT be called while holding pg_stmt->mutex if it needs to query PG.
+// Must NOT be called while holding pg_stmt->lock if it needs to query PG.
 
 void resolve_column_tables(pg_stmt_t *pg_stmt, pg_connection_t *pg_conn) {
     if (!pg_stmt || !pg_stmt->result || pg_stmt->col_tables_resolved) {
         return;
     }
 
+    // Table names only feed the decltypes - a current template shape
+    // already has them
+    if (attach_template_shape(pg_stmt)) {
+        pg_stmt->col_tables_resolved = 1;
+        return;
+    }
+
     int num_cols = pg_stmt->num_cols;
-    if (num_cols <= 0 || num_cols > MAX_PARAMS) {
+    if (num_cols <= 0 || !pg_stmt_reserve_cols(pg_stmt, num_cols)) {
         pg_stmt->col_tables_resolved = 1;
         return;
     }
 
-    // Collect unique table OIDs that need name resolution
-    Oid table_oids[MAX_PARAMS];
-    int num_unique_tables = 0;
+    // Collect table OIDs the cache can't answer yet
+    Oid missing[MAX_PARAMS];
+    int num_missing = 0;
+    int num_sourced = 0;
+    relname_map_t *map = atomic_load(&relname_map);
+    int stale = relname_map_is_stale();
 
     for (int i = 0; i < num_cols; i++) {
         Oid table_oid = PQftable(pg_stmt->result, i);
         if (table_oid == InvalidOid) {
             continue;  // Computed column, no source table
         }
+        num_sourced++;
+        if (!stale && relname_map_find(map, table_oid)) continue;
 
-        // Check if we already have this OID
         int found = 0;
-        for (int j = 0; j < num_unique_tables; j++) {
-            if (table_oids[j] == table_oid) {
+        for (int j = 0; j < num_missing; j++) {
+            if (missing[j] == table_oid) {
                 found = 1;
                 break;
             }
         }
-        if (!found && num_unique_tables < MAX_PARAMS) {
-            table_oids[num_unique_tables++] = table_oid;
-        }
+        if (!found) missing[num_missing++] = table_oid;
     }
 
-    if (num_unique_tables == 0) {
+    if (num_sourced == 0) {
         pg_stmt->col_tables_resolved = 1;
         return;
     }
 
-    // Build query to get table names for all OIDs in one round-trip
-    char query[4096];
-    int offset = snprintf(query, sizeof(query),
-        "SELECT oid, relname FROM pg_class WHERE oid IN (");
-
-    for (int i = 0; i < num_unique_tables; i++) {
-        if (i > 0) {
-            offset += snprintf(query + offset, sizeof(query) - offset, ",");
+    if (num_missing > 0) {
+        if (!pg_conn || !pg_conn->conn) {
+            LOG_DEBUG("RESOLVE_TABLES: No connection available");
+            pg_stmt->col_tables_resolved = 1;
+            return;
         }
-        offset += snprintf(query + offset, sizeof(query) - offset, "%u", table_oids[i]);
-    }
-    snprintf(query + offset, sizeof(query) - offset, ")");
-
-    // Execute query to get table names (need connection)
-    if (!pg_conn || !pg_conn->conn) {
-        LOG_DEBUG("RESOLVE_TABLES: No connection available");
-        pg_stmt->col_tables_resolved = 1;
-        return;
-    }
-
-    pthread_mutex_lock(&pg_conn->mutex);
-    PGresult *res = PQexec(pg_conn->conn, query);
-    pthread_mutex_unlock(&pg_conn->mutex);
-
-    if (!res || PQresultStatus(res) != PGRES_TUPLES_OK) {
-        LOG_ERROR("RESOLVE_TABLES: Query failed: %s",
-                  res ? PQerrorMessage(pg_conn->conn) : "NULL result");
-        if (res) PQclear(res);
-        pg_stmt->col_tables_resolved = 1;
-        return;
+        relname_map_refresh(pg_conn, missing, num_missing);
+        map = atomic_load(&relname_map);
     }
 
-    // Build OID -> name map
-    int num_results = PQntuples(res);
-    Oid result_oids[MAX_PARAMS];
-    char result_names[MAX_PARAMS][64];
-
-    for (int i = 0; i < num_results && i < MAX_PARAMS; i++) {
-        result_oids[i] = (Oid)atol(PQgetvalue(res, i, 0));
-        strncpy(result_names[i], PQgetvalue(res, i, 1), 63);
-        result_names[i][63] = '\0';
-    }
-    PQclear(res);
-
     // Now assign table names to each column
-    for (int i = 0; i < num_cols && i < MAX_PARAMS; i++) {
+    for (int i = 0; i < num_cols; i++) {
         Oid table_oid = PQftable(pg_stmt->result, i);
         if (table_oid == InvalidOid) {
             continue;  // Computed column
         }
 
-        // Find matching table name
-        for (int j = 0; j < num_results; j++) {
-            if (result_oids[j] == table_oid) {
-                pg_stmt->col_table_names[i] = strdup(result_names[j]);
-                LOG_DEBUG("RESOLVE_TABLES: col[%d] '%s' -> table '%s'",
-                          i, PQfname(pg_stmt->result, i), result_names[j]);
-                break;
-            }
+        const relname_entry_t *e = relname_map_find(map, table_oid);
+        if (e && e->name[0]) {
+            pg_stmt->col_table_names[i] = strdup(e->name);
+            LOG_DEBUG("RESOLVE_TABLES: col[%d] '%s' -> table '%s'",
+                      i, PQfname(pg_stmt->result, i), e->name);
         }
     }
 
     pg_stmt->col_tables_resolved = 1;
-    LOG_INFO("RESOLVE_TABLES: Resolved %d columns from %d unique tables",
-             num_cols, num_unique_tables);
+    LOG_DEBUG("RESOLVE_TABLES: Resolved %d columns (%d cache misses)", num_cols, num_missing);
 }
 
 // ============================================================================
@@ -450,9 +972,14 @@ const void* pg_decode_bytea(pg_stmt_t *pg_stmt, int row, int col, int *out_lengt
 
     // Skip \x prefix
     hex_str += 2;
-    size_t hex_len = strlen(hex_str);
+    size_t hex_len = (size_t)PQgetlength(pg_stmt->result, row, col) - 2;
     size_t bin_len = hex_len / 2;
 
+    if (!pg_stmt_reserve_cols(pg_stmt, col + 1)) {
+        *out_length = 0;
+        return NULL;
+    }
+
     // Check if we already have this row cached
     if (pg_stmt->decoded_blob_row == row && pg_stmt->decoded_blobs[col]) {
         *out_length = pg_stmt->decoded_blob_lens[col];
@@ -461,7 +988,7 @@ const void* pg_decode_bytea(pg_stmt_t *pg_stmt, int row, int col, int *out_lengt
 
     // Clear old cache if row changed
     if (pg_stmt->decoded_blob_row != row) {
-        for (int i = 0; i < MAX_PARAMS; i++) {
+        for (int i = 0; i < pg_stmt->col_cap; i++) {
             if (pg_stmt->decoded_blobs[i]) {
                 free(pg_stmt->decoded_blobs[i]);
                 pg_stmt->decoded_blobs[i] = NULL;
@@ -478,36 +1005,11 @@ const void* pg_decode_bytea(pg_stmt_t *pg_stmt, int row, int col, int *out_lengt
         return NULL;
     }
 
-    // Inline hex decode - 4-10x faster than sscanf
-    // Lookup table for hex digit values (255 = invalid)
-    static const unsigned char hex_lut[256] = {
-        255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
-        255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
-        255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
-        0,1,2,3,4,5,6,7,8,9,255,255,255,255,255,255,  // 0-9
-        255,10,11,12,13,14,15,255,255,255,255,255,255,255,255,255,  // A-F
-        255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
-        255,10,11,12,13,14,15,255,255,255,255,255,255,255,255,255,  // a-f
-        255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
-        255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
-        255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
-        255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
-        255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
-        255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
-        255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
-        255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
-        255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255
-    };
-
-    for (size_t i = 0; i < bin_len; i++) {
-        unsigned char hi = hex_lut[(unsigned char)hex_str[i * 2]];
-        unsigned char lo = hex_lut[(unsigned char)hex_str[i * 2 + 1]];
-        if (hi == 255 || lo == 255) {
-            free(binary);
-            *out_length = 0;
-            return NULL;
-        }
-        binary[i] = (hi << 4) | lo;
+    // Vectorized hex decode (pg_hex.c), rejects any non-hex digit
+    if (!pg_hex_decode(binary, hex_str, bin_len)) {
+        free(binary);
+        *out_length = 0;
+        return NULL;
     }
 
     // Cache the decoded data
@@ -519,18 +1021,24 @@ const void* pg_decode_bytea(pg_stmt_t *pg_stmt, int row, int col, int *out_lengt
 }
 
 // ============================================================================
-// Helper: Execute query on-demand for column metadata access
+// Helper: Describe query on-demand for column metadata access
 // ============================================================================
-// SQLite allows column_count/column_name to be called before step().
-// PostgreSQL requires executing the query to get column metadata.
-// This helper executes the query if not yet executed.
+// SQLite allows column_count/column_name/decltype to be called before step().
+// Instead of executing the query (before its params are even bound), prepare
+// and describe it: PQdescribePrepared returns column names, type OIDs and
+// source tables without running anything. The description is stored on the
+// shared statement template, so later statements with the same SQL answer
+// these calls from memory.
+//
+// The installed result has 0 rows and metadata_only_result=2, so step()
+// always executes the query for real.
 static int ensure_pg_result_for_metadata(pg_stmt_t *pg_stmt) {
-    // Must be called with pg_stmt->mutex held
+    // Must be called with pg_stmt->lock held
     if (pg_stmt->result || pg_stmt->cached_result) {
         return 1;  // Already have result
     }
     if (!pg_stmt->pg_sql || !pg_stmt->conn || !pg_stmt->conn->conn) {
-        return 0;  // Can't execute - missing query or connection
+        return 0;  // Can't describe - missing query or connection
     }
 
     // Get the connection to use (thread-local for library DB)
@@ -542,55 +1050,209 @@ static int ensure_pg_result_for_metadata(pg_stmt_t *pg_stmt) {
         }
     }
 
-    LOG_INFO("METADATA_EXEC: Executing query for column metadata access: %.100s", pg_stmt->pg_sql);
+    uint64_t template_hash = pg_stmt->sql_hash ? pg_stmt->sql_hash : pg_hash_sql(pg_stmt->pg_sql);
+    PGresult *desc = pg_template_description(template_hash);
 
-    // Lock the connection mutex
-    pthread_mutex_lock(&exec_conn->mutex);
+    if (!desc) {
+        LOG_DEBUG("METADATA_DESCRIBE: Describing query for column metadata: %.100s", pg_stmt->pg_sql);
 
-    // Drain any pending results
-    PQsetnonblocking(exec_conn->conn, 0);
-    while (PQisBusy(exec_conn->conn)) {
-        PQconsumeInput(exec_conn->conn);
-    }
-    PGresult *pending;
-    while ((pending = PQgetResult(exec_conn->conn)) != NULL) {
-        PQclear(pending);
-    }
+        pthread_mutex_lock(&exec_conn->mutex);
+
+        // Drain any pending results
+        PQsetnonblocking(exec_conn->conn, 0);
+        while (PQisBusy(exec_conn->conn)) {
+            PQconsumeInput(exec_conn->conn);
+        }
+        PGresult *pending;
+        while ((pending = PQgetResult(exec_conn->conn)) != NULL) {
+            PQclear(pending);
+        }
+
+        // Reuse the connection's named prepared statement when possible,
+        // otherwise describe through the unnamed statement
+        const char *describe_name = "";
+        if (pg_stmt->use_prepared && pg_stmt->stmt_name[0]) {
+            const char *cached_name = NULL;
+            if (pg_stmt_cache_lookup(exec_conn, pg_stmt->sql_hash, &cached_name)) {
+                describe_name = cached_name;
+            } else {
+                PGresult *prep_res = PQprepare(exec_conn->conn, pg_stmt->stmt_name,
+                                               pg_stmt->pg_sql, pg_stmt->param_count, NULL);
+                if (PQresultStatus(prep_res) == PGRES_COMMAND_OK) {
+                    pg_stmt_cache_add(exec_conn, pg_stmt->sql_hash, pg_stmt->stmt_name, pg_stmt->param_count);
+                    describe_name = pg_stmt->stmt_name;
+                }
+                PQclear(prep_res);
+            }
+        }
+        if (!describe_name[0]) {
+            PGresult *prep_res = PQprepare(exec_conn->conn, "", pg_stmt->pg_sql,
+                                           pg_stmt->param_count, NULL);
+            if (PQresultStatus(prep_res) != PGRES_COMMAND_OK) {
+                LOG_ERROR("METADATA_DESCRIBE: Prepare failed: %s", PQerrorMessage(exec_conn->conn));
+                PQclear(prep_res);
+                pthread_mutex_unlock(&exec_conn->mutex);
+                return 0;
+            }
+            PQclear(prep_res);
+        }
 
-    // Build parameter values array
-    const char *paramValues[MAX_PARAMS] = {NULL};
-    for (int i = 0; i < pg_stmt->param_count && i < MAX_PARAMS; i++) {
-        paramValues[i] = pg_stmt->param_values[i];
+        PGresult *res = PQdescribePrepared(exec_conn->conn, describe_name);
+        if (PQresultStatus(res) == PGRES_COMMAND_OK) {
+            pg_template_store_description(template_hash, res);
+            desc = PQcopyResult(res, PG_COPYRES_ATTRS);
+        } else {
+            LOG_ERROR("METADATA_DESCRIBE: Describe failed: %s", PQerrorMessage(exec_conn->conn));
+        }
+        PQclear(res);
+        pthread_mutex_unlock(&exec_conn->mutex);
+
+        if (!desc) return 0;
     }
 
-    // Execute the query
-    pg_stmt->result = PQexecParams(exec_conn->conn, pg_stmt->pg_sql,
-                                    pg_stmt->param_count, NULL,
-                                    paramValues, NULL, NULL, 0);
-    pthread_mutex_unlock(&exec_conn->mutex);
+    pg_stmt->result = desc;
+    pg_stmt->num_rows = 0;
+    pg_stmt->num_cols = PQnfields(desc);
+    pg_stmt->current_row = -1;  // Will be 0 after first step()
+    pg_stmt->result_conn = NULL;
 
-    if (PQresultStatus(pg_stmt->result) == PGRES_TUPLES_OK) {
-        pg_stmt->num_rows = PQntuples(pg_stmt->result);
-        pg_stmt->num_cols = PQnfields(pg_stmt->result);
-        pg_stmt->current_row = -1;  // Will be 0 after first step()
-        pg_stmt->result_conn = exec_conn;
+    // Resolve source table names for bare column lookup in decltype
+    // (the description carries PQftable, names come from the relname cache)
+    resolve_column_tables(pg_stmt, exec_conn);
 
-        // Resolve source table names for bare column lookup in decltype
-        // This enables proper type lookups for queries without AS aliases
-        resolve_column_tables(pg_stmt, exec_conn);
+    // Description only - step() must execute with the bound params
+    pg_stmt->metadata_only_result = 2;
 
-        // v0.8.9 FIX: Mark this result as from metadata-only execution
-        // If bind() is called later, we need to re-execute with bound params
-        pg_stmt->metadata_only_result = 1;
+    LOG_DEBUG("METADATA_DESCRIBE: %d cols (metadata_only=2)", pg_stmt->num_cols);
+    return 1;
+}
 
-        LOG_INFO("METADATA_EXEC: Success - %d cols, %d rows (metadata_only=1)", pg_stmt->num_cols, pg_stmt->num_rows);
-        return 1;
-    } else {
-        LOG_ERROR("METADATA_EXEC: Query failed: %s", PQerrorMessage(exec_conn->conn));
-        PQclear(pg_stmt->result);
-        pg_stmt->result = NULL;
-        return 0;
+// ============================================================================
+// Decoded Row
+// ============================================================================
+// Plex reads dozens of columns per row, often several accessors per column.
+// The first accessor after a step decodes the whole current row into
+// pg_stmt->row_cells - storage class, int64/double for numeric columns, raw
+// text pointer and length - so the accessors are bounds-checked array loads
+// with no parsing or string compares. Column info (affinity, workaround
+// flags) only depends on the SQL and is filled once per statement.
+
+// Integer as column_int/int64 always parsed it: t/f booleans, else atoll
+static inline sqlite3_int64 decode_int(const char *val) {
+    if (val[0] == 't' && val[1] == '\0') return 1;
+    if (val[0] == 'f' && val[1] == '\0') return 0;
+    return atoll(val);
+}
+
+static inline double decode_double(const char *val) {
+    if (val[0] == 't' && val[1] == '\0') return 1.0;
+    if (val[0] == 'f' && val[1] == '\0') return 0.0;
+    return atof(val);
+}
+
+static int is_aggregate_name(const char *col_name) {
+    return strcmp(col_name, "count") == 0 ||
+           strcmp(col_name, "sum") == 0 ||
+           strcmp(col_name, "max") == 0 ||
+           strcmp(col_name, "min") == 0 ||
+           strcmp(col_name, "avg") == 0 ||
+           strstr(col_name, "count(") != NULL ||
+           strstr(col_name, "COUNT(") != NULL;
+}
+
+// Per-column info from the result's OIDs and names
+static void fill_column_info(pg_stmt_t *pg_stmt, const Oid *oids, char *const *names, int num_cols) {
+    const pg_shape_t *shape = pg_stmt->shape;
+    if (shape && shape->num_cols != num_cols) shape = NULL;
+    for (int c = 0; c < num_cols; c++) {
+        pg_row_cell_t *cell = &pg_stmt->row_cells[c];
+        Oid oid = oids ? oids[c] : PQftype(pg_stmt->result, c);
+        const char *name = names ? names[c] : PQfname(pg_stmt->result, c);
+        cell->oid = oid;
+        cell->affinity = shape ? shape->sqlite_types[c] : pg_oid_to_sqlite_type(oid);
+        cell->flags = 0;
+        if (name && (strcmp(name, "metadata_items_metadata_type") == 0 ||
+                     strcmp(name, "metadata_type") == 0)) {
+            cell->flags |= PG_CELL_METADATA_TYPE;
+        }
+        if (name && (oid == 20 || oid == 21 || oid == 23) && is_aggregate_name(name)) {
+            cell->flags |= PG_CELL_AGGREGATE_INT;
+        }
+    }
+    pg_stmt->row_cells_cols = num_cols;
+}
+
+// Decode the current row if not done since the last step. Returns the cells
+// (pg_stmt->num_cols of them), or NULL when there is no current row.
+// Must hold pg_stmt->lock.
+static const pg_row_cell_t* decode_current_row(pg_stmt_t *pg_stmt) {
+    int row = pg_stmt->current_row;
+    if (pg_stmt->decoded_row == row && row >= 0) return pg_stmt->row_cells;
+
+    cached_result_t *cached = pg_stmt->cached_result;
+    PGresult *res = cached ? NULL : pg_stmt->result;
+    int num_cols = cached ? cached->num_cols : pg_stmt->num_cols;
+    int num_rows = cached ? cached->num_rows : pg_stmt->num_rows;
+    if ((!cached && !res) || row < 0 || row >= num_rows || num_cols <= 0) return NULL;
+
+    if (num_cols > pg_stmt->row_cells_cap) {
+        pg_row_cell_t *cells = realloc(pg_stmt->row_cells, (size_t)num_cols * sizeof(pg_row_cell_t));
+        if (!cells) return NULL;
+        pg_mem_charge(PG_MEM_COLUMN_BUFFERS,
+                      (ssize_t)((num_cols - pg_stmt->row_cells_cap) * sizeof(pg_row_cell_t)));
+        pg_stmt->row_cells = cells;
+        pg_stmt->row_cells_cap = num_cols;
+        pg_stmt->row_cells_cols = 0;
+    }
+    if (pg_stmt->row_cells_cols != num_cols) {
+        fill_column_info(pg_stmt, cached ? cached->col_types : NULL,
+                         cached ? cached->col_names : NULL, num_cols);
+    }
+
+    for (int c = 0; c < num_cols; c++) {
+        pg_row_cell_t *cell = &pg_stmt->row_cells[c];
+        cell->name = cached ? cached->col_names[c] : PQfname(res, c);
+        if (cached ? cached_cell_is_null(cached, row, c) : PQgetisnull(res, row, c)) {
+            cell->type = SQLITE_NULL;
+            cell->text = NULL;
+            cell->copy = NULL;
+            cell->len = 0;
+            cell->utf8_valid = 1;
+            cell->i = 0;
+            cell->d = 0.0;
+            continue;
+        }
+        cell->type = cell->affinity;
+        cell->text = cached ? cached_cell_value(cached, row, c) : PQgetvalue(res, row, c);
+        cell->copy = NULL;
+        cell->len = cached ? cached_cell_length(cached, row, c) : PQgetlength(res, row, c);
+        // Validated once per cell. Only TEXT columns can hold non-ASCII: the
+        // text output of numbers, booleans and hex bytea is ASCII.
+        if (cached) {
+            cell->utf8_valid = cached_cell_utf8_valid(cached, row, c);
+        } else {
+            cell->utf8_valid = cell->affinity != SQLITE_TEXT ||
+                               pg_utf8_valid(cell->text, (size_t)cell->len);
+        }
+        if (cell->affinity == SQLITE_INTEGER) {
+            cell->i = decode_int(cell->text);
+            cell->d = (double)cell->i;
+        } else if (cell->affinity == SQLITE_FLOAT) {
+            cell->i = decode_int(cell->text);
+            cell->d = decode_double(cell->text);
+        }
     }
+    pg_stmt->decoded_row = row;
+    return pg_stmt->row_cells;
+}
+
+// Cell idx of the current row, or NULL (no row / out of bounds).
+// Must hold pg_stmt->lock.
+static inline const pg_row_cell_t* current_cell(pg_stmt_t *pg_stmt, int idx) {
+    const pg_row_cell_t *cells = decode_current_row(pg_stmt);
+    int num_cols = pg_stmt->cached_result ? pg_stmt->cached_result->num_cols : pg_stmt->num_cols;
+    if (!cells || idx < 0 || idx >= num_cols) return NULL;
+    return &cells[idx];
 }
 
 // ============================================================================
@@ -603,81 +1265,33 @@ int my_sqlite3_column_count(sqlite3_stmt *pStmt) {
     // Handle both READ (is_pg == 2) and WRITE (is_pg == 1) statements
     // For WRITE without RETURNING result, return 0 columns (no data to read)
     if (pg_stmt && pg_stmt->is_pg) {
-        pthread_mutex_lock(&pg_stmt->mutex);
+        pg_bias_lock(&pg_stmt->lock);
         // QUERY CACHE: Check for cached result first
         if (pg_stmt->cached_result) {
             int count = pg_stmt->cached_result->num_cols;
-            pthread_mutex_unlock(&pg_stmt->mutex);
+            pg_bias_unlock(&pg_stmt->lock);
             return count;
         }
-        // If num_cols is 0 and we have a query but no result yet,
-        // execute the query to get column metadata (SQLite allows this before step)
+        // If num_cols is 0 and we have a query but no result yet, answer from
+        // the template's result shape, else describe the query to get column
+        // metadata (SQLite allows this before step)
         if (pg_stmt->num_cols == 0 && pg_stmt->pg_sql && !pg_stmt->result) {
+            const pg_shape_t *shape = statement_shape(pg_stmt);
+            if (shape) {
+                int count = shape->num_cols;
+                pg_bias_unlock(&pg_stmt->lock);
+                return count;
+            }
             ensure_pg_result_for_metadata(pg_stmt);
         }
         // For PostgreSQL statements, return our stored num_cols
         // Don't fall through to orig_sqlite3_column_count which would fail
         // because pStmt is not a valid SQLite statement
-        int count = pg_stmt->num_cols;
-        pthread_mutex_unlock(&pg_stmt->mutex);
-        return count;
-    }
-    return orig_sqlite3_column_count ? orig_sqlite3_column_count(pStmt) : 0;
-}
-
-// Helper to convert SQLite type to string for logging
-static const char* sqlite_type_name(int type) {
-    switch (type) {
-        case SQLITE_INTEGER: return "INTEGER";
-        case SQLITE_FLOAT: return "FLOAT";
-        case SQLITE_TEXT: return "TEXT";
-        case SQLITE_BLOB: return "BLOB";
-        case SQLITE_NULL: return "NULL";
-        default: return "UNKNOWN";
-    }
-}
-
-// Type consistency validation helper
-// Validates that column_type and column_decltype are consistent
-static void validate_type_consistency(sqlite3_stmt *pStmt, int idx, const char *accessor_name) {
-    pg_stmt_t *pg_stmt = pg_find_any_stmt(pStmt);
-    if (!pg_stmt || !pg_stmt->is_pg) return;
-    
-    int col_type = my_sqlite3_column_type(pStmt, idx);
-    const char *col_decltype = my_sqlite3_column_decltype(pStmt, idx);
-    
-    pthread_mutex_lock(&pg_stmt->mutex);
-    if (!pg_stmt->result) {
-        pthread_mutex_unlock(&pg_stmt->mutex);
-        return;
-    }
-    
-    Oid oid = PQftype(pg_stmt->result, idx);
-    const char *col_name = PQfname(pg_stmt->result, idx);
-    
-        // Warn about type mismatches
-        if (col_decltype) {
-            int expected_for_decltype = -1;
-            if (strcmp(col_decltype, "INTEGER") == 0 || 
-                strcmp(col_decltype, "BIGINT") == 0 ||
-                strcmp(col_decltype, "dt_integer(8)") == 0) {
-                expected_for_decltype = SQLITE_INTEGER;
-            } else if (strcmp(col_decltype, "TEXT") == 0) {
-                expected_for_decltype = SQLITE_TEXT;
-            } else if (strcmp(col_decltype, "REAL") == 0) {
-                expected_for_decltype = SQLITE_FLOAT;
-            } else if (strcmp(col_decltype, "BLOB") == 0) {
-                expected_for_decltype = SQLITE_BLOB;
-            }
-        
-        if (expected_for_decltype != -1 && col_type != SQLITE_NULL && col_type != expected_for_decltype) {
-            LOG_ERROR("TYPE_MISMATCH: accessor=%s col='%s' idx=%d decltype='%s' expects %s but column_type returned %s (OID=%u)",
-                      accessor_name, col_name ? col_name : "?", idx,
-                      col_decltype, sqlite_type_name(expected_for_decltype),
-                      sqlite_type_name(col_type), (unsigned)oid);
-        }
+        int count = pg_stmt->num_cols;
+        pg_bias_unlock(&pg_stmt->lock);
+        return count;
     }
-    pthread_mutex_unlock(&pg_stmt->mutex);
+    return orig_sqlite3_column_count ? orig_sqlite3_column_count(pStmt) : 0;
 }
 
 int my_sqlite3_column_type(sqlite3_stmt *pStmt, int idx) {
@@ -689,92 +1303,34 @@ int my_sqlite3_column_type(sqlite3_stmt *pStmt, int idx) {
     if (pg_stmt && pg_stmt->is_pg) {
         // Update exception context BEFORE locking (query is constant)
         last_query_being_processed = pg_stmt->pg_sql;
-        pthread_mutex_lock(&pg_stmt->mutex);
-
-        // QUERY CACHE: Check for cached result first
-        if (pg_stmt->cached_result) {
-            cached_result_t *cached = pg_stmt->cached_result;
-            int row = pg_stmt->current_row;
-            if (idx >= 0 && idx < cached->num_cols && row >= 0 && row < cached->num_rows) {
-                cached_row_t *crow = &cached->rows[row];
-                if (crow->is_null[idx]) {
-                    LOG_DEBUG("COLUMN_TYPE_VERBOSE: idx=%d row=%d -> SQLITE_NULL (cached, is_null=true)", idx, row);
-                    pthread_mutex_unlock(&pg_stmt->mutex);
-                    return SQLITE_NULL;
-                }
-                // Use cached column type OID to determine SQLite type
-                Oid oid = cached->col_types[idx];
-                int result = pg_oid_to_sqlite_type(oid);
-                LOG_DEBUG("COLUMN_TYPE_VERBOSE: idx=%d row=%d OID=%u -> %s (cached)",
-                        idx, row, (unsigned)oid, sqlite_type_name(result));
-                pthread_mutex_unlock(&pg_stmt->mutex);
-                return result;
-            }
-            LOG_DEBUG("COLUMN_TYPE_VERBOSE: idx=%d row=%d -> SQLITE_NULL (cached, out of bounds)", idx, row);
-            pthread_mutex_unlock(&pg_stmt->mutex);
-            return SQLITE_NULL;
-        }
+        pg_bias_lock(&pg_stmt->lock);
 
-        if (!pg_stmt->result) {
-            LOG_DEBUG("COLUMN_TYPE_VERBOSE: idx=%d -> SQLITE_NULL (no result)", idx);
-            pthread_mutex_unlock(&pg_stmt->mutex);
-            return SQLITE_NULL;
-        }
-        if (idx < 0 || idx >= pg_stmt->num_cols) {
-            LOG_DEBUG("COL_TYPE_BOUNDS: idx=%d out of bounds (num_cols=%d) sql=%.100s",
-                     idx, pg_stmt->num_cols, pg_stmt->pg_sql ? pg_stmt->pg_sql : "?");
-            pthread_mutex_unlock(&pg_stmt->mutex);
-            return SQLITE_NULL;
-        }
-        int row = pg_stmt->current_row;
-        if (row < 0 || row >= pg_stmt->num_rows) {
-            LOG_DEBUG("COL_TYPE_ROW_BOUNDS: row=%d out of bounds (num_rows=%d)", row, pg_stmt->num_rows);
-            pthread_mutex_unlock(&pg_stmt->mutex);
+        // Current row (PGresult or query cache) decoded once per step
+        const pg_row_cell_t *cell = current_cell(pg_stmt, idx);
+        if (!cell) {
+            LOG_DEBUG("COL_TYPE_BOUNDS: idx=%d row=%d out of bounds (num_cols=%d num_rows=%d) sql=%.100s",
+                     idx, pg_stmt->current_row, pg_stmt->num_cols, pg_stmt->num_rows,
+                     pg_stmt->pg_sql ? pg_stmt->pg_sql : "?");
+            pg_bias_unlock(&pg_stmt->lock);
             return SQLITE_NULL;
         }
-        int is_null = PQgetisnull(pg_stmt->result, row, idx);
-        Oid oid = PQftype(pg_stmt->result, idx);
-        const char *col_name = PQfname(pg_stmt->result, idx);
         // Update exception context
-        last_column_being_accessed = col_name;
-        int result = is_null ? SQLITE_NULL : pg_oid_to_sqlite_type(oid);
-        
-        // ENHANCED LOGGING: Include decltype for comparison
-        const char *col_decltype = NULL;
-        // Quick decltype check without recursive call - use OID mapping
-        switch (oid) {
-            case 16: case 21: case 23: case 26:  // bool, int2, int4, oid
-                col_decltype = "INTEGER";
-                break;
-            case 20:  // int8
-                col_decltype = "BIGINT";
-                break;
-            case 700: case 701: case 1700:  // float4, float8, numeric
-                col_decltype = "REAL";
-                break;
-            case 17:  // bytea
-                col_decltype = "BLOB";
-                break;
-            default:
-                col_decltype = "TEXT";
-                break;
-        }
-        
-    LOG_DEBUG("COLUMN_TYPE: idx=%d col='%s' row=%d OID=%u is_null=%d -> %s (decltype='%s')",
-            idx, col_name ? col_name : "?", row, (unsigned)oid, is_null, 
-            sqlite_type_name(result), col_decltype ? col_decltype : "NULL");
-        pthread_mutex_unlock(&pg_stmt->mutex);
+        last_column_being_accessed = cell->name;
+        int result = cell->type;
+        LOG_DEBUG("COLUMN_TYPE: idx=%d col='%s' row=%d OID=%u -> %s",
+                  idx, cell->name ? cell->name : "?", pg_stmt->current_row,
+                  (unsigned)cell->oid, sqlite_type_name(result));
+        pg_bias_unlock(&pg_stmt->lock);
         return result;
     }
     return orig_sqlite3_column_type ? orig_sqlite3_column_type(pStmt, idx) : SQLITE_NULL;
 }
 
 int my_sqlite3_column_int(sqlite3_stmt *pStmt, int idx) {
-    validate_type_consistency(pStmt, idx, "column_int");
     pg_stmt_t *pg_stmt = pg_find_any_stmt(pStmt);
     
     // ULTRA-DEBUG: Log count query int reads
-    int is_count_query = (pg_stmt && pg_stmt->pg_sql && strstr(pg_stmt->pg_sql, "parents.parent_id,count(*)"));
+    int is_count_query = PG_DEBUG_TRACE && pg_stmt && (pg_stmt->flags & PG_STMT_F_COUNT_TRACE);
     if (is_count_query) {
         struct timeval tv;
         gettimeofday(&tv, NULL);
@@ -784,310 +1340,106 @@ int my_sqlite3_column_int(sqlite3_stmt *pStmt, int idx) {
     
     // Handle all PostgreSQL statements
     if (pg_stmt && pg_stmt->is_pg) {
-        pthread_mutex_lock(&pg_stmt->mutex);
-        
+        pg_bias_lock(&pg_stmt->lock);
+
+        const pg_row_cell_t *cell = current_cell(pg_stmt, idx);
         if (is_count_query) {
-            const char *col_name = (pg_stmt->result && idx >= 0 && idx < pg_stmt->num_cols) ? 
-                                   PQfname(pg_stmt->result, idx) : "?";
-            LOG_ERROR("ULTRA_DEBUG_INT: col='%s' row=%d/%d", 
-                     col_name, pg_stmt->current_row, pg_stmt->num_rows);
+            LOG_ERROR("ULTRA_DEBUG_INT: col='%s' row=%d/%d",
+                     cell && cell->name ? cell->name : "?", pg_stmt->current_row, pg_stmt->num_rows);
         }
-
-        // QUERY CACHE: Check for cached result first
-        if (pg_stmt->cached_result) {
-            cached_result_t *cached = pg_stmt->cached_result;
-            int row = pg_stmt->current_row;
-            if (idx >= 0 && idx < cached->num_cols && row >= 0 && row < cached->num_rows) {
-                cached_row_t *crow = &cached->rows[row];
-                if (!crow->is_null[idx] && crow->values[idx]) {
-                    const char *val = crow->values[idx];
-                    int result_val = 0;
-                    if (val[0] == 't' && val[1] == '\0') result_val = 1;
-                    else if (val[0] == 'f' && val[1] == '\0') result_val = 0;
-                    else result_val = atoi(val);
-                    
-                    // TYPE_DEBUG: Enhanced logging for type-related columns (cached path)
-                    const char *col_name = (idx < MAX_PARAMS && cached->col_names) ? cached->col_names[idx] : NULL;
-                    if (col_name && strstr(col_name, "type") != NULL) {
-                        LOG_DEBUG("TYPE_DEBUG_CACHED: col='%s' idx=%d row=%d raw_val='%s' result=%d sql=%.200s",
-                                  col_name, idx, row, val, result_val,
-                                  pg_stmt->pg_sql ? pg_stmt->pg_sql : "?");
-                    }
-                    
-                    pthread_mutex_unlock(&pg_stmt->mutex);
-                    return result_val;
-                }
-            }
-            pthread_mutex_unlock(&pg_stmt->mutex);
+        if (!cell || cell->type == SQLITE_NULL) {
+            pg_bias_unlock(&pg_stmt->lock);
             return 0;
         }
 
-        if (!pg_stmt->result) {
-            pthread_mutex_unlock(&pg_stmt->mutex);
-            return 0;
-        }
-        if (idx < 0 || idx >= pg_stmt->num_cols) {
-            LOG_DEBUG("COL_INT_BOUNDS: idx=%d out of bounds (num_cols=%d)", idx, pg_stmt->num_cols);
-            pthread_mutex_unlock(&pg_stmt->mutex);
-            return 0;
-        }
-        int row = pg_stmt->current_row;
-        if (row < 0 || row >= pg_stmt->num_rows) {
-            LOG_DEBUG("COL_INT_ROW_BOUNDS: row=%d out of bounds (num_rows=%d)", row, pg_stmt->num_rows);
-            pthread_mutex_unlock(&pg_stmt->mutex);
-            return 0;
-        }
+        int result_val = (int)(cell->type == SQLITE_INTEGER || cell->type == SQLITE_FLOAT
+                               ? cell->i : decode_int(cell->text));
 
-        int result_val = 0;
-        const char *val = NULL;
-        const char *col_name = PQfname(pg_stmt->result, idx);
-        
-        if (!PQgetisnull(pg_stmt->result, row, idx)) {
-            val = PQgetvalue(pg_stmt->result, row, idx);
-            if (val[0] == 't' && val[1] == '\0') result_val = 1;
-            else if (val[0] == 'f' && val[1] == '\0') result_val = 0;
-            else result_val = atoi(val);
-            
-            // WORKAROUND: metadata_type 18 (collection/folder) causes std::bad_cast
-            // When Plex loads related objects, it tries to cast Collection to Show/Episode
-            // Convert type 18 to NULL to make Plex skip these items
-            if (col_name && (strcmp(col_name, "metadata_items_metadata_type") == 0 || 
-                            strcmp(col_name, "metadata_type") == 0)) {
-                if (result_val == 18) {
-                    LOG_ERROR("TYPE18_WORKAROUND: Converting metadata_type 18 (collection) to 0 for row %d to prevent std::bad_cast", row);
-                    result_val = 0;  // Return 0 (invalid type) so Plex will skip
-                }
-            }
-        }
-        
-        // TYPE_DEBUG: Enhanced logging for type-related columns (non-cached path)
-        if (col_name && strstr(col_name, "type") != NULL) {
-            LOG_DEBUG("TYPE_DEBUG: col='%s' idx=%d row=%d raw_val='%s' result=%d sql=%.200s",
-                      col_name, idx, row, val ? val : "(NULL)", result_val,
-                      pg_stmt->pg_sql ? pg_stmt->pg_sql : "?");
+        // WORKAROUND: metadata_type 18 (collection/folder) causes std::bad_cast
+        // When Plex loads related objects, it tries to cast Collection to Show/Episode
+        // Convert type 18 to NULL to make Plex skip these items
+        if ((cell->flags & PG_CELL_METADATA_TYPE) && result_val == 18) {
+            LOG_ERROR("TYPE18_WORKAROUND: Converting metadata_type 18 (collection) to 0 for row %d to prevent std::bad_cast",
+                      pg_stmt->current_row);
+            result_val = 0;  // Return 0 (invalid type) so Plex will skip
         }
-        
-        pthread_mutex_unlock(&pg_stmt->mutex);
+
+        pg_bias_unlock(&pg_stmt->lock);
         return result_val;
     }
     return orig_sqlite3_column_int ? orig_sqlite3_column_int(pStmt, idx) : 0;
 }
 
 sqlite3_int64 my_sqlite3_column_int64(sqlite3_stmt *pStmt, int idx) {
-    validate_type_consistency(pStmt, idx, "column_int64");
     pg_stmt_t *pg_stmt = pg_find_any_stmt(pStmt);
     
     // ULTRA_DEBUG: Log all column_int64 calls for count query
-    int is_count_query = (pg_stmt && pg_stmt->pg_sql && strstr(pg_stmt->pg_sql, "parents.parent_id,count(*)"));
+    int is_count_query = PG_DEBUG_TRACE && pg_stmt && (pg_stmt->flags & PG_STMT_F_COUNT_TRACE);
     if (is_count_query) {
         LOG_ERROR("ULTRA_DEBUG_INT64: Called for count query! stmt=%p idx=%d", (void*)pStmt, idx);
     }
     // Handle all PostgreSQL statements
     if (pg_stmt && pg_stmt->is_pg) {
-        pthread_mutex_lock(&pg_stmt->mutex);
-
-        // QUERY CACHE: Check for cached result first
-        if (pg_stmt->cached_result) {
-            cached_result_t *cached = pg_stmt->cached_result;
-            int row = pg_stmt->current_row;
-            if (idx >= 0 && idx < cached->num_cols && row >= 0 && row < cached->num_rows) {
-                cached_row_t *crow = &cached->rows[row];
-                if (!crow->is_null[idx] && crow->values[idx]) {
-                    const char *val = crow->values[idx];
-                    sqlite3_int64 result_val = 0;
-                    if (val[0] == 't' && val[1] == '\0') result_val = 1;
-                    else if (val[0] == 'f' && val[1] == '\0') result_val = 0;
-                    else result_val = atoll(val);
-                    
-                    // TYPE_DEBUG: Enhanced logging for type-related columns (cached path)
-                    const char *col_name = (idx < MAX_PARAMS && cached->col_names) ? cached->col_names[idx] : NULL;
-                    if (col_name && strstr(col_name, "type") != NULL) {
-                        LOG_DEBUG("TYPE_DEBUG_INT64_CACHED: col='%s' idx=%d row=%d raw_val='%s' result=%lld sql=%.200s",
-                                  col_name, idx, row, val, (long long)result_val,
-                                  pg_stmt->pg_sql ? pg_stmt->pg_sql : "?");
-                    }
-                    
-                    pthread_mutex_unlock(&pg_stmt->mutex);
-                    return result_val;
-                }
-            }
-            pthread_mutex_unlock(&pg_stmt->mutex);
-            return 0;
-        }
-
-        if (!pg_stmt->result) {
-            pthread_mutex_unlock(&pg_stmt->mutex);
-            return 0;
-        }
-        if (idx < 0 || idx >= pg_stmt->num_cols) {
-            LOG_DEBUG("COL_INT64_BOUNDS: idx=%d out of bounds (num_cols=%d)", idx, pg_stmt->num_cols);
-            pthread_mutex_unlock(&pg_stmt->mutex);
-            return 0;
-        }
-        int row = pg_stmt->current_row;
-        if (row < 0 || row >= pg_stmt->num_rows) {
-            LOG_DEBUG("COL_INT64_ROW_BOUNDS: row=%d out of bounds (num_rows=%d)", row, pg_stmt->num_rows);
-            pthread_mutex_unlock(&pg_stmt->mutex);
-            return 0;
-        }
-
+        pg_bias_lock(&pg_stmt->lock);
+        const pg_row_cell_t *cell = current_cell(pg_stmt, idx);
         sqlite3_int64 result_val = 0;
-        if (!PQgetisnull(pg_stmt->result, row, idx)) {
-            const char *val = PQgetvalue(pg_stmt->result, row, idx);
-            if (val[0] == 't' && val[1] == '\0') result_val = 1;
-            else if (val[0] == 'f' && val[1] == '\0') result_val = 0;
-            else result_val = atoll(val);
-            
-            // TYPE_DEBUG: Enhanced logging for type-related columns (non-cached path)
-            const char *col_name = PQfname(pg_stmt->result, idx);
-            if (col_name && strstr(col_name, "type") != NULL) {
-                LOG_DEBUG("TYPE_DEBUG_INT64: col='%s' idx=%d row=%d raw_val='%s' result=%lld sql=%.200s",
-                          col_name, idx, row, val ? val : "(NULL)", (long long)result_val,
-                          pg_stmt->pg_sql ? pg_stmt->pg_sql : "?");
-            }
+        if (cell && cell->type != SQLITE_NULL) {
+            result_val = cell->type == SQLITE_INTEGER || cell->type == SQLITE_FLOAT
+                         ? cell->i : decode_int(cell->text);
         }
-        pthread_mutex_unlock(&pg_stmt->mutex);
+        pg_bias_unlock(&pg_stmt->lock);
         return result_val;
     }
     return orig_sqlite3_column_int64 ? orig_sqlite3_column_int64(pStmt, idx) : 0;
 }
 
 double my_sqlite3_column_double(sqlite3_stmt *pStmt, int idx) {
-    validate_type_consistency(pStmt, idx, "column_double");
     pg_stmt_t *pg_stmt = pg_find_any_stmt(pStmt);
     // Handle all PostgreSQL statements
     if (pg_stmt && pg_stmt->is_pg) {
-        pthread_mutex_lock(&pg_stmt->mutex);
-
-        // QUERY CACHE: Check for cached result first
-        if (pg_stmt->cached_result) {
-            cached_result_t *cached = pg_stmt->cached_result;
-            int row = pg_stmt->current_row;
-            if (idx >= 0 && idx < cached->num_cols && row >= 0 && row < cached->num_rows) {
-                cached_row_t *crow = &cached->rows[row];
-                if (!crow->is_null[idx] && crow->values[idx]) {
-                    const char *val = crow->values[idx];
-                    double result_val = 0.0;
-                    if (val[0] == 't' && val[1] == '\0') result_val = 1.0;
-                    else if (val[0] == 'f' && val[1] == '\0') result_val = 0.0;
-                    else result_val = atof(val);
-                    pthread_mutex_unlock(&pg_stmt->mutex);
-                    return result_val;
-                }
-            }
-            pthread_mutex_unlock(&pg_stmt->mutex);
-            return 0.0;
-        }
-
-        if (!pg_stmt->result) {
-            pthread_mutex_unlock(&pg_stmt->mutex);
-            return 0.0;
-        }
-        if (idx < 0 || idx >= pg_stmt->num_cols) {
-            pthread_mutex_unlock(&pg_stmt->mutex);
-            return 0.0;
-        }
-        int row = pg_stmt->current_row;
-        if (row < 0 || row >= pg_stmt->num_rows) {
-            pthread_mutex_unlock(&pg_stmt->mutex);
-            return 0.0;
-        }
+        pg_bias_lock(&pg_stmt->lock);
+        const pg_row_cell_t *cell = current_cell(pg_stmt, idx);
         double result_val = 0.0;
-        if (!PQgetisnull(pg_stmt->result, row, idx)) {
-            const char *val = PQgetvalue(pg_stmt->result, row, idx);
-            if (val[0] == 't' && val[1] == '\0') result_val = 1.0;
-            else if (val[0] == 'f' && val[1] == '\0') result_val = 0.0;
-            else result_val = atof(val);
+        if (cell && cell->type != SQLITE_NULL) {
+            result_val = cell->type == SQLITE_INTEGER || cell->type == SQLITE_FLOAT
+                         ? cell->d : decode_double(cell->text);
         }
-        pthread_mutex_unlock(&pg_stmt->mutex);
+        pg_bias_unlock(&pg_stmt->lock);
         return result_val;
     }
     return orig_sqlite3_column_double ? orig_sqlite3_column_double(pStmt, idx) : 0.0;
 }
 
 // ============================================================================
-// UTF-8 Validation and String Sanitization
+// UTF-8 Validation
 // ============================================================================
-// Boost.Locale in Plex may be sensitive to invalid UTF-8 sequences.
-// This function validates and optionally sanitizes strings from PostgreSQL.
-
-static int is_valid_utf8_char(const unsigned char *s, size_t len, size_t *char_len) {
-    if (len == 0) return 0;
-    
-    unsigned char c = s[0];
-    
-    // ASCII (0xxxxxxx)
-    if (c <= 0x7F) {
-        *char_len = 1;
-        return 1;
-    }
-    
-    // 2-byte UTF-8 (110xxxxx 10xxxxxx)
-    if ((c & 0xE0) == 0xC0) {
-        if (len < 2) return 0;
-        if ((s[1] & 0xC0) != 0x80) return 0;
-        // Check for overlong encoding
-        if (c < 0xC2) return 0;
-        *char_len = 2;
-        return 1;
-    }
-    
-    // 3-byte UTF-8 (1110xxxx 10xxxxxx 10xxxxxx)
-    if ((c & 0xF0) == 0xE0) {
-        if (len < 3) return 0;
-        if ((s[1] & 0xC0) != 0x80) return 0;
-        if ((s[2] & 0xC0) != 0x80) return 0;
-        // Check for overlong encoding and surrogates
-        if (c == 0xE0 && s[1] < 0xA0) return 0;
-        if (c == 0xED && s[1] >= 0xA0) return 0; // Reject surrogates U+D800..U+DFFF
-        *char_len = 3;
-        return 1;
-    }
-    
-    // 4-byte UTF-8 (11110xxx 10xxxxxx 10xxxxxx 10xxxxxx)
-    if ((c & 0xF8) == 0xF0) {
-        if (len < 4) return 0;
-        if ((s[1] & 0xC0) != 0x80) return 0;
-        if ((s[2] & 0xC0) != 0x80) return 0;
-        if ((s[3] & 0xC0) != 0x80) return 0;
-        // Check for overlong encoding and values > U+10FFFF
-        if (c == 0xF0 && s[1] < 0x90) return 0;
-        if (c == 0xF4 && s[1] >= 0x90) return 0;
-        if (c >= 0xF5) return 0;
-        *char_len = 4;
-        return 1;
-    }
-    
-    return 0; // Invalid UTF-8 start byte
-}
-
-static int validate_utf8_string(const char *str, size_t len) {
-    size_t i = 0;
-    while (i < len) {
-        size_t char_len;
-        if (!is_valid_utf8_char((const unsigned char *)(str + i), len - i, &char_len)) {
-            return 0; // Invalid UTF-8 sequence found
-        }
-        i += char_len;
-    }
-    return 1; // Valid UTF-8
+// Boost.Locale in Plex may be sensitive to invalid UTF-8 sequences, so
+// column_text returns "" for a cell that is not valid UTF-8. The check runs
+// once per cell (pg_utf8_valid in decode_current_row, or when the query
+// cache stores the result); column_text only reads cell->utf8_valid.
+
+// column_text copies live in the statement's text arena (pg_stmt_text_alloc):
+// valid until the next step/reset/finalize as SQLite promises, memory scales
+// with live statements rather than threads, no size cap. Each cell is copied
+// at most once per row, so repeated calls return the same pointer.
+
+// Query cache BYTEA cells are decoded (build_entry); text reads get the "\x"
+// hex PostgreSQL returned, as on a miss. Must hold pg_stmt->lock.
+static char* cached_bytea_text(pg_stmt_t *pg_stmt, const char *bin, size_t len) {
+    char *buf = pg_stmt_text_alloc(pg_stmt, len * 2 + 3);
+    if (!buf) return NULL;
+    buf[0] = '\\';
+    buf[1] = 'x';
+    pg_hex_encode(buf + 2, (const unsigned char *)bin, len);
+    buf[len * 2 + 2] = '\0';
+    return buf;
 }
 
-// Static buffers for column_text - INCREASED SIZE v0.8.13
-// Due to potential Boost.Locale issues, we copy strings instead of returning PQgetvalue() directly.
-// Use larger buffers and more of them to handle concurrent access patterns.
-#define NUM_TEXT_BUFFERS 64
-#define TEXT_BUFFER_SIZE 8192
-static __thread char column_text_buffers[NUM_TEXT_BUFFERS][TEXT_BUFFER_SIZE];
-static __thread int column_text_buf_idx = 0;  // Thread-local, no atomic needed
-
 const unsigned char* my_sqlite3_column_text(sqlite3_stmt *pStmt, int idx) {
-    validate_type_consistency(pStmt, idx, "column_text");
-    
     pg_stmt_t *pg_stmt = pg_find_any_stmt(pStmt);
     
     // ULTRA-DEBUG: Log EVERYTHING for count queries
-    int is_count_query = (pg_stmt && pg_stmt->pg_sql && strstr(pg_stmt->pg_sql, "parents.parent_id,count(*)"));
+    int is_count_query = PG_DEBUG_TRACE && pg_stmt && (pg_stmt->flags & PG_STMT_F_COUNT_TRACE);
     
     if (is_count_query) {
         struct timeval tv;
@@ -1098,20 +1450,15 @@ const unsigned char* my_sqlite3_column_text(sqlite3_stmt *pStmt, int idx) {
     
     // Handle all PostgreSQL statements
     if (pg_stmt && pg_stmt->is_pg) {
-        pthread_mutex_lock(&pg_stmt->mutex);
-        
+        pg_bias_lock(&pg_stmt->lock);
+
+        // Current row (PGresult or query cache) decoded once per step
+        const pg_row_cell_t *cell = current_cell(pg_stmt, idx);
+
         if (is_count_query) {
-            const char *col_name = (pg_stmt->result && idx >= 0 && idx < pg_stmt->num_cols) ?
-                                   PQfname(pg_stmt->result, idx) : "?";
-            int row = pg_stmt->current_row;
-            const char *preview = NULL;
-            if (pg_stmt->result && row >= 0 && row < pg_stmt->num_rows && 
-                idx >= 0 && idx < pg_stmt->num_cols && 
-                !PQgetisnull(pg_stmt->result, row, idx)) {
-                preview = PQgetvalue(pg_stmt->result, row, idx);
-            }
+            const char *preview = cell ? cell->text : NULL;
             LOG_ERROR("ULTRA_DEBUG_TEXT: col='%s' row=%d/%d value='%s' (hex:", 
-                     col_name, pg_stmt->current_row, pg_stmt->num_rows, 
+                     cell && cell->name ? cell->name : "?", pg_stmt->current_row, pg_stmt->num_rows,
                      preview ? preview : "(null)");
             if (preview) {
                 for (int i = 0; i < 20 && preview[i]; i++) {
@@ -1121,120 +1468,50 @@ const unsigned char* my_sqlite3_column_text(sqlite3_stmt *pStmt, int idx) {
             fprintf(stderr, ")\n");
             fflush(stderr);
         }
-        LOG_DEBUG("COLUMN_TEXT: locked mutex, result=%p row=%d cols=%d",
-                 (void*)pg_stmt->result, pg_stmt->current_row, pg_stmt->num_cols);
-
-        const char *source_value = NULL;
-
-        // QUERY CACHE: Check for cached result first
-        if (pg_stmt->cached_result) {
-            cached_result_t *cached = pg_stmt->cached_result;
-            int row = pg_stmt->current_row;
-            LOG_DEBUG("COLUMN_TEXT_CACHE: idx=%d row=%d num_cols=%d num_rows=%d",
-                     idx, row, cached->num_cols, cached->num_rows);
-            if (idx >= 0 && idx < cached->num_cols && row >= 0 && row < cached->num_rows) {
-                cached_row_t *crow = &cached->rows[row];
-                if (!crow->is_null[idx] && crow->values[idx]) {
-                    source_value = crow->values[idx];
-                    LOG_DEBUG("COLUMN_TEXT_CACHE_HIT: found cached value len=%zu", strlen(source_value));
-                }
-            }
-            if (!source_value) {
-                LOG_DEBUG("COLUMN_TEXT_CACHE_NULL: returning NULL (SQLite behavior)");
-                pthread_mutex_unlock(&pg_stmt->mutex);
-                return NULL;  // SQLite returns NULL for NULL columns
-            }
-        } else {
-            // Non-cached path - get from PGresult
-            if (!pg_stmt->result) {
-                LOG_DEBUG("COLUMN_TEXT: no result, returning empty buffer");
-                int buf = column_text_buf_idx;
-                column_text_buf_idx = (column_text_buf_idx + 1) % NUM_TEXT_BUFFERS;
-                column_text_buffers[buf][0] = '\0';
-                pthread_mutex_unlock(&pg_stmt->mutex);
-                return (const unsigned char*)column_text_buffers[buf];
-            }
-
-            if (idx < 0 || idx >= pg_stmt->num_cols) {
-                LOG_DEBUG("COLUMN_TEXT: idx=%d out of bounds (num_cols=%d)", idx, pg_stmt->num_cols);
-                int buf = column_text_buf_idx;
-                column_text_buf_idx = (column_text_buf_idx + 1) % NUM_TEXT_BUFFERS;
-                column_text_buffers[buf][0] = '\0';
-                pthread_mutex_unlock(&pg_stmt->mutex);
-                return (const unsigned char*)column_text_buffers[buf];
-            }
 
-            int row = pg_stmt->current_row;
-            if (row < 0 || row >= pg_stmt->num_rows) {
-                LOG_DEBUG("COLUMN_TEXT: row=%d out of bounds (num_rows=%d)", row, pg_stmt->num_rows);
-                int buf = column_text_buf_idx;
-                column_text_buf_idx = (column_text_buf_idx + 1) % NUM_TEXT_BUFFERS;
-                column_text_buffers[buf][0] = '\0';
-                pthread_mutex_unlock(&pg_stmt->mutex);
-                return (const unsigned char*)column_text_buffers[buf];
-            }
+        if (!cell) {
+            LOG_DEBUG("COLUMN_TEXT: no row or idx=%d out of bounds (row=%d cols=%d), returning empty buffer",
+                      idx, pg_stmt->current_row, pg_stmt->num_cols);
+            int no_data = pg_stmt->cached_result != NULL;
+            pg_bias_unlock(&pg_stmt->lock);
+            if (no_data) return NULL;  // Query cache path always reported NULL here
+            return (const unsigned char*)"";
+        }
+        if (cell->type == SQLITE_NULL) {
+            LOG_DEBUG("COLUMN_TEXT: value is NULL, returning NULL (SQLite behavior)");
+            pg_bias_unlock(&pg_stmt->lock);
+            return NULL;  // SQLite returns NULL for NULL columns
+        }
 
-            if (PQgetisnull(pg_stmt->result, row, idx)) {
-                LOG_DEBUG("COLUMN_TEXT: value is NULL, returning NULL (SQLite behavior)");
-                pthread_mutex_unlock(&pg_stmt->mutex);
-                return NULL;  // SQLite returns NULL for NULL columns
-            }
+        if (cell->copy) {  // Already copied for this row
+            const char *copy = cell->copy;
+            pg_bias_unlock(&pg_stmt->lock);
+            return (const unsigned char*)copy;
+        }
+        const char *source_value = cell->text;
 
-            source_value = PQgetvalue(pg_stmt->result, row, idx);
-            if (!source_value) {
-                LOG_DEBUG("COLUMN_TEXT: PQgetvalue returned NULL, returning empty buffer");
-                int buf = column_text_buf_idx;
-                column_text_buf_idx = (column_text_buf_idx + 1) % NUM_TEXT_BUFFERS;
-                column_text_buffers[buf][0] = '\0';
-                pthread_mutex_unlock(&pg_stmt->mutex);
-                return (const unsigned char*)column_text_buffers[buf];
-            }
-            
-            // TYPE_DEBUG: Enhanced logging for type-related columns (column_text non-cached path)
-            const char *col_name = PQfname(pg_stmt->result, idx);
-            Oid oid = PQftype(pg_stmt->result, idx);
-            
-            // CRITICAL WARNING: column_text called for INTEGER column - this suggests SOCI type mismatch
-            if (oid == 23 || oid == 20 || oid == 21) {  // int4, int8, int2
-                LOG_DEBUG("COLUMN_TEXT_INTEGER: col='%s' idx=%d row=%d oid=%u val='%.50s' - INTEGER column accessed as TEXT!",
-                          col_name ? col_name : "?", idx, row, oid, source_value);
-                
-                // TARGETED FIX: Only reformat aggregate function results (count, sum, max, min, avg)
-                // These are the columns that cause std::bad_cast in SOCI
-                if (col_name && (strcmp(col_name, "count") == 0 ||
-                                strcmp(col_name, "sum") == 0 ||
-                                strcmp(col_name, "max") == 0 ||
-                                strcmp(col_name, "min") == 0 ||
-                                strcmp(col_name, "avg") == 0 ||
-                                strstr(col_name, "count(") != NULL ||
-                                strstr(col_name, "COUNT(") != NULL)) {
-                    // Reformat through sprintf to ensure clean string conversion
-                    int buf_idx = column_text_buf_idx;
-                    column_text_buf_idx = (column_text_buf_idx + 1) % NUM_TEXT_BUFFERS;
-                    
-                    if (oid == 20) {  // int8/BIGINT
-                        long long val = atoll(source_value);
-                        snprintf(column_text_buffers[buf_idx], TEXT_BUFFER_SIZE, "%lld", val);
-                    } else {  // int2/int4
-                        int val = atoi(source_value);
-                        snprintf(column_text_buffers[buf_idx], TEXT_BUFFER_SIZE, "%d", val);
-                    }
-                    
-                    LOG_ERROR("COLUMN_TEXT_AGGREGATE_REFORMAT: col='%s' '%s' -> '%s'", 
-                             col_name, source_value, column_text_buffers[buf_idx]);
-                    pthread_mutex_unlock(&pg_stmt->mutex);
-                    return (const unsigned char*)column_text_buffers[buf_idx];
-                }
+        // TARGETED FIX: Only reformat aggregate function results (count, sum, max, min, avg)
+        // read as TEXT - these are the columns that cause std::bad_cast in SOCI
+        if ((cell->flags & PG_CELL_AGGREGATE_INT) && !pg_stmt->cached_result) {
+            // Reformat through sprintf to ensure clean string conversion
+            char *buf = pg_stmt_text_alloc(pg_stmt, 24);
+            if (!buf) {
+                pg_bias_unlock(&pg_stmt->lock);
+                return NULL;
             }
-            
-            if (col_name && strstr(col_name, "type") != NULL) {
-                LOG_DEBUG("TYPE_DEBUG_TEXT: col='%s' idx=%d row=%d val='%.50s' sql=%.200s",
-                          col_name, idx, row, source_value,
-                          pg_stmt->pg_sql ? pg_stmt->pg_sql : "?");
+            if (cell->oid == 20) {  // int8/BIGINT
+                snprintf(buf, 24, "%lld", (long long)cell->i);
+            } else {  // int2/int4
+                snprintf(buf, 24, "%d", (int)cell->i);
             }
+            pg_stmt->row_cells[idx].copy = buf;
+            LOG_ERROR("COLUMN_TEXT_AGGREGATE_REFORMAT: col='%s' '%s' -> '%s'",
+                     cell->name, source_value, buf);
+            pg_bias_unlock(&pg_stmt->lock);
+            return (const unsigned char*)buf;
         }
 
-        // FIX v0.8.13: Copy strings to thread-local buffers instead of returning PQgetvalue() directly
+        // FIX v0.8.13: Copy strings to our own buffers instead of returning PQgetvalue() directly
         // This addresses potential Boost.Locale issues where it may be sensitive to:
         // - Memory alignment of source strings  
         // - Presence of specific memory metadata
@@ -1242,33 +1519,41 @@ const unsigned char* my_sqlite3_column_text(sqlite3_stmt *pStmt, int idx) {
         // 
         // By copying to our own buffers, we ensure consistent behavior similar to native SQLite.
         
-        // Validate UTF-8 first
-        size_t str_len = strlen(source_value);
-        if (str_len > 0 && !validate_utf8_string(source_value, str_len)) {
+        if (cell->oid == 17 && pg_stmt->cached_result) {
+            char *hex = cached_bytea_text(pg_stmt, source_value, (size_t)cell->len);
+            pg_stmt->row_cells[idx].copy = hex;
+            pg_bias_unlock(&pg_stmt->lock);
+            return (const unsigned char*)hex;
+        }
+
+        // UTF-8 was validated when the row was decoded
+        size_t str_len = (size_t)cell->len;
+        if (!cell->utf8_valid) {
             LOG_ERROR("COLUMN_TEXT_UTF8_INVALID: idx=%d row=%d contains invalid UTF-8! len=%zu sql=%.200s",
                       idx, pg_stmt->current_row, str_len,
                       pg_stmt->pg_sql ? pg_stmt->pg_sql : "?");
             // Return empty string for invalid UTF-8
-            column_text_buffers[column_text_buf_idx][0] = '\0';
-            const unsigned char *result = (const unsigned char*)column_text_buffers[column_text_buf_idx];
-            column_text_buf_idx = (column_text_buf_idx + 1) % NUM_TEXT_BUFFERS;
-            pthread_mutex_unlock(&pg_stmt->mutex);
-            return result;
+            pg_stmt->row_cells[idx].copy = "";
+            pg_bias_unlock(&pg_stmt->lock);
+            return (const unsigned char*)"";
         }
         
-        // Copy string to thread-local buffer
-        int buf_idx = column_text_buf_idx;
-        column_text_buf_idx = (column_text_buf_idx + 1) % NUM_TEXT_BUFFERS;
-        
-        size_t copy_len = (str_len < TEXT_BUFFER_SIZE - 1) ? str_len : (TEXT_BUFFER_SIZE - 1);
-        memcpy(column_text_buffers[buf_idx], source_value, copy_len);
-        column_text_buffers[buf_idx][copy_len] = '\0';
+        // Copy string to the statement's text arena, whole value
+        char *buf = pg_stmt_text_alloc(pg_stmt, str_len + 1);
+        if (!buf) {
+            LOG_ERROR("COLUMN_TEXT: out of memory copying %zu bytes idx=%d", str_len, idx);
+            pg_bias_unlock(&pg_stmt->lock);
+            return NULL;
+        }
+        memcpy(buf, source_value, str_len);
+        buf[str_len] = '\0';
+        pg_stmt->row_cells[idx].copy = buf;
         
-        LOG_DEBUG("COLUMN_TEXT: copied %zu bytes to buffer[%d] idx=%d row=%d utf8=valid",
-                  copy_len, buf_idx, idx, pg_stmt->current_row);
+        LOG_DEBUG("COLUMN_TEXT: copied %zu bytes to buffer %p idx=%d row=%d utf8=valid",
+                  str_len, (void*)buf, idx, pg_stmt->current_row);
         
-        pthread_mutex_unlock(&pg_stmt->mutex);
-        return (const unsigned char*)column_text_buffers[buf_idx];
+        pg_bias_unlock(&pg_stmt->lock);
+        return (const unsigned char*)buf;
     }
     LOG_DEBUG("COLUMN_TEXT: falling through to orig");
     return orig_sqlite3_column_text ? orig_sqlite3_column_text(pStmt, idx) : NULL;
@@ -1278,37 +1563,36 @@ const void* my_sqlite3_column_blob(sqlite3_stmt *pStmt, int idx) {
     pg_stmt_t *pg_stmt = pg_find_any_stmt(pStmt);
     // Handle all PostgreSQL statements
     if (pg_stmt && pg_stmt->is_pg) {
-        pthread_mutex_lock(&pg_stmt->mutex);
+        pg_bias_lock(&pg_stmt->lock);
 
         // QUERY CACHE: Check for cached result first
         if (pg_stmt->cached_result) {
             cached_result_t *cached = pg_stmt->cached_result;
             int row = pg_stmt->current_row;
             if (idx >= 0 && idx < cached->num_cols && row >= 0 && row < cached->num_rows) {
-                cached_row_t *crow = &cached->rows[row];
-                if (!crow->is_null[idx] && crow->values[idx]) {
-                    // Return cached blob data directly
-                    // Note: For BYTEA, the cached value is already decoded
-                    pthread_mutex_unlock(&pg_stmt->mutex);
-                    return crow->values[idx];
+                if (!cached_cell_is_null(cached, row, idx)) {
+                    // Return cached blob data directly - BYTEA cells were
+                    // decoded when the entry was built
+                    pg_bias_unlock(&pg_stmt->lock);
+                    return cached_cell_value(cached, row, idx);
                 }
             }
-            pthread_mutex_unlock(&pg_stmt->mutex);
+            pg_bias_unlock(&pg_stmt->lock);
             return NULL;
         }
 
         if (!pg_stmt->result) {
-            pthread_mutex_unlock(&pg_stmt->mutex);
+            pg_bias_unlock(&pg_stmt->lock);
             return NULL;
         }
 
-        if (idx < 0 || idx >= pg_stmt->num_cols || idx >= MAX_PARAMS) {
-            pthread_mutex_unlock(&pg_stmt->mutex);
+        if (idx < 0 || idx >= pg_stmt->num_cols || !pg_stmt_reserve_cols(pg_stmt, idx + 1)) {
+            pg_bias_unlock(&pg_stmt->lock);
             return NULL;
         }
         int row = pg_stmt->current_row;
         if (row < 0 || row >= pg_stmt->num_rows) {
-            pthread_mutex_unlock(&pg_stmt->mutex);
+            pg_bias_unlock(&pg_stmt->lock);
             return NULL;
         }
         if (!PQgetisnull(pg_stmt->result, row, idx)) {
@@ -1319,7 +1603,7 @@ const void* my_sqlite3_column_blob(sqlite3_stmt *pStmt, int idx) {
             if (col_type == 17) {  // BYTEA
                 int blob_len;
                 const void *result = pg_decode_bytea(pg_stmt, row, idx, &blob_len);
-                pthread_mutex_unlock(&pg_stmt->mutex);
+                pg_bias_unlock(&pg_stmt->lock);
                 return result;
             }
 
@@ -1327,17 +1611,13 @@ const void* my_sqlite3_column_blob(sqlite3_stmt *pStmt, int idx) {
             // Check if we already have this value cached for the current row
             if (pg_stmt->cached_row == row && pg_stmt->cached_blob[idx]) {
                 const void *result = pg_stmt->cached_blob[idx];
-                pthread_mutex_unlock(&pg_stmt->mutex);
+                pg_bias_unlock(&pg_stmt->lock);
                 return result;
             }
 
             // Clear cache if row changed
             if (pg_stmt->cached_row != row) {
-                for (int i = 0; i < MAX_PARAMS; i++) {
-                    if (pg_stmt->cached_text[i]) {
-                        free(pg_stmt->cached_text[i]);
-                        pg_stmt->cached_text[i] = NULL;
-                    }
+                for (int i = 0; i < pg_stmt->col_cap; i++) {
                     if (pg_stmt->cached_blob[i]) {
                         free(pg_stmt->cached_blob[i]);
                         pg_stmt->cached_blob[i] = NULL;
@@ -1357,15 +1637,15 @@ const void* my_sqlite3_column_blob(sqlite3_stmt *pStmt, int idx) {
                     pg_stmt->cached_blob_len[idx] = blob_len;
                 } else {
                     LOG_ERROR("COL_BLOB: malloc failed for column %d, len %d", idx, blob_len);
-                    pthread_mutex_unlock(&pg_stmt->mutex);
+                    pg_bias_unlock(&pg_stmt->lock);
                     return NULL;
                 }
             }
             const void *result = pg_stmt->cached_blob[idx];
-            pthread_mutex_unlock(&pg_stmt->mutex);
+            pg_bias_unlock(&pg_stmt->lock);
             return result;
         }
-        pthread_mutex_unlock(&pg_stmt->mutex);
+        pg_bias_unlock(&pg_stmt->lock);
         return NULL;
     }
     return orig_sqlite3_column_blob ? orig_sqlite3_column_blob(pStmt, idx) : NULL;
@@ -1376,54 +1656,20 @@ int my_sqlite3_column_bytes(sqlite3_stmt *pStmt, int idx) {
     pg_stmt_t *pg_stmt = pg_find_any_stmt(pStmt);
     // Handle all PostgreSQL statements
     if (pg_stmt && pg_stmt->is_pg) {
-        pthread_mutex_lock(&pg_stmt->mutex);
-
-        // QUERY CACHE: Check for cached result first
-        if (pg_stmt->cached_result) {
-            cached_result_t *cached = pg_stmt->cached_result;
-            int row = pg_stmt->current_row;
-            if (idx >= 0 && idx < cached->num_cols && row >= 0 && row < cached->num_rows) {
-                cached_row_t *crow = &cached->rows[row];
-                if (!crow->is_null[idx]) {
-                    int len = crow->lengths[idx];
-                    pthread_mutex_unlock(&pg_stmt->mutex);
-                    return len;
-                }
-            }
-            pthread_mutex_unlock(&pg_stmt->mutex);
-            return 0;
-        }
-
-        if (!pg_stmt->result) {
-            pthread_mutex_unlock(&pg_stmt->mutex);
-            return 0;
-        }
-
-        if (idx < 0 || idx >= pg_stmt->num_cols) {
-            pthread_mutex_unlock(&pg_stmt->mutex);
-            return 0;
-        }
-        int row = pg_stmt->current_row;
-        if (row < 0 || row >= pg_stmt->num_rows) {
-            pthread_mutex_unlock(&pg_stmt->mutex);
-            return 0;
-        }
-        if (!PQgetisnull(pg_stmt->result, row, idx)) {
-            // Check if this is a BYTEA column (OID 17)
-            Oid col_type = PQftype(pg_stmt->result, idx);
-            if (col_type == 17) {  // BYTEA
-                // Decode the blob (caches it) and return the decoded length
-                int blob_len;
-                pg_decode_bytea(pg_stmt, row, idx, &blob_len);
-                pthread_mutex_unlock(&pg_stmt->mutex);
-                return blob_len;
+        pg_bias_lock(&pg_stmt->lock);
+        const pg_row_cell_t *cell = current_cell(pg_stmt, idx);
+        int len = 0;
+        if (cell && cell->type != SQLITE_NULL) {
+            if (cell->oid == 17 && !pg_stmt->cached_result && idx < MAX_PARAMS) {  // BYTEA
+                // Decode the blob (caches it) and return the decoded length.
+                // Query cache cells are stored decoded: cell->len is the length.
+                pg_decode_bytea(pg_stmt, pg_stmt->current_row, idx, &len);
+            } else {
+                len = cell->len;
             }
-            int len = PQgetlength(pg_stmt->result, row, idx);
-            pthread_mutex_unlock(&pg_stmt->mutex);
-            return len;
         }
-        pthread_mutex_unlock(&pg_stmt->mutex);
-        return 0;
+        pg_bias_unlock(&pg_stmt->lock);
+        return len;
     }
     return orig_sqlite3_column_bytes ? orig_sqlite3_column_bytes(pStmt, idx) : 0;
 }
@@ -1433,29 +1679,37 @@ const char* my_sqlite3_column_name(sqlite3_stmt *pStmt, int idx) {
     pg_stmt_t *pg_stmt = pg_find_any_stmt(pStmt);
     // Handle all PostgreSQL statements
     if (pg_stmt && pg_stmt->is_pg) {
-        pthread_mutex_lock(&pg_stmt->mutex);
-        // If no result yet but we have a query, execute it to get column metadata
+        pg_bias_lock(&pg_stmt->lock);
+        // If no result yet but we have a query, answer from the template's
+        // result shape or describe the query to get column metadata
         // SQLite allows column_name to be called before step()
         if (!pg_stmt->result && !pg_stmt->cached_result && pg_stmt->pg_sql) {
+            const pg_shape_t *shape = statement_shape(pg_stmt);
+            if (shape) {
+                const char *name = idx >= 0 && idx < shape->num_cols ? shape->names[idx] : NULL;
+                LOG_DEBUG("COLUMN_NAME: returning '%s' for idx=%d (shape)", name ? name : "NULL", idx);
+                pg_bias_unlock(&pg_stmt->lock);
+                return name;
+            }
             if (!ensure_pg_result_for_metadata(pg_stmt)) {
                 LOG_DEBUG("COLUMN_NAME: failed to execute query for metadata");
-                pthread_mutex_unlock(&pg_stmt->mutex);
+                pg_bias_unlock(&pg_stmt->lock);
                 return orig_sqlite3_column_name ? orig_sqlite3_column_name(pStmt, idx) : NULL;
             }
         }
         if (!pg_stmt->result) {
             LOG_DEBUG("COLUMN_NAME: pg_stmt has no result, falling back to orig");
-            pthread_mutex_unlock(&pg_stmt->mutex);
+            pg_bias_unlock(&pg_stmt->lock);
             return orig_sqlite3_column_name ? orig_sqlite3_column_name(pStmt, idx) : NULL;
         }
         if (idx >= 0 && idx < pg_stmt->num_cols) {
             const char *name = PQfname(pg_stmt->result, idx);
             LOG_DEBUG("COLUMN_NAME: returning '%s' for idx=%d", name ? name : "NULL", idx);
-            pthread_mutex_unlock(&pg_stmt->mutex);
+            pg_bias_unlock(&pg_stmt->lock);
             return name;
         }
         LOG_DEBUG("COLUMN_NAME: idx out of bounds (num_cols=%d)", pg_stmt->num_cols);
-        pthread_mutex_unlock(&pg_stmt->mutex);
+        pg_bias_unlock(&pg_stmt->lock);
     } else {
         LOG_DEBUG("COLUMN_NAME: not a PG stmt (pg_stmt=%p is_pg=%d), using orig",
                  (void*)pg_stmt, pg_stmt ? pg_stmt->is_pg : -1);
@@ -1473,131 +1727,50 @@ const char* my_sqlite3_column_name(sqlite3_stmt *pStmt, int idx) {
 // Solution: Return the original SQLite declared type from metadata cache, with OID fallback.
 // See: https://bugs.debian.org/cgi-bin/bugreport.cgi?bug=984534
 const char* my_sqlite3_column_decltype(sqlite3_stmt *pStmt, int idx) {
-    LOG_DEBUG("DECLTYPE_ENTRY: stmt=%p idx=%d", (void*)pStmt, idx);
     pg_stmt_t *pg_stmt = pg_find_any_stmt(pStmt);
-    // CRITICAL DEBUG: Log all decltype calls
     LOG_DEBUG("DECLTYPE_CALLED: stmt=%p idx=%d pg_stmt=%p is_pg=%d",
              (void*)pStmt, idx, (void*)pg_stmt, pg_stmt ? pg_stmt->is_pg : -1);
     // Handle all PostgreSQL statements
     if (pg_stmt && pg_stmt->is_pg) {
-        pthread_mutex_lock(&pg_stmt->mutex);
+        pg_bias_lock(&pg_stmt->lock);
 
-        // CRITICAL: If no result yet, execute query to get column metadata
-        // SOCI calls column_decltype before step() to determine types
-        if (!pg_stmt->result && !pg_stmt->cached_result && pg_stmt->pg_sql) {
+        // SOCI calls column_decltype before step() to determine types - the
+        // template's result shape answers without touching PostgreSQL
+        const pg_shape_t *shape = statement_shape(pg_stmt);
+
+        // CRITICAL: If no shape and no result yet, describe the query to get column metadata
+        if (!shape && !pg_stmt->result && !pg_stmt->cached_result && pg_stmt->pg_sql) {
             if (!ensure_pg_result_for_metadata(pg_stmt)) {
                 LOG_ERROR("COLUMN_DECLTYPE: failed to execute query for metadata, returning TEXT");
-                pthread_mutex_unlock(&pg_stmt->mutex);
+                pg_bias_unlock(&pg_stmt->lock);
                 return "TEXT";  // Safe fallback
             }
-        }
-
-        // Validate we have result and index is in range
-        if (!pg_stmt->result || idx < 0 || idx >= pg_stmt->num_cols) {
+            shape = statement_shape(pg_stmt);
+        }
+
+        const char *decltype;
+        if (shape && idx >= 0 && idx < shape->num_cols) {
+            decltype = shape->decltypes[idx];
+        } else if (pg_stmt->result && idx >= 0 && idx < pg_stmt->num_cols) {
+            // Shape not resolvable (no source tables) - compute directly
+            decltype = compute_column_decltype(pg_stmt->conn, PQfname(pg_stmt->result, idx),
+                                               PQftype(pg_stmt->result, idx),
+                                               idx < pg_stmt->col_cap ? pg_stmt->col_table_names[idx] : NULL,
+                                               pg_stmt->pg_sql);
+        } else {
             LOG_DEBUG("DECLTYPE_NO_RESULT: result=%p idx=%d num_cols=%d, returning TEXT",
                      (void*)pg_stmt->result, idx, pg_stmt->num_cols);
-            pthread_mutex_unlock(&pg_stmt->mutex);
+            pg_bias_unlock(&pg_stmt->lock);
             return "TEXT";  // Safe default that matches SQLITE_TEXT
         }
 
-        const char *col_name = PQfname(pg_stmt->result, idx);
-        const char *cached_type = NULL;
-        
-        // Debug logging for metadata_type specifically
-        int is_metadata_type = (col_name && strstr(col_name, "metadata_type") != NULL);
-        if (is_metadata_type) {
-            LOG_DEBUG("DECLTYPE_DEBUG: START col='%s' idx=%d row=%d num_cols=%d",
-                     col_name, idx, pg_stmt->current_row, pg_stmt->num_cols);
-        }
-
-        // STEP 1: Try looking up using column name as-is (for aliased columns like "devices_id")
-        cached_type = lookup_sqlite_decltype(pg_stmt->conn, col_name);
-        
-        if (is_metadata_type) {
-            LOG_DEBUG("DECLTYPE_DEBUG: STEP1 col='%s' cached_type='%s'",
-                     col_name, cached_type ? cached_type : "(null)");
-        }
-
-        // STEP 2: If not found and we have a resolved table name, try table_column format
-        if (!cached_type && idx < MAX_PARAMS && pg_stmt->col_table_names[idx]) {
-            // Column name is bare (e.g., "extra_data"), construct "table_column" key
-            char cache_key[DECLTYPE_MAX_KEY_LEN];
-            snprintf(cache_key, sizeof(cache_key), "%s_%s",
-                     pg_stmt->col_table_names[idx], col_name);
-            cached_type = lookup_decltype_direct(pg_stmt->conn, cache_key);
-            if (cached_type) {
-                LOG_INFO("DECLTYPE_RESOLVED: bare col '%s' -> table '%s' -> '%s'",
-                         col_name, pg_stmt->col_table_names[idx], cached_type);
-            }
-            if (is_metadata_type) {
-                LOG_DEBUG("DECLTYPE_DEBUG: STEP2 table='%s' cache_key='%s' cached_type='%s'",
-                         pg_stmt->col_table_names[idx], cache_key, cached_type ? cached_type : "(null)");
-            }
-        } else if (is_metadata_type) {
-            LOG_DEBUG("DECLTYPE_DEBUG: STEP2 SKIPPED (cached_type=%s idx=%d has_table=%d)",
-                     cached_type ? cached_type : "(null)", idx,
-                     (idx < MAX_PARAMS && pg_stmt->col_table_names[idx]) ? 1 : 0);
-        }
-
-        // STEP 3: If found in cache, return the original SQLite declared type
-        if (cached_type) {
-            if (is_metadata_type) {
-                LOG_DEBUG("DECLTYPE_DEBUG: RETURNING CACHED='%s' for col='%s' idx=%d",
-                         cached_type, col_name, idx);
-            }
-            // CRITICAL DEBUG: Log cached decltype returns too
-            LOG_DEBUG("DECLTYPE_CACHED: idx=%d col='%s' -> '%s' sql=%.300s",
-                     idx, col_name ? col_name : "?", cached_type,
-                     pg_stmt->pg_sql ? pg_stmt->pg_sql : "?");
-            pthread_mutex_unlock(&pg_stmt->mutex);
-            return cached_type;
-        }
-
-        // STEP 4: Fallback to OID-based type mapping
-        Oid oid = PQftype(pg_stmt->result, idx);
-        
-        // SPECIAL CASE: Aggregate functions (count, sum, max, min, avg) 
-        // PostgreSQL returns BIGINT (OID 20) for aggregates
-        // SOCI needs BIGINT (not INTEGER) to map to db_int64 for proper 64-bit handling
-        // This was the root cause: INTEGER -> db_int32 -> row.get<int64_t>() -> std::bad_cast
-        if (col_name && oid == 20) {
-            if (strcmp(col_name, "count") == 0 ||
-                strcmp(col_name, "sum") == 0 ||
-                strcmp(col_name, "max") == 0 ||
-                strcmp(col_name, "min") == 0 ||
-                strcmp(col_name, "avg") == 0 ||
-                strstr(col_name, "count(") != NULL ||
-                strstr(col_name, "COUNT(") != NULL) {
-                LOG_DEBUG("DECLTYPE_AGGREGATE: col='%s' OID=20 (BIGINT) -> returning TEXT to avoid SOCI bad_cast bug", col_name);
-                pthread_mutex_unlock(&pg_stmt->mutex);
-                return "TEXT";  // WORKAROUND: Force TEXT to avoid SOCI integer parsing bug
-            }
-        }
-        
-        // Use centralized OID-to-decltype mapping function
-        // CRITICAL: This function now differentiates INT4 (OID 23) -> "INTEGER" 
-        //           from INT8 (OID 20) -> "BIGINT" to prevent std::bad_cast
-        const char *decltype = pg_oid_to_sqlite_decltype(oid);
-
-        // LOG INT8 vs INT4 detection (for debugging type issues)
-        if (strcmp(decltype, "BIGINT") == 0 || strcmp(decltype, "INTEGER") == 0) {
-            LOG_DEBUG("DECLTYPE_INT: col='%s' idx=%d oid=%u -> '%s' sql=%.100s",
-                      col_name ? col_name : "?", idx, (unsigned)oid, decltype,
-                      pg_stmt->pg_sql ? pg_stmt->pg_sql : "?");
-        }
-        
         // ULTRA-DEBUG: Log count query decltype returns
-        int is_count_query = (pg_stmt->pg_sql && strstr(pg_stmt->pg_sql, "parents.parent_id,count(*)"));
-        if (is_count_query) {
-            LOG_ERROR("ULTRA_DEBUG_DECLTYPE: idx=%d col='%s' oid=%u -> RETURNING '%s'",
-                     idx, col_name ? col_name : "?", (unsigned)oid, decltype);
+        if (PG_DEBUG_TRACE && (pg_stmt->flags & PG_STMT_F_COUNT_TRACE)) {
+            LOG_ERROR("ULTRA_DEBUG_DECLTYPE: idx=%d col='%s' -> RETURNING '%s'",
+                     idx, shape ? shape->names[idx] : PQfname(pg_stmt->result, idx), decltype);
         }
-        
-        LOG_DEBUG("DECLTYPE_CACHED: idx=%d col='%s' -> '%s' sql=%.100s",
-                 idx, col_name ? col_name : "?", decltype,
-                 pg_stmt->pg_sql ? pg_stmt->pg_sql : "?");
-        
-        pthread_mutex_unlock(&pg_stmt->mutex);
+
+        pg_bias_unlock(&pg_stmt->lock);
         return decltype;
     }
     LOG_DEBUG("DECLTYPE_FALLBACK: using orig (pg_stmt=%p is_pg=%d)",
@@ -1606,6 +1779,7 @@ const char* my_sqlite3_column_decltype(sqlite3_stmt *pStmt, int idx) {
     LOG_DEBUG("COLUMN_DECLTYPE: orig returned '%s'", orig_type ? orig_type : "NULL");
     return orig_type;
 }
+
 // sqlite3_column_value returns a pointer to a sqlite3_value for a column.
 // For PostgreSQL statements, we return a fake sqlite3_value that encodes the pg_stmt and column.
 // The sqlite3_value_* functions will decode this to return proper PostgreSQL data.
@@ -1613,40 +1787,30 @@ sqlite3_value* my_sqlite3_column_value(sqlite3_stmt *pStmt, int idx) {
     pg_stmt_t *pg_stmt = pg_find_any_stmt(pStmt);
     // Handle all PostgreSQL statements
     if (pg_stmt && pg_stmt->is_pg) {
-        pthread_mutex_lock(&pg_stmt->mutex);
+        pg_bias_lock(&pg_stmt->lock);
         // column_value is typically called after step(), but just in case...
         if (!pg_stmt->result && !pg_stmt->cached_result && pg_stmt->pg_sql) {
             if (!ensure_pg_result_for_metadata(pg_stmt)) {
                 LOG_DEBUG("COLUMN_VALUE: failed to execute query for metadata");
-                pthread_mutex_unlock(&pg_stmt->mutex);
+                pg_bias_unlock(&pg_stmt->lock);
                 return orig_sqlite3_column_value ? orig_sqlite3_column_value(pStmt, idx) : NULL;
             }
         }
-        if (!pg_stmt->result) {
-            pthread_mutex_unlock(&pg_stmt->mutex);
+        // A query cache hit has no PGresult - the value reads the entry
+        if (!pg_stmt->result && !pg_stmt->cached_result) {
+            pg_bias_unlock(&pg_stmt->lock);
             return orig_sqlite3_column_value ? orig_sqlite3_column_value(pStmt, idx) : NULL;
         }
         if (idx < 0 || idx >= pg_stmt->num_cols) {
             LOG_DEBUG("COLUMN_VALUE_BOUNDS: idx=%d out of bounds (num_cols=%d) sql=%.100s",
                      idx, pg_stmt->num_cols, pg_stmt->pg_sql ? pg_stmt->pg_sql : "?");
-            pthread_mutex_unlock(&pg_stmt->mutex);
+            pg_bias_unlock(&pg_stmt->lock);
             return NULL;
         }
-        int row = pg_stmt->current_row;
-        pthread_mutex_unlock(&pg_stmt->mutex);
-
-        // Return a fake value from our pool (thread-safe)
-        pthread_mutex_lock(&fake_value_mutex);
-        // Use bitmask instead of modulo - always produces 0-255 even after overflow
-        unsigned int slot = (fake_value_next++) & 0xFF;
-        pg_fake_value_t *fake = &fake_value_pool[slot];
-        fake->magic = PG_FAKE_VALUE_MAGIC;
-        fake->pg_stmt = pg_stmt;
-        fake->col_idx = idx;
-        fake->row_idx = row;
-        pthread_mutex_unlock(&fake_value_mutex);
-
-        return (sqlite3_value*)fake;
+        // Fake value from this thread's arena, valid until the next step/reset
+        sqlite3_value *value = pg_create_column_value(pg_stmt, idx);
+        pg_bias_unlock(&pg_stmt->lock);
+        return value;
     }
     return orig_sqlite3_column_value ? orig_sqlite3_column_value(pStmt, idx) : NULL;
 }
@@ -1656,11 +1820,11 @@ int my_sqlite3_data_count(sqlite3_stmt *pStmt) {
     pg_stmt_t *pg_stmt = pg_find_any_stmt(pStmt);
     // Handle all PostgreSQL statements
     if (pg_stmt && pg_stmt->is_pg) {
-        pthread_mutex_lock(&pg_stmt->mutex);
+        pg_bias_lock(&pg_stmt->lock);
         // For PostgreSQL statements, return our stored num_cols if we have a valid row
         // Don't fall through to orig_sqlite3_data_count which would fail
         int count = (pg_stmt->current_row < pg_stmt->num_rows) ? pg_stmt->num_cols : 0;
-        pthread_mutex_unlock(&pg_stmt->mutex);
+        pg_bias_unlock(&pg_stmt->lock);
         LOG_DEBUG("DATA_COUNT: returning %d (row=%d rows=%d cols=%d)",
                  count, pg_stmt->current_row, pg_stmt->num_rows, pg_stmt->num_cols);
         return count;
@@ -1677,26 +1841,60 @@ static atomic_long value_type_calls = 0;
 static atomic_long value_text_calls = 0;
 static atomic_long value_int_calls = 0;
 
+// Cell behind a live fake value, from the PGresult or the query cache entry
+// (a cache hit has no PGresult). Returns 0 once the value was released or
+// when out of range; otherwise *val is the cell (NULL for SQL NULL) and *len
+// its length. Query cache BYTEA cells are already decoded (build_entry).
+// Must hold pg_stmt->lock.
+static int value_cell(pg_stmt_t *pg_stmt, const pg_value_t *fake,
+                      const char **val, int *len, Oid *oid) {
+    int row = fake->row_idx, col = fake->col_idx;
+    if (!pg_value_live(fake, pg_stmt) || row < 0 || row >= pg_stmt->num_rows ||
+        col < 0 || col >= pg_stmt->num_cols) {
+        return 0;
+    }
+    cached_result_t *cached = pg_stmt->cached_result;
+    if (cached) {
+        *oid = cached->col_types[col];
+        *val = cached_cell_value(cached, row, col);
+        *len = cached_cell_length(cached, row, col);
+        return 1;
+    }
+    if (!pg_stmt->result) return 0;
+    *oid = PQftype(pg_stmt->result, col);
+    *val = PQgetisnull(pg_stmt->result, row, col) ? NULL : PQgetvalue(pg_stmt->result, row, col);
+    *len = *val ? PQgetlength(pg_stmt->result, row, col) : 0;
+    return 1;
+}
+
+static const char* value_col_name(pg_stmt_t *pg_stmt, int col) {
+    if (pg_stmt->cached_result) return pg_stmt->cached_result->col_names[col];
+    return PQfname(pg_stmt->result, col);
+}
+
 // Intercept sqlite3_value_type to handle our fake values
 // CRITICAL: Must hold mutex while accessing pg_stmt->result to prevent race conditions
 int my_sqlite3_value_type(sqlite3_value *pVal) {
     global_value_type_calls++;  // Global counter for exception debugging
     if (!pVal) return SQLITE_NULL;  // CRITICAL FIX: NULL check to prevent crash
-    pg_fake_value_t *fake = pg_check_fake_value(pVal);
-    if (fake && fake->pg_stmt) {
-        pg_stmt_t *pg_stmt = (pg_stmt_t*)fake->pg_stmt;
+    pg_value_t *fake = pg_value_from(pVal);
+    if (fake) {
+        pg_stmt_t *pg_stmt = atomic_load(&fake->stmt);
+        if (!pg_stmt) return SQLITE_NULL;  // Released by step/reset
         long call_num = atomic_fetch_add(&value_type_calls, 1);
 
         // Update context for exception debugging (TLS)
         last_query_being_processed = pg_stmt->pg_sql;
 
         // CRITICAL FIX: Lock mutex before accessing result to prevent use-after-free
-        pthread_mutex_lock(&pg_stmt->mutex);
+        pg_bias_lock(&pg_stmt->lock);
         
-        if (pg_stmt->result && fake->row_idx >= 0 && fake->row_idx < pg_stmt->num_rows && fake->col_idx < pg_stmt->num_cols) {
-            int is_null = PQgetisnull(pg_stmt->result, fake->row_idx, fake->col_idx);
-            Oid oid = PQftype(pg_stmt->result, fake->col_idx);
-            const char *col_name = PQfname(pg_stmt->result, fake->col_idx);
+        const char *val;
+        int len;
+        Oid oid;
+        if (value_cell(pg_stmt, fake, &val, &len, &oid)) {
+            int is_null = val == NULL;
+            const char *col_name = value_col_name(pg_stmt, fake->col_idx);
 
             // Update context
             last_column_being_accessed = col_name;
@@ -1728,10 +1926,10 @@ int my_sqlite3_value_type(sqlite3_value *pVal) {
                         (unsigned)oid, is_null, sqlite_type_name(result),
                         pg_stmt->pg_sql ? pg_stmt->pg_sql : "?");
             }
-            pthread_mutex_unlock(&pg_stmt->mutex);
+            pg_bias_unlock(&pg_stmt->lock);
             return result;
         }
-        pthread_mutex_unlock(&pg_stmt->mutex);
+        pg_bias_unlock(&pg_stmt->lock);
         LOG_INFO("VALUE_TYPE[%ld]: FAKE VALUE but no result (row=%d col=%d)",
                 call_num, fake->row_idx, fake->col_idx);
         return SQLITE_NULL;
@@ -1740,54 +1938,55 @@ int my_sqlite3_value_type(sqlite3_value *pVal) {
 }
 
 // Intercept sqlite3_value_text to handle our fake values
-// Static buffers for value_text - LARGE pool, separate from column_text
-// 256 buffers x 16KB = 4MB total - prevents race condition wrap-around
-static char value_text_buffers[256][16384];
-static atomic_int value_text_idx = 0;  // Atomic for thread-safe increment
-
+// Copies go to the statement's text arena - valid exactly as long as the value
 const unsigned char* my_sqlite3_value_text(sqlite3_value *pVal) {
     if (!pVal) return NULL;  // CRITICAL FIX: NULL check
-    pg_fake_value_t *fake = pg_check_fake_value(pVal);
-    if (fake && fake->pg_stmt) {
-        pg_stmt_t *pg_stmt = (pg_stmt_t*)fake->pg_stmt;
+    pg_value_t *fake = pg_value_from(pVal);
+    if (fake) {
+        pg_stmt_t *pg_stmt = atomic_load(&fake->stmt);
+        if (!pg_stmt) return NULL;  // Released by step/reset
         long call_num = atomic_fetch_add(&value_text_calls, 1);
-        pthread_mutex_lock(&pg_stmt->mutex);
-        if (pg_stmt->result && fake->row_idx >= 0 && fake->row_idx < pg_stmt->num_rows && fake->col_idx < pg_stmt->num_cols) {
-            if (PQgetisnull(pg_stmt->result, fake->row_idx, fake->col_idx)) {
+        pg_bias_lock(&pg_stmt->lock);
+        const char *val;
+        int len;
+        Oid oid;
+        if (value_cell(pg_stmt, fake, &val, &len, &oid)) {
+            if (!val) {
                 if (call_num % 100 == 0) {
                     LOG_INFO("VALUE_TEXT[%ld]: col=%d row=%d -> NULL (is_null)", call_num, fake->col_idx, fake->row_idx);
                 }
-                pthread_mutex_unlock(&pg_stmt->mutex);
+                pg_bias_unlock(&pg_stmt->lock);
                 return NULL;
             }
-            // CRITICAL FIX: Copy to static buffer instead of returning PGresult pointer directly
+            // CRITICAL FIX: Copy instead of returning PGresult pointer directly
             // This prevents use-after-free when PGresult is cleared
-            const char* pg_value = PQgetvalue(pg_stmt->result, fake->row_idx, fake->col_idx);
-            if (!pg_value) {
-                pthread_mutex_unlock(&pg_stmt->mutex);
+            char *buf;
+            if (oid == 17 && pg_stmt->cached_result) {
+                buf = cached_bytea_text(pg_stmt, val, (size_t)len);
+            } else {
+                buf = pg_stmt_text_alloc(pg_stmt, (size_t)len + 1);
+                if (buf) {
+                    memcpy(buf, val, (size_t)len);
+                    buf[len] = '\0';
+                }
+            }
+            if (!buf) {
+                pg_bias_unlock(&pg_stmt->lock);
                 return NULL;
             }
 
-            size_t len = strlen(pg_value);
-            if (len >= 16383) len = 16383;
-
-            // Thread-safe buffer allocation using atomic increment
-            int buf = atomic_fetch_add(&value_text_idx, 1) & 0xFF;
-            memcpy(value_text_buffers[buf], pg_value, len);
-            value_text_buffers[buf][len] = '\0';
-
             // Log every 100th call with value preview
             if (call_num % 100 == 0) {
-                const char *col_name = PQfname(pg_stmt->result, fake->col_idx);
+                const char *col_name = value_col_name(pg_stmt, fake->col_idx);
                 LOG_INFO("VALUE_TEXT[%ld]: col='%s' row=%d val='%.30s%s'",
                         call_num, col_name ? col_name : "?", fake->row_idx,
-                        value_text_buffers[buf], len > 30 ? "..." : "");
+                        buf, len > 30 ? "..." : "");
             }
 
-            pthread_mutex_unlock(&pg_stmt->mutex);
-            return (const unsigned char*)value_text_buffers[buf];
+            pg_bias_unlock(&pg_stmt->lock);
+            return (const unsigned char*)buf;
         }
-        pthread_mutex_unlock(&pg_stmt->mutex);
+        pg_bias_unlock(&pg_stmt->lock);
         return NULL;
     }
     return orig_sqlite3_value_text ? orig_sqlite3_value_text(pVal) : NULL;
@@ -1797,21 +1996,20 @@ const unsigned char* my_sqlite3_value_text(sqlite3_value *pVal) {
 // CRITICAL: Must hold mutex while accessing pg_stmt->result
 int my_sqlite3_value_int(sqlite3_value *pVal) {
     if (!pVal) return 0;  // CRITICAL FIX: NULL check
-    pg_fake_value_t *fake = pg_check_fake_value(pVal);
-    if (fake && fake->pg_stmt) {
-        pg_stmt_t *pg_stmt = (pg_stmt_t*)fake->pg_stmt;
+    pg_value_t *fake = pg_value_from(pVal);
+    if (fake) {
+        pg_stmt_t *pg_stmt = atomic_load(&fake->stmt);
+        if (!pg_stmt) return 0;  // Released by step/reset
         long call_num = atomic_fetch_add(&value_int_calls, 1);
         (void)call_num;  // Suppress unused warning
         
-        pthread_mutex_lock(&pg_stmt->mutex);
-        if (pg_stmt->result && fake->row_idx >= 0 && fake->row_idx < pg_stmt->num_rows && fake->col_idx < pg_stmt->num_cols) {
-            if (PQgetisnull(pg_stmt->result, fake->row_idx, fake->col_idx)) {
-                pthread_mutex_unlock(&pg_stmt->mutex);
-                return 0;
-            }
-            const char *val = PQgetvalue(pg_stmt->result, fake->row_idx, fake->col_idx);
+        pg_bias_lock(&pg_stmt->lock);
+        const char *val;
+        int len;
+        Oid oid;
+        if (value_cell(pg_stmt, fake, &val, &len, &oid)) {
             if (!val) {
-                pthread_mutex_unlock(&pg_stmt->mutex);
+                pg_bias_unlock(&pg_stmt->lock);
                 return 0;
             }
             int result;
@@ -1821,17 +2019,17 @@ int my_sqlite3_value_int(sqlite3_value *pVal) {
             else result = atoi(val);
 
             // TYPE_DEBUG: Enhanced logging for type-related columns (value_int path)
-            const char *col_name = PQfname(pg_stmt->result, fake->col_idx);
+            const char *col_name = value_col_name(pg_stmt, fake->col_idx);
             if (col_name && strstr(col_name, "type") != NULL) {
                 LOG_DEBUG("TYPE_DEBUG_VALUE_INT: col='%s' idx=%d row=%d raw_val='%s' result=%d sql=%.200s",
                           col_name, fake->col_idx, fake->row_idx, val, result,
                           pg_stmt->pg_sql ? pg_stmt->pg_sql : "?");
             }
 
-            pthread_mutex_unlock(&pg_stmt->mutex);
+            pg_bias_unlock(&pg_stmt->lock);
             return result;
         }
-        pthread_mutex_unlock(&pg_stmt->mutex);
+        pg_bias_unlock(&pg_stmt->lock);
         return 0;
     }
     return orig_sqlite3_value_int ? orig_sqlite3_value_int(pVal) : 0;
@@ -1841,19 +2039,18 @@ int my_sqlite3_value_int(sqlite3_value *pVal) {
 // CRITICAL: Must hold mutex while accessing pg_stmt->result
 sqlite3_int64 my_sqlite3_value_int64(sqlite3_value *pVal) {
     if (!pVal) return 0;  // CRITICAL FIX: NULL check
-    pg_fake_value_t *fake = pg_check_fake_value(pVal);
-    if (fake && fake->pg_stmt) {
-        pg_stmt_t *pg_stmt = (pg_stmt_t*)fake->pg_stmt;
+    pg_value_t *fake = pg_value_from(pVal);
+    if (fake) {
+        pg_stmt_t *pg_stmt = atomic_load(&fake->stmt);
+        if (!pg_stmt) return 0;  // Released by step/reset
         
-        pthread_mutex_lock(&pg_stmt->mutex);
-        if (pg_stmt->result && fake->row_idx >= 0 && fake->row_idx < pg_stmt->num_rows && fake->col_idx < pg_stmt->num_cols) {
-            if (PQgetisnull(pg_stmt->result, fake->row_idx, fake->col_idx)) {
-                pthread_mutex_unlock(&pg_stmt->mutex);
-                return 0;
-            }
-            const char *val = PQgetvalue(pg_stmt->result, fake->row_idx, fake->col_idx);
+        pg_bias_lock(&pg_stmt->lock);
+        const char *val;
+        int len;
+        Oid oid;
+        if (value_cell(pg_stmt, fake, &val, &len, &oid)) {
             if (!val) {
-                pthread_mutex_unlock(&pg_stmt->mutex);
+                pg_bias_unlock(&pg_stmt->lock);
                 return 0;
             }
             sqlite3_int64 result;
@@ -1861,10 +2058,10 @@ sqlite3_int64 my_sqlite3_value_int64(sqlite3_value *pVal) {
             if (val[0] == 't' && val[1] == '\0') result = 1;
             else if (val[0] == 'f' && val[1] == '\0') result = 0;
             else result = atoll(val);
-            pthread_mutex_unlock(&pg_stmt->mutex);
+            pg_bias_unlock(&pg_stmt->lock);
             return result;
         }
-        pthread_mutex_unlock(&pg_stmt->mutex);
+        pg_bias_unlock(&pg_stmt->lock);
         return 0;
     }
     return orig_sqlite3_value_int64 ? orig_sqlite3_value_int64(pVal) : 0;
@@ -1874,19 +2071,18 @@ sqlite3_int64 my_sqlite3_value_int64(sqlite3_value *pVal) {
 // CRITICAL: Must hold mutex while accessing pg_stmt->result
 double my_sqlite3_value_double(sqlite3_value *pVal) {
     if (!pVal) return 0.0;  // CRITICAL FIX: NULL check
-    pg_fake_value_t *fake = pg_check_fake_value(pVal);
-    if (fake && fake->pg_stmt) {
-        pg_stmt_t *pg_stmt = (pg_stmt_t*)fake->pg_stmt;
+    pg_value_t *fake = pg_value_from(pVal);
+    if (fake) {
+        pg_stmt_t *pg_stmt = atomic_load(&fake->stmt);
+        if (!pg_stmt) return 0.0;  // Released by step/reset
         
-        pthread_mutex_lock(&pg_stmt->mutex);
-        if (pg_stmt->result && fake->row_idx >= 0 && fake->row_idx < pg_stmt->num_rows && fake->col_idx < pg_stmt->num_cols) {
-            if (PQgetisnull(pg_stmt->result, fake->row_idx, fake->col_idx)) {
-                pthread_mutex_unlock(&pg_stmt->mutex);
-                return 0.0;
-            }
-            const char *val = PQgetvalue(pg_stmt->result, fake->row_idx, fake->col_idx);
+        pg_bias_lock(&pg_stmt->lock);
+        const char *val;
+        int len;
+        Oid oid;
+        if (value_cell(pg_stmt, fake, &val, &len, &oid)) {
             if (!val) {
-                pthread_mutex_unlock(&pg_stmt->mutex);
+                pg_bias_unlock(&pg_stmt->lock);
                 return 0.0;
             }
             double result;
@@ -1894,10 +2090,10 @@ double my_sqlite3_value_double(sqlite3_value *pVal) {
             if (val[0] == 't' && val[1] == '\0') result = 1.0;
             else if (val[0] == 'f' && val[1] == '\0') result = 0.0;
             else result = atof(val);
-            pthread_mutex_unlock(&pg_stmt->mutex);
+            pg_bias_unlock(&pg_stmt->lock);
             return result;
         }
-        pthread_mutex_unlock(&pg_stmt->mutex);
+        pg_bias_unlock(&pg_stmt->lock);
         return 0.0;
     }
     return orig_sqlite3_value_double ? orig_sqlite3_value_double(pVal) : 0.0;
@@ -1907,60 +2103,56 @@ double my_sqlite3_value_double(sqlite3_value *pVal) {
 // CRITICAL: Must hold mutex while accessing pg_stmt->result
 int my_sqlite3_value_bytes(sqlite3_value *pVal) {
     if (!pVal) return 0;  // CRITICAL FIX: NULL check
-    pg_fake_value_t *fake = pg_check_fake_value(pVal);
-    if (fake && fake->pg_stmt) {
-        pg_stmt_t *pg_stmt = (pg_stmt_t*)fake->pg_stmt;
+    pg_value_t *fake = pg_value_from(pVal);
+    if (fake) {
+        pg_stmt_t *pg_stmt = atomic_load(&fake->stmt);
+        if (!pg_stmt) return 0;  // Released by step/reset
         
-        pthread_mutex_lock(&pg_stmt->mutex);
-        if (pg_stmt->result && fake->row_idx >= 0 && fake->row_idx < pg_stmt->num_rows && fake->col_idx < pg_stmt->num_cols) {
-            if (PQgetisnull(pg_stmt->result, fake->row_idx, fake->col_idx)) {
-                pthread_mutex_unlock(&pg_stmt->mutex);
-                return 0;
+        pg_bias_lock(&pg_stmt->lock);
+        const char *val;
+        int len;
+        Oid oid;
+        if (value_cell(pg_stmt, fake, &val, &len, &oid)) {
+            if (val && oid == 17 && !pg_stmt->cached_result) {  // BYTEA: decoded length
+                pg_decode_bytea(pg_stmt, fake->row_idx, fake->col_idx, &len);
             }
-            int len = PQgetlength(pg_stmt->result, fake->row_idx, fake->col_idx);
-            pthread_mutex_unlock(&pg_stmt->mutex);
-            return len;
+            pg_bias_unlock(&pg_stmt->lock);
+            return val ? len : 0;
         }
-        pthread_mutex_unlock(&pg_stmt->mutex);
+        pg_bias_unlock(&pg_stmt->lock);
         return 0;
     }
     return orig_sqlite3_value_bytes ? orig_sqlite3_value_bytes(pVal) : 0;
 }
 
-// Static buffers for value_blob - LARGE pool, separate from text buffers
-// 64 buffers x 64KB = 4MB total - prevents race condition wrap-around
-static char value_blob_buffers[64][65536];
-static atomic_int value_blob_idx = 0;  // Atomic for thread-safe increment
-
 // Intercept sqlite3_value_blob to handle our fake values
 const void* my_sqlite3_value_blob(sqlite3_value *pVal) {
     if (!pVal) return NULL;  // CRITICAL FIX: NULL check
-    pg_fake_value_t *fake = pg_check_fake_value(pVal);
-    if (fake && fake->pg_stmt) {
-        pg_stmt_t *pg_stmt = (pg_stmt_t*)fake->pg_stmt;
-        pthread_mutex_lock(&pg_stmt->mutex);
-        if (pg_stmt->result && fake->row_idx >= 0 && fake->row_idx < pg_stmt->num_rows && fake->col_idx < pg_stmt->num_cols) {
-            if (PQgetisnull(pg_stmt->result, fake->row_idx, fake->col_idx)) {
-                pthread_mutex_unlock(&pg_stmt->mutex);
-                return NULL;
+    pg_value_t *fake = pg_value_from(pVal);
+    if (fake) {
+        pg_stmt_t *pg_stmt = atomic_load(&fake->stmt);
+        if (!pg_stmt) return NULL;  // Released by step/reset
+        pg_bias_lock(&pg_stmt->lock);
+        const char *val;
+        int len;
+        Oid oid;
+        if (value_cell(pg_stmt, fake, &val, &len, &oid)) {
+            if (val && oid == 17 && !pg_stmt->cached_result) {  // BYTEA: decode like column_blob
+                val = pg_decode_bytea(pg_stmt, fake->row_idx, fake->col_idx, &len);
             }
-            // CRITICAL FIX: Copy to static buffer to prevent use-after-free
-            const char *pg_value = PQgetvalue(pg_stmt->result, fake->row_idx, fake->col_idx);
-            int len = PQgetlength(pg_stmt->result, fake->row_idx, fake->col_idx);
-            if (!pg_value || len <= 0) {
-                pthread_mutex_unlock(&pg_stmt->mutex);
+            // CRITICAL FIX: Copy to the statement's text arena to prevent use-after-free
+            if (!val || len <= 0) {
+                pg_bias_unlock(&pg_stmt->lock);
                 return NULL;
             }
-            if (len > 65535) len = 65535;  // Truncate if too large
 
-            // Thread-safe buffer allocation using atomic increment
-            int buf = atomic_fetch_add(&value_blob_idx, 1) & 0x3F;  // % 64 via bitmask
-            memcpy(value_blob_buffers[buf], pg_value, len);
+            char *buf = pg_stmt_text_alloc(pg_stmt, (size_t)len);
+            if (buf) memcpy(buf, val, len);
 
-            pthread_mutex_unlock(&pg_stmt->mutex);
-            return value_blob_buffers[buf];
+            pg_bias_unlock(&pg_stmt->lock);
+            return buf;
         }
-        pthread_mutex_unlock(&pg_stmt->mutex);
+        pg_bias_unlock(&pg_stmt->lock);
         return NULL;
     }
     return orig_sqlite3_value_blob ? orig_sqlite3_value_blob(pVal) : NULL;
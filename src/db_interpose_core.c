@@ -11,6 +11,7 @@
 
 #include "db_interpose.h"
 #include "pg_query_cache.h"
+#include "pg_mem.h"
 #include "fishhook.h"
 #include <execinfo.h>
 #include <signal.h>
@@ -505,11 +506,6 @@ pthread_cond_t worker_cond_response = PTHREAD_COND_INITIALIZER;
 worker_request_t worker_request;
 volatile int worker_running = 0;
 
-// Fake value pool for sqlite3_column_value
-pg_fake_value_t fake_value_pool[MAX_FAKE_VALUES];
-unsigned int fake_value_next = 0;
-pthread_mutex_t fake_value_mutex = PTHREAD_MUTEX_INITIALIZER;
-
 // Initialization flag
 int shim_initialized = 0;
 
@@ -528,24 +524,6 @@ volatile long global_column_type_calls = 0;
 // Helper Functions
 // ============================================================================
 
-// Check if a pointer is one of our fake values
-pg_fake_value_t* pg_check_fake_value(sqlite3_value *pVal) {
-    if (!pVal) return NULL;
-
-    // Check if pointer is in our pool
-    uintptr_t ptr = (uintptr_t)pVal;
-    uintptr_t pool_start = (uintptr_t)&fake_value_pool[0];
-    uintptr_t pool_end = (uintptr_t)&fake_value_pool[MAX_FAKE_VALUES];
-
-    if (ptr >= pool_start && ptr < pool_end) {
-        pg_fake_value_t *fake = (pg_fake_value_t*)pVal;
-        if (fake->magic == PG_FAKE_VALUE_MAGIC) {
-            return fake;
-        }
-    }
-    return NULL;
-}
-
 // Helper to check if path is library.db
 int is_library_db_path(const char *path) {
     return path && strstr(path, "com.plexapp.plugins.library.db") != NULL;
@@ -970,6 +948,20 @@ static void atfork_child(void) {
     // Call pg_client cleanup function to clear pool state
     extern void pg_pool_cleanup_after_fork(void);
     pg_pool_cleanup_after_fork();
+
+    // Drop sequence ids reserved by the parent (would collide if reused)
+    extern void pg_id_block_reset_after_fork(void);
+    pg_id_block_reset_after_fork();
+
+    // Drop the query cache refresh worker (thread and connection are the parent's)
+    extern void pg_query_cache_reset_after_fork(void);
+    pg_query_cache_reset_after_fork();
+
+    // Drop the invalidation listener (its LISTEN socket is the parent's)
+    extern void pg_inval_reset_after_fork(void);
+    pg_inval_reset_after_fork();
+    extern void pg_row_cache_reset_after_fork(void);
+    pg_row_cache_reset_after_fork();
     
     // Reset logging to prevent mutex deadlock
     // After fork, the child inherits parent's mutex state which may be locked
@@ -1224,5 +1216,6 @@ static void shim_cleanup(void) {
     pg_statement_cleanup();
     pg_client_cleanup();
     sql_translator_cleanup();
+    pg_mem_log_stats();  // Final cache memory usage
     pg_logging_cleanup();
 }
@@ -11,6 +11,8 @@
  */
 
 #include "db_interpose.h"
+#include "pg_query_cache.h"
+#include "pg_row_cache.h"
 #include <ctype.h>
 
 // ============================================================================
@@ -232,9 +234,20 @@ int my_sqlite3_exec(sqlite3 *db, const char *sql,
                 
                 ExecStatusType status = PQresultStatus(res);
 
+                // Anything but a plain SELECT may have changed data (autocommit,
+                // so it's visible now) - drop cached reads of the affected tables
+                if (!is_read_operation(sql)) {
+                    pg_query_cache_invalidate_write(exec_sql);
+                    pg_row_cache_invalidate_write(exec_sql, NULL);
+                }
+
                 if (status == PGRES_COMMAND_OK || status == PGRES_TUPLES_OK) {
                     pg_conn->last_changes = atoi(PQcmdTuples(res) ?: "1");
 
+                    // Table OIDs and declared types may have changed - schema
+                    // caches reload, here and in other processes
+                    if (is_ddl_operation(sql)) pg_query_cache_invalidate_ddl();
+
                     // Extract ID from RETURNING clause for INSERT
                     if (strncasecmp(sql, "INSERT", 6) == 0 && status == PGRES_TUPLES_OK && PQntuples(res) > 0) {
                         const char *id_str = PQgetvalue(res, 0, 0);
@@ -245,6 +258,7 @@ int my_sqlite3_exec(sqlite3 *db, const char *sql,
                             sqlite3_int64 meta_id = extract_metadata_id_from_generator_sql(sql);
                             if (meta_id > 0) pg_set_global_metadata_id(meta_id);
                         }
+                        pg_capture_insert_rowid(pg_conn, res);
                     }
                 } else {
                     const char *err = (pg_conn && pg_conn->conn) ? PQerrorMessage(pg_conn->conn) : "NULL connection";
@@ -6,6 +6,7 @@
  */
 
 #include "db_interpose.h"
+#include "pg_hex.h"
 
 // ============================================================================
 // Changes / Last Insert Rowid
@@ -60,61 +61,56 @@ sqlite3_int64 my_sqlite3_last_insert_rowid(sqlite3 *db) {
     in_interpose_call = 1;
 
     pg_connection_t *pg_conn = pg_find_connection(db);
-    
+    int exact = (pg_conn != NULL);
+
     // FIX v0.9.2: If we can't find the exact connection, try to find ANY library connection
     // This happens when Plex uses a different db handle than the one that did the INSERT
     if (!pg_conn) {
         pg_conn = pg_find_any_library_connection();
-        LOG_ERROR("last_insert_rowid: CALLED db=%p pg_conn=%p (FALLBACK to any library connection)", 
-                  (void*)db, (void*)pg_conn);
-    } else {
-        LOG_ERROR("last_insert_rowid: CALLED db=%p pg_conn=%p (exact match)", (void*)db, (void*)pg_conn);
     }
-    
+
     sqlite3_int64 result = 0;
 
-    // Use PostgreSQL lastval() if we found a connection
+    if (pg_conn && pg_conn->is_pg_active) {
+        // Fast path: every INSERT carries RETURNING id and the write path records
+        // it, so this is a memory read with no network I/O
+        result = pg_conn->last_insert_rowid;
+        if (result <= 0 && !exact) {
+            result = pg_get_global_last_insert_rowid();
+        }
+        if (result > 0) {
+            LOG_DEBUG("last_insert_rowid: db=%p pg_conn=%p captured rowid=%lld",
+                      (void*)db, (void*)pg_conn, result);
+            in_interpose_call = 0;
+            return result;
+        }
+    }
+
+    // Fallback: nothing captured (e.g. the INSERT ran outside the shim's write
+    // paths) - ask PostgreSQL for lastval()
     if (pg_conn && pg_conn->is_pg_active && pg_conn->conn) {
         // CRITICAL FIX: Lock connection mutex to prevent concurrent libpq access
         pthread_mutex_lock(&pg_conn->mutex);
-        LOG_ERROR("last_insert_rowid: EXECUTING lastval() on conn %p", (void*)pg_conn->conn);
         PGresult *res = PQexec(pg_conn->conn, "SELECT lastval()");
         ExecStatusType status = PQresultStatus(res);
-        LOG_ERROR("last_insert_rowid: STATUS=%d TUPLES=%d", status, PQntuples(res));
         if (status == PGRES_TUPLES_OK && PQntuples(res) > 0) {
-            const char *val_str = PQgetvalue(res, 0, 0);
-            sqlite3_int64 rowid = atoll(val_str ?: "0");
-            LOG_ERROR("last_insert_rowid: GOT VALUE=%s rowid=%lld", val_str, rowid);
-            PQclear(res);
-            pthread_mutex_unlock(&pg_conn->mutex);
-            if (rowid > 0) {
-                LOG_ERROR("last_insert_rowid: RETURNING rowid=%lld", rowid);
-                result = rowid;
-            } else {
-                LOG_ERROR("last_insert_rowid: rowid <= 0, RETURNING 0");
-            }
-        } else {
+            sqlite3_int64 rowid = atoll(PQgetvalue(res, 0, 0) ?: "0");
+            if (rowid > 0) result = rowid;
+        } else if (status == PGRES_FATAL_ERROR) {
             // CRITICAL FIX: lastval() fails if no INSERT has been done yet in this session
             // Return 0 (like SQLite does) instead of propagating the error
             // This prevents 500 errors when Plex calls last_insert_rowid() before INSERT
-            if (status == PGRES_FATAL_ERROR) {
-                const char *err = PQerrorMessage(pg_conn->conn);
-                LOG_ERROR("last_insert_rowid: FATAL_ERROR: %s", err ? err : "(null)");
-            } else {
-                LOG_ERROR("last_insert_rowid: NON-TUPLES status=%d", status);
-            }
-            PQclear(res);
-            pthread_mutex_unlock(&pg_conn->mutex);
-            LOG_ERROR("last_insert_rowid: RETURNING 0 due to error");
-            // result stays 0, which is correct SQLite behavior for "no insert yet"
+            const char *err = PQerrorMessage(pg_conn->conn);
+            LOG_DEBUG("last_insert_rowid: lastval() failed: %s", err ? err : "(null)");
         }
-    } else {
-        LOG_ERROR("last_insert_rowid: NO PG_CONN or not active, RETURNING 0");
+        PQclear(res);
+        pthread_mutex_unlock(&pg_conn->mutex);
+        LOG_DEBUG("last_insert_rowid: db=%p pg_conn=%p lastval fallback rowid=%lld",
+                  (void*)db, (void*)pg_conn, result);
     }
     // For non-PostgreSQL databases, return 0 (safe default)
 
     in_interpose_call = 0;
-    LOG_ERROR("last_insert_rowid: FINAL result=%lld", result);
     return result;
 }
 
@@ -537,7 +533,9 @@ char* my_sqlite3_expanded_sql(sqlite3_stmt *pStmt) {
         // First, estimate the size needed
         size_t estimated_size = strlen(base_sql) + 1;
         for (int i = 0; i < pg_stmt->param_count && i < MAX_PARAMS; i++) {
-            if (pg_stmt->param_values[i]) {
+            if (pg_stmt->param_values[i] && pg_stmt->param_types[i] == PG_OID_BYTEA) {
+                estimated_size += (size_t)pg_stmt->param_lengths[i] * 2 + 5;  // '\x' + hex + quote
+            } else if (pg_stmt->param_values[i]) {
                 estimated_size += strlen(pg_stmt->param_values[i]) + 3;  // quotes + safety
             } else {
                 estimated_size += 4;  // "NULL"
@@ -566,7 +564,19 @@ char* my_sqlite3_expanded_sql(sqlite3_stmt *pStmt) {
                 int idx = param_num - 1;
                 if (idx >= 0 && idx < pg_stmt->param_count && idx < MAX_PARAMS) {
                     const char *val = pg_stmt->param_values[idx];
-                    if (val) {
+                    if (val && pg_stmt->param_types[idx] == PG_OID_BYTEA) {
+                        // Raw blob bind - render as a '\x...' bytea literal
+                        *dst++ = '\'';
+                        *dst++ = '\\';
+                        *dst++ = 'x';
+                        // Bytes that fit before end - 3, as many as the old per-byte loop wrote
+                        size_t room = dst < end - 3 ? (size_t)(end - 3 - dst + 1) / 2 : 0;
+                        size_t n = (size_t)pg_stmt->param_lengths[idx];
+                        if (n > room) n = room;
+                        pg_hex_encode(dst, (const unsigned char *)val, n);
+                        dst += n * 2;
+                        *dst++ = '\'';
+                    } else if (val) {
                         // Quote text values
                         *dst++ = '\'';
                         while (*val && dst < end - 1) {
@@ -8,91 +8,6 @@
 #define _GNU_SOURCE
 
 #include "db_interpose.h"
-#include <time.h>
-
-// ============================================================================
-// Query Loop Detection
-// ============================================================================
-// Plex can get into infinite query loops (e.g., OnDeck with many views).
-// We detect this by tracking recent query hashes and breaking the loop.
-
-#define LOOP_DETECT_WINDOW_MS 1000   // 1 second window
-#define LOOP_DETECT_THRESHOLD 100    // Max same query in window before breaking
-
-typedef struct {
-    uint32_t hash;
-    uint64_t first_seen_ms;
-    int count;
-} query_loop_entry_t;
-
-#define LOOP_DETECT_SLOTS 16
-static __thread query_loop_entry_t loop_detect[LOOP_DETECT_SLOTS];
-static __thread int loop_detect_initialized = 0;
-
-static uint32_t simple_hash(const char *str, int max_len) {
-    uint32_t hash = 5381;
-    int len = 0;
-    while (*str && len < max_len) {
-        hash = ((hash << 5) + hash) + (unsigned char)*str++;
-        len++;
-    }
-    return hash;
-}
-
-static uint64_t get_time_ms(void) {
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
-}
-
-// Returns 1 if query loop detected and should be broken
-static int detect_query_loop(const char *sql) {
-    if (!sql) return 0;
-    
-    if (!loop_detect_initialized) {
-        memset(loop_detect, 0, sizeof(loop_detect));
-        loop_detect_initialized = 1;
-    }
-    
-    uint32_t hash = simple_hash(sql, 200);  // Hash first 200 chars
-    uint64_t now = get_time_ms();
-    int slot = hash % LOOP_DETECT_SLOTS;
-    
-    query_loop_entry_t *entry = &loop_detect[slot];
-    
-    // Check if same query hash
-    if (entry->hash == hash) {
-        // Check if within time window
-        if (now - entry->first_seen_ms < LOOP_DETECT_WINDOW_MS) {
-            entry->count++;
-            if (entry->count >= LOOP_DETECT_THRESHOLD) {
-                // Only log every 10th detection to reduce spam
-                static __thread int log_counter = 0;
-                if (log_counter++ % 10 == 0) {
-                    LOG_ERROR("LOOP DETECTED: query called %d times in %llu ms (logged 1/10)",
-                             entry->count, (unsigned long long)(now - entry->first_seen_ms));
-                }
-                // Reset for next detection
-                entry->count = 0;
-                entry->first_seen_ms = now;
-                // Don't break - Plex crashes on empty results
-                // The prepared statement caching makes the queries fast anyway
-                return 0;
-            }
-        } else {
-            // Window expired, reset
-            entry->first_seen_ms = now;
-            entry->count = 1;
-        }
-    } else {
-        // Different query, reset slot
-        entry->hash = hash;
-        entry->first_seen_ms = now;
-        entry->count = 1;
-    }
-    
-    return 0;
-}
 
 // ============================================================================
 // Helper Functions
@@ -284,18 +199,6 @@ int my_sqlite3_prepare_v2_internal(sqlite3 *db, const char *zSql, int nByte,
         }
     }
 
-    // LOOP DETECTION: Break infinite query loops (e.g., OnDeck with many views)
-    if (zSql && detect_query_loop(zSql)) {
-        // Return empty result to break the loop
-        if (real_sqlite3_prepare_v2) {
-            int rc = real_sqlite3_prepare_v2(db, "SELECT 1 WHERE 0", -1, ppStmt, pzTail);
-            return rc;
-        }
-        if (ppStmt) *ppStmt = NULL;
-        if (pzTail) *pzTail = NULL;
-        return SQLITE_OK;
-    }
-
     // CRITICAL: Track recursion depth to prevent infinite loops
     // SQLite can internally call prepare_v2 again, creating deep recursion
     prepare_v2_depth++;
@@ -416,9 +319,10 @@ int my_sqlite3_prepare_v2_internal(sqlite3 *db, const char *zSql, int nByte,
                     sql_translation_t trans = sql_translate(zSql);
                     if (trans.success && trans.sql) {
                         pg_stmt->pg_sql = strdup(trans.sql);
-                        pg_stmt->param_count = trans.param_count;
+                        pg_stmt_set_param_count(pg_stmt, trans.param_count);
                         LOG_INFO("STACK LOW OnDeck: routed to PG: %.100s", trans.sql);
                     }
+                    pg_stmt_classify(pg_stmt);
                     sql_translation_free(&trans);
                 }
             }
@@ -473,7 +377,7 @@ int my_sqlite3_prepare_v2_internal(sqlite3 *db, const char *zSql, int nByte,
                     sql_translation_t trans = sql_translate(zSql);
                     if (trans.success && trans.sql) {
                         pg_stmt->pg_sql = strdup(trans.sql);
-                        pg_stmt->param_count = trans.param_count;
+                        pg_stmt_set_param_count(pg_stmt, trans.param_count);
 
                         // Store parameter names
                         if (trans.param_names && trans.param_count > 0) {
@@ -493,6 +397,7 @@ int my_sqlite3_prepare_v2_internal(sqlite3 *db, const char *zSql, int nByte,
                                      "ps_%llx", (unsigned long long)pg_stmt->sql_hash);
                             pg_stmt->use_prepared = 1;
                         }
+                        pg_stmt_classify(pg_stmt);
                     }
                     sql_translation_free(&trans);
                     pg_register_stmt(*ppStmt, pg_stmt);
@@ -664,14 +569,14 @@ int my_sqlite3_prepare_v2_internal(sqlite3 *db, const char *zSql, int nByte,
                 // Use parameter count from SQL translator (already counted during placeholder translation)
                 // The translator always returns param_count even if translation failed
                 if (trans.param_count > 0) {
-                    pg_stmt->param_count = trans.param_count;
+                    pg_stmt_set_param_count(pg_stmt, trans.param_count);
                 } else {
                     // Fallback: count ? in original SQL if translator didn't provide count
-                    const char *p = zSql;
-                    while (*p) {
-                        if (*p == '?') pg_stmt->param_count++;
-                        p++;
+                    int n = 0;
+                    for (const char *p = zSql; *p; p++) {
+                        if (*p == '?') n++;
                     }
+                    pg_stmt_set_param_count(pg_stmt, n);
                 }
 
                 // Store parameter names for mapping named parameters
@@ -683,7 +588,7 @@ int my_sqlite3_prepare_v2_internal(sqlite3 *db, const char *zSql, int nByte,
                         }
                     }
                     // Debug: log parameter names for metadata_items INSERT
-                    if (strcasestr(zSql, "INSERT") && strcasestr(zSql, "metadata_items")) {
+                    if (PG_DEBUG_TRACE && strcasestr(zSql, "INSERT") && strcasestr(zSql, "metadata_items")) {
                         LOG_ERROR("PREPARE INSERT metadata_items: param_count=%d", trans.param_count);
                         LOG_ERROR("  First 15 params in SQL order:");
                         for (int i = 0; i < trans.param_count && i < 15; i++) {
@@ -721,6 +626,7 @@ int my_sqlite3_prepare_v2_internal(sqlite3 *db, const char *zSql, int nByte,
                                  "ps_%llx", (unsigned long long)pg_stmt->sql_hash);
                         pg_stmt->use_prepared = 1;  // Use prepared statements for better caching
                     }
+                    pg_stmt_classify(pg_stmt);
                 }
                 sql_translation_free(&trans);
             }
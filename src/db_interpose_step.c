@@ -7,6 +7,8 @@
 
 #include "db_interpose.h"
 #include "pg_query_cache.h"
+#include "pg_row_cache.h"
+#include "pg_id_block.h"
 
 // ============================================================================
 // Step Function - Main Query Execution
@@ -42,7 +44,7 @@ int my_sqlite3_step(sqlite3_stmt *pStmt) {
             const char *orig_sql = sqlite3_sql(pStmt);
             if (sql && is_write_operation(sql) && !should_skip_sql(sql) && !should_skip_sql(orig_sql)) {
                 // Debug: log cached INSERT for metadata_items
-                if (sql && strcasestr(sql, "INSERT") && strcasestr(sql, "metadata_items")) {
+                if (PG_DEBUG_TRACE && strcasestr(sql, "INSERT") && strcasestr(sql, "metadata_items")) {
                     LOG_ERROR("CACHED INSERT metadata_items:");
                     LOG_ERROR("  expanded_sql=%s", expanded_sql ? "YES" : "NO");
                     LOG_ERROR("  sql (first 300): %.300s", sql ? sql : "(null)");
@@ -80,7 +82,7 @@ int my_sqlite3_step(sqlite3_stmt *pStmt) {
                     }
 
                     // Log cached INSERT on play_queue_generators
-                    if (strstr(sql, "play_queue_generators")) {
+                    if (PG_DEBUG_TRACE && strstr(sql, "play_queue_generators")) {
                         LOG_INFO("CACHED INSERT play_queue_generators on thread %p conn %p",
                                 (void*)pthread_self(), (void*)cached_exec_conn);
                     }
@@ -129,6 +131,10 @@ int my_sqlite3_step(sqlite3_stmt *pStmt) {
                     pthread_mutex_unlock(&cached_exec_conn->mutex);
                     ExecStatusType status = PQresultStatus(res);
 
+                    // Write is committed (autocommit) - drop cached reads of its tables
+                    pg_query_cache_invalidate_write(exec_sql);
+                    pg_row_cache_invalidate_write(exec_sql, NULL);
+
                     if (status == PGRES_COMMAND_OK || status == PGRES_TUPLES_OK) {
                         pg_conn->last_changes = atoi(PQcmdTuples(res) ?: "1");
 
@@ -138,6 +144,9 @@ int my_sqlite3_step(sqlite3_stmt *pStmt) {
                                 sqlite3_int64 meta_id = extract_metadata_id_from_generator_sql(sql);
                                 if (meta_id > 0) pg_set_global_metadata_id(meta_id);
                             }
+                            // Remember the id for last_insert_rowid() (no lastval() round trip)
+                            sqlite3_int64 rowid = pg_capture_insert_rowid(cached_exec_conn, res);
+                            if (rowid > 0 && pg_conn != cached_exec_conn) pg_conn->last_insert_rowid = rowid;
                         }
                     } else {
                         const char *err = (pg_conn && pg_conn->conn) ? PQerrorMessage(pg_conn->conn) : "NULL connection";
@@ -179,6 +188,13 @@ int my_sqlite3_step(sqlite3_stmt *pStmt) {
                 }
 
                 pg_stmt_t *cached = pg_find_cached_stmt(pStmt);
+                if (cached) {
+                    // Values from the previous row die with this step
+                    pg_bias_lock(&cached->lock);
+                    pg_stmt_release_values(cached);
+                    pg_stmt_text_reset(cached);
+                    pg_bias_unlock(&cached->lock);
+                }
                 int sqlite_result = orig_sqlite3_step ? orig_sqlite3_step(pStmt) : SQLITE_ERROR;
 
                 if (sqlite_result == SQLITE_ROW || sqlite_result == SQLITE_DONE) {
@@ -188,6 +204,7 @@ int my_sqlite3_step(sqlite3_stmt *pStmt) {
                     if (cached && cached->result) {
                         // Already have results, advance to next row
                         cached->current_row++;
+                        cached->decoded_row = -1;
                         if (cached->current_row >= cached->num_rows) {
                             // CRITICAL FIX: Free PGresult immediately when done
                             // Prevents memory accumulation when Plex doesn't call reset()
@@ -210,6 +227,7 @@ int my_sqlite3_step(sqlite3_stmt *pStmt) {
                             new_stmt = pg_stmt_create(cached_read_conn, sql, pStmt);
                             if (new_stmt) {
                                 new_stmt->pg_sql = strdup(trans.sql);
+                                pg_stmt_classify(new_stmt);
                                 new_stmt->is_pg = 2;
                                 new_stmt->is_cached = 1;
                                 pg_register_cached_stmt(pStmt, new_stmt);
@@ -313,10 +331,13 @@ int my_sqlite3_step(sqlite3_stmt *pStmt) {
         // Lock statement mutex to protect statement state
         // NOTE: exec_conn->mutex is NOT needed because each thread has its own
         // connection from the pool (per-thread connection model)
-        pthread_mutex_lock(&pg_stmt->mutex);
+        pg_bias_lock(&pg_stmt->lock);
+        pg_stmt->decoded_row = -1;  // Row or result changes below
+        pg_stmt_release_values(pg_stmt);  // So do sqlite3_column_value() results
+        pg_stmt_text_reset(pg_stmt);      // and column_text() copies
 
         const char *paramValues[MAX_PARAMS] = {NULL};  // Initialize to prevent garbage access
-        for (int i = 0; i < pg_stmt->param_count && i < MAX_PARAMS; i++) {
+        for (int i = 0; i < pg_stmt->param_count && i < pg_stmt->param_cap; i++) {
             paramValues[i] = pg_stmt->param_values[i];
         }
 
@@ -324,7 +345,7 @@ int my_sqlite3_step(sqlite3_stmt *pStmt) {
             // CRITICAL FIX: Prevent re-execution after SQLITE_DONE was returned
             // Without this, Plex calling step() after DONE would re-execute the query
             if (pg_stmt->read_done) {
-                pthread_mutex_unlock(&pg_stmt->mutex);
+                pg_bias_unlock(&pg_stmt->lock);
                 return SQLITE_DONE;
             }
 
@@ -341,10 +362,10 @@ int my_sqlite3_step(sqlite3_stmt *pStmt) {
                     pg_query_cache_release(pg_stmt->cached_result);
                     pg_stmt->cached_result = NULL;
                     pg_stmt->read_done = 1;
-                    pthread_mutex_unlock(&pg_stmt->mutex);
+                    pg_bias_unlock(&pg_stmt->lock);
                     return SQLITE_DONE;
                 }
-                pthread_mutex_unlock(&pg_stmt->mutex);
+                pg_bias_unlock(&pg_stmt->lock);
                 return SQLITE_ROW;
             }
 
@@ -354,6 +375,19 @@ int my_sqlite3_step(sqlite3_stmt *pStmt) {
                          (void*)pthread_self(), (void*)pg_stmt, (void*)exec_conn);
             }
 
+            // v0.8.9.1: Check if we need to re-execute due to metadata-only result
+            // When bind() was called after metadata execution, it set metadata_only_result=2
+            // to indicate we need to re-execute with the now-bound parameters.
+            // Runs before the connection check: a description (PQdescribePrepared
+            // copy) belongs to no connection, so it is not a mismatch.
+            if (pg_stmt->result && pg_stmt->metadata_only_result == 2) {
+                LOG_DEBUG("STEP: Clearing metadata-only result for re-execution with bound params");
+                PQclear(pg_stmt->result);
+                pg_stmt->result = NULL;
+                pg_stmt->metadata_only_result = 0;
+                pg_stmt->current_row = -1;
+            }
+
             // CRITICAL FIX: Check if result belongs to a different connection
             // If statement is being used by a different thread/connection, we must
             // re-execute the query on THIS thread's connection to avoid protocol desync
@@ -366,17 +400,6 @@ int my_sqlite3_step(sqlite3_stmt *pStmt) {
                 pg_stmt->current_row = 0;
             }
 
-            // v0.8.9.1: Check if we need to re-execute due to metadata-only result
-            // When bind() was called after metadata execution, it set metadata_only_result=2
-            // to indicate we need to re-execute with the now-bound parameters
-            if (pg_stmt->result && pg_stmt->metadata_only_result == 2) {
-                LOG_DEBUG("STEP: Clearing metadata-only result for re-execution with bound params");
-                PQclear(pg_stmt->result);
-                pg_stmt->result = NULL;
-                pg_stmt->metadata_only_result = 0;
-                pg_stmt->current_row = -1;
-            }
-
             if (!pg_stmt->result) {
                 // ============================================================
                 // QUERY RESULT CACHE: Check if we have cached results
@@ -397,12 +420,30 @@ int my_sqlite3_step(sqlite3_stmt *pStmt) {
                     // Store pointer to cached result for column_* functions
                     // We'll use a special marker to indicate cached result
                     pg_stmt->cached_result = cached;
+                    if (cached->num_rows > 1) pg_row_cache_note_result(pg_stmt);
 
-                    pthread_mutex_unlock(&pg_stmt->mutex);
+                    pg_bias_unlock(&pg_stmt->lock);
                     return (cached->num_rows > 0) ? SQLITE_ROW : SQLITE_DONE;
                 }
                 #endif
 
+                // ROW CACHE: "SELECT ... FROM <table> WHERE <col> = $1" answered
+                // from cached rows or a lookup loop's batch as a synthesized
+                // PGresult; also counts this run for loop detection (see pg_row_cache.h)
+                PGresult *row_hit = pg_row_cache_lookup(pg_stmt, exec_conn);
+                if (row_hit) {
+                    pg_stmt->result = row_hit;
+                    pg_stmt->num_rows = PQntuples(row_hit);
+                    pg_stmt->num_cols = PQnfields(row_hit);
+                    pg_stmt->current_row = 0;
+                    pg_stmt->result_conn = exec_conn;  // Served as if executed here
+                    pg_stmt->metadata_only_result = 0;
+                    resolve_column_tables(pg_stmt, exec_conn);
+                    pg_bias_unlock(&pg_stmt->lock);
+                    return SQLITE_ROW;
+                }
+                pg_row_cache_begin_read();
+
                 // Track which thread is executing this statement
                 pthread_t current = pthread_self();
                 pg_stmt->executing_thread = current;
@@ -413,7 +454,7 @@ int my_sqlite3_step(sqlite3_stmt *pStmt) {
                              (void*)exec_conn,
                              exec_conn ? (void*)exec_conn->conn : NULL,
                              exec_conn && exec_conn->conn ? (int)PQstatus(exec_conn->conn) : -1);
-                    pthread_mutex_unlock(&pg_stmt->mutex);
+                    pg_bias_unlock(&pg_stmt->lock);
                     return SQLITE_ERROR;
                 }
 
@@ -433,7 +474,7 @@ int my_sqlite3_step(sqlite3_stmt *pStmt) {
                     if (PQstatus(exec_conn->conn) != CONNECTION_OK) {
                         LOG_ERROR("STEP READ: Reset failed, connection lost");
                         pthread_mutex_unlock(&exec_conn->mutex);
-                        pthread_mutex_unlock(&pg_stmt->mutex);
+                        pg_bias_unlock(&pg_stmt->lock);
                         return SQLITE_ERROR;
                     }
                     // Re-apply settings after reset
@@ -491,22 +532,32 @@ int my_sqlite3_step(sqlite3_stmt *pStmt) {
                                  cached_name, pg_stmt->param_count,
                                  (pg_stmt->param_count > 0 && paramValues[0]) ? paramValues[0] : "NULL",
                                  (pg_stmt->param_count > 1 && paramValues[1]) ? paramValues[1] : "NULL");
+                        pg_resolve_param_types(pg_stmt, exec_conn->conn, cached_name);
+                        pg_build_exec_params(pg_stmt, paramValues);
                         pg_stmt->result = PQexecPrepared(exec_conn->conn, cached_name,
-                            pg_stmt->param_count, paramValues, NULL, NULL, 0);
+                            pg_stmt->param_count, paramValues,
+                            pg_stmt->param_lengths, pg_stmt->param_formats, 0);
                         LOG_DEBUG("EXEC_PREPARED DONE: result=%p status=%d",
                                  (void*)pg_stmt->result,
                                  pg_stmt->result ? (int)PQresultStatus(pg_stmt->result) : -1);
                     } else {
                         // Fallback to PQexecParams
+                        const Oid *param_types = pg_build_exec_params(pg_stmt, paramValues);
                         pg_stmt->result = PQexecParams(exec_conn->conn, pg_stmt->pg_sql,
-                            pg_stmt->param_count, NULL, paramValues, NULL, NULL, 0);
+                            pg_stmt->param_count, param_types, paramValues,
+                            pg_stmt->param_lengths, pg_stmt->param_formats, 0);
                     }
                 } else {
                     // No prepared statement support for this query
                     LOG_INFO("EXEC_PARAMS READ: conn=%p params=%d sql=%.60s",
                              (void*)exec_conn, pg_stmt->param_count, pg_stmt->pg_sql);
+                    // Server $N types from the template, else one describe of
+                    // this SQL (unnamed statement) - then ints/doubles/blobs go binary
+                    pg_resolve_param_types(pg_stmt, exec_conn->conn, NULL);
+                    const Oid *param_types = pg_build_exec_params(pg_stmt, paramValues);
                     pg_stmt->result = PQexecParams(exec_conn->conn, pg_stmt->pg_sql,
-                        pg_stmt->param_count, NULL, paramValues, NULL, NULL, 0);
+                        pg_stmt->param_count, param_types, paramValues,
+                        pg_stmt->param_lengths, pg_stmt->param_formats, 0);
                     LOG_INFO("EXEC_PARAMS READ DONE: conn=%p result=%p",
                              (void*)exec_conn, (void*)pg_stmt->result);
                 }
@@ -538,7 +589,10 @@ int my_sqlite3_step(sqlite3_stmt *pStmt) {
                     pg_stmt->metadata_only_result = 0;
 
                     // QUERY RESULT CACHE: Store result for potential reuse
-                    // pg_query_cache_store(pg_stmt, pg_stmt->result);  // DISABLED
+                    // (uses the table versions snapshotted by the lookup above)
+                    pg_query_cache_store(pg_stmt, pg_stmt->result);
+                    pg_row_cache_store(pg_stmt, exec_conn, pg_stmt->result);
+                    if (pg_stmt->num_rows > 1) pg_row_cache_note_result(pg_stmt);  // Possible N+1 parent
                 } else {
                     const char *err = (exec_conn && exec_conn->conn) ? PQerrorMessage(exec_conn->conn) : "NULL connection";
                     log_sql_fallback(pg_stmt->sql, pg_stmt->pg_sql,
@@ -569,11 +623,11 @@ int my_sqlite3_step(sqlite3_stmt *pStmt) {
                     pg_stmt->result = NULL;
                     pg_stmt->result_conn = NULL;
                     pg_stmt->read_done = 1;  // Prevent re-execution on next step() call
-                    pthread_mutex_unlock(&pg_stmt->mutex);
+                    pg_bias_unlock(&pg_stmt->lock);
                     LOG_DEBUG("RETURNING SQLITE_DONE");
                     return SQLITE_DONE;
                 }
-                pthread_mutex_unlock(&pg_stmt->mutex);
+                pg_bias_unlock(&pg_stmt->lock);
                 LOG_DEBUG("RETURNING SQLITE_ROW for stmt=%p pg_stmt=%p thread=%p sql=%.50s",
                           (void*)pStmt, (void*)pg_stmt, (void*)pthread_self(), pg_stmt->sql ? pg_stmt->sql : "NULL");
                 // Flush log to ensure it's written before potential crash
@@ -586,18 +640,18 @@ int my_sqlite3_step(sqlite3_stmt *pStmt) {
             if (pg_stmt->write_executed) {
                 // Already executed this write, just return DONE
                 // This prevents the statistics_media INSERT storm bug
-                pthread_mutex_unlock(&pg_stmt->mutex);
+                pg_bias_unlock(&pg_stmt->lock);
                 return SQLITE_DONE;
             }
 
             // Log INSERT on play_queue_generators for debugging
-            if (pg_stmt->pg_sql && strstr(pg_stmt->pg_sql, "play_queue_generators")) {
+            if (PG_DEBUG_TRACE && (pg_stmt->flags & PG_STMT_F_PLAY_QUEUE_GENERATORS)) {
                 LOG_INFO("INSERT play_queue_generators on thread %p conn %p",
                         (void*)pthread_self(), (void*)exec_conn);
             }
 
             // Debug: log INSERT params for troubleshooting
-            if (pg_stmt->sql && strcasestr(pg_stmt->sql, "INSERT INTO metadata_items")) {
+            if (PG_DEBUG_TRACE && (pg_stmt->flags & PG_STMT_F_METADATA_ITEMS_INSERT)) {
                 LOG_ERROR("STEP metadata_items INSERT: param_count=%d", pg_stmt->param_count);
                 // CRITICAL FIX: Only access paramValues within bounds
                 LOG_ERROR("  PARAMS: [0]=%s [1]=%s [2]=%s [8]=%s [9]=%s",
@@ -608,7 +662,7 @@ int my_sqlite3_step(sqlite3_stmt *pStmt) {
                          (pg_stmt->param_count > 9 && paramValues[9]) ? paramValues[9] : "NULL"); // title_sort
             }
             // Debug: log play_queue_generators INSERT params
-            if (pg_stmt->sql && strcasestr(pg_stmt->sql, "play_queue_generators")) {
+            if (PG_DEBUG_TRACE && (pg_stmt->flags & PG_STMT_F_PLAY_QUEUE_GENERATORS)) {
                 LOG_ERROR("STEP play_queue_generators INSERT: param_count=%d", pg_stmt->param_count);
                 // CRITICAL FIX: Only access paramValues within bounds
                 LOG_ERROR("  PARAMS: [0]=%s [1]=%s [2]=%s [3]=%s",
@@ -621,7 +675,7 @@ int my_sqlite3_step(sqlite3_stmt *pStmt) {
 
             // VALIDATION: Skip statistics_media INSERTs with empty count AND duration
             // FIX v0.9.2: Fetch sequence value before skipping to make last_insert_rowid() work
-            if (pg_stmt->pg_sql && strcasestr(pg_stmt->pg_sql, "statistics_media")) {
+            if (pg_stmt->flags & PG_STMT_F_STATISTICS_MEDIA) {
                 // Check if count (param 6) and duration (param 7) are both 0 or NULL
                 const char *count_val = (pg_stmt->param_count > 6) ? paramValues[6] : NULL;
                 const char *duration_val = (pg_stmt->param_count > 7) ? paramValues[7] : NULL;
@@ -634,20 +688,24 @@ int my_sqlite3_step(sqlite3_stmt *pStmt) {
                     
                     // CRITICAL FIX: Advance the sequence so last_insert_rowid() works
                     // This prevents Plex from throwing std::exception on timeline requests
+                    // Ids come from the process-wide block allocator: one round trip
+                    // per PLEX_PG_ID_BLOCK_SIZE skipped rows instead of one per row
                     if (exec_conn && exec_conn->conn && PQstatus(exec_conn->conn) == CONNECTION_OK) {
                         pthread_mutex_lock(&exec_conn->mutex);
-                        PGresult *seq_res = PQexec(exec_conn->conn, 
-                            "SELECT nextval('plex.statistics_media_id_seq')");
-                        if (PQresultStatus(seq_res) == PGRES_TUPLES_OK && PQntuples(seq_res) > 0) {
-                            const char *seq_val = PQgetvalue(seq_res, 0, 0);
-                            LOG_INFO("SKIP: Advanced sequence to %s", seq_val);
+                        sqlite3_int64 rowid = pg_id_block_next(exec_conn->conn,
+                                                               "plex.statistics_media_id_seq");
+                        if (rowid > 0) {
+                            LOG_INFO("SKIP: Reserved statistics_media id %lld", (long long)rowid);
+                            // Same contract as a real INSERT: last_insert_rowid() reads this
+                            exec_conn->last_insert_rowid = rowid;
+                            if (pg_stmt->conn) pg_stmt->conn->last_insert_rowid = rowid;
+                            pg_set_global_last_insert_rowid(rowid);
                         }
-                        PQclear(seq_res);
                         pthread_mutex_unlock(&exec_conn->mutex);
                     }
                     
                     pg_stmt->write_executed = 1;
-                    pthread_mutex_unlock(&pg_stmt->mutex);
+                    pg_bias_unlock(&pg_stmt->lock);
                     return SQLITE_DONE;
                 }
             }
@@ -656,7 +714,7 @@ int my_sqlite3_step(sqlite3_stmt *pStmt) {
             if (!exec_conn || !exec_conn->conn || PQstatus(exec_conn->conn) != CONNECTION_OK) {
                 LOG_ERROR("STEP: Invalid connection, reconnecting...");
                 pg_stmt->write_executed = 1;
-                pthread_mutex_unlock(&pg_stmt->mutex);
+                pg_bias_unlock(&pg_stmt->lock);
                 return SQLITE_ERROR;
             }
 
@@ -701,40 +759,59 @@ int my_sqlite3_step(sqlite3_stmt *pStmt) {
                 }
 
                 if (is_cached && cached_name) {
-                    // Execute prepared statement
+                    // Execute prepared statement (int/double/blob params in binary
+                    // once the server-side $N types are known)
+                    pg_resolve_param_types(pg_stmt, exec_conn->conn, cached_name);
+                    pg_build_exec_params(pg_stmt, paramValues);
                     res = PQexecPrepared(exec_conn->conn, cached_name,
-                        pg_stmt->param_count, paramValues, NULL, NULL, 0);
+                        pg_stmt->param_count, paramValues,
+                        pg_stmt->param_lengths, pg_stmt->param_formats, 0);
                 } else {
                     // Fallback to PQexecParams
+                    const Oid *param_types = pg_build_exec_params(pg_stmt, paramValues);
                     res = PQexecParams(exec_conn->conn, pg_stmt->pg_sql,
-                        pg_stmt->param_count, NULL, paramValues, NULL, NULL, 0);
+                        pg_stmt->param_count, param_types, paramValues,
+                        pg_stmt->param_lengths, pg_stmt->param_formats, 0);
                 }
             } else {
                 // No prepared statement support for this query
+                pg_resolve_param_types(pg_stmt, NULL, NULL);
+                const Oid *param_types = pg_build_exec_params(pg_stmt, paramValues);
                 res = PQexecParams(exec_conn->conn, pg_stmt->pg_sql,
-                    pg_stmt->param_count, NULL, paramValues, NULL, NULL, 0);
+                    pg_stmt->param_count, param_types, paramValues,
+                    pg_stmt->param_lengths, pg_stmt->param_formats, 0);
             }
 
             pthread_mutex_unlock(&exec_conn->mutex);
 
+            // Write is committed (autocommit) - drop cached reads of its tables
+            pg_query_cache_invalidate_write(pg_stmt->pg_sql);
+            pg_row_cache_invalidate_write(pg_stmt->pg_sql, pg_stmt);
+
             ExecStatusType status = PQresultStatus(res);
             if (status == PGRES_COMMAND_OK || status == PGRES_TUPLES_OK) {
                 exec_conn->last_changes = atoi(PQcmdTuples(res) ?: "1");
 
-                // v0.8.9.5 FIX: For INSERT...RETURNING, log the ID but DON'T store result
-                // SOCI uses lastval() via last_insert_rowid() to get the ID, not RETURNING columns
+                // v0.8.9.5 FIX: For INSERT...RETURNING, record the ID but DON'T store result
                 // Storing result with current_row=-1 causes issues when column functions are called
                 if (status == PGRES_TUPLES_OK && PQntuples(res) > 0) {
                     const char *id_str = PQgetvalue(res, 0, 0);
                     if (id_str && *id_str) {
-                        if (pg_stmt->pg_sql && strstr(pg_stmt->pg_sql, "play_queue_generators")) {
+                        if (pg_stmt->flags & PG_STMT_F_PLAY_QUEUE_GENERATORS) {
                             LOG_INFO("STEP play_queue_generators: RETURNING id = %s on thread %p conn %p",
                                     id_str, (void*)pthread_self(), (void*)exec_conn);
+                            sqlite3_int64 meta_id = extract_metadata_id_from_generator_sql(pg_stmt->sql);
+                            if (meta_id > 0) pg_set_global_metadata_id(meta_id);
+                        }
+                    }
+                    // SOCI reads the id via last_insert_rowid() - keep it on both the
+                    // executing (pool) connection and the handle's connection
+                    if (pg_stmt->flags & PG_STMT_F_INSERT) {
+                        sqlite3_int64 rowid = pg_capture_insert_rowid(exec_conn, res);
+                        if (rowid > 0 && pg_stmt->conn && pg_stmt->conn != exec_conn) {
+                            pg_stmt->conn->last_insert_rowid = rowid;
                         }
-                        sqlite3_int64 meta_id = extract_metadata_id_from_generator_sql(pg_stmt->sql);
-                        if (meta_id > 0) pg_set_global_metadata_id(meta_id);
                     }
-                    // Don't store result - SOCI will use lastval() instead
                 }
             } else {
                 const char *err = (exec_conn && exec_conn->conn) ? PQerrorMessage(exec_conn->conn) : "NULL connection";
@@ -751,24 +828,19 @@ int my_sqlite3_step(sqlite3_stmt *pStmt) {
             if (res) PQclear(res);
         }
 
-        pthread_mutex_unlock(&pg_stmt->mutex);
+        pg_bias_unlock(&pg_stmt->lock);
     }
 
     if (pg_stmt && pg_stmt->is_pg) {
         // v0.8.9.5: WRITE statements always return SQLITE_DONE
-        // SOCI expects this and uses last_insert_rowid() to get the ID via lastval()
+        // SOCI expects this and uses last_insert_rowid() to get the captured RETURNING id
         // The RETURNING result is kept for debugging but not exposed as SQLITE_ROW
         if (pg_stmt->is_pg == 1) return SQLITE_DONE;
     
     // DEBUG TRACE: Log every step completion for PlayQueue/COUNT queries
-    if (pg_stmt && pg_stmt->pg_sql) {
-        int is_count = (strstr(pg_stmt->pg_sql, "COUNT(") != NULL || strstr(pg_stmt->pg_sql, "SUM(") != NULL || strstr(pg_stmt->pg_sql, "MAX(") != NULL);
-        int is_playqueue = (strstr(pg_stmt->pg_sql, "play_queue") != NULL);
-        
-        if (is_count || is_playqueue) {
-            LOG_ERROR("DEBUG_TRACE: STEP_EXIT - rows=%d cols=%d sql=%.100s",
-                      pg_stmt->num_rows, pg_stmt->num_cols, pg_stmt->pg_sql);
-        }
+    if (PG_DEBUG_TRACE && (pg_stmt->flags & (PG_STMT_F_AGGREGATE | PG_STMT_F_PLAY_QUEUE))) {
+        LOG_ERROR("DEBUG_TRACE: STEP_EXIT - rows=%d cols=%d sql=%.100s",
+                  pg_stmt->num_rows, pg_stmt->num_cols, pg_stmt->pg_sql);
     }
     }
 
@@ -787,12 +859,13 @@ int my_sqlite3_reset(sqlite3_stmt *pStmt) {
     // Clear prepared statements
     pg_stmt_t *pg_stmt = pg_find_any_stmt(pStmt);
     if (pg_stmt) {
-        pthread_mutex_lock(&pg_stmt->mutex);
+        pg_row_cache_forget(pg_stmt);  // Its rows are no longer being walked
+        pg_bias_lock(&pg_stmt->lock);
         
         // CRITICAL FIX v0.9.0: Clear in_step flag to allow new bind operations
         atomic_store(&pg_stmt->in_step, 0);
         
-        for (int i = 0; i < MAX_PARAMS; i++) {
+        for (int i = 0; i < pg_stmt->param_cap; i++) {
             if (pg_stmt->param_values[i] && !is_preallocated_buffer(pg_stmt, i)) {
                 free(pg_stmt->param_values[i]);
                 pg_stmt->param_values[i] = NULL;
@@ -804,21 +877,22 @@ int my_sqlite3_reset(sqlite3_stmt *pStmt) {
         // If this is a PostgreSQL-only statement (is_pg == 2), don't call real SQLite
         // as the statement handle is not a valid SQLite statement
         if (is_pg_only) {
-            pthread_mutex_unlock(&pg_stmt->mutex);
+            pg_bias_unlock(&pg_stmt->lock);
             return SQLITE_OK;
         }
 
         // CRITICAL FIX: Call orig_sqlite3_reset WHILE HOLDING THE MUTEX
         // to prevent "bind on busy prepared statement" race condition
         int rc = orig_sqlite3_reset ? orig_sqlite3_reset(pStmt) : SQLITE_ERROR;
-        pthread_mutex_unlock(&pg_stmt->mutex);
+        pg_bias_unlock(&pg_stmt->lock);
         return rc;
     }
 
     // Also clear cached statements - these use a separate registry
     pg_stmt_t *cached = pg_find_cached_stmt(pStmt);
     if (cached) {
-        pthread_mutex_lock(&cached->mutex);
+        pg_row_cache_forget(cached);
+        pg_bias_lock(&cached->lock);
         
         // CRITICAL FIX v0.9.0: Clear in_step flag to allow new bind operations
         atomic_store(&cached->in_step, 0);
@@ -828,13 +902,13 @@ int my_sqlite3_reset(sqlite3_stmt *pStmt) {
 
         // If this is a PostgreSQL-only statement, don't call real SQLite
         if (is_pg_only) {
-            pthread_mutex_unlock(&cached->mutex);
+            pg_bias_unlock(&cached->lock);
             return SQLITE_OK;
         }
 
         // CRITICAL FIX: Call orig_sqlite3_reset WHILE HOLDING THE MUTEX
         int rc = orig_sqlite3_reset ? orig_sqlite3_reset(pStmt) : SQLITE_ERROR;
-        pthread_mutex_unlock(&cached->mutex);
+        pg_bias_unlock(&cached->lock);
         return rc;
     }
 
@@ -863,6 +937,10 @@ int my_sqlite3_finalize(sqlite3_stmt *pStmt) {
             pg_clear_cached_stmt(pStmt);
         }
 
+        // Other threads' TLS tables drop their entries on next lookup/sweep
+        pg_stmt_mark_finalized(pg_stmt);
+        pg_row_cache_forget(pg_stmt);
+
         pg_unregister_stmt(pStmt);
         pg_stmt_unref(pg_stmt);
     } else {
@@ -870,6 +948,8 @@ int my_sqlite3_finalize(sqlite3_stmt *pStmt) {
         pg_stmt_t *cached = pg_find_cached_stmt(pStmt);
         if (cached) {
             is_pg_only = (cached->is_pg == 2);
+            pg_stmt_mark_finalized(cached);
+            pg_row_cache_forget(cached);
             // TLS-only statement - but pg_register_cached_stmt incremented ref_count
             // so it's now at 2 instead of 1. Need to unref twice.
             LOG_DEBUG("finalize: stmt only in TLS (ref_count=%d), clearing",
@@ -891,15 +971,15 @@ int my_sqlite3_clear_bindings(sqlite3_stmt *pStmt) {
     pg_stmt_t *pg_stmt = pg_find_stmt(pStmt);
     if (pg_stmt) {
         // CRITICAL FIX: Lock mutex for entire operation to prevent race conditions
-        pthread_mutex_lock(&pg_stmt->mutex);
-        for (int i = 0; i < MAX_PARAMS; i++) {
+        pg_bias_lock(&pg_stmt->lock);
+        for (int i = 0; i < pg_stmt->param_cap; i++) {
             if (pg_stmt->param_values[i] && !is_preallocated_buffer(pg_stmt, i)) {
                 free(pg_stmt->param_values[i]);
                 pg_stmt->param_values[i] = NULL;
             }
         }
         int rc = orig_sqlite3_clear_bindings ? orig_sqlite3_clear_bindings(pStmt) : SQLITE_ERROR;
-        pthread_mutex_unlock(&pg_stmt->mutex);
+        pg_bias_unlock(&pg_stmt->lock);
         return rc;
     }
     return orig_sqlite3_clear_bindings ? orig_sqlite3_clear_bindings(pStmt) : SQLITE_ERROR;
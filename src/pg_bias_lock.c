@@ -0,0 +1,131 @@
+/*
+ * PostgreSQL Shim - Biased (owner-thread) statement lock
+ *
+ * See pg_bias_lock.h for the protocol. Everything here runs with the
+ * mutex held except the one-time membarrier setup.
+ */
+
+#include <errno.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#include "pg_bias_lock.h"
+#include "pg_logging.h"
+
+// <linux/membarrier.h> values (not every libc ships the header)
+#define PG_MEMBARRIER_CMD_QUERY 0
+#define PG_MEMBARRIER_CMD_PRIVATE_EXPEDITED (1 << 3)
+#define PG_MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED (1 << 4)
+
+static int bias_enabled = 0;
+static pthread_once_t bias_once = PTHREAD_ONCE_INIT;
+
+static void bias_setup(void) {
+    const char *env = getenv("PLEX_PG_BIASED_LOCKS");
+    if (env && strcmp(env, "0") == 0) {
+        LOG_INFO("Biased statement locks disabled (PLEX_PG_BIASED_LOCKS=0)");
+        return;
+    }
+#if defined(__linux__) && defined(SYS_membarrier)
+    long cmds = syscall(SYS_membarrier, PG_MEMBARRIER_CMD_QUERY, 0, 0);
+    if (cmds > 0 && (cmds & PG_MEMBARRIER_CMD_PRIVATE_EXPEDITED) &&
+        syscall(SYS_membarrier, PG_MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0) == 0) {
+        bias_enabled = 1;
+        LOG_INFO("Biased statement locks enabled (membarrier)");
+        return;
+    }
+#endif
+    LOG_INFO("Biased statement locks unavailable (no membarrier), using plain mutexes");
+}
+
+int pg_bias_lock_enabled(void) {
+    pthread_once(&bias_once, bias_setup);
+    return bias_enabled;
+}
+
+// Full fence on every thread of the process, i.e. on the owner too
+static void process_fence(void) {
+#if defined(__linux__) && defined(SYS_membarrier)
+    if (syscall(SYS_membarrier, PG_MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0) == 0) return;
+    LOG_ERROR("membarrier failed (errno=%d)", errno);
+#endif
+    atomic_thread_fence(memory_order_seq_cst);  // Not reached when biasing is enabled
+}
+
+void pg_bias_lock_init(pg_bias_lock_t *l) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&l->mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+    atomic_store(&l->owner, 0);
+    atomic_store(&l->depth, 0);
+    atomic_store(&l->revoke, 0);
+    memset(&l->last_thread, 0, sizeof(l->last_thread));
+    l->revocations = 0;
+}
+
+void pg_bias_lock_destroy(pg_bias_lock_t *l) {
+    pthread_mutex_destroy(&l->mutex);
+}
+
+// Caller holds the mutex and is not the owner
+static void revoke_bias(pg_bias_lock_t *l) {
+    atomic_store(&l->revoke, 1);
+    process_fence();
+
+    // Owner is inside a critical section - as long as it would have held
+    // the mutex; back off from spinning to sleeping
+    for (int spins = 0; atomic_load_explicit(&l->depth, memory_order_acquire) != 0; spins++) {
+        if (spins < 100) {
+            sched_yield();
+        } else {
+            struct timespec ts = { 0, 50000 };  // 50us
+            nanosleep(&ts, NULL);
+        }
+    }
+    atomic_store_explicit(&l->owner, 0, memory_order_relaxed);
+    l->revocations++;
+}
+
+// Mutex held; bias to the caller if it also took the lock last time
+static void maybe_bias(pg_bias_lock_t *l, pthread_t self) {
+    if (atomic_load_explicit(&l->owner, memory_order_relaxed) == 0 &&
+        l->revocations < PG_BIAS_MAX_REVOKES &&
+        pthread_equal(l->last_thread, self) && pg_bias_lock_enabled()) {
+        atomic_store_explicit(&l->revoke, 0, memory_order_relaxed);
+        atomic_store_explicit(&l->owner, (uintptr_t)self, memory_order_release);
+    }
+    l->last_thread = self;
+}
+
+void pg_bias_lock_slow(pg_bias_lock_t *l) {
+    pthread_mutex_lock(&l->mutex);
+    pthread_t self = pthread_self();
+    uintptr_t owner = atomic_load_explicit(&l->owner, memory_order_relaxed);
+    if (owner && owner != (uintptr_t)self) revoke_bias(l);
+    maybe_bias(l, self);
+}
+
+int pg_bias_trylock(pg_bias_lock_t *l) {
+    uintptr_t self = (uintptr_t)pthread_self();
+    if (pg_bias_lock_fast(l, self)) return 0;
+    uintptr_t owner = atomic_load_explicit(&l->owner, memory_order_relaxed);
+    if (owner && owner != self) return EBUSY;  // Biased to another thread - don't revoke from here
+
+    int rc = pthread_mutex_trylock(&l->mutex);
+    if (rc != 0) return rc;
+    if (atomic_load_explicit(&l->owner, memory_order_relaxed) != 0) {
+        // Another thread biased it between the check and the trylock
+        pthread_mutex_unlock(&l->mutex);
+        return EBUSY;
+    }
+    return 0;
+}
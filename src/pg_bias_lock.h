@@ -0,0 +1,87 @@
+/*
+ * PostgreSQL Shim - Biased (owner-thread) statement lock
+ *
+ * SQLite statements are almost always driven by one thread at a time, yet
+ * every bind/step/column call locked the statement's recursive mutex - two
+ * atomic RMWs per call, 60 for a 30-column row.
+ *
+ * A pg_bias_lock_t is a recursive mutex plus a bias: once the same thread
+ * has taken the mutex twice in a row, the lock is biased to it and that
+ * thread locks/unlocks with plain stores (no RMW, no fence). Any other
+ * thread takes the mutex and revokes the bias first:
+ *
+ *   owner:    depth = 1; compiler barrier; if (!revoke) -> locked
+ *   revoker:  revoke = 1; membarrier(); wait for depth == 0; owner = 0
+ *
+ * membarrier(MEMBARRIER_CMD_PRIVATE_EXPEDITED) supplies the owner's half of
+ * the store/load fence (asymmetric Dekker), so only the rare revocation pays
+ * for it. After a revocation the lock is a plain mutex until the same thread
+ * again takes it twice in a row; locks revoked PG_BIAS_MAX_REVOKES times
+ * stay plain mutexes for good.
+ *
+ * Without membarrier (macOS, old kernels, PLEX_PG_BIASED_LOCKS=0) nothing is
+ * ever biased and every call is the recursive mutex as before.
+ */
+
+#ifndef PG_BIAS_LOCK_H
+#define PG_BIAS_LOCK_H
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#define PG_BIAS_MAX_REVOKES 8
+
+typedef struct {
+    pthread_mutex_t mutex;          // Recursive
+    _Atomic(uintptr_t) owner;       // Biased thread (pthread_self), 0 = unbiased
+    atomic_int depth;               // Owner's recursion depth on the biased path (owner writes)
+    atomic_int revoke;              // Set by a thread revoking the bias
+    pthread_t last_thread;          // Last mutex-path acquirer (ownership transfer detection)
+    int revocations;
+} pg_bias_lock_t;
+
+void pg_bias_lock_init(pg_bias_lock_t *l);
+void pg_bias_lock_destroy(pg_bias_lock_t *l);
+
+// Slow paths - use the inline functions below
+void pg_bias_lock_slow(pg_bias_lock_t *l);
+
+// 0 = locked. Never waits for another thread (EBUSY instead), and never
+// revokes a bias held by another thread.
+int pg_bias_trylock(pg_bias_lock_t *l);
+
+// 1 if biasing is available in this process (membarrier registered)
+int pg_bias_lock_enabled(void);
+
+// Biased path for the owner; 1 = locked, 0 = not ours (any more)
+static inline int pg_bias_lock_fast(pg_bias_lock_t *l, uintptr_t self) {
+    if (atomic_load_explicit(&l->owner, memory_order_relaxed) != self) return 0;
+    int depth = atomic_load_explicit(&l->depth, memory_order_relaxed);
+    atomic_store_explicit(&l->depth, depth + 1, memory_order_relaxed);
+    if (depth > 0) return 1;  // Nested - a revoker is already waiting for us
+    atomic_signal_fence(memory_order_seq_cst);  // Revoker's membarrier does the rest
+    if (!atomic_load_explicit(&l->revoke, memory_order_relaxed)) {
+        atomic_thread_fence(memory_order_acquire);
+        return 1;
+    }
+    atomic_store_explicit(&l->depth, 0, memory_order_release);  // Lost the bias
+    return 0;
+}
+
+static inline void pg_bias_lock(pg_bias_lock_t *l) {
+    if (!pg_bias_lock_fast(l, (uintptr_t)pthread_self())) pg_bias_lock_slow(l);
+}
+
+static inline void pg_bias_unlock(pg_bias_lock_t *l) {
+    if (atomic_load_explicit(&l->owner, memory_order_relaxed) == (uintptr_t)pthread_self()) {
+        int depth = atomic_load_explicit(&l->depth, memory_order_relaxed);
+        if (depth > 0) {
+            atomic_store_explicit(&l->depth, depth - 1, memory_order_release);
+            return;
+        }
+    }
+    pthread_mutex_unlock(&l->mutex);
+}
+
+#endif // PG_BIAS_LOCK_H
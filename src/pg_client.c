@@ -6,6 +6,7 @@
 #include "pg_client.h"
 #include "pg_config.h"
 #include "pg_logging.h"
+#include "pg_mem.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -64,6 +65,20 @@ static inline uint32_t hash_ptr(const void *ptr) {
     val = (val >> 16) ^ val;
     return (uint32_t)(val & (CONN_HASH_BUCKETS - 1));
 }
+
+// pg_connection_t is mostly its prepared statement cache (STMT_CACHE_SIZE
+// entries) - charged to pg_mem for the connection's lifetime
+static pg_connection_t* alloc_connection(void) {
+    pg_connection_t *conn = calloc(1, sizeof(pg_connection_t));
+    if (conn) pg_mem_charge(PG_MEM_STMT_CACHE, sizeof(pg_connection_t));
+    return conn;
+}
+
+static void free_connection(pg_connection_t *conn) {
+    pthread_mutex_destroy(&conn->mutex);
+    free(conn);
+    pg_mem_charge(PG_MEM_STMT_CACHE, -(ssize_t)sizeof(pg_connection_t));
+}
 static volatile int client_initialized = 0;
 static pthread_once_t client_init_once = PTHREAD_ONCE_INIT;
 
@@ -211,8 +226,7 @@ void pg_client_cleanup(void) {
             if (connections[i]->conn) {
                 PQfinish(connections[i]->conn);
             }
-            pthread_mutex_destroy(&connections[i]->mutex);
-            free(connections[i]);
+            free_connection(connections[i]);
             connections[i] = NULL;
         }
     }
@@ -230,8 +244,7 @@ void pg_client_cleanup(void) {
                         i, old_state, (void*)library_pool[i].owner_thread);
                 PQfinish(library_pool[i].conn->conn);
             }
-            pthread_mutex_destroy(&library_pool[i].conn->mutex);
-            free(library_pool[i].conn);
+            free_connection(library_pool[i].conn);
             library_pool[i].conn = NULL;
         }
         library_pool[i].owner_thread = 0;
@@ -506,8 +519,7 @@ static void pool_reap_idle_connections(void) {
                 if (library_pool[i].conn->conn) {
                     PQfinish(library_pool[i].conn->conn);
                 }
-                pthread_mutex_destroy(&library_pool[i].conn->mutex);
-                free(library_pool[i].conn);
+                free_connection(library_pool[i].conn);
                 library_pool[i].conn = NULL;
                 library_pool[i].owner_thread = 0;
                 library_pool[i].last_used = 0;
@@ -542,7 +554,7 @@ static void pool_reap_idle_connections(void) {
 static pg_connection_t* create_pool_connection(const char *db_path) {
     pg_conn_config_t *cfg = pg_config_get();
 
-    pg_connection_t *conn = calloc(1, sizeof(pg_connection_t));
+    pg_connection_t *conn = alloc_connection();
     if (!conn) {
         LOG_ERROR("Failed to allocate pg_connection_t for pool");
         return NULL;
@@ -594,6 +606,14 @@ static pg_connection_t* create_pool_connection(const char *db_path) {
     return conn;
 }
 
+pg_connection_t* pg_connect_maintenance(const char *purpose) {
+    pg_connection_t *conn = create_pool_connection(purpose);
+    if (conn && conn->conn) {
+        LOG_INFO("Maintenance connection opened (%s)", purpose ? purpose : "?");
+    }
+    return conn;
+}
+
 // Helper: Perform reconnection for a slot (caller must own the slot via SLOT_RECONNECTING)
 static pg_connection_t* do_slot_reconnect(int slot_idx) {
     pg_connection_t *conn = library_pool[slot_idx].conn;
@@ -856,8 +876,7 @@ static pg_connection_t* pool_get_connection(const char *db_path) {
                 library_pool[i].owner_thread = 0;
                 if (new_conn) {
                     if (new_conn->conn) PQfinish(new_conn->conn);
-                    pthread_mutex_destroy(&new_conn->mutex);
-                    free(new_conn);
+                    free_connection(new_conn);
                 }
                 atomic_store(&library_pool[i].state, SLOT_FREE);
                 // Continue trying other slots
@@ -882,8 +901,7 @@ static pg_connection_t* pool_get_connection(const char *db_path) {
                 if (library_pool[i].conn->conn) {
                     PQfinish(library_pool[i].conn->conn);
                 }
-                pthread_mutex_destroy(&library_pool[i].conn->mutex);
-                free(library_pool[i].conn);
+                free_connection(library_pool[i].conn);
                 library_pool[i].conn = NULL;
             }
 
@@ -902,8 +920,7 @@ static pg_connection_t* pool_get_connection(const char *db_path) {
                 library_pool[i].owner_thread = 0;
                 if (new_conn) {
                     if (new_conn->conn) PQfinish(new_conn->conn);
-                    pthread_mutex_destroy(&new_conn->mutex);
-                    free(new_conn);
+                    free_connection(new_conn);
                 }
                 atomic_store(&library_pool[i].state, SLOT_FREE);
             }
@@ -1061,7 +1078,7 @@ void pg_close_pool_for_db(sqlite3 *db) {
 pg_connection_t* pg_connect(const char *db_path, sqlite3 *shadow_db) {
     pg_conn_config_t *cfg = pg_config_get();
 
-    pg_connection_t *conn = calloc(1, sizeof(pg_connection_t));
+    pg_connection_t *conn = alloc_connection();
     if (!conn) {
         LOG_ERROR("Failed to allocate pg_connection_t");
         return NULL;
@@ -1206,8 +1223,7 @@ void pg_close(pg_connection_t *conn) {
     }
     pthread_mutex_unlock(&conn->mutex);
 
-    pthread_mutex_destroy(&conn->mutex);
-    free(conn);
+    free_connection(conn);
 }
 
 // ============================================================================
@@ -1244,6 +1260,27 @@ void pg_set_global_last_insert_rowid(sqlite3_int64 id) {
     pthread_mutex_unlock(&global_rowid_mutex);
 }
 
+// Avoids a SELECT lastval() round trip in last_insert_rowid(): every INSERT
+// already carries RETURNING id, so the value is on the result we just got.
+sqlite3_int64 pg_capture_insert_rowid(pg_connection_t *conn, const PGresult *res) {
+    if (!res || PQresultStatus(res) != PGRES_TUPLES_OK) return 0;
+
+    int rows = PQntuples(res);
+    if (rows <= 0 || PQnfields(res) < 1) return 0;
+
+    // Only trust our own RETURNING id, not an arbitrary RETURNING list
+    const char *fname = PQfname(res, 0);
+    if (!fname || strcmp(fname, "id") != 0) return 0;
+    if (PQgetisnull(res, rows - 1, 0)) return 0;
+
+    sqlite3_int64 id = atoll(PQgetvalue(res, rows - 1, 0));
+    if (id <= 0) return 0;
+
+    if (conn) conn->last_insert_rowid = id;
+    pg_set_global_last_insert_rowid(id);
+    return id;
+}
+
 // ============================================================================
 // Fork Safety - Connection Pool Cleanup
 // ============================================================================
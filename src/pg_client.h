@@ -24,6 +24,11 @@ pg_connection_t* pg_find_connection(sqlite3 *db);          // Returns pool conn
 pg_connection_t* pg_find_handle_connection(sqlite3 *db);   // Returns registered handle (never pool)
 pg_connection_t* pg_find_any_library_connection(void);
 
+// Standalone connection for background work (cache refresh, LISTEN).
+// Not part of the pool or registry; owned by the caller, close with pg_close().
+// Returns NULL on allocation failure; conn->conn is NULL if connecting failed.
+pg_connection_t* pg_connect_maintenance(const char *purpose);
+
 // Thread-local connection (one PG connection per thread for library.db)
 pg_connection_t* pg_get_thread_connection(const char *db_path);
 
@@ -45,6 +50,10 @@ void pg_set_global_metadata_id(sqlite3_int64 id);
 sqlite3_int64 pg_get_global_last_insert_rowid(void);
 void pg_set_global_last_insert_rowid(sqlite3_int64 id);
 
+// Capture the id returned by INSERT ... RETURNING id (last row wins, like lastval())
+// Stores it in conn->last_insert_rowid and the global rowid. Returns 0 if none.
+sqlite3_int64 pg_capture_insert_rowid(pg_connection_t *conn, const PGresult *res);
+
 // Prepared statement cache management
 uint64_t pg_hash_sql(const char *sql);
 int pg_stmt_cache_lookup(pg_connection_t *conn, uint64_t sql_hash, const char **stmt_name);
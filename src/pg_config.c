@@ -167,3 +167,16 @@ int is_read_operation(const char *sql) {
 
     return 0;
 }
+
+int is_ddl_operation(const char *sql) {
+    if (!sql) return 0;
+
+    // Skip whitespace
+    while (*sql && isspace(*sql)) sql++;
+
+    if (strncasecmp(sql, "CREATE", 6) == 0) return 1;
+    if (strncasecmp(sql, "ALTER", 5) == 0) return 1;
+    if (strncasecmp(sql, "DROP", 4) == 0) return 1;
+
+    return 0;
+}
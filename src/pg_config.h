@@ -17,5 +17,6 @@ int should_redirect(const char *filename);
 int should_skip_sql(const char *sql);
 int is_write_operation(const char *sql);
 int is_read_operation(const char *sql);
+int is_ddl_operation(const char *sql);
 
 #endif // PG_CONFIG_H
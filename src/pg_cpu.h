@@ -0,0 +1,46 @@
+/*
+ * PostgreSQL Shim - CPU Feature Detection
+ *
+ * Runtime checks for the SIMD code paths (pg_utf8, pg_hex). Uses cpuid
+ * directly rather than __builtin_cpu_supports, which needs libgcc's
+ * __cpu_model and is unavailable in the -nodefaultlibs musl link.
+ * Callers cache the result (pthread_once) - cpuid is slow.
+ */
+
+#ifndef PG_CPU_H
+#define PG_CPU_H
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PG_CPU_X86 1
+#include <cpuid.h>
+
+static inline int pg_cpu_has_ssse3(void) {
+    unsigned int a, b, c, d;
+    if (!__get_cpuid(1, &a, &b, &c, &d)) return 0;
+    return (c & bit_SSSE3) != 0;
+}
+
+static inline int pg_cpu_has_sse41(void) {
+    unsigned int a, b, c, d;
+    if (!__get_cpuid(1, &a, &b, &c, &d)) return 0;
+    return (c & bit_SSE4_1) != 0;
+}
+
+static inline int pg_cpu_has_avx2(void) {
+    unsigned int a, b, c, d;
+    if (!__get_cpuid(1, &a, &b, &c, &d)) return 0;
+    if (!(c & bit_OSXSAVE) || !(c & bit_AVX)) return 0;
+    // OS saves the YMM state (XCR0 bits 1 and 2)
+    unsigned int xcr0_lo, xcr0_hi;
+    __asm__ volatile("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+    (void)xcr0_hi;
+    if ((xcr0_lo & 0x6) != 0x6) return 0;
+    if (!__get_cpuid_count(7, 0, &a, &b, &c, &d)) return 0;
+    return (b & bit_AVX2) != 0;
+}
+
+#elif defined(__aarch64__)
+#define PG_CPU_NEON 1  // Baseline on aarch64, no check needed
+#endif
+
+#endif // PG_CPU_H
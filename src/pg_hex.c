@@ -0,0 +1,208 @@
+/*
+ * PostgreSQL Shim - BYTEA Hex Codec Implementation
+ *
+ * Encode: split each byte into nibbles, map both through "0123456789abcdef"
+ * with one pshufb, interleave high/low with unpack.
+ *
+ * Decode: for each character c, d = c - '0' is a digit when d <= 9 and
+ * a = (c | 0x20) - 'a' is a letter when a <= 5 (unsigned compares via
+ * min_epu8). Anything else is an error. Nibble pairs are merged into bytes
+ * with pmaddubsw (hi * 16 + lo) and packed back to 8 bits.
+ */
+
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "pg_hex.h"
+
+#ifdef PG_CPU_X86
+#include <immintrin.h>
+#endif
+
+// Inputs shorter than this (in bytes of binary data) stay scalar
+#define HEX_SIMD_MIN_LEN 32
+
+static const char hex_chars[] = "0123456789abcdef";
+
+// Hex digit values, 255 = invalid
+static const unsigned char hex_lut[256] = {
+    255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
+    255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
+    255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
+    0,1,2,3,4,5,6,7,8,9,255,255,255,255,255,255,  // 0-9
+    255,10,11,12,13,14,15,255,255,255,255,255,255,255,255,255,  // A-F
+    255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
+    255,10,11,12,13,14,15,255,255,255,255,255,255,255,255,255,  // a-f
+    255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
+    255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
+    255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
+    255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
+    255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
+    255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
+    255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
+    255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
+    255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255
+};
+
+// ============================================================================
+// Scalar
+// ============================================================================
+
+void pg_hex_encode_scalar(char *dst, const unsigned char *src, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        dst[i * 2] = hex_chars[src[i] >> 4];
+        dst[i * 2 + 1] = hex_chars[src[i] & 0x0F];
+    }
+}
+
+int pg_hex_decode_scalar(unsigned char *dst, const char *src, size_t bin_len) {
+    for (size_t i = 0; i < bin_len; i++) {
+        unsigned char hi = hex_lut[(unsigned char)src[i * 2]];
+        unsigned char lo = hex_lut[(unsigned char)src[i * 2 + 1]];
+        if (hi == 255 || lo == 255) return 0;
+        dst[i] = (unsigned char)((hi << 4) | lo);
+    }
+    return 1;
+}
+
+// ============================================================================
+// x86-64: SSSE3 / AVX2
+// ============================================================================
+
+#ifdef PG_CPU_X86
+
+__attribute__((target("ssse3")))
+void pg_hex_encode_ssse3(char *dst, const unsigned char *src, size_t len) {
+    const __m128i digits = _mm_loadu_si128((const __m128i *)hex_chars);
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i in = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i hi = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(in, 4), nibble));
+        __m128i lo = _mm_shuffle_epi8(digits, _mm_and_si128(in, nibble));
+        _mm_storeu_si128((__m128i *)(dst + i * 2), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128((__m128i *)(dst + i * 2 + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+    pg_hex_encode_scalar(dst + i * 2, src + i, len - i);
+}
+
+// 16 hex characters -> 16 nibbles; sets *bad if any character is not hex
+__attribute__((target("ssse3")))
+static inline __m128i hex_nibbles_ssse3(__m128i c, __m128i *bad) {
+    __m128i d = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+    __m128i a = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(9)), d);
+    __m128i is_alpha = _mm_cmpeq_epi8(_mm_min_epu8(a, _mm_set1_epi8(5)), a);
+    *bad = _mm_or_si128(*bad, _mm_xor_si128(_mm_or_si128(is_digit, is_alpha), _mm_set1_epi8(-1)));
+    __m128i alpha = _mm_add_epi8(a, _mm_set1_epi8(10));
+    return _mm_or_si128(_mm_and_si128(is_digit, d), _mm_andnot_si128(is_digit, alpha));
+}
+
+__attribute__((target("ssse3")))
+int pg_hex_decode_ssse3(unsigned char *dst, const char *src, size_t bin_len) {
+    const __m128i weights = _mm_set1_epi16(0x0110);  // Bytes (16, 1): hi * 16 + lo
+    size_t i = 0;
+    for (; i + 16 <= bin_len; i += 16) {
+        __m128i bad = _mm_setzero_si128();
+        __m128i n0 = hex_nibbles_ssse3(_mm_loadu_si128((const __m128i *)(src + i * 2)), &bad);
+        __m128i n1 = hex_nibbles_ssse3(_mm_loadu_si128((const __m128i *)(src + i * 2 + 16)), &bad);
+        if (_mm_movemask_epi8(bad)) return 0;
+        __m128i w0 = _mm_maddubs_epi16(n0, weights);
+        __m128i w1 = _mm_maddubs_epi16(n1, weights);
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(w0, w1));
+    }
+    return pg_hex_decode_scalar(dst + i, src + i * 2, bin_len - i);
+}
+
+__attribute__((target("avx2")))
+void pg_hex_encode_avx2(char *dst, const unsigned char *src, size_t len) {
+    const __m256i digits = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)hex_chars));
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i in = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i hi = _mm256_shuffle_epi8(digits, _mm256_and_si256(_mm256_srli_epi16(in, 4), nibble));
+        __m256i lo = _mm256_shuffle_epi8(digits, _mm256_and_si256(in, nibble));
+        // Unpack works per 128-bit lane: lo holds bytes 0-7 | 16-23, hi 8-15 | 24-31
+        __m256i ul = _mm256_unpacklo_epi8(hi, lo);
+        __m256i uh = _mm256_unpackhi_epi8(hi, lo);
+        _mm256_storeu_si256((__m256i *)(dst + i * 2), _mm256_permute2x128_si256(ul, uh, 0x20));
+        _mm256_storeu_si256((__m256i *)(dst + i * 2 + 32), _mm256_permute2x128_si256(ul, uh, 0x31));
+    }
+    pg_hex_encode_ssse3(dst + i * 2, src + i, len - i);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i hex_nibbles_avx2(__m256i c, __m256i *bad) {
+    __m256i d = _mm256_sub_epi8(c, _mm256_set1_epi8('0'));
+    __m256i a = _mm256_sub_epi8(_mm256_or_si256(c, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+    __m256i is_digit = _mm256_cmpeq_epi8(_mm256_min_epu8(d, _mm256_set1_epi8(9)), d);
+    __m256i is_alpha = _mm256_cmpeq_epi8(_mm256_min_epu8(a, _mm256_set1_epi8(5)), a);
+    *bad = _mm256_or_si256(*bad, _mm256_xor_si256(_mm256_or_si256(is_digit, is_alpha), _mm256_set1_epi8(-1)));
+    __m256i alpha = _mm256_add_epi8(a, _mm256_set1_epi8(10));
+    return _mm256_blendv_epi8(alpha, d, is_digit);
+}
+
+__attribute__((target("avx2")))
+int pg_hex_decode_avx2(unsigned char *dst, const char *src, size_t bin_len) {
+    const __m256i weights = _mm256_set1_epi16(0x0110);
+    size_t i = 0;
+    for (; i + 32 <= bin_len; i += 32) {
+        __m256i bad = _mm256_setzero_si256();
+        __m256i n0 = hex_nibbles_avx2(_mm256_loadu_si256((const __m256i *)(src + i * 2)), &bad);
+        __m256i n1 = hex_nibbles_avx2(_mm256_loadu_si256((const __m256i *)(src + i * 2 + 32)), &bad);
+        if (_mm256_movemask_epi8(bad)) return 0;
+        __m256i w0 = _mm256_maddubs_epi16(n0, weights);
+        __m256i w1 = _mm256_maddubs_epi16(n1, weights);
+        // packus interleaves lanes (w0.lo, w1.lo, w0.hi, w1.hi) - restore order
+        __m256i packed = _mm256_packus_epi16(w0, w1);
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_permute4x64_epi64(packed, 0xD8));
+    }
+    return pg_hex_decode_ssse3(dst + i, src + i * 2, bin_len - i);
+}
+
+#endif // PG_CPU_X86
+
+// ============================================================================
+// Dispatch
+// ============================================================================
+
+static void (*hex_encode_impl)(char *, const unsigned char *, size_t) = pg_hex_encode_scalar;
+static int (*hex_decode_impl)(unsigned char *, const char *, size_t) = pg_hex_decode_scalar;
+static const char *hex_impl_name = "scalar";
+static pthread_once_t hex_once = PTHREAD_ONCE_INIT;
+
+static void hex_select(void) {
+#ifdef PG_CPU_X86
+    if (pg_cpu_has_avx2()) {
+        hex_encode_impl = pg_hex_encode_avx2;
+        hex_decode_impl = pg_hex_decode_avx2;
+        hex_impl_name = "avx2";
+    } else if (pg_cpu_has_ssse3()) {
+        hex_encode_impl = pg_hex_encode_ssse3;
+        hex_decode_impl = pg_hex_decode_ssse3;
+        hex_impl_name = "ssse3";
+    }
+#endif
+}
+
+void pg_hex_encode(char *dst, const unsigned char *src, size_t len) {
+    if (len < HEX_SIMD_MIN_LEN) {
+        pg_hex_encode_scalar(dst, src, len);
+        return;
+    }
+    pthread_once(&hex_once, hex_select);
+    hex_encode_impl(dst, src, len);
+}
+
+int pg_hex_decode(unsigned char *dst, const char *src, size_t bin_len) {
+    if (bin_len < HEX_SIMD_MIN_LEN) return pg_hex_decode_scalar(dst, src, bin_len);
+    pthread_once(&hex_once, hex_select);
+    return hex_decode_impl(dst, src, bin_len);
+}
+
+const char* pg_hex_impl_name(void) {
+    pthread_once(&hex_once, hex_select);
+    return hex_impl_name;
+}
@@ -0,0 +1,43 @@
+/*
+ * PostgreSQL Shim - BYTEA Hex Codec
+ *
+ * PostgreSQL's text-format bytea is "\x" followed by two hex digits per
+ * byte. Blob parameters sent as text are encoded with pg_hex_encode();
+ * text-format bytea results are decoded with pg_hex_decode(). The blobs
+ * database moves multi-megabyte thumbnails through both.
+ *
+ * Design:
+ * - Nibble lookup through pshufb: 16 (SSSE3) or 32 (AVX2) bytes per step
+ * - Decode validates every digit; any non-hex character fails the call
+ * - Implementation chosen once at runtime (pg_cpu.h), scalar fallback for
+ *   short inputs, tails and other architectures
+ */
+
+#ifndef PG_HEX_H
+#define PG_HEX_H
+
+#include <stddef.h>
+
+#include "pg_cpu.h"
+
+// Write 2 * len lowercase hex digits to dst (no prefix, no terminator)
+void pg_hex_encode(char *dst, const unsigned char *src, size_t len);
+
+// Decode 2 * bin_len hex digits (either case) from src into bin_len bytes.
+// Returns 1, or 0 if src holds a non-hex character (dst contents undefined).
+int pg_hex_decode(unsigned char *dst, const char *src, size_t bin_len);
+
+// Name of the implementation in use ("avx2", "ssse3", "scalar")
+const char* pg_hex_impl_name(void);
+
+// Individual implementations (tests and benchmarks)
+void pg_hex_encode_scalar(char *dst, const unsigned char *src, size_t len);
+int pg_hex_decode_scalar(unsigned char *dst, const char *src, size_t bin_len);
+#ifdef PG_CPU_X86
+void pg_hex_encode_ssse3(char *dst, const unsigned char *src, size_t len);  // Requires pg_cpu_has_ssse3()
+int pg_hex_decode_ssse3(unsigned char *dst, const char *src, size_t bin_len);
+void pg_hex_encode_avx2(char *dst, const unsigned char *src, size_t len);   // Requires pg_cpu_has_avx2()
+int pg_hex_decode_avx2(unsigned char *dst, const char *src, size_t bin_len);
+#endif
+
+#endif // PG_HEX_H
@@ -0,0 +1,181 @@
+/*
+ * PostgreSQL Shim - Sequence ID Block Allocator Implementation
+ *
+ * A block is filled with
+ *     SELECT nextval($1::regclass) FROM generate_series(1, $2)
+ * which reserves N values atomically per value (each nextval is
+ * non-transactional and never handed out twice), in a single round trip.
+ * The values are usually contiguous, but concurrent writers may interleave,
+ * so the block stores the returned ids rather than a [start, end) range.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <pthread.h>
+
+#include "pg_id_block.h"
+#include "pg_logging.h"
+
+typedef struct {
+    char seq_name[128];          // Set once when the slot is claimed, then read-only
+    sqlite3_int64 *ids;          // Reserved ids, handed out in order
+    int count;                   // Number of ids in the block
+    int next;                    // Index of next id to hand out
+    sqlite3_int64 *spare;        // Refill target, swapped with ids (refill_mutex)
+    pthread_mutex_t refill_mutex;  // One round trip at a time per sequence
+} id_block_t;
+
+// Slots are claimed once and never freed, so a refilling thread can keep
+// its id_block_t pointer after dropping block_mutex
+static id_block_t blocks[PG_ID_BLOCK_MAX_SEQUENCES];
+static int block_count = 0;
+static int block_size = 1;
+static pthread_once_t block_size_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t block_mutex = PTHREAD_MUTEX_INITIALIZER;  // Slots and counts only
+
+static void read_block_size(void) {
+    int size = 1;
+    const char *env = getenv(ENV_PG_ID_BLOCK_SIZE);
+    if (env) {
+        size = atoi(env);
+        if (size < 1) size = 1;
+        if (size > PG_ID_BLOCK_MAX) {
+            LOG_INFO("%s=%d exceeds max, using %d", ENV_PG_ID_BLOCK_SIZE, size, PG_ID_BLOCK_MAX);
+            size = PG_ID_BLOCK_MAX;
+        }
+    }
+    block_size = size;
+    if (block_size > 1) {
+        LOG_INFO("ID block allocator enabled: %d ids per round trip", block_size);
+    }
+}
+
+// Must hold block_mutex
+static void reset_blocks_locked(void) {
+    for (int i = 0; i < block_count; i++) {
+        blocks[i].count = 0;
+        blocks[i].next = 0;
+    }
+}
+
+void pg_id_block_init(void) {
+    pthread_once(&block_size_once, read_block_size);
+}
+
+// A refill already in flight still installs its block afterwards - those
+// ids were reserved after the reset, so they are safe to hand out
+void pg_id_block_reset(void) {
+    pthread_mutex_lock(&block_mutex);
+    reset_blocks_locked();
+    pthread_mutex_unlock(&block_mutex);
+}
+
+// Called in child after fork(): ids reserved before fork() belong to the
+// parent - handing them out again would produce duplicate keys. The mutexes
+// may have been held by parent threads mid-refill, so reinitialize them first.
+void pg_id_block_reset_after_fork(void) {
+    pthread_mutex_init(&block_mutex, NULL);
+    for (int i = 0; i < block_count; i++) {
+        pthread_mutex_init(&blocks[i].refill_mutex, NULL);
+    }
+    reset_blocks_locked();
+}
+
+// Must hold block_mutex
+static id_block_t* find_block_locked(const char *seq_name) {
+    for (int i = 0; i < block_count; i++) {
+        if (strcmp(blocks[i].seq_name, seq_name) == 0) return &blocks[i];
+    }
+    if (block_count >= PG_ID_BLOCK_MAX_SEQUENCES) return NULL;
+    if (strlen(seq_name) >= sizeof(blocks[0].seq_name)) return NULL;
+
+    id_block_t *b = &blocks[block_count];
+    b->ids = malloc(sizeof(sqlite3_int64) * block_size);
+    b->spare = malloc(sizeof(sqlite3_int64) * block_size);
+    if (!b->ids || !b->spare) {
+        free(b->ids);
+        free(b->spare);
+        b->ids = b->spare = NULL;
+        return NULL;
+    }
+    strcpy(b->seq_name, seq_name);
+    b->count = 0;
+    b->next = 0;
+    pthread_mutex_init(&b->refill_mutex, NULL);
+    block_count++;
+    return b;
+}
+
+// Must hold block_mutex; 1 if an id was taken
+static int take_locked(id_block_t *b, sqlite3_int64 *id) {
+    if (b->next >= b->count) return 0;
+    *id = b->ids[b->next++];
+    return 1;
+}
+
+// Reserve up to block_size ids into b->spare. Must hold b->refill_mutex but
+// NOT block_mutex - other sequences keep handing out ids during the round trip.
+// Returns the number of ids reserved.
+static int fetch_block(PGconn *conn, id_block_t *b) {
+    char size_str[16];
+    snprintf(size_str, sizeof(size_str), "%d", block_size);
+    const char *params[2] = { b->seq_name, size_str };
+
+    PGresult *res = PQexecParams(conn,
+        "SELECT nextval($1::regclass) FROM generate_series(1, $2::int)",
+        2, NULL, params, NULL, NULL, 0);
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        LOG_ERROR("ID block refill failed for %s: %s", b->seq_name, PQerrorMessage(conn));
+        PQclear(res);
+        return 0;
+    }
+
+    int n = PQntuples(res);
+    if (n > block_size) n = block_size;
+    for (int i = 0; i < n; i++) {
+        b->spare[i] = atoll(PQgetvalue(res, i, 0));
+    }
+    PQclear(res);
+
+    if (n > 1) {
+        LOG_DEBUG("ID block: reserved %d ids from %s (%lld..%lld)",
+                  n, b->seq_name, (long long)b->spare[0], (long long)b->spare[n - 1]);
+    }
+    return n;
+}
+
+sqlite3_int64 pg_id_block_next(PGconn *conn, const char *seq_name) {
+    if (!conn || !seq_name) return 0;
+    pg_id_block_init();
+
+    sqlite3_int64 id = 0;
+    pthread_mutex_lock(&block_mutex);
+    id_block_t *b = find_block_locked(seq_name);
+    if (!b || take_locked(b, &id)) {
+        pthread_mutex_unlock(&block_mutex);
+        return id;
+    }
+    pthread_mutex_unlock(&block_mutex);
+
+    // Block empty - refill with only this sequence's refill_mutex held
+    pthread_mutex_lock(&b->refill_mutex);
+    pthread_mutex_lock(&block_mutex);
+    int taken = take_locked(b, &id);  // Refilled by another thread while we waited
+    pthread_mutex_unlock(&block_mutex);
+    if (!taken) {
+        int n = fetch_block(conn, b);
+        if (n > 0) {
+            pthread_mutex_lock(&block_mutex);
+            sqlite3_int64 *old = b->ids;
+            b->ids = b->spare;
+            b->spare = old;
+            b->count = n;
+            b->next = 0;
+            take_locked(b, &id);
+            pthread_mutex_unlock(&block_mutex);
+        }
+    }
+    pthread_mutex_unlock(&b->refill_mutex);
+    return id;
+}
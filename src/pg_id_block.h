@@ -0,0 +1,43 @@
+/*
+ * PostgreSQL Shim - Sequence ID Block Allocator
+ *
+ * Reserves ranges of sequence values with one round trip per block, so
+ * skipped INSERTs (and callers that assign ids themselves) can hand out
+ * ids locally instead of running nextval() per row.
+ *
+ * Design:
+ * - Per-process, one block per sequence. A short global mutex guards the
+ *   slots; the refill round trip holds only that sequence's refill mutex
+ *   and fills a spare array that is swapped in afterwards
+ * - Block size from PLEX_PG_ID_BLOCK_SIZE (unset/0/1 = one nextval per id)
+ * - Reserved ids are consumed from the real sequence, so they never collide
+ *   with ids the server assigns through column defaults (gaps are possible,
+ *   exactly like any aborted nextval())
+ * - Blocks are dropped in a forked child (ids belong to the parent)
+ */
+
+#ifndef PG_ID_BLOCK_H
+#define PG_ID_BLOCK_H
+
+#include <libpq-fe.h>
+#include <sqlite3.h>
+
+#define ENV_PG_ID_BLOCK_SIZE "PLEX_PG_ID_BLOCK_SIZE"
+#define PG_ID_BLOCK_MAX 4096        // Largest block reserved in one round trip
+#define PG_ID_BLOCK_MAX_SEQUENCES 16
+
+// Read PLEX_PG_ID_BLOCK_SIZE (safe to call repeatedly)
+void pg_id_block_init(void);
+
+// Take the next id for a sequence (e.g. "plex.statistics_media_id_seq").
+// Refills the block on `conn` when empty. Caller must own `conn`
+// (hold the pg_connection_t mutex). Returns 0 on failure.
+sqlite3_int64 pg_id_block_next(PGconn *conn, const char *seq_name);
+
+// Drop all reserved ids (remaining ids become sequence gaps)
+void pg_id_block_reset(void);
+
+// Fork safety - drop the parent's reserved ids in the child after fork()
+void pg_id_block_reset_after_fork(void);
+
+#endif // PG_ID_BLOCK_H
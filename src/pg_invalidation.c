@@ -0,0 +1,248 @@
+/*
+ * PostgreSQL Shim - Cross-Process Cache Invalidation Implementation
+ *
+ * Listener loop: poll() the LISTEN socket for up to PG_INVAL_FLUSH_MS,
+ * apply received notifications, then flush the outbox with
+ *     SELECT pg_notify($1, t) FROM unnest($2::text[]) t
+ * so a burst of writes costs one round trip per flush, on a connection no
+ * query is waiting for.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <poll.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <libpq-fe.h>
+
+#include "pg_invalidation.h"
+#include "pg_query_cache.h"
+#include "pg_row_cache.h"
+#include "pg_client.h"
+#include "pg_logging.h"
+
+static atomic_int listener_started = 0;
+static atomic_int listening = 0;
+static pg_connection_t *listener_conn = NULL;  // Listener thread only
+static int listener_pid = 0;                   // Backend PID of our LISTEN session
+static int listener_connects = 0;              // Listener thread only
+
+// Outbox - table names queued by writers
+static char pending_tables[PG_INVAL_MAX_PENDING][64];
+static int pending_count = 0;
+static int pending_all = 0;
+static int pending_schema = 0;
+static pthread_mutex_t pending_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Must hold pending_mutex
+static void queue_locked(const char *table) {
+    if (strcmp(table, PG_INVAL_SCHEMA) == 0) {
+        pending_schema = 1;
+    } else if (strcmp(table, PG_INVAL_ALL) == 0 || strlen(table) >= sizeof(pending_tables[0]) ||
+               strpbrk(table, "\"\\{},")) {
+        // Unknown, or not safe inside the text[] literal - drop everything
+        pending_all = 1;
+    } else if (!pending_all) {
+        int found = 0;
+        for (int i = 0; i < pending_count && !found; i++) {
+            found = strcmp(pending_tables[i], table) == 0;
+        }
+        if (!found) {
+            if (pending_count < PG_INVAL_MAX_PENDING) {
+                strcpy(pending_tables[pending_count++], table);
+            } else {
+                pending_all = 1;
+            }
+        }
+    }
+}
+
+static void apply_notification(const char *payload) {
+    if (!payload || !payload[0]) return;
+    if (strcmp(payload, PG_INVAL_SCHEMA) == 0) {
+        pg_query_cache_invalidate_schema();
+    } else if (strcmp(payload, PG_INVAL_ALL) == 0) {
+        pg_query_cache_invalidate_all();
+        pg_row_cache_invalidate_all();
+    } else {
+        pg_query_cache_invalidate_table(payload);
+        pg_row_cache_invalidate_table(payload);
+    }
+}
+
+static void listener_disconnect(const char *why) {
+    if (atomic_exchange(&listening, 0)) {
+        LOG_ERROR("Invalidation listener lost (%s) - caches fall back to TTL", why);
+    }
+    if (listener_conn) {
+        pg_close(listener_conn);
+        listener_conn = NULL;
+    }
+}
+
+static int listener_connect(void) {
+    listener_conn = pg_connect_maintenance("invalidation listener");
+    if (!listener_conn || !listener_conn->conn) {
+        listener_disconnect("connect failed");
+        return 0;
+    }
+
+    PGresult *res = PQexec(listener_conn->conn, "LISTEN " PG_INVAL_CHANNEL);
+    int ok = PQresultStatus(res) == PGRES_COMMAND_OK;
+    if (!ok) LOG_ERROR("LISTEN %s failed: %s", PG_INVAL_CHANNEL, PQerrorMessage(listener_conn->conn));
+    PQclear(res);
+    if (!ok) {
+        listener_disconnect("LISTEN failed");
+        return 0;
+    }
+
+    listener_pid = PQbackendPID(listener_conn->conn);
+
+    // Anything written by other processes before LISTEN took effect was missed
+    pg_query_cache_invalidate_schema();
+    if (listener_connects++ > 0) {
+        // And peers may have missed ours: a failed flush, or a NOTIFY lost
+        // with the old session
+        pthread_mutex_lock(&pending_mutex);
+        queue_locked(PG_INVAL_ALL);
+        pthread_mutex_unlock(&pending_mutex);
+    }
+    atomic_store(&listening, 1);
+    LOG_INFO("Invalidation listener active (channel=%s backend_pid=%d)", PG_INVAL_CHANNEL, listener_pid);
+    return 1;
+}
+
+// Build a text[] literal from the outbox and send it. Listener thread only.
+// A batch that fails to send goes back into the outbox - peers keep their
+// caches for the listen TTL, so a lost notification means stale reads there.
+static int flush_outbox(void) {
+    char tables[PG_INVAL_MAX_PENDING][64];
+    int count, all, schema;
+
+    pthread_mutex_lock(&pending_mutex);
+    count = pending_count;
+    all = pending_all;
+    schema = pending_schema;
+    memcpy(tables, pending_tables, sizeof(tables[0]) * count);
+    pending_count = 0;
+    pending_all = 0;
+    pending_schema = 0;
+    pthread_mutex_unlock(&pending_mutex);
+
+    if (!count && !all && !schema) return 1;
+
+    // pg_inval_publish() only queues names without quotes, backslashes,
+    // braces or commas, so quoting each element is enough
+    char array[PG_INVAL_MAX_PENDING * 68 + 32];
+    int off = snprintf(array, sizeof(array), "{");
+    if (schema) off += snprintf(array + off, sizeof(array) - off, "\"%s\"", PG_INVAL_SCHEMA);
+    if (all) off += snprintf(array + off, sizeof(array) - off, "%s\"%s\"", off > 1 ? "," : "", PG_INVAL_ALL);
+    for (int i = 0; i < count && !all; i++) {
+        off += snprintf(array + off, sizeof(array) - off, "%s\"%s\"", off > 1 ? "," : "", tables[i]);
+    }
+    snprintf(array + off, sizeof(array) - off, "}");
+
+    const char *params[2] = { PG_INVAL_CHANNEL, array };
+    PGresult *res = PQexecParams(listener_conn->conn,
+        "SELECT pg_notify($1, t) FROM unnest($2::text[]) t",
+        2, NULL, params, NULL, NULL, 0);
+    int ok = PQresultStatus(res) == PGRES_TUPLES_OK;
+    if (ok) {
+        LOG_DEBUG("Invalidation NOTIFY sent: %s", array);
+    } else {
+        LOG_ERROR("Invalidation NOTIFY failed: %s", PQerrorMessage(listener_conn->conn));
+    }
+    PQclear(res);
+    if (ok) return 1;
+
+    pthread_mutex_lock(&pending_mutex);
+    if (schema) queue_locked(PG_INVAL_SCHEMA);
+    if (all) queue_locked(PG_INVAL_ALL);
+    for (int i = 0; i < count && !all; i++) queue_locked(tables[i]);
+    pthread_mutex_unlock(&pending_mutex);
+    // Caller retries on a fresh session after PG_INVAL_RECONNECT_MS (which
+    // also publishes PG_INVAL_ALL) instead of every PG_INVAL_FLUSH_MS
+    listener_disconnect("NOTIFY failed");
+    return 0;
+}
+
+static void reconnect_wait(void) {
+    struct timespec ts = { PG_INVAL_RECONNECT_MS / 1000, (PG_INVAL_RECONNECT_MS % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+static void* listener_thread(void *arg) {
+    (void)arg;
+    for (;;) {
+        if (!listener_conn || PQstatus(listener_conn->conn) != CONNECTION_OK) {
+            if (listener_conn) listener_disconnect("connection closed");
+            if (!listener_connect()) {
+                reconnect_wait();
+                continue;
+            }
+        }
+
+        PGconn *conn = listener_conn->conn;
+        struct pollfd pfd = { .fd = PQsocket(conn), .events = POLLIN, .revents = 0 };
+        if (poll(&pfd, 1, PG_INVAL_FLUSH_MS) > 0 && !PQconsumeInput(conn)) {
+            listener_disconnect(PQerrorMessage(conn));
+            continue;
+        }
+
+        PGnotify *n;
+        while ((n = PQnotifies(conn)) != NULL) {
+            if (n->be_pid != listener_pid) {
+                LOG_DEBUG("Invalidation received from pid %d: %s", n->be_pid, n->extra);
+                apply_notification(n->extra);
+            }
+            PQfreemem(n);
+        }
+
+        if (!flush_outbox()) reconnect_wait();
+    }
+    return NULL;
+}
+
+void pg_inval_start(void) {
+    if (atomic_load(&listener_started)) return;
+    if (atomic_exchange(&listener_started, 1)) return;
+
+    pthread_t tid;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&tid, &attr, listener_thread, NULL) != 0) {
+        LOG_ERROR("Failed to start invalidation listener thread");
+        atomic_store(&listener_started, 0);
+    }
+    pthread_attr_destroy(&attr);
+}
+
+void pg_inval_publish(const char *table) {
+    if (!table || !table[0]) return;
+    pg_inval_start();
+
+    pthread_mutex_lock(&pending_mutex);
+    queue_locked(table);
+    pthread_mutex_unlock(&pending_mutex);
+}
+
+int pg_inval_listening(void) {
+    return atomic_load(&listening);
+}
+
+// Called in child after fork(): the listener thread doesn't exist in the
+// child and its socket belongs to the parent (don't PQfinish it)
+void pg_inval_reset_after_fork(void) {
+    pthread_mutex_init(&pending_mutex, NULL);
+    pending_count = 0;
+    pending_all = 0;
+    pending_schema = 0;
+    listener_conn = NULL;
+    listener_pid = 0;
+    listener_connects = 0;
+    atomic_store(&listening, 0);
+    atomic_store(&listener_started, 0);
+}
@@ -0,0 +1,48 @@
+/*
+ * PostgreSQL Shim - Cross-Process Cache Invalidation
+ *
+ * Plex Media Server, Plex Media Scanner and the transcoder all load the shim
+ * and each has its own caches. Writes are broadcast with
+ *     NOTIFY plex_shim_inval, '<table>'
+ * and every process runs one listener connection that applies other
+ * processes' notifications to the local per-table version counters
+ * (see pg_query_cache.h), which all shim caches check.
+ *
+ * Design:
+ * - One background thread per process owns a maintenance connection that
+ *   both LISTENs and sends this process's notifications
+ * - Outgoing notifications are queued by writers and flushed in one
+ *   round trip every PG_INVAL_FLUSH_MS (never on the writer's connection)
+ * - Notifications sent by our own listener session are ignored (local
+ *   caches were already invalidated by the writer)
+ * - Whenever the listener (re)connects, everything is invalidated, since
+ *   notifications sent while it was down are lost; after a reconnect it
+ *   also publishes PG_INVAL_ALL, since peers may have missed ours
+ * - A batch whose NOTIFY fails is put back in the outbox and retried on a
+ *   new session
+ */
+
+#ifndef PG_INVALIDATION_H
+#define PG_INVALIDATION_H
+
+#define PG_INVAL_CHANNEL "plex_shim_inval"
+#define PG_INVAL_ALL "*"                 // Payload: unknown write, drop everything
+#define PG_INVAL_SCHEMA "#schema"        // Payload: DDL, also reload schema caches
+#define PG_INVAL_FLUSH_MS 20             // Max delay before queued notifications are sent
+#define PG_INVAL_RECONNECT_MS 5000       // Retry interval while the listener is down
+#define PG_INVAL_MAX_PENDING 64          // Distinct tables queued per flush (overflow = ALL)
+
+// Start the listener thread (idempotent, cheap to call on hot paths)
+void pg_inval_start(void);
+
+// Queue a notification for other processes: a table name, PG_INVAL_ALL or
+// PG_INVAL_SCHEMA. Call AFTER the write has executed (autocommit).
+void pg_inval_publish(const char *table);
+
+// 1 while LISTEN is established (remote writes are being applied)
+int pg_inval_listening(void);
+
+// Fork safety - the listener thread and its socket belong to the parent
+void pg_inval_reset_after_fork(void);
+
+#endif // PG_INVALIDATION_H
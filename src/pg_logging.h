@@ -38,4 +38,10 @@ int is_known_translation_limitation(const char *error_msg);
 #define LOG_INFO(fmt, ...)  pg_log_message_internal(PG_LOG_INFO, fmt, ##__VA_ARGS__)
 #define LOG_DEBUG(fmt, ...) pg_log_message_internal(PG_LOG_DEBUG, fmt, ##__VA_ARGS__)
 
+// Per-query diagnostic traces (ULTRA_DEBUG_*, DEBUG_TRACE, write param
+// dumps). Compiled out unless built with `make TRACE=1`.
+#ifndef PG_DEBUG_TRACE
+#define PG_DEBUG_TRACE 0
+#endif
+
 #endif // PG_LOGGING_H
@@ -0,0 +1,248 @@
+/*
+ * PostgreSQL Shim - Cache Memory Accounting
+ *
+ * See pg_mem.h. Counters are plain atomics so charging from inside a
+ * cache's critical section costs one fetch_add; the budget check, reclaim
+ * and periodic logging live in pg_mem_check(), which callers run after
+ * dropping their locks.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "pg_mem.h"
+#include "pg_logging.h"
+
+// ============================================================================
+// State
+// ============================================================================
+
+static const char *KIND_NAMES[PG_MEM_KINDS] = {
+    "query_cache", "row_cache", "translations", "column_buffers",
+    "decltype", "templates", "stmt_cache", "values"
+};
+
+static _Atomic ssize_t kind_bytes[PG_MEM_KINDS];
+static _Atomic uint64_t kind_hits[PG_MEM_KINDS];
+static _Atomic ssize_t total_bytes = 0;
+static _Atomic(pg_mem_shrink_fn) shrinkers[PG_MEM_KINDS];
+
+static uint64_t hits_at_reclaim[PG_MEM_KINDS];  // Benefit baseline (reclaiming only)
+static atomic_int reclaiming = 0;               // Single-flight
+static _Atomic uint64_t total_reclaims = 0;
+static _Atomic uint64_t total_reclaimed = 0;
+static _Atomic uint64_t last_log_s = 0;
+static uint64_t last_reclaim_ms = 0;            // Reclaiming only
+static uint64_t last_reclaim_log_s = 0;
+static uint64_t reclaims_since_log = 0;
+static uint64_t reclaimed_since_log = 0;
+
+static size_t budget_bytes = 0;
+static pthread_once_t budget_once = PTHREAD_ONCE_INIT;
+
+static uint64_t get_time_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static uint64_t get_time_s(void) {
+    return get_time_ms() / 1000;
+}
+
+static void read_budget(void) {
+    long mb = PG_MEM_DEFAULT_BUDGET_MB;
+    const char *env = getenv("PLEX_PG_CACHE_MB");
+    if (env && *env) {
+        char *end;
+        long v = strtol(env, &end, 10);
+        if (*end == '\0' && v >= 16) {
+            mb = v;
+        } else {
+            LOG_ERROR("PLEX_PG_CACHE_MB=%s invalid (min 16), using %ld", env, mb);
+        }
+    }
+    budget_bytes = (size_t)mb * 1024 * 1024;
+    LOG_INFO("Cache memory budget: %ldMB", mb);
+}
+
+// ============================================================================
+// Reclaim
+// ============================================================================
+
+// Benefit per byte since the last reclaim; lower = evict first
+static double kind_score(int k) {
+    ssize_t bytes = atomic_load(&kind_bytes[k]);
+    if (bytes <= 0) return 0;
+    uint64_t hits = atomic_load(&kind_hits[k]) - hits_at_reclaim[k];
+    return (double)hits / (double)bytes;
+}
+
+// Bytes that no shrinker can give back (per-thread and static caches)
+static size_t unevictable_bytes(size_t total) {
+    size_t evictable = 0;
+    for (int k = 0; k < PG_MEM_KINDS; k++) {
+        ssize_t bytes = atomic_load(&kind_bytes[k]);
+        if (atomic_load(&shrinkers[k]) && bytes > 0) evictable += (size_t)bytes;
+    }
+    return total > evictable ? total - evictable : 0;
+}
+
+// Summary of the reclaims since the last line, at most every PG_MEM_RECLAIM_LOG_S
+static void reclaim_log(size_t total, size_t budget, size_t fixed, uint64_t now_s) {
+    if (now_s - last_reclaim_log_s < PG_MEM_RECLAIM_LOG_S && last_reclaim_log_s != 0) return;
+    last_reclaim_log_s = now_s;
+    if (fixed >= budget) {
+        LOG_INFO("PG_MEM: over budget (%zuMB > %zuMB), %zuMB of it per-thread - shared caches not shrunk",
+                 total / (1024 * 1024), budget / (1024 * 1024), fixed / (1024 * 1024));
+    } else {
+        LOG_INFO("PG_MEM: over budget (%zuMB > %zuMB), reclaimed %lluKB in %llu reclaim(s)",
+                 total / (1024 * 1024), budget / (1024 * 1024),
+                 (unsigned long long)(reclaimed_since_log / 1024),
+                 (unsigned long long)reclaims_since_log);
+    }
+    reclaims_since_log = 0;
+    reclaimed_since_log = 0;
+}
+
+// Shrink evictable caches, lowest score first, until total <= goal. The
+// goal is PG_MEM_RECLAIM_TARGET of the budget, raised when the
+// non-evictable bytes are already above it; nothing is shrunk when they
+// alone are over budget (emptying the shared caches wouldn't fix that).
+static void reclaim(size_t budget) {
+    uint64_t now_ms = get_time_ms();
+    if (now_ms - last_reclaim_ms < PG_MEM_RECLAIM_INTERVAL_MS && last_reclaim_ms != 0) return;
+    last_reclaim_ms = now_ms;
+
+    size_t target = (size_t)(budget * PG_MEM_RECLAIM_TARGET);
+    size_t before = (size_t)atomic_load(&total_bytes);
+    size_t fixed = unevictable_bytes(before);
+    if (fixed >= budget) {
+        reclaim_log(before, budget, fixed, now_ms / 1000);
+        return;
+    }
+    size_t goal = fixed < target ? target : fixed + (budget - fixed) / 2;
+    int tried[PG_MEM_KINDS] = {0};
+
+    for (;;) {
+        ssize_t total = atomic_load(&total_bytes);
+        if (total <= (ssize_t)goal) break;
+
+        int pick = -1;
+        double best = 0;
+        for (int k = 0; k < PG_MEM_KINDS; k++) {
+            if (tried[k] || !atomic_load(&shrinkers[k]) || atomic_load(&kind_bytes[k]) <= 0) continue;
+            double score = kind_score(k);
+            if (pick < 0 || score < best) {
+                pick = k;
+                best = score;
+            }
+        }
+        if (pick < 0) break;  // Nothing left to shrink - the rest is per-thread/static
+        tried[pick] = 1;
+
+        size_t freed = atomic_load(&shrinkers[pick])((size_t)(total - (ssize_t)goal));
+        LOG_DEBUG("PG_MEM: reclaimed %zuKB from %s (score=%.3g hits/KB)",
+                  freed / 1024, KIND_NAMES[pick], best * 1024);
+    }
+
+    for (int k = 0; k < PG_MEM_KINDS; k++) hits_at_reclaim[k] = atomic_load(&kind_hits[k]);
+
+    size_t after = (size_t)atomic_load(&total_bytes);
+    size_t freed = after < before ? before - after : 0;
+    atomic_fetch_add(&total_reclaims, 1);
+    atomic_fetch_add(&total_reclaimed, freed);
+    reclaims_since_log++;
+    reclaimed_since_log += freed;
+    reclaim_log(before, budget, fixed, now_ms / 1000);
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+void pg_mem_charge(pg_mem_kind_t kind, ssize_t bytes) {
+    if ((unsigned)kind >= PG_MEM_KINDS || bytes == 0) return;
+    atomic_fetch_add(&kind_bytes[kind], bytes);
+    atomic_fetch_add(&total_bytes, bytes);
+}
+
+void pg_mem_check(void) {
+    size_t budget = pg_mem_budget();
+
+    uint64_t now = get_time_s();
+    uint64_t last = atomic_load(&last_log_s);
+    if (now - last >= PG_MEM_LOG_INTERVAL_S &&
+        atomic_compare_exchange_strong(&last_log_s, &last, now) && last != 0) {
+        pg_mem_log_stats();
+    }
+
+    if (atomic_load(&total_bytes) <= (ssize_t)budget) return;
+    int expected = 0;
+    if (!atomic_compare_exchange_strong(&reclaiming, &expected, 1)) return;  // Another thread is on it
+    reclaim(budget);
+    atomic_store(&reclaiming, 0);
+}
+
+void pg_mem_hit(pg_mem_kind_t kind) {
+    if ((unsigned)kind < PG_MEM_KINDS) atomic_fetch_add_explicit(&kind_hits[kind], 1, memory_order_relaxed);
+}
+
+void pg_mem_register_shrinker(pg_mem_kind_t kind, pg_mem_shrink_fn fn) {
+    if ((unsigned)kind < PG_MEM_KINDS) atomic_store(&shrinkers[kind], fn);
+}
+
+size_t pg_mem_budget(void) {
+    pthread_once(&budget_once, read_budget);
+    return budget_bytes;
+}
+
+size_t pg_mem_total(void) {
+    ssize_t total = atomic_load(&total_bytes);
+    return total > 0 ? (size_t)total : 0;
+}
+
+void pg_mem_stats(pg_mem_stats_t *out) {
+    if (!out) return;
+    out->budget = pg_mem_budget();
+    out->total = pg_mem_total();
+    for (int k = 0; k < PG_MEM_KINDS; k++) {
+        ssize_t bytes = atomic_load(&kind_bytes[k]);
+        out->bytes[k] = bytes > 0 ? (size_t)bytes : 0;
+        out->hits[k] = atomic_load(&kind_hits[k]);
+    }
+    out->reclaims = atomic_load(&total_reclaims);
+    out->reclaimed_bytes = atomic_load(&total_reclaimed);
+}
+
+int pg_mem_format_stats(char *buf, size_t size) {
+    if (!buf || size == 0) return 0;
+    pg_mem_stats_t st;
+    pg_mem_stats(&st);
+
+    int off = snprintf(buf, size, "total=%zuKB budget=%zuMB reclaims=%llu reclaimed=%lluKB",
+                       st.total / 1024, st.budget / (1024 * 1024),
+                       (unsigned long long)st.reclaims,
+                       (unsigned long long)(st.reclaimed_bytes / 1024));
+    for (int k = 0; k < PG_MEM_KINDS && off >= 0 && (size_t)off < size; k++) {
+        off += snprintf(buf + off, size - off, " %s=%zuKB", KIND_NAMES[k], st.bytes[k] / 1024);
+        if (st.hits[k] && (size_t)off < size) {
+            off += snprintf(buf + off, size - off, "/%lluhits", (unsigned long long)st.hits[k]);
+        }
+    }
+    return off;
+}
+
+void pg_mem_log_stats(void) {
+    if (pg_mem_total() == 0) return;
+    char buf[512];
+    pg_mem_format_stats(buf, sizeof(buf));
+    LOG_INFO("PG_MEM: %s", buf);
+}
+
+const char* pg_mem_kind_name(pg_mem_kind_t kind) {
+    return (unsigned)kind < PG_MEM_KINDS ? KIND_NAMES[kind] : "unknown";
+}
@@ -0,0 +1,90 @@
+/*
+ * PostgreSQL Shim - Cache Memory Accounting
+ *
+ * Every shim cache charges the bytes it holds to one process-wide ledger.
+ * Plex runs 150+ threads and several caches are per thread, so the sizes
+ * hard-coded in each module don't say much about resident size on their
+ * own; the ledger does.
+ *
+ * Design:
+ * - One atomic byte counter per cache kind, charged/credited by the owner
+ * - Global budget from PLEX_PG_CACHE_MB (default PG_MEM_DEFAULT_BUDGET_MB)
+ * - Caches that can give memory back register a shrink callback. When the
+ *   total goes over budget, the evictable cache with the lowest benefit
+ *   (hits since the last reclaim per byte held) is shrunk first, then the
+ *   next, until the total is back under PG_MEM_RECLAIM_TARGET of the budget.
+ *   Per-thread caches can't be shrunk from another thread; they are
+ *   accounted, so the shared caches make room for them - but only as far as
+ *   that helps: when the non-evictable kinds alone exceed the budget the
+ *   shared caches are left alone, and when they exceed the target the
+ *   shared caches keep half of the remaining headroom.
+ * - At most one reclaim per PG_MEM_RECLAIM_INTERVAL_MS; the reclaim log
+ *   line is a summary at most every PG_MEM_RECLAIM_LOG_S
+ * - Stats: pg_mem_stats() / pg_mem_format_stats(), logged at LOG_INFO
+ *   every PG_MEM_LOG_INTERVAL_S while caches grow and at exit
+ */
+
+#ifndef PG_MEM_H
+#define PG_MEM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#define PG_MEM_DEFAULT_BUDGET_MB 256
+#define PG_MEM_RECLAIM_TARGET 0.9     // Reclaim down to this fraction of the budget
+#define PG_MEM_LOG_INTERVAL_S 300
+#define PG_MEM_RECLAIM_INTERVAL_MS 250  // Minimum time between reclaims
+#define PG_MEM_RECLAIM_LOG_S 60         // Minimum time between reclaim log lines
+
+typedef enum {
+    PG_MEM_QUERY_CACHE,      // pg_query_cache.c - result entries (evictable)
+    PG_MEM_ROW_CACHE,        // pg_row_cache.c - rows (evictable)
+    PG_MEM_TRANSLATIONS,     // sql_translator.c - per-thread translation cache
+    PG_MEM_COLUMN_BUFFERS,   // pg_statement.c / db_interpose_column.c - text arenas, decoded rows
+    PG_MEM_DECLTYPE,         // db_interpose_column.c - decltype and relname tables
+    PG_MEM_TEMPLATES,        // pg_statement.c - per-SQL param types / descriptions
+    PG_MEM_STMT_CACHE,       // pg_client.c - per-connection prepared statement caches
+    PG_MEM_VALUES,           // pg_statement.c - sqlite3_value arenas
+    PG_MEM_KINDS
+} pg_mem_kind_t;
+
+// Give back about `bytes` (more is fine). Returns bytes actually freed.
+// Called without any of the cache's locks held.
+typedef size_t (*pg_mem_shrink_fn)(size_t bytes);
+
+typedef struct {
+    size_t budget;
+    size_t total;
+    size_t bytes[PG_MEM_KINDS];
+    uint64_t hits[PG_MEM_KINDS];
+    uint64_t reclaims;               // Over-budget episodes
+    uint64_t reclaimed_bytes;
+} pg_mem_stats_t;
+
+// Account bytes allocated (positive) or freed (negative) by a cache.
+// Just an atomic add - safe under the cache's own locks.
+void pg_mem_charge(pg_mem_kind_t kind, ssize_t bytes);
+
+// Reclaim if over budget (and log stats every PG_MEM_LOG_INTERVAL_S).
+// Calls shrinkers, so the caller must not hold any cache lock. Cheap when
+// under budget; call it after charging new allocations.
+void pg_mem_check(void);
+
+// Record a hit - the benefit side of cost/benefit eviction
+void pg_mem_hit(pg_mem_kind_t kind);
+
+// Register the shrink callback of an evictable cache
+void pg_mem_register_shrinker(pg_mem_kind_t kind, pg_mem_shrink_fn fn);
+
+size_t pg_mem_budget(void);
+size_t pg_mem_total(void);
+
+void pg_mem_stats(pg_mem_stats_t *out);
+// One line: "total=...KB budget=...MB query_cache=...KB/...hits ..."
+int pg_mem_format_stats(char *buf, size_t size);
+void pg_mem_log_stats(void);
+
+const char* pg_mem_kind_name(pg_mem_kind_t kind);
+
+#endif // PG_MEM_H
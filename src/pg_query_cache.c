@@ -1,12 +1,19 @@
 /*
  * PostgreSQL Shim - Query Result Cache Implementation
  *
- * Thread-local cache for query results to avoid hitting PostgreSQL
+ * Process-wide cache for query results to avoid hitting PostgreSQL
  * for repeated identical queries (common in Plex's OnDeck endpoint).
+ *
+ * Freshness: every entry stores the ids of the tables its SQL reads and the
+ * version of each table as seen BEFORE the query executed. Writes bump table
+ * versions AFTER they execute. A hit requires all versions to still match,
+ * so a result computed concurrently with a write is never served after it.
  */
 
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#include <ctype.h>
 #include <time.h>
 #include <pthread.h>
 #include <stdatomic.h>
@@ -14,11 +21,85 @@
 
 #include "pg_query_cache.h"
 #include "pg_types.h"
+#include "pg_client.h"
+#include "pg_invalidation.h"
 #include "pg_logging.h"
+#include "pg_mem.h"
+#include "pg_utf8.h"
+#include "pg_hex.h"
+#include "sql_translator_internal.h"  // for safe_strcasestr
+
+// ============================================================================
+// Types
+// ============================================================================
+
+typedef struct qc_entry {
+    cached_result_t result;          // Must be first - handed out as cached_result_t*
+    struct qc_entry *hash_next;      // Bucket chain
+    struct qc_entry *clock_prev;     // Insertion-order list for CLOCK eviction
+    struct qc_entry *clock_next;
+    atomic_int referenced;           // CLOCK bit, set on hit
+    atomic_int refreshing;           // Background refresh queued (SWR)
+    int linked;                      // In buckets/CLOCK list (cache_rwlock)
+    size_t bytes;                    // Accounted size
+
+    // Exact key (hash collisions must not serve another query's rows)
+    char *sql;
+    char *params;                    // Serialized params (see serialize_params)
+    size_t params_len;
+
+    // Freshness
+    uint64_t soft_expires_ms;        // Hot entries are refreshed in background after this
+    uint64_t expires_ms;             // Hard expiry - never served after this
+    uint64_t epoch;                  // cache_epoch at snapshot time
+    int ntables;
+    uint32_t table_ids[QUERY_CACHE_MAX_TABLES];
+    uint64_t table_versions[QUERY_CACHE_MAX_TABLES];
+} qc_entry_t;
+
+// Per-SQL analysis: which tables a query reads and whether it's cacheable
+#define QC_ANALYSIS_SLOTS 1024
+#define QC_TABLE_NAME_LEN 128  // = read_identifier() buffers
+typedef struct {
+    uint64_t sql_hash;               // 0 = empty slot
+    int cacheable;
+    int ntables;
+    uint32_t table_ids[QUERY_CACHE_MAX_TABLES];
+} qc_analysis_t;
+
+// Version snapshot taken before a query executes: by lookup() on a miss
+// (consumed by store()), or by the refresh worker
+typedef struct {
+    int valid;
+    uint64_t key;
+    uint64_t epoch;
+    int ntables;
+    uint32_t table_ids[QUERY_CACHE_MAX_TABLES];
+    uint64_t table_versions[QUERY_CACHE_MAX_TABLES];
+} qc_pending_t;
+
+// ============================================================================
+// Static State
+// ============================================================================
+
+static qc_entry_t *buckets[QUERY_CACHE_BUCKETS];
+static qc_entry_t *clock_head = NULL;   // Newest
+static qc_entry_t *clock_tail = NULL;   // Oldest (next eviction candidate)
+static size_t total_bytes = 0;
+static int entry_count = 0;
+static pthread_rwlock_t cache_rwlock = PTHREAD_RWLOCK_INITIALIZER;
 
-// Thread-local cache
-static pthread_key_t cache_key;
-static pthread_once_t cache_key_once = PTHREAD_ONCE_INIT;
+static _Atomic uint64_t table_versions[QUERY_CACHE_TABLE_SLOTS];
+static _Atomic uint64_t cache_epoch = 0;   // Bumped by invalidate_all
+static _Atomic uint64_t schema_version = 0; // Bumped by invalidate_schema (DDL)
+
+static qc_analysis_t analysis_cache[QC_ANALYSIS_SLOTS];
+static pthread_rwlock_t analysis_rwlock = PTHREAD_RWLOCK_INITIALIZER;
+
+static _Atomic uint64_t total_hits = 0;
+static _Atomic uint64_t total_misses = 0;
+
+static __thread qc_pending_t pending;
 
 // Get current time in milliseconds
 static uint64_t get_time_ms(void) {
@@ -38,367 +119,1131 @@ static uint64_t fnv1a_hash(const void *data, size_t len) {
     return hash;
 }
 
-// Free a single cached result (only if ref_count is 0)
-static void free_cached_result(cached_result_t *entry) {
-    if (!entry || entry->cache_key == 0) return;
+// ============================================================================
+// SQL Analysis (tables read / written, volatility)
+// ============================================================================
 
-    // Don't free if still referenced
-    if (atomic_load(&entry->ref_count) > 0) {
-        LOG_DEBUG("CACHE_FREE_SKIP: entry still has %d refs", atomic_load(&entry->ref_count));
-        return;
+// Functions whose result changes between executions - never cache
+static const char *VOLATILE_PATTERNS[] = {
+    "now()", "'now'", "unixepoch()", "current_timestamp", "current_date", "current_time",
+    "clock_timestamp", "random(", "nextval(", "setval(", "currval(", "lastval(",
+    "txid_", "pg_sleep", "gen_random", "for update",
+    NULL
+};
+
+// Views over base tables (see schema/plex_schema.sql) - a write to the base
+// table must invalidate queries that read the view
+static const struct { const char *prefix; const char *base; } VIEW_BASE_TABLES[] = {
+    {"fts4_metadata_titles", "metadata_items"},
+    {"fts4_tag_titles", "tags"},
+    {NULL, NULL}
+};
+
+// Words that end a FROM list entry - never an alias
+static const char *CLAUSE_KEYWORDS[] = {
+    "where", "group", "order", "limit", "offset", "join", "inner", "left", "right",
+    "full", "cross", "natural", "on", "using", "union", "except", "intersect",
+    "having", "window", "returning", "set", "values", "select", "default", "for",
+    NULL
+};
+
+static uint32_t table_id(const char *name) {
+    for (int i = 0; VIEW_BASE_TABLES[i].prefix; i++) {
+        if (strncmp(name, VIEW_BASE_TABLES[i].prefix, strlen(VIEW_BASE_TABLES[i].prefix)) == 0) {
+            name = VIEW_BASE_TABLES[i].base;
+            break;
+        }
     }
+    return (uint32_t)fnv1a_hash(name, strlen(name));
+}
+
+static inline int qc_ident_char(char c) {
+    return isalnum((unsigned char)c) || c == '_' || c == '$';
+}
+
+// Read a possibly quoted, possibly schema-qualified identifier. Stores the
+// last component, lowercased, in out. Returns 0 if no identifier at *pp.
+static int read_identifier(const char **pp, char *out, size_t outsz) {
+    const char *p = *pp;
+    size_t n = 0;
+    for (;;) {
+        n = 0;
+        if (*p == '"') {
+            p++;
+            while (*p && *p != '"') {
+                if (n + 1 < outsz) out[n++] = (char)tolower((unsigned char)*p);
+                p++;
+            }
+            if (*p == '"') p++;
+        } else if (qc_ident_char(*p)) {
+            while (qc_ident_char(*p)) {
+                if (n + 1 < outsz) out[n++] = (char)tolower((unsigned char)*p);
+                p++;
+            }
+        } else {
+            break;
+        }
+        if (*p != '.') break;
+        p++;  // Schema qualifier - keep reading
+    }
+    out[n] = '\0';
+    *pp = p;
+    return n > 0;
+}
+
+static int is_clause_keyword(const char *word) {
+    for (int i = 0; CLAUSE_KEYWORDS[i]; i++) {
+        if (strcmp(word, CLAUSE_KEYWORDS[i]) == 0) return 1;
+    }
+    return 0;
+}
 
-    // Free column types
-    if (entry->col_types) {
-        free(entry->col_types);
-        entry->col_types = NULL;
+// `names` (optional) receives each table's name, for NOTIFY payloads
+static int add_table(uint32_t *ids, char (*names)[QC_TABLE_NAME_LEN], int n, const char *name) {
+    if (n < 0) return n;
+    uint32_t id = table_id(name);
+    for (int i = 0; i < n; i++) {
+        if (ids[i] == id) return n;
     }
+    if (n >= QUERY_CACHE_MAX_TABLES) return -1;  // Too many tables
+    ids[n] = id;
+    if (names) snprintf(names[n], QC_TABLE_NAME_LEN, "%s", name);
+    return n + 1;
+}
 
-    // Free column names
-    if (entry->col_names) {
-        for (int i = 0; i < entry->num_cols; i++) {
-            if (entry->col_names[i]) free(entry->col_names[i]);
+static const char* qc_skip_ws(const char *p) {
+    while (*p && isspace((unsigned char)*p)) p++;
+    return p;
+}
+
+// Tables after FROM/JOIN, including comma lists: "FROM a x, b AS y"
+static int parse_table_list(const char **pp, uint32_t *ids, int n) {
+    const char *p = *pp;
+    char name[128];
+    for (;;) {
+        p = qc_skip_ws(p);
+        if (*p == '(') break;  // Subquery - its own FROM is scanned separately
+        if (!read_identifier(&p, name, sizeof(name))) break;
+        if (is_clause_keyword(name)) break;
+        n = add_table(ids, NULL, n, name);
+
+        // Optional alias
+        p = qc_skip_ws(p);
+        const char *save = p;
+        char alias[128];
+        if (read_identifier(&p, alias, sizeof(alias))) {
+            if (strcmp(alias, "as") == 0) {
+                p = qc_skip_ws(p);
+                read_identifier(&p, alias, sizeof(alias));
+            } else if (is_clause_keyword(alias)) {
+                p = save;
+            }
         }
-        free(entry->col_names);
-        entry->col_names = NULL;
+        p = qc_skip_ws(p);
+        if (*p != ',') break;
+        p++;
     }
+    *pp = p;
+    return n;
+}
 
-    // Free rows
-    if (entry->rows) {
-        for (int r = 0; r < entry->num_rows; r++) {
-            cached_row_t *row = &entry->rows[r];
-            if (row->values) {
-                for (int c = 0; c < entry->num_cols; c++) {
-                    if (row->values[c]) free(row->values[c]);
-                }
-                free(row->values);
+#define QC_MAX_DEPTH 32  // Parenthesis nesting tracked by collect_tables()
+
+// Keywords that end a FROM clause at the current nesting level
+static const char *FROM_TERMINATORS[] = {
+    "where", "group", "order", "limit", "offset", "having", "window", "union",
+    "except", "intersect", "returning", "set", "values", "for", NULL
+};
+
+static int is_from_terminator(const char *word) {
+    for (int i = 0; FROM_TERMINATORS[i]; i++) {
+        if (strcmp(word, FROM_TERMINATORS[i]) == 0) return 1;
+    }
+    return 0;
+}
+
+// Walk SQL words outside string literals. mode 0 = tables read (FROM/JOIN),
+// mode 1 = tables written (INSERT/REPLACE INTO, UPDATE, DELETE FROM).
+// `names` (mode 1 only, optional) receives the written tables' names.
+// Returns number of tables, or -1 if there are more than QUERY_CACHE_MAX_TABLES.
+static int collect_tables(const char *sql, int mode, uint32_t *ids, char (*names)[QC_TABLE_NAME_LEN]) {
+    int n = 0;
+    const char *p = sql;
+    char word[32];
+    int depth = 0;
+    unsigned char in_from[QC_MAX_DEPTH] = {0};
+
+    while (*p && n >= 0) {
+        if (*p == '\'') {
+            // String literal ('' escapes are two adjacent literals - same result)
+            p++;
+            while (*p && *p != '\'') p++;
+            if (*p) p++;
+            continue;
+        }
+        if (*p == '(') {
+            // Subquery or function call - tracked per nesting level so a
+            // comma inside it never looks like a FROM list continuation
+            if (depth < QC_MAX_DEPTH - 1) in_from[++depth] = 0;
+            p++;
+            continue;
+        }
+        if (*p == ')') {
+            if (depth > 0) depth--;
+            p++;
+            continue;
+        }
+        if (*p == ',' && mode == 0 && in_from[depth]) {
+            // "FROM a JOIN b ON ..., c" - the comma continues the FROM list
+            p++;
+            n = parse_table_list(&p, ids, n);
+            continue;
+        }
+        if (!qc_ident_char(*p) && *p != '"') {
+            p++;
+            continue;
+        }
+        if (!read_identifier(&p, word, sizeof(word))) {
+            p++;
+            continue;
+        }
+
+        if (mode == 0) {
+            if (strcmp(word, "from") == 0 || strcmp(word, "join") == 0) {
+                n = parse_table_list(&p, ids, n);
+                in_from[depth] = 1;
+            } else if (is_from_terminator(word)) {
+                in_from[depth] = 0;
             }
-            if (row->lengths) free(row->lengths);
-            if (row->is_null) free(row->is_null);
+        } else if (strcmp(word, "into") == 0 || strcmp(word, "update") == 0 ||
+                   strcmp(word, "delete") == 0 || strcmp(word, "truncate") == 0) {
+            const char *q = qc_skip_ws(p);
+            char name[128];
+            if (!read_identifier(&q, name, sizeof(name))) continue;
+            // DELETE FROM x / UPDATE OR IGNORE x / TRUNCATE TABLE x
+            if (strcmp(name, "from") == 0 || strcmp(name, "table") == 0) {
+                q = qc_skip_ws(q);
+                if (!read_identifier(&q, name, sizeof(name))) continue;
+            } else if (strcmp(name, "or") == 0) {
+                q = qc_skip_ws(q);
+                if (!read_identifier(&q, name, sizeof(name))) continue;
+                q = qc_skip_ws(q);
+                if (!read_identifier(&q, name, sizeof(name))) continue;
+            }
+            if (strcmp(name, "set") == 0) continue;  // ON CONFLICT DO UPDATE SET
+            n = add_table(ids, names, n, name);
+            p = q;
+        }
+    }
+    return n;
+}
+
+static void analyze_sql(const char *sql, uint64_t sql_hash, qc_analysis_t *out) {
+    unsigned int slot = (unsigned int)(sql_hash & (QC_ANALYSIS_SLOTS - 1));
+
+    pthread_rwlock_rdlock(&analysis_rwlock);
+    if (analysis_cache[slot].sql_hash == sql_hash) {
+        *out = analysis_cache[slot];
+        pthread_rwlock_unlock(&analysis_rwlock);
+        return;
+    }
+    pthread_rwlock_unlock(&analysis_rwlock);
+
+    memset(out, 0, sizeof(*out));
+    out->sql_hash = sql_hash;
+    out->cacheable = 1;
+    for (int i = 0; VOLATILE_PATTERNS[i]; i++) {
+        if (strcasestr(sql, VOLATILE_PATTERNS[i])) {
+            out->cacheable = 0;
+            break;
+        }
+    }
+    if (out->cacheable) {
+        int n = collect_tables(sql, 0, out->table_ids, NULL);
+        if (n < 0) {
+            out->cacheable = 0;
+        } else {
+            out->ntables = n;
         }
-        free(entry->rows);
-        entry->rows = NULL;
     }
 
-    entry->cache_key = 0;
-    entry->num_rows = 0;
-    entry->num_cols = 0;
+    pthread_rwlock_wrlock(&analysis_rwlock);
+    analysis_cache[slot] = *out;
+    pthread_rwlock_unlock(&analysis_rwlock);
 }
 
-// Thread-local destructor
-static void cache_destructor(void *ptr) {
-    query_cache_t *cache = (query_cache_t *)ptr;
-    if (!cache) return;
+// ============================================================================
+// Entry Helpers
+// ============================================================================
+
+// Serialized params: per param an int32 length (-1 = NULL), a format byte
+// (1 = raw BYTEA, 0 = text) and the value bytes. Doubles as the exact cache
+// key and as the parameter list replayed by the refresh worker.
+static size_t params_size(pg_stmt_t *stmt) {
+    size_t size = 0;
+    for (int i = 0; i < stmt->param_count && i < MAX_PARAMS; i++) {
+        size += sizeof(int32_t) + 1;
+        if (stmt->param_values[i]) {
+            size += (stmt->param_types[i] == PG_OID_BYTEA)
+                    ? (size_t)stmt->param_lengths[i]
+                    : strlen(stmt->param_values[i]);
+        }
+    }
+    return size;
+}
 
-    // Log stats before cleanup
-    if (cache->total_hits > 0 || cache->total_misses > 0) {
-        LOG_INFO("QUERY_CACHE thread exit: hits=%llu misses=%llu ratio=%.1f%%",
-                 (unsigned long long)cache->total_hits,
-                 (unsigned long long)cache->total_misses,
-                 cache->total_hits + cache->total_misses > 0 ?
-                     100.0 * cache->total_hits / (cache->total_hits + cache->total_misses) : 0);
+static void serialize_params(pg_stmt_t *stmt, char *out) {
+    for (int i = 0; i < stmt->param_count && i < MAX_PARAMS; i++) {
+        int32_t len = -1;
+        if (stmt->param_values[i]) {
+            len = (stmt->param_types[i] == PG_OID_BYTEA)
+                  ? stmt->param_lengths[i]
+                  : (int32_t)strlen(stmt->param_values[i]);
+        }
+        memcpy(out, &len, sizeof(len));
+        out += sizeof(len);
+        *out++ = (stmt->param_types[i] == PG_OID_BYTEA) ? 1 : 0;
+        if (len > 0) {
+            memcpy(out, stmt->param_values[i], (size_t)len);
+            out += len;
+        }
     }
+}
 
-    // Free all cached results
-    for (int i = 0; i < QUERY_CACHE_SIZE; i++) {
-        free_cached_result(&cache->entries[i]);
+static int entry_matches(const qc_entry_t *e, pg_stmt_t *stmt) {
+    if (strcmp(e->sql, stmt->pg_sql) != 0) return 0;
+
+    const char *p = e->params;
+    const char *end = e->params + e->params_len;
+    for (int i = 0; i < stmt->param_count && i < MAX_PARAMS; i++) {
+        int32_t len;
+        if (p + sizeof(len) + 1 > end) return 0;
+        memcpy(&len, p, sizeof(len));
+        p += sizeof(len);
+        if (*p++ != ((stmt->param_types[i] == PG_OID_BYTEA) ? 1 : 0)) return 0;
+        if (!stmt->param_values[i]) {
+            if (len != -1) return 0;
+            continue;
+        }
+        int32_t cur = (stmt->param_types[i] == PG_OID_BYTEA)
+                      ? stmt->param_lengths[i]
+                      : (int32_t)strlen(stmt->param_values[i]);
+        if (cur != len || p + len > end) return 0;
+        if (memcmp(p, stmt->param_values[i], (size_t)len) != 0) return 0;
+        p += len;
     }
+    return p == end;
+}
 
-    free(cache);
+static int entry_is_fresh(const qc_entry_t *e, uint64_t now) {
+    if (now >= e->expires_ms) return 0;
+    if (e->epoch != atomic_load(&cache_epoch)) return 0;
+    for (int i = 0; i < e->ntables; i++) {
+        uint32_t slot = e->table_ids[i] & (QUERY_CACHE_TABLE_SLOTS - 1);
+        if (atomic_load(&table_versions[slot]) != e->table_versions[i]) return 0;
+    }
+    return 1;
 }
 
-// Create thread-local key
-static void create_cache_key(void) {
-    pthread_key_create(&cache_key, cache_destructor);
+// Entry, exact key and result data are one allocation (see build_entry)
+static void free_entry(qc_entry_t *e) {
+    free(e);
 }
 
-// Get or create thread-local cache
-static query_cache_t* get_thread_cache(void) {
-    pthread_once(&cache_key_once, create_cache_key);
+// Drop the cache's reference. Must hold cache_rwlock (write).
+static void unlink_entry(qc_entry_t *e) {
+    if (!e->linked) return;  // Already replaced/evicted
+    e->linked = 0;
+
+    qc_entry_t **pp = &buckets[e->result.cache_key & (QUERY_CACHE_BUCKETS - 1)];
+    while (*pp && *pp != e) pp = &(*pp)->hash_next;
+    if (*pp) *pp = e->hash_next;
 
-    query_cache_t *cache = pthread_getspecific(cache_key);
-    if (!cache) {
-        cache = calloc(1, sizeof(query_cache_t));
-        if (cache) {
-            pthread_setspecific(cache_key, cache);
+    if (e->clock_prev) e->clock_prev->clock_next = e->clock_next;
+    else clock_head = e->clock_next;
+    if (e->clock_next) e->clock_next->clock_prev = e->clock_prev;
+    else clock_tail = e->clock_prev;
+
+    total_bytes -= e->bytes;
+    entry_count--;
+    pg_mem_charge(PG_MEM_QUERY_CACHE, -(ssize_t)e->bytes);
+    pg_query_cache_release(&e->result);
+}
+
+// CLOCK eviction until at most `limit` bytes are cached. Must hold
+// cache_rwlock (write).
+static void evict_until(size_t limit) {
+    int budget = entry_count * 2;  // Every entry gets at most one second chance
+    while (clock_tail && total_bytes > limit && budget-- > 0) {
+        qc_entry_t *e = clock_tail;
+        if (atomic_exchange(&e->referenced, 0) && clock_head != e) {
+            // Second chance - move to head
+            clock_tail = e->clock_prev;
+            clock_tail->clock_next = NULL;
+            e->clock_prev = NULL;
+            e->clock_next = clock_head;
+            clock_head->clock_prev = e;
+            clock_head = e;
+            continue;
         }
+        unlink_entry(e);
+    }
+    while (clock_tail && total_bytes > limit) {
+        unlink_entry(clock_tail);
     }
-    return cache;
+}
+
+// Make room for `needed` more bytes (needed <= QUERY_CACHE_MAX_BYTES)
+static void evict_for(size_t needed) {
+    evict_until(QUERY_CACHE_BUDGET_BYTES - needed);
+}
+
+// pg_mem shrinker - the global cache budget is over, give back `bytes`
+static size_t qc_shrink(size_t bytes) {
+    pthread_rwlock_wrlock(&cache_rwlock);
+    size_t before = total_bytes;
+    evict_until(total_bytes > bytes ? total_bytes - bytes : 0);
+    size_t freed = before - total_bytes;
+    pthread_rwlock_unlock(&cache_rwlock);
+    return freed;
 }
 
 // ============================================================================
-// Public API
+// Entry Construction
 // ============================================================================
 
-void pg_query_cache_init(void) {
-    // Just ensure key is created
-    pthread_once(&cache_key_once, create_cache_key);
-    LOG_INFO("Query result cache initialized (size=%d, ttl=%dms)",
-             QUERY_CACHE_SIZE, QUERY_CACHE_TTL_MS);
-}
+#define QC_ALIGN(n) (((n) + 7) & ~(size_t)7)
 
-void pg_query_cache_cleanup(void) {
-    // Thread-local cleanup happens via destructor
+// Hex-format BYTEA cell ("\x..."), stored decoded
+static inline int cell_is_hex_bytea(Oid type, const char *value, int len) {
+    return type == 17 && len >= 2 && value[0] == '\\' && value[1] == 'x';
 }
 
-uint64_t pg_query_cache_key(pg_stmt_t *stmt) {
-    if (!stmt || !stmt->pg_sql) return 0;
+// Copy a result into a single allocation laid out as
+//   qc_entry_t | col_types | col_names | cell_offsets | null_bitmap |
+//   utf8_bad_bitmap | sql | params | column name strings | cell data
+// Sizes are summed first so the copy is one malloc plus memcpys, and a hit
+// reads one contiguous block. BYTEA cells are decoded here, so a hit hands
+// column_blob the bytes a miss gets from pg_decode_bytea. Returns NULL when
+// over QUERY_CACHE_MAX_BYTES or a BYTEA cell is not valid hex.
+static qc_entry_t* build_entry(const char *sql, const char *params, size_t params_len,
+                               const PGresult *result, int num_rows, int num_cols) {
+    size_t ncells = (size_t)num_rows * num_cols;
+    size_t sql_len = strlen(sql) + 1;
+
+    size_t names_len = 0;
+    for (int c = 0; c < num_cols; c++) {
+        const char *name = PQfname(result, c);
+        names_len += (name ? strlen(name) : 0) + 1;
+    }
 
-    // Start with SQL hash
-    uint64_t hash = fnv1a_hash(stmt->pg_sql, strlen(stmt->pg_sql));
+    size_t data_len = 0;
+    for (int row = 0; row < num_rows; row++) {
+        for (int c = 0; c < num_cols; c++) {
+            if (PQgetisnull(result, row, c)) continue;
+            int len = PQgetlength(result, row, c);
+            if (cell_is_hex_bytea(PQftype(result, c), PQgetvalue(result, row, c), len)) {
+                data_len += (size_t)(len - 2) / 2 + 1;
+            } else {
+                data_len += (size_t)len + 1;
+            }
+        }
+    }
 
-    // Mix in parameter values
+    size_t off_types = QC_ALIGN(sizeof(qc_entry_t));
+    size_t off_names = QC_ALIGN(off_types + num_cols * sizeof(Oid));
+    size_t off_offsets = off_names + num_cols * sizeof(char*);
+    size_t off_bitmap = off_offsets + (ncells + 1) * sizeof(uint32_t);
+    size_t off_utf8 = off_bitmap + (ncells + 7) / 8;
+    size_t off_sql = off_utf8 + (ncells + 7) / 8;
+    size_t off_params = off_sql + sql_len;
+    size_t off_strings = off_params + params_len;
+    size_t off_data = off_strings + names_len;
+    size_t total_size = off_data + data_len;
+
+    if (total_size > QUERY_CACHE_MAX_BYTES) {
+        LOG_DEBUG("QUERY_CACHE SKIP: result too large (%zu > %d bytes)",
+                  total_size, QUERY_CACHE_MAX_BYTES);
+        return NULL;
+    }
+
+    char *base = malloc(total_size);
+    if (!base) return NULL;
+    memset(base, 0, off_sql);  // Header, metadata tables and bitmaps
+
+    qc_entry_t *e = (qc_entry_t *)base;
+    cached_result_t *r = &e->result;
+    e->bytes = total_size;
+    e->sql = base + off_sql;
+    e->params = base + off_params;
+    e->params_len = params_len;
+    memcpy(e->sql, sql, sql_len);
+    if (params_len) memcpy(e->params, params, params_len);
+
+    r->num_rows = num_rows;
+    r->num_cols = num_cols;
+    r->col_types = (Oid *)(base + off_types);
+    r->col_names = (char **)(base + off_names);
+    r->cell_offsets = (uint32_t *)(base + off_offsets);
+    r->null_bitmap = (uint8_t *)(base + off_bitmap);
+    r->utf8_bad_bitmap = (uint8_t *)(base + off_utf8);
+    r->cell_data = base + off_data;
+
+    char *strings = base + off_strings;
+    for (int c = 0; c < num_cols; c++) {
+        r->col_types[c] = PQftype(result, c);
+        const char *name = PQfname(result, c);
+        size_t len = name ? strlen(name) : 0;
+        memcpy(strings, name ? name : "", len + 1);
+        r->col_names[c] = strings;
+        strings += len + 1;
+    }
+
+    uint32_t pos = 0;
+    size_t i = 0;
+    for (int row = 0; row < num_rows; row++) {
+        for (int c = 0; c < num_cols; c++, i++) {
+            r->cell_offsets[i] = pos;
+            if (PQgetisnull(result, row, c)) {
+                r->null_bitmap[i >> 3] |= (uint8_t)(1 << (i & 7));
+                continue;
+            }
+            int len = PQgetlength(result, row, c);
+            const char *value = PQgetvalue(result, row, c);
+            if (cell_is_hex_bytea(r->col_types[c], value, len)) {
+                size_t bin_len = (size_t)(len - 2) / 2;
+                if (!pg_hex_decode((unsigned char *)r->cell_data + pos, value + 2, bin_len)) {
+                    LOG_DEBUG("QUERY_CACHE SKIP: invalid hex in BYTEA column %d", c);
+                    free(base);
+                    return NULL;
+                }
+                r->cell_data[pos + bin_len] = '\0';
+                pos += (uint32_t)bin_len + 1;
+                continue;
+            }
+            // Validated here once - every hit's column_text reads the bit
+            if (!pg_utf8_valid(value, (size_t)len)) {
+                r->utf8_bad_bitmap[i >> 3] |= (uint8_t)(1 << (i & 7));
+            }
+            memcpy(r->cell_data + pos, value, len);
+            r->cell_data[pos + len] = '\0';
+            pos += len + 1;
+        }
+    }
+    r->cell_offsets[ncells] = pos;
+    return e;
+}
+
+// Link a built entry into the cache with the version snapshot taken before
+// its query executed, replacing any entry for the same key. Takes over the
+// caller's reference (ref_count starts at 1 = the cache's own).
+static void insert_entry(qc_entry_t *e, uint64_t key, const qc_pending_t *snap) {
+    cached_result_t *r = &e->result;
+    r->cache_key = key;
+    r->created_ms = get_time_ms();
+    atomic_store(&r->ref_count, 1);  // The cache's own reference
+    e->soft_expires_ms = r->created_ms + QUERY_CACHE_SOFT_TTL_MS;
+    e->expires_ms = r->created_ms +
+                    (pg_inval_listening() ? QUERY_CACHE_LISTEN_TTL_MS : QUERY_CACHE_TTL_MS);
+    e->epoch = snap->epoch;
+    e->ntables = snap->ntables;
+    memcpy(e->table_ids, snap->table_ids, sizeof(e->table_ids));
+    memcpy(e->table_versions, snap->table_versions, sizeof(e->table_versions));
+
+    pthread_rwlock_wrlock(&cache_rwlock);
+
+    // Replace an existing entry for the same query
+    for (qc_entry_t *old = buckets[key & (QUERY_CACHE_BUCKETS - 1)]; old; old = old->hash_next) {
+        if (old->result.cache_key == key && strcmp(old->sql, e->sql) == 0 &&
+            old->params_len == e->params_len &&
+            memcmp(old->params, e->params, e->params_len) == 0) {
+            unlink_entry(old);
+            break;
+        }
+    }
+    evict_for(e->bytes);
+
+    qc_entry_t **bucket = &buckets[key & (QUERY_CACHE_BUCKETS - 1)];
+    e->hash_next = *bucket;
+    *bucket = e;
+    e->clock_next = clock_head;
+    if (clock_head) clock_head->clock_prev = e;
+    clock_head = e;
+    if (!clock_tail) clock_tail = e;
+    e->linked = 1;
+    total_bytes += e->bytes;
+    entry_count++;
+    pg_mem_charge(PG_MEM_QUERY_CACHE, (ssize_t)e->bytes);
+
+    pthread_rwlock_unlock(&cache_rwlock);
+    pg_mem_check();
+}
+
+// ============================================================================
+// Negative Cache (zero-row results)
+// ============================================================================
+// Existence probes during scans ("does this media_part / stream / tag
+// exist?") mostly come back empty, and an empty result carries nothing but
+// its column layout. So instead of a full entry per (SQL, params), an empty
+// result is remembered as a 32-byte fingerprint:
+// - the cache key, plus a second, independently seeded hash of the exact SQL
+//   and params (a false hit needs both 64-bit hashes to collide)
+// - the sum of cache_epoch and the read tables' versions from the snapshot
+//   taken before the query ran. Versions only grow, so any write to a table
+//   the query reads - INSERTs in particular - or a global invalidation
+//   changes the current sum and the fingerprint stops matching.
+// The column layout is one zero-row entry per SQL, shared by every
+// fingerprint of that SQL and handed out like a normal hit.
+
+typedef struct {
+    uint64_t key;            // 0 = empty slot
+    uint64_t check;          // neg_check_hash()
+    uint64_t version_sum;    // epoch + table versions at snapshot time
+    uint64_t expires_ms;     // Hard expiry (writes by other processes)
+} qc_neg_entry_t;
+
+typedef struct {
+    uint64_t sql_hash;       // 0 = empty slot
+    qc_entry_t *entry;       // Zero-row layout (slot's ref)
+} qc_neg_layout_t;
+
+static qc_neg_entry_t neg_entries[QUERY_CACHE_NEG_SLOTS];
+static qc_neg_layout_t neg_layouts[QC_ANALYSIS_SLOTS];
+static pthread_rwlock_t neg_rwlock = PTHREAD_RWLOCK_INITIALIZER;
+static _Atomic uint64_t total_neg_hits = 0;
+
+// FNV-1a over SQL and params with a different basis than the key
+static uint64_t neg_check_hash(pg_stmt_t *stmt) {
+    uint64_t hash = 0x9e3779b97f4a7c15ULL;
+    for (const uint8_t *p = (const uint8_t *)stmt->pg_sql; *p; p++) {
+        hash ^= *p;
+        hash *= 0x100000001b3ULL;
+    }
     for (int i = 0; i < stmt->param_count && i < MAX_PARAMS; i++) {
+        int32_t len = -1;
         if (stmt->param_values[i]) {
-            // Hash the parameter value
-            uint64_t param_hash = fnv1a_hash(stmt->param_values[i],
-                                              strlen(stmt->param_values[i]));
-            // Mix hashes
-            hash ^= param_hash;
-            hash *= 0x100000001b3ULL;
-        } else {
-            // NULL parameter - use a sentinel value
-            hash ^= 0xDEADBEEFULL;
+            len = (stmt->param_types[i] == PG_OID_BYTEA)
+                  ? stmt->param_lengths[i]
+                  : (int32_t)strlen(stmt->param_values[i]);
+        }
+        hash ^= (uint64_t)(uint32_t)len;
+        hash *= 0x100000001b3ULL;
+        for (int32_t j = 0; j < len; j++) {
+            hash ^= (uint8_t)stmt->param_values[i][j];
             hash *= 0x100000001b3ULL;
         }
     }
-
     return hash;
 }
 
-cached_result_t* pg_query_cache_lookup(pg_stmt_t *stmt) {
-    LOG_DEBUG("CACHE_LOOKUP_ENTER: stmt=%p", (void*)stmt);
-    if (!stmt || !stmt->pg_sql) {
-        LOG_DEBUG("CACHE_LOOKUP_EARLY_EXIT: stmt or pg_sql is NULL");
-        return NULL;
+static uint64_t current_version_sum(int ntables, const uint32_t *table_ids) {
+    uint64_t sum = atomic_load(&cache_epoch);
+    for (int i = 0; i < ntables; i++) {
+        sum += atomic_load(&table_versions[table_ids[i] & (QUERY_CACHE_TABLE_SLOTS - 1)]);
     }
-    LOG_DEBUG("CACHE_LOOKUP: calling get_thread_cache");
+    return sum;
+}
 
-    query_cache_t *cache = get_thread_cache();
-    LOG_DEBUG("CACHE_LOOKUP: got cache=%p", (void*)cache);
-    if (!cache) return NULL;
+static uint64_t snapshot_version_sum(const qc_pending_t *snap) {
+    uint64_t sum = snap->epoch;
+    for (int i = 0; i < snap->ntables; i++) sum += snap->table_versions[i];
+    return sum;
+}
 
-    uint64_t key = pg_query_cache_key(stmt);
-    if (key == 0) return NULL;
+// Empty result for a fresh fingerprint, with a reference taken; NULL on miss
+static qc_entry_t* neg_lookup(pg_stmt_t *stmt, uint64_t key, uint64_t sql_hash,
+                              const qc_analysis_t *analysis, uint64_t now) {
+    const qc_neg_entry_t *n = &neg_entries[key & (QUERY_CACHE_NEG_SLOTS - 1)];
+    qc_entry_t *layout = NULL;
+
+    pthread_rwlock_rdlock(&neg_rwlock);
+    if (n->key == key && now < n->expires_ms &&
+        n->version_sum == current_version_sum(analysis->ntables, analysis->table_ids)) {
+        const qc_neg_layout_t *l = &neg_layouts[sql_hash & (QC_ANALYSIS_SLOTS - 1)];
+        if (l->sql_hash == sql_hash && strcmp(l->entry->sql, stmt->pg_sql) == 0 &&
+            n->check == neg_check_hash(stmt)) {
+            layout = l->entry;
+            atomic_fetch_add(&layout->result.ref_count, 1);
+        }
+    }
+    pthread_rwlock_unlock(&neg_rwlock);
 
-    uint64_t now = get_time_ms();
+    if (layout) atomic_fetch_add(&total_neg_hits, 1);
+    return layout;
+}
 
-    // Linear search (cache is small)
-    for (int i = 0; i < QUERY_CACHE_SIZE; i++) {
-        cached_result_t *entry = &cache->entries[i];
-
-        if (entry->cache_key == key) {
-            // Check TTL
-            if (now - entry->created_ms < QUERY_CACHE_TTL_MS) {
-                // Cache hit! Increment ref_count to prevent eviction
-                atomic_fetch_add(&entry->ref_count, 1);
-                entry->hit_count++;
-                cache->total_hits++;
-
-                // Log every 100th hit to reduce spam
-                if (entry->hit_count % 100 == 1) {
-                    LOG_DEBUG("QUERY_CACHE HIT #%d: key=%llx rows=%d refs=%d sql=%.60s",
-                             entry->hit_count, (unsigned long long)key,
-                             entry->num_rows, atomic_load(&entry->ref_count), stmt->pg_sql);
-                }
+// Remember an empty result (pending snapshot from this thread's miss)
+static void neg_store(pg_stmt_t *stmt, const PGresult *result, uint64_t key) {
+    uint64_t sql_hash = fnv1a_hash(stmt->pg_sql, strlen(stmt->pg_sql));
+    qc_neg_layout_t *l = &neg_layouts[sql_hash & (QC_ANALYSIS_SLOTS - 1)];
+
+    // Column layout once per SQL
+    qc_entry_t *layout = NULL;
+    pthread_rwlock_rdlock(&neg_rwlock);
+    int have_layout = l->sql_hash == sql_hash && strcmp(l->entry->sql, stmt->pg_sql) == 0;
+    pthread_rwlock_unlock(&neg_rwlock);
+    if (!have_layout) {
+        layout = build_entry(stmt->pg_sql, NULL, 0, result, 0, PQnfields(result));
+        if (!layout) return;
+        layout->result.cache_key = sql_hash;
+        layout->result.created_ms = get_time_ms();
+        layout->soft_expires_ms = UINT64_MAX;  // Never queued for background refresh
+        atomic_store(&layout->result.ref_count, 1);  // The layout slot's own
+    }
 
-                return entry;
-            } else {
-                // Expired - try to free (will skip if ref_count > 0)
-                free_cached_result(entry);
-                cache->total_misses++;
-                return NULL;
-            }
+    qc_neg_entry_t fp = {
+        .key = key,
+        .check = neg_check_hash(stmt),
+        .version_sum = snapshot_version_sum(&pending),
+        .expires_ms = get_time_ms() +
+                      (pg_inval_listening() ? QUERY_CACHE_LISTEN_TTL_MS : QUERY_CACHE_TTL_MS),
+    };
+
+    qc_entry_t *old_layout = NULL;
+    pthread_rwlock_wrlock(&neg_rwlock);
+    if (layout) {
+        if (l->sql_hash == sql_hash && strcmp(l->entry->sql, stmt->pg_sql) == 0) {
+            old_layout = layout;  // Another thread installed it meanwhile
+        } else {
+            old_layout = l->entry;
+            l->sql_hash = sql_hash;
+            l->entry = layout;
+            pg_mem_charge(PG_MEM_QUERY_CACHE, (ssize_t)layout->bytes);
+            if (old_layout) pg_mem_charge(PG_MEM_QUERY_CACHE, -(ssize_t)old_layout->bytes);
         }
     }
+    neg_entries[key & (QUERY_CACHE_NEG_SLOTS - 1)] = fp;
+    pthread_rwlock_unlock(&neg_rwlock);
 
-    cache->total_misses++;
-    return NULL;
+    if (old_layout) pg_query_cache_release(&old_layout->result);
+    LOG_DEBUG("QUERY_CACHE NEG STORE: key=%llx tables=%d sql=%.60s",
+              (unsigned long long)key, pending.ntables, stmt->pg_sql);
 }
 
-void pg_query_cache_store(pg_stmt_t *stmt, void *result_ptr) {
-    LOG_DEBUG("CACHE_STORE_ENTER: stmt=%p result=%p", (void*)stmt, result_ptr);
-    PGresult *result = (PGresult *)result_ptr;
-    if (!stmt || !stmt->pg_sql || !result) {
-        LOG_DEBUG("CACHE_STORE_EARLY_EXIT: null check failed");
-        return;
+static void neg_invalidate(uint64_t key) {
+    pthread_rwlock_wrlock(&neg_rwlock);
+    qc_neg_entry_t *n = &neg_entries[key & (QUERY_CACHE_NEG_SLOTS - 1)];
+    if (n->key == key) n->key = 0;
+    pthread_rwlock_unlock(&neg_rwlock);
+}
+
+// ============================================================================
+// Stale-While-Revalidate
+// ============================================================================
+
+// A hot entry (QUERY_CACHE_SWR_MIN_HITS hits) past its soft expiry is still
+// served, and one refresh is queued for a background worker that re-runs the
+// query on its own maintenance connection and swaps in the new entry. Only
+// hard expiry or a write to a dependent table makes a reader execute
+// synchronously, so home-screen queries stay on the cached path.
+
+static qc_entry_t *refresh_queue[QUERY_CACHE_SWR_QUEUE];  // Each holds a ref
+static int refresh_head = 0;
+static int refresh_count = 0;
+static int refresh_started = 0;
+static pthread_mutex_t refresh_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t refresh_cond = PTHREAD_COND_INITIALIZER;
+static pg_connection_t *refresh_conn = NULL;   // Worker thread only
+static _Atomic uint64_t total_refreshes = 0;
+
+static void snapshot_versions(qc_pending_t *snap, int ntables, const uint32_t *table_ids) {
+    snap->epoch = atomic_load(&cache_epoch);
+    snap->ntables = ntables;
+    for (int i = 0; i < ntables; i++) {
+        uint32_t slot = table_ids[i] & (QUERY_CACHE_TABLE_SLOTS - 1);
+        snap->table_ids[i] = table_ids[i];
+        snap->table_versions[i] = atomic_load(&table_versions[slot]);
     }
+}
 
-    // Don't cache failed queries
-    ExecStatusType status = PQresultStatus(result);
-    LOG_DEBUG("CACHE_STORE: status=%d", (int)status);
-    if (status != PGRES_TUPLES_OK) return;
+static PGconn* refresh_connection(void) {
+    if (refresh_conn && (!refresh_conn->conn || PQstatus(refresh_conn->conn) != CONNECTION_OK)) {
+        pg_close(refresh_conn);
+        refresh_conn = NULL;
+    }
+    if (!refresh_conn) refresh_conn = pg_connect_maintenance("query cache refresh");
+    return refresh_conn ? refresh_conn->conn : NULL;
+}
 
-    int num_rows = PQntuples(result);
-    int num_cols = PQnfields(result);
+// Re-run an entry's query and replace it. Runs on the worker thread.
+static void refresh_entry(qc_entry_t *old) {
+    PGconn *conn = refresh_connection();
+    if (!conn) return;
+
+    // Rebuild the parameter list from the serialized key
+    const char *values[MAX_PARAMS];
+    int lengths[MAX_PARAMS];
+    int formats[MAX_PARAMS];
+    Oid types[MAX_PARAMS];
+    int nparams = 0;
+    const char *p = old->params;
+    const char *end = old->params + old->params_len;
+    while (p < end && nparams < MAX_PARAMS) {
+        int32_t len;
+        memcpy(&len, p, sizeof(len));
+        p += sizeof(len);
+        int raw = *p++;
+        values[nparams] = (len < 0) ? NULL : p;
+        lengths[nparams] = (len < 0) ? 0 : len;
+        formats[nparams] = raw;
+        types[nparams] = raw ? PG_OID_BYTEA : 0;
+        if (len > 0) p += len;
+        nparams++;
+    }
 
-    // Don't cache huge results
-    if (num_rows > QUERY_CACHE_MAX_ROWS) {
-        LOG_DEBUG("QUERY_CACHE SKIP: too many rows (%d > %d)", num_rows, QUERY_CACHE_MAX_ROWS);
-        return;
+    // Text params are NUL-terminated for libpq - copy them out of the key
+    char *text_copies[MAX_PARAMS] = {0};
+    for (int i = 0; i < nparams; i++) {
+        if (values[i] && !formats[i]) {
+            text_copies[i] = strndup(values[i], (size_t)lengths[i]);
+            if (!text_copies[i]) goto done;
+            values[i] = text_copies[i];
+        }
     }
 
-    // Don't cache empty results (usually not worth it)
-    if (num_rows == 0) return;
+    qc_pending_t snap;
+    snapshot_versions(&snap, old->ntables, old->table_ids);
 
-    query_cache_t *cache = get_thread_cache();
-    if (!cache) return;
+    PGresult *res = PQexecParams(conn, old->sql, nparams, types, values, lengths, formats, 0);
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        LOG_DEBUG("QUERY_CACHE REFRESH failed: %s sql=%.60s", PQerrorMessage(conn), old->sql);
+        PQclear(res);
+        goto done;
+    }
 
-    uint64_t key = pg_query_cache_key(stmt);
-    if (key == 0) return;
+    int num_rows = PQntuples(res);
+    int num_cols = PQnfields(res);
+    qc_entry_t *e = NULL;
+    if (num_rows > 0 && num_rows <= QUERY_CACHE_MAX_ROWS) {
+        e = build_entry(old->sql, old->params, old->params_len, res, num_rows, num_cols);
+    }
+    PQclear(res);
+
+    if (e) {
+        atomic_store(&e->result.hit_count, atomic_load(&old->result.hit_count));  // Stays hot
+        insert_entry(e, old->result.cache_key, &snap);
+        atomic_fetch_add(&total_refreshes, 1);
+        LOG_DEBUG("QUERY_CACHE REFRESH: key=%llx rows=%d sql=%.60s",
+                  (unsigned long long)old->result.cache_key, num_rows, old->sql);
+    } else {
+        // Now empty or too large to cache - drop the stale rows
+        pthread_rwlock_wrlock(&cache_rwlock);
+        unlink_entry(old);
+        pthread_rwlock_unlock(&cache_rwlock);
+    }
 
-    // Find slot - either existing with same key, oldest, or first free
-    int target_slot = -1;
-    uint64_t oldest_time = UINT64_MAX;
+done:
+    for (int i = 0; i < nparams; i++) free(text_copies[i]);
+}
 
-    for (int i = 0; i < QUERY_CACHE_SIZE; i++) {
-        cached_result_t *entry = &cache->entries[i];
+static void* refresh_worker(void *arg) {
+    (void)arg;
+    for (;;) {
+        pthread_mutex_lock(&refresh_mutex);
+        while (refresh_count == 0) pthread_cond_wait(&refresh_cond, &refresh_mutex);
+        qc_entry_t *e = refresh_queue[refresh_head];
+        refresh_head = (refresh_head + 1) % QUERY_CACHE_SWR_QUEUE;
+        refresh_count--;
+        pthread_mutex_unlock(&refresh_mutex);
+
+        // Skip entries dropped since they were queued; a failed refresh
+        // leaves `refreshing` set so the entry simply runs to hard expiry
+        pthread_rwlock_rdlock(&cache_rwlock);
+        int linked = e->linked;
+        pthread_rwlock_unlock(&cache_rwlock);
+        if (linked) refresh_entry(e);
+        pg_query_cache_release(&e->result);
+    }
+    return NULL;
+}
 
-        // Exact match - reuse slot
-        if (entry->cache_key == key) {
-            target_slot = i;
-            break;
+// Queue one background refresh for a hot entry. Caller holds a ref on `e`.
+static void schedule_refresh(qc_entry_t *e) {
+    if (atomic_exchange(&e->refreshing, 1)) return;  // Already queued
+
+    atomic_fetch_add(&e->result.ref_count, 1);  // Ref held by the queue
+    pthread_mutex_lock(&refresh_mutex);
+    if (!refresh_started) {
+        pthread_t tid;
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        if (pthread_create(&tid, &attr, refresh_worker, NULL) == 0) {
+            refresh_started = 1;
+            LOG_INFO("Query cache refresh worker started (soft ttl=%dms)", QUERY_CACHE_SOFT_TTL_MS);
         }
+        pthread_attr_destroy(&attr);
+    }
+    if (!refresh_started || refresh_count >= QUERY_CACHE_SWR_QUEUE) {
+        // No worker or queue full: entry runs to hard expiry instead
+        pthread_mutex_unlock(&refresh_mutex);
+        pg_query_cache_release(&e->result);
+        return;
+    }
+    refresh_queue[(refresh_head + refresh_count) % QUERY_CACHE_SWR_QUEUE] = e;
+    refresh_count++;
+    pthread_cond_signal(&refresh_cond);
+    pthread_mutex_unlock(&refresh_mutex);
+}
 
-        // Free slot
-        if (entry->cache_key == 0) {
-            target_slot = i;
-            break;
-        }
+// ============================================================================
+// Public API
+// ============================================================================
 
-        // LRU candidate
-        if (entry->created_ms < oldest_time) {
-            oldest_time = entry->created_ms;
-            target_slot = i;
-        }
+void pg_query_cache_init(void) {
+    pg_mem_register_shrinker(PG_MEM_QUERY_CACHE, qc_shrink);
+    pg_mem_charge(PG_MEM_QUERY_CACHE, (ssize_t)sizeof(neg_entries));
+    LOG_INFO("Query result cache initialized (buckets=%d, ttl=%dms, budget=%dMB)",
+             QUERY_CACHE_BUCKETS, QUERY_CACHE_TTL_MS, QUERY_CACHE_BUDGET_BYTES / (1024 * 1024));
+}
+
+void pg_query_cache_cleanup(void) {
+    uint64_t hits = atomic_load(&total_hits);
+    uint64_t misses = atomic_load(&total_misses);
+    if (hits > 0 || misses > 0) {
+        LOG_INFO("QUERY_CACHE exit: hits=%llu (empty=%llu) misses=%llu ratio=%.1f%% refreshes=%llu",
+                 (unsigned long long)hits, (unsigned long long)atomic_load(&total_neg_hits),
+                 (unsigned long long)misses, 100.0 * hits / (hits + misses),
+                 (unsigned long long)atomic_load(&total_refreshes));
+    }
+
+    pthread_rwlock_wrlock(&cache_rwlock);
+    while (clock_tail) unlink_entry(clock_tail);
+    pthread_rwlock_unlock(&cache_rwlock);
+
+    pthread_rwlock_wrlock(&neg_rwlock);
+    memset(neg_entries, 0, sizeof(neg_entries));
+    for (int i = 0; i < QC_ANALYSIS_SLOTS; i++) {
+        if (!neg_layouts[i].entry) continue;
+        pg_mem_charge(PG_MEM_QUERY_CACHE, -(ssize_t)neg_layouts[i].entry->bytes);
+        pg_query_cache_release(&neg_layouts[i].entry->result);
+        neg_layouts[i].entry = NULL;
+        neg_layouts[i].sql_hash = 0;
     }
+    pthread_rwlock_unlock(&neg_rwlock);
+}
 
-    if (target_slot < 0) {
-        target_slot = 0;  // Fallback to first slot
+static uint64_t key_with_sql_hash(pg_stmt_t *stmt, uint64_t hash) {
+    // Mix in parameter values
+    for (int i = 0; i < stmt->param_count && i < MAX_PARAMS; i++) {
+        if (stmt->param_values[i]) {
+            // Hash the parameter value (raw BYTEA binds may contain NULs)
+            size_t len = (stmt->param_types[i] == PG_OID_BYTEA)
+                         ? (size_t)stmt->param_lengths[i]
+                         : strlen(stmt->param_values[i]);
+            uint64_t param_hash = fnv1a_hash(stmt->param_values[i], len);
+            // Mix hashes
+            hash ^= param_hash;
+            hash *= 0x100000001b3ULL;
+        } else {
+            // NULL parameter - use a sentinel value
+            hash ^= 0xDEADBEEFULL;
+            hash *= 0x100000001b3ULL;
+        }
     }
+    return hash ? hash : 1;  // 0 means "no key"
+}
 
-    // Free existing entry
-    free_cached_result(&cache->entries[target_slot]);
+uint64_t pg_query_cache_key(pg_stmt_t *stmt) {
+    if (!stmt || !stmt->pg_sql) return 0;
+    return key_with_sql_hash(stmt, fnv1a_hash(stmt->pg_sql, strlen(stmt->pg_sql)));
+}
 
-    cached_result_t *entry = &cache->entries[target_slot];
+cached_result_t* pg_query_cache_lookup(pg_stmt_t *stmt) {
+    pending.valid = 0;
+    if (!stmt || !stmt->pg_sql) return NULL;
+    pg_inval_start();  // Other processes' writes must reach this cache
 
-    // Calculate total size estimate
-    size_t total_size = 0;
+    uint64_t sql_hash = fnv1a_hash(stmt->pg_sql, strlen(stmt->pg_sql));
+    qc_analysis_t analysis;
+    analyze_sql(stmt->pg_sql, sql_hash, &analysis);
+    if (!analysis.cacheable) return NULL;
 
-    // Allocate column types
-    entry->col_types = malloc(num_cols * sizeof(Oid));
-    if (!entry->col_types) goto cleanup;
+    uint64_t key = key_with_sql_hash(stmt, sql_hash);
+    uint64_t now = get_time_ms();
+    qc_entry_t *hit = NULL;
+
+    pthread_rwlock_rdlock(&cache_rwlock);
+    for (qc_entry_t *e = buckets[key & (QUERY_CACHE_BUCKETS - 1)]; e; e = e->hash_next) {
+        if (e->result.cache_key == key && entry_matches(e, stmt)) {
+            if (entry_is_fresh(e, now)) {
+                // Cache hit! Take a ref so eviction can't free it under the reader
+                atomic_fetch_add(&e->result.ref_count, 1);
+                atomic_store(&e->referenced, 1);
+                hit = e;
+            }
+            break;
+        }
+    }
+    pthread_rwlock_unlock(&cache_rwlock);
 
-    // Allocate column names
-    entry->col_names = calloc(num_cols, sizeof(char*));
-    if (!entry->col_names) goto cleanup;
+    if (!hit) hit = neg_lookup(stmt, key, sql_hash, &analysis, now);
 
-    for (int c = 0; c < num_cols; c++) {
-        entry->col_types[c] = PQftype(result, c);
-        const char *name = PQfname(result, c);
-        if (name) {
-            entry->col_names[c] = strdup(name);
-            total_size += strlen(name) + 1;
+    if (hit) {
+        atomic_fetch_add(&total_hits, 1);
+        pg_mem_hit(PG_MEM_QUERY_CACHE);
+        int hits = atomic_fetch_add(&hit->result.hit_count, 1) + 1;
+        if (now >= hit->soft_expires_ms && hits >= QUERY_CACHE_SWR_MIN_HITS) {
+            schedule_refresh(hit);  // Serve stale now, refresh in background
+        }
+        // Log every 100th hit to reduce spam
+        if (hits % 100 == 1) {
+            LOG_DEBUG("QUERY_CACHE HIT #%d: key=%llx rows=%d sql=%.60s",
+                      hits, (unsigned long long)key, hit->result.num_rows, stmt->pg_sql);
         }
+        return &hit->result;
     }
 
-    // Allocate rows
-    entry->rows = calloc(num_rows, sizeof(cached_row_t));
-    if (!entry->rows) goto cleanup;
+    // Miss - snapshot versions BEFORE the query runs (see file header)
+    atomic_fetch_add(&total_misses, 1);
+    pending.valid = 1;
+    pending.key = key;
+    snapshot_versions(&pending, analysis.ntables, analysis.table_ids);
+    return NULL;
+}
 
-    for (int r = 0; r < num_rows; r++) {
-        cached_row_t *row = &entry->rows[r];
+void pg_query_cache_store(pg_stmt_t *stmt, void *result_ptr) {
+    PGresult *result = (PGresult *)result_ptr;
+    if (!stmt || !stmt->pg_sql || !result || !pending.valid) return;
+    pending.valid = 0;
 
-        row->values = calloc(num_cols, sizeof(char*));
-        row->lengths = calloc(num_cols, sizeof(int));
-        row->is_null = calloc(num_cols, sizeof(int));
+    // Don't cache failed queries
+    if (PQresultStatus(result) != PGRES_TUPLES_OK) return;
 
-        if (!row->values || !row->lengths || !row->is_null) goto cleanup;
+    int num_rows = PQntuples(result);
+    int num_cols = PQnfields(result);
 
-        for (int c = 0; c < num_cols; c++) {
-            if (PQgetisnull(result, r, c)) {
-                row->is_null[c] = 1;
-                row->values[c] = NULL;
-                row->lengths[c] = 0;
-            } else {
-                int len = PQgetlength(result, r, c);
-                row->lengths[c] = len;
-                row->is_null[c] = 0;
-
-                // Check size limit
-                total_size += len + 1;
-                if (total_size > QUERY_CACHE_MAX_BYTES) {
-                    LOG_DEBUG("QUERY_CACHE SKIP: result too large (%zu > %d bytes)",
-                             total_size, QUERY_CACHE_MAX_BYTES);
-                    goto cleanup;
-                }
+    // Don't cache huge results
+    if (num_rows > QUERY_CACHE_MAX_ROWS) {
+        LOG_DEBUG("QUERY_CACHE SKIP: too many rows (%d > %d)", num_rows, QUERY_CACHE_MAX_ROWS);
+        return;
+    }
 
-                // Copy value (including null terminator for strings)
-                row->values[c] = malloc(len + 1);
-                if (!row->values[c]) goto cleanup;
+    uint64_t key = pg_query_cache_key(stmt);
+    if (key != pending.key) return;  // Params changed since lookup
 
-                const char *val = PQgetvalue(result, r, c);
-                memcpy(row->values[c], val, len);
-                row->values[c][len] = '\0';
-            }
-        }
+    // Empty results only need a fingerprint (see Negative Cache)
+    if (num_rows == 0) {
+        neg_store(stmt, result, key);
+        return;
     }
 
-    // Success - fill in metadata
-    entry->cache_key = key;
-    entry->created_ms = get_time_ms();
-    atomic_store(&entry->ref_count, 0);  // Initialize ref_count
-    entry->num_rows = num_rows;
-    entry->num_cols = num_cols;
-    entry->hit_count = 0;
-    cache->count++;
+    size_t params_len = params_size(stmt);
+    char params_buf[1024];
+    char *params = params_len <= sizeof(params_buf) ? params_buf : malloc(params_len);
+    if (!params) return;
+    serialize_params(stmt, params);
 
-    LOG_DEBUG("QUERY_CACHE STORE: key=%llx rows=%d cols=%d size=%zu sql=%.60s",
-             (unsigned long long)key, num_rows, num_cols, total_size, stmt->pg_sql);
-    return;
+    qc_entry_t *e = build_entry(stmt->pg_sql, params, params_len, result, num_rows, num_cols);
+    if (params != params_buf) free(params);
+    if (!e) return;
 
-cleanup:
-    // Failed to allocate - clean up partial entry
-    free_cached_result(entry);
+    LOG_DEBUG("QUERY_CACHE STORE: key=%llx rows=%d cols=%d size=%zu tables=%d sql=%.60s",
+              (unsigned long long)key, num_rows, num_cols, e->bytes, pending.ntables, stmt->pg_sql);
+    insert_entry(e, key, &pending);
 }
 
 void pg_query_cache_invalidate(pg_stmt_t *stmt) {
     if (!stmt || !stmt->pg_sql) return;
 
-    query_cache_t *cache = get_thread_cache();
-    if (!cache) return;
-
     uint64_t key = pg_query_cache_key(stmt);
     if (key == 0) return;
+    neg_invalidate(key);
 
-    for (int i = 0; i < QUERY_CACHE_SIZE; i++) {
-        if (cache->entries[i].cache_key == key) {
-            free_cached_result(&cache->entries[i]);
-            cache->count--;
-            return;
+    pthread_rwlock_wrlock(&cache_rwlock);
+    for (qc_entry_t *e = buckets[key & (QUERY_CACHE_BUCKETS - 1)]; e; e = e->hash_next) {
+        if (e->result.cache_key == key && entry_matches(e, stmt)) {
+            unlink_entry(e);
+            break;
         }
     }
+    pthread_rwlock_unlock(&cache_rwlock);
 }
 
-void pg_query_cache_stats(uint64_t *hits, uint64_t *misses) {
-    query_cache_t *cache = get_thread_cache();
-    if (!cache) {
-        if (hits) *hits = 0;
-        if (misses) *misses = 0;
+void pg_query_cache_invalidate_table(const char *table) {
+    if (!table) return;
+    char name[128];
+    const char *p = table;
+    if (!read_identifier(&p, name, sizeof(name))) return;
+    uint32_t slot = table_id(name) & (QUERY_CACHE_TABLE_SLOTS - 1);
+    atomic_fetch_add(&table_versions[slot], 1);
+}
+
+void pg_query_cache_invalidate_all(void) {
+    atomic_fetch_add(&cache_epoch, 1);
+}
+
+void pg_query_cache_invalidate_write(const char *sql) {
+    if (!sql) return;
+
+    uint32_t ids[QUERY_CACHE_MAX_TABLES];
+    char names[QUERY_CACHE_MAX_TABLES][QC_TABLE_NAME_LEN];
+    int n = collect_tables(sql, 1, ids, names);
+    if (n <= 0) {
+        // Can't tell what changed - play safe
+        LOG_DEBUG("QUERY_CACHE: invalidating all (unparsed write: %.60s)", sql);
+        pg_query_cache_invalidate_all();
+        pg_inval_publish(PG_INVAL_ALL);
         return;
     }
+    for (int i = 0; i < n; i++) {
+        atomic_fetch_add(&table_versions[ids[i] & (QUERY_CACHE_TABLE_SLOTS - 1)], 1);
+        pg_inval_publish(names[i]);
+    }
+}
+
+void pg_query_cache_invalidate_schema(void) {
+    atomic_fetch_add(&schema_version, 1);
+    atomic_fetch_add(&cache_epoch, 1);
+}
+
+void pg_query_cache_invalidate_ddl(void) {
+    pg_query_cache_invalidate_schema();
+    pg_inval_publish(PG_INVAL_SCHEMA);
+}
 
-    if (hits) *hits = cache->total_hits;
-    if (misses) *misses = cache->total_misses;
+uint64_t pg_query_cache_table_version(const char *table) {
+    if (!table) return 0;
+    return atomic_load(&table_versions[table_id(table) & (QUERY_CACHE_TABLE_SLOTS - 1)]);
+}
+
+uint64_t pg_query_cache_schema_version(void) {
+    return atomic_load(&schema_version);
+}
+
+void pg_query_cache_stats(uint64_t *hits, uint64_t *misses) {
+    if (hits) *hits = atomic_load(&total_hits);
+    if (misses) *misses = atomic_load(&total_misses);
+}
+
+// Called in child after fork(): the refresh worker doesn't exist in the child
+// and its connection's socket belongs to the parent (don't PQfinish it). Locks
+// may have been held by parent threads, so reinitialize them.
+void pg_query_cache_reset_after_fork(void) {
+    pthread_mutex_init(&refresh_mutex, NULL);
+    pthread_cond_init(&refresh_cond, NULL);
+    pthread_rwlock_init(&cache_rwlock, NULL);
+    pthread_rwlock_init(&analysis_rwlock, NULL);
+    pthread_rwlock_init(&neg_rwlock, NULL);
+
+    for (int i = 0; i < refresh_count; i++) {
+        qc_entry_t *e = refresh_queue[(refresh_head + i) % QUERY_CACHE_SWR_QUEUE];
+        atomic_store(&e->refreshing, 0);
+        pg_query_cache_release(&e->result);
+    }
+    refresh_head = 0;
+    refresh_count = 0;
+    refresh_started = 0;
+    refresh_conn = NULL;
+    pending.valid = 0;
 }
 
 void pg_query_cache_release(cached_result_t *entry) {
     if (!entry) return;
 
     int old_count = atomic_fetch_sub(&entry->ref_count, 1);
-    if (old_count <= 1) {
-        // ref_count is now 0 or less - entry can be freed on next eviction
-        LOG_DEBUG("CACHE_RELEASE: entry %p now has 0 refs, eligible for eviction",
-                 (void*)entry);
+    if (old_count == 1) {
+        // Last reference - already unlinked from the cache
+        free_entry((qc_entry_t *)entry);
     }
 }
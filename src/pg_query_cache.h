@@ -1,53 +1,93 @@
 /*
  * PostgreSQL Shim - Query Result Cache
- * 
- * Caches query results for identical queries within a short time window.
- * This is critical for Plex's OnDeck endpoint which executes the same query
- * 2000+ times in a loop.
+ *
+ * Caches query results for identical queries so repeated reads don't hit
+ * PostgreSQL. This is critical for Plex's OnDeck endpoint which executes
+ * the same query 2000+ times in a loop, and for hub rendering.
  *
  * Design:
- * - Thread-local cache (no locking needed)
- * - Cache key: hash of (SQL + bound parameters)
- * - Cache TTL: 1 second (data freshness)
- * - LRU eviction when cache is full
+ * - Process-wide hash table shared by all threads (rwlock, lookups take the
+ *   read side only)
+ * - Cache key: (translated SQL, bound parameters) - hashed for the bucket,
+ *   compared exactly on hit
+ * - Byte budget with CLOCK (second-chance) eviction
+ * - Each entry records the tables its query reads, with a per-table version
+ *   snapshot taken BEFORE execution. Writes through step()/exec() bump the
+ *   versions of the tables they touch, so an entry is never served after a
+ *   write to any table it depends on and the TTL can be long.
+ * - Queries with volatile functions (now(), random(), nextval(), ...) are
+ *   never cached
+ * - Writes in other processes arrive through the LISTEN/NOTIFY listener
+ *   (pg_invalidation.h) and bump the same versions; while it is live the
+ *   hard TTL is only a backstop
+ * - Stale-while-revalidate: a hot entry past its soft TTL is still served and
+ *   refreshed once by a background worker on a maintenance connection. Only
+ *   hard TTL or a write to a dependent table forces synchronous execution.
+ * - Zero-row results (existence probes) are kept as 32-byte fingerprints in
+ *   a negative cache, validated against the same table versions, and served
+ *   with one shared empty layout per SQL
  */
 
 #ifndef PG_QUERY_CACHE_H
 #define PG_QUERY_CACHE_H
 
 #include <stdint.h>
+#include <stddef.h>
 #include <libpq-fe.h>
-#include "pg_types.h"  // For cached_result_t, cached_row_t, pg_stmt_t
+#include "pg_types.h"  // For cached_result_t, pg_stmt_t
 
 // Cache configuration
-#define QUERY_CACHE_SIZE 64         // Number of cached queries per thread
-#define QUERY_CACHE_TTL_MS 1000     // Cache TTL in milliseconds (1 second)
-#define QUERY_CACHE_MAX_ROWS 5      // Don't cache results with more than this many rows (TEST: tiny)
-#define QUERY_CACHE_MAX_BYTES 1024*1024  // Max total cached bytes per entry (1MB)
-
-// Thread-local cache structure
-typedef struct {
-    cached_result_t entries[QUERY_CACHE_SIZE];
-    int count;
-    uint64_t total_hits;
-    uint64_t total_misses;
-} query_cache_t;
+#define QUERY_CACHE_BUCKETS 4096                    // Hash buckets (power of 2)
+#define QUERY_CACHE_TTL_MS 10000                    // Hard expiry without a listener (writes by other processes)
+#define QUERY_CACHE_LISTEN_TTL_MS 60000             // Hard expiry while cross-process invalidation is live
+#define QUERY_CACHE_SOFT_TTL_MS 2000                // Soft expiry: hot entries served stale + refreshed in background
+#define QUERY_CACHE_SWR_MIN_HITS 2                  // Hits before an entry qualifies for background refresh
+#define QUERY_CACHE_SWR_QUEUE 64                    // Pending background refreshes
+#define QUERY_CACHE_MAX_ROWS 1000                   // Don't cache results with more rows than this
+#define QUERY_CACHE_MAX_BYTES (1024 * 1024)         // Max cached bytes per entry (1MB)
+#define QUERY_CACHE_BUDGET_BYTES (64 * 1024 * 1024) // Max cached bytes in total (64MB)
+#define QUERY_CACHE_MAX_TABLES 16                   // Queries reading more tables aren't cached
+#define QUERY_CACHE_TABLE_SLOTS 4096                // Per-table version counters (power of 2)
+#define QUERY_CACHE_NEG_SLOTS 16384                 // Zero-row result fingerprints (power of 2, 32B each)
 
 // Initialize/cleanup
 void pg_query_cache_init(void);
 void pg_query_cache_cleanup(void);
 
 // Cache operations
-// Returns cached result if found and not expired, NULL otherwise
+// Returns cached result if found, fresh and not invalidated, NULL otherwise.
+// On a miss, snapshots table versions for the following store() on this thread.
 cached_result_t* pg_query_cache_lookup(pg_stmt_t *stmt);
 
 // Store result in cache (makes a copy of all data)
+// Only stores after a miss from pg_query_cache_lookup() for the same key on
+// this thread, so the entry carries pre-execution table versions.
 // PGresult* is from libpq - passed as void* to avoid header dependency
 void pg_query_cache_store(pg_stmt_t *stmt, void *result);
 
-// Invalidate cache entry for a statement (call on reset/finalize)
+// Invalidate cache entry for a statement's current key
 void pg_query_cache_invalidate(pg_stmt_t *stmt);
 
+// Write invalidation - call AFTER a write has executed (autocommit):
+// bumps the version of every table the write statement(s) modify and
+// notifies other processes (pg_invalidation.h).
+// Unparseable writes invalidate everything.
+void pg_query_cache_invalidate_write(const char *sql);
+
+// Same for DDL: bumps the schema version (relation names, declared types)
+// and drops every cached result, here and in other processes
+void pg_query_cache_invalidate_ddl(void);
+
+// Local-only invalidation (no NOTIFY) - used to apply other processes' writes
+void pg_query_cache_invalidate_table(const char *table);
+void pg_query_cache_invalidate_all(void);
+void pg_query_cache_invalidate_schema(void);
+
+// Version counters for other caches to validate against. Any change means
+// data in the table (or, for the schema version, any schema) changed.
+uint64_t pg_query_cache_table_version(const char *table);
+uint64_t pg_query_cache_schema_version(void);
+
 // Release a cached result (decrement ref_count)
 // MUST be called when pg_stmt->cached_result is cleared
 void pg_query_cache_release(cached_result_t *entry);
@@ -58,4 +98,8 @@ uint64_t pg_query_cache_key(pg_stmt_t *stmt);
 // Get stats (for logging)
 void pg_query_cache_stats(uint64_t *hits, uint64_t *misses);
 
+// Fork safety - drop the parent's refresh worker state (thread, connection,
+// locks) in the child after fork()
+void pg_query_cache_reset_after_fork(void);
+
 #endif // PG_QUERY_CACHE_H
@@ -0,0 +1,1315 @@
+/*
+ * PostgreSQL Shim - Primary Key Row Cache Implementation
+ *
+ * Freshness follows the query cache (pg_query_cache.c): a reader snapshots
+ * the hot tables' versions before it executes and only stores rows if the
+ * version is unchanged, checked under the slot lock. Writers bump the
+ * version (pg_query_cache_invalidate_write) before they drop rows under
+ * the same lock, so a row read before a write can never be stored after
+ * that write's invalidation.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <libpq-fe.h>
+
+#include "pg_row_cache.h"
+#include "pg_query_cache.h"
+#include "pg_client.h"
+#include "pg_statement.h"
+#include "pg_config.h"
+#include "pg_invalidation.h"
+#include "pg_logging.h"
+#include "pg_mem.h"
+#include "sql_translator_internal.h"  // for safe_strcasestr
+
+// ============================================================================
+// Types
+// ============================================================================
+
+// Hot tables - the ones Plex reads by id in tight loops
+static const char *HOT_TABLES[] = {
+    "metadata_items", "media_items", "media_parts", "tags", NULL
+};
+#define RC_TABLES 4
+#define RC_MAX_ATTNUM 256   // Tables with more attributes aren't cached
+
+// Catalog facts for the hot tables, immutable once published
+typedef struct rc_meta {
+    uint64_t schema;                 // pg_query_cache_schema_version() at load
+    struct rc_meta *retired;         // Previous generation (never freed, DDL is rare)
+    struct {
+        Oid oid;                     // 0 = table missing, never cached
+        int natts;                   // Live (not dropped) attributes
+        int max_attnum;
+        int id_attnum;
+    } t[RC_TABLES];
+} rc_meta_t;
+
+// One cached row - a single allocation: header, offsets, null flags, data
+typedef struct {
+    int table;                       // Index into HOT_TABLES
+    int64_t id;
+    uint64_t gen;                    // table_gen[table] at snapshot time
+    uint64_t all_gen;                // all_gen at snapshot time
+    uint64_t schema;                 // Schema version at snapshot time
+    uint64_t created_ms;             // Expiry (see row_is_valid)
+    int nattrs;                      // = max_attnum; attnum N is index N - 1
+    size_t bytes;                    // Allocation size (pg_mem accounting)
+    uint32_t *offsets;               // nattrs + 1 entries into data
+    uint8_t *nulls;
+    char *data;
+} rc_row_t;
+
+// Per-SQL analysis: is this a point lookup on a hot table?
+typedef struct {
+    uint64_t sql_hash;               // 0 = empty slot
+    int table;                       // -1 = not a point lookup
+    int keyed;                       // Single-key lookup on any table (batchable)
+    uint64_t schema;                 // attrs are only valid for this schema version
+    PGresult *attrs;                 // Column attributes (no rows), NULL until first result
+} rc_shape_t;
+
+// Versions snapshotted by begin_read(), consumed by store()
+typedef struct {
+    int valid;
+    uint64_t schema;
+    uint64_t all_gen;
+    uint64_t versions[RC_TABLES];
+    uint64_t gens[RC_TABLES];
+} rc_snapshot_t;
+
+// ============================================================================
+// Static State
+// ============================================================================
+
+static rc_row_t *slots[ROW_CACHE_SLOTS];
+static pthread_rwlock_t slots_rwlock = PTHREAD_RWLOCK_INITIALIZER;
+
+static rc_shape_t shapes[ROW_CACHE_SHAPES];
+static pthread_rwlock_t shapes_rwlock = PTHREAD_RWLOCK_INITIALIZER;
+
+static _Atomic(rc_meta_t*) meta = NULL;
+static pthread_mutex_t meta_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static _Atomic uint64_t table_gen[RC_TABLES];
+static _Atomic uint64_t all_gen = 0;
+
+static _Atomic uint64_t total_hits = 0;
+static _Atomic uint64_t total_misses = 0;
+static _Atomic uint64_t total_stored = 0;
+static _Atomic uint64_t total_batches = 0;
+
+static __thread rc_snapshot_t snapshot;
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+static int hot_table_index(const char *name) {
+    for (int i = 0; HOT_TABLES[i]; i++) {
+        if (strcmp(name, HOT_TABLES[i]) == 0) return i;
+    }
+    return -1;
+}
+
+static inline uint32_t row_slot(int table, int64_t id) {
+    uint64_t h = ((uint64_t)id * 0x9E3779B97F4A7C15ULL) ^ ((uint64_t)table << 56);
+    return (uint32_t)(h >> 32) & (ROW_CACHE_SLOTS - 1);
+}
+
+static int parse_id(const char *s, int64_t *out) {
+    if (!s || !*s) return 0;
+    char *end;
+    errno = 0;
+    long long v = strtoll(s, &end, 10);
+    if (errno || *end) return 0;
+    *out = v;
+    return 1;
+}
+
+static uint64_t get_time_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Generations catch local writes and notified remote ones. Without a
+// listener, writes by other processes (the scanner) are never seen, so
+// rows get the query cache's short TTL; the TTL is checked at lookup so
+// rows stored while listening expire quickly once the listener drops.
+static int row_is_valid(const rc_row_t *r) {
+    uint64_t ttl = pg_inval_listening() ? ROW_CACHE_LISTEN_TTL_MS : ROW_CACHE_TTL_MS;
+    return r->gen == atomic_load(&table_gen[r->table]) &&
+           r->all_gen == atomic_load(&all_gen) &&
+           r->schema == pg_query_cache_schema_version() &&
+           get_time_ms() - r->created_ms < ttl;
+}
+
+// ============================================================================
+// SQL Analysis
+// ============================================================================
+
+static inline int rc_ident_char(char c) {
+    return isalnum((unsigned char)c) || c == '_';
+}
+
+static const char* rc_skip_ws(const char *p) {
+    while (*p && isspace((unsigned char)*p)) p++;
+    return p;
+}
+
+// Possibly quoted, possibly qualified identifier; stores the last component
+// lowercased. Returns 0 if there is none at *pp.
+static int rc_read_ident(const char **pp, char *out, size_t outsz) {
+    const char *p = *pp;
+    size_t n = 0;
+    for (;;) {
+        n = 0;
+        if (*p == '"') {
+            p++;
+            while (*p && *p != '"') {
+                if (n + 1 < outsz) out[n++] = (char)tolower((unsigned char)*p);
+                p++;
+            }
+            if (*p == '"') p++;
+        } else if (rc_ident_char(*p)) {
+            while (rc_ident_char(*p)) {
+                if (n + 1 < outsz) out[n++] = (char)tolower((unsigned char)*p);
+                p++;
+            }
+        } else {
+            break;
+        }
+        if (*p != '.') break;
+        p++;
+    }
+    out[n] = '\0';
+    *pp = p;
+    return n > 0;
+}
+
+// Consume keyword kw (case-insensitive, whole word) after whitespace
+static int rc_keyword(const char **pp, const char *kw) {
+    const char *p = rc_skip_ws(*pp);
+    size_t len = strlen(kw);
+    if (strncasecmp(p, kw, len) != 0 || rc_ident_char(p[len])) return 0;
+    *pp = p + len;
+    return 1;
+}
+
+// Position just after the first top-level WHERE (outside strings, quoted
+// identifiers and parentheses), or NULL
+static const char* find_where(const char *p) {
+    int depth = 0;
+    while (*p) {
+        if (*p == '\'' || *p == '"') {
+            char q = *p++;
+            while (*p && *p != q) p++;
+            if (*p) p++;
+        } else if (*p == '(') {
+            depth++;
+            p++;
+        } else if (*p == ')') {
+            depth--;
+            p++;
+        } else if (rc_ident_char(*p)) {
+            const char *w = p;
+            while (rc_ident_char(*p)) p++;
+            if (depth == 0 && p - w == 5 && strncasecmp(w, "where", 5) == 0) return p;
+        } else {
+            p++;
+        }
+    }
+    return NULL;
+}
+
+// "[qual.]id = <value>" up to the end of the statement (or RETURNING).
+// *param = N for "$N", else *literal holds an integer literal.
+static int parse_id_predicate(const char *p, int *param, int64_t *literal) {
+    char name[64];
+    p = rc_skip_ws(p);
+    if (!rc_read_ident(&p, name, sizeof(name)) || strcmp(name, "id") != 0) return 0;
+    p = rc_skip_ws(p);
+    if (*p++ != '=') return 0;
+    p = rc_skip_ws(p);
+
+    *param = 0;
+    if (*p == '$') {
+        p++;
+        if (!isdigit((unsigned char)*p)) return 0;
+        while (isdigit((unsigned char)*p)) *param = *param * 10 + (*p++ - '0');
+    } else {
+        char *end;
+        errno = 0;
+        *literal = strtoll(p, &end, 10);
+        if (errno || end == p) return 0;
+        p = end;
+    }
+
+    p = rc_skip_ws(p);
+    if (rc_keyword(&p, "returning")) return 1;
+    if (*p == ';') p = rc_skip_ws(p + 1);
+    return *p == '\0';
+}
+
+// A single-key lookup, as located by analyze_key_lookup()
+typedef struct {
+    char table[64];                  // Unqualified, lowercased
+    char column[64];                 // Key column, lowercased
+    int from;                        // Offset of FROM
+    int where;                       // Offset of WHERE
+    int key, key_len;                // Key expression as written ([q.]col)
+    int limit1;                      // Ends in LIMIT 1
+} rc_key_lookup_t;
+
+// SELECT <plain column list> FROM <table> [[AS] alias] WHERE [q.]<col> = $1 [LIMIT 1]
+static int analyze_key_lookup(const char *sql, rc_key_lookup_t *k) {
+    const char *p = sql;
+    if (!rc_keyword(&p, "select")) return 0;
+
+    // Column list: no expressions, subqueries or literals
+    const char *from = NULL;
+    while (*p && !from) {
+        if (*p == '(' || *p == '\'' || *p == ';') return 0;
+        if (*p == '"') {
+            p++;
+            while (*p && *p != '"') p++;
+            if (*p) p++;
+        } else if (rc_ident_char(*p)) {
+            const char *w = p;
+            while (rc_ident_char(*p)) p++;
+            if (p - w == 4 && strncasecmp(w, "from", 4) == 0) from = w;
+        } else {
+            p++;
+        }
+    }
+    if (!from) return 0;
+    k->from = (int)(from - sql);
+
+    char name[64];
+    p = rc_skip_ws(p);
+    if (!rc_read_ident(&p, k->table, sizeof(k->table))) return 0;
+
+    const char *where = rc_skip_ws(p);
+    if (!rc_keyword(&p, "where")) {
+        rc_keyword(&p, "as");
+        p = rc_skip_ws(p);
+        if (!rc_read_ident(&p, name, sizeof(name))) return 0;  // Alias
+        where = rc_skip_ws(p);
+        if (!rc_keyword(&p, "where")) return 0;
+    }
+    k->where = (int)(where - sql);
+
+    p = rc_skip_ws(p);
+    const char *key = p;
+    if (!rc_read_ident(&p, k->column, sizeof(k->column))) return 0;
+    k->key = (int)(key - sql);
+    k->key_len = (int)(p - key);
+    p = rc_skip_ws(p);
+    if (*p++ != '=') return 0;
+    p = rc_skip_ws(p);
+    if (strncmp(p, "$1", 2) != 0 || isdigit((unsigned char)p[2])) return 0;
+    p += 2;
+
+    k->limit1 = 0;
+    if (rc_keyword(&p, "limit")) {
+        p = rc_skip_ws(p);
+        if (*p++ != '1' || isdigit((unsigned char)*p)) return 0;
+        k->limit1 = 1;
+    }
+    p = rc_skip_ws(p);
+    if (*p == ';') p = rc_skip_ws(p + 1);
+    return *p == '\0';
+}
+
+// ============================================================================
+// Table Metadata
+// ============================================================================
+
+static rc_meta_t* load_meta(pg_connection_t *conn, uint64_t schema) {
+    rc_meta_t *m = calloc(1, sizeof(rc_meta_t));
+    if (!m) return NULL;
+    m->schema = schema;
+
+    pg_conn_config_t *cfg = pg_config_get();
+    const char *params[2] = { cfg ? cfg->schema : "plex",
+                              "{metadata_items,media_items,media_parts,tags}" };
+
+    pthread_mutex_lock(&conn->mutex);
+    PGresult *res = PQexecParams(conn->conn,
+        "SELECT c.relname, c.oid, count(*), max(a.attnum), "
+        "coalesce(max(a.attnum) FILTER (WHERE a.attname = 'id'), 0) "
+        "FROM pg_class c JOIN pg_namespace n ON n.oid = c.relnamespace "
+        "JOIN pg_attribute a ON a.attrelid = c.oid AND a.attnum > 0 AND NOT a.attisdropped "
+        "WHERE n.nspname = $1 AND c.relname = ANY($2::text[]) GROUP BY c.relname, c.oid",
+        2, NULL, params, NULL, NULL, 0);
+    pthread_mutex_unlock(&conn->mutex);
+
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        LOG_ERROR("ROW_CACHE: table metadata query failed: %s", PQerrorMessage(conn->conn));
+    } else {
+        for (int r = 0; r < PQntuples(res); r++) {
+            int t = hot_table_index(PQgetvalue(res, r, 0));
+            if (t < 0) continue;
+            int max_attnum = atoi(PQgetvalue(res, r, 3));
+            int id_attnum = atoi(PQgetvalue(res, r, 4));
+            if (max_attnum > RC_MAX_ATTNUM || id_attnum <= 0) continue;
+            m->t[t].oid = (Oid)strtoul(PQgetvalue(res, r, 1), NULL, 10);
+            m->t[t].natts = atoi(PQgetvalue(res, r, 2));
+            m->t[t].max_attnum = max_attnum;
+            m->t[t].id_attnum = id_attnum;
+        }
+    }
+    PQclear(res);
+    return m;
+}
+
+// Current metadata; reloaded through conn after DDL. NULL if unavailable.
+static rc_meta_t* get_meta(pg_connection_t *conn) {
+    uint64_t schema = pg_query_cache_schema_version();
+    rc_meta_t *m = atomic_load(&meta);
+    if (m && m->schema == schema) return m;
+    if (!conn || !conn->conn) return NULL;
+
+    pthread_mutex_lock(&meta_mutex);
+    m = atomic_load(&meta);
+    if (!m || m->schema != schema) {
+        rc_meta_t *fresh = load_meta(conn, schema);
+        if (fresh) {
+            fresh->retired = m;
+            atomic_store(&meta, fresh);
+            m = fresh;
+            LOG_DEBUG("ROW_CACHE: loaded table metadata (schema version %llu)",
+                      (unsigned long long)schema);
+        }
+    }
+    pthread_mutex_unlock(&meta_mutex);
+    return m && m->schema == schema ? m : NULL;
+}
+
+// Which hot table a result reads in full (every live attribute present),
+// or -1. col_of[attnum - 1] receives each attribute's result column.
+static int full_row_table(const rc_meta_t *m, const PGresult *res, int *col_of) {
+    int ncols = PQnfields(res);
+    Oid oid = PQftable(res, 0);
+    int t = -1;
+    for (int i = 0; i < RC_TABLES; i++) {
+        if (m->t[i].oid && m->t[i].oid == oid) t = i;
+    }
+    if (t < 0 || ncols < m->t[t].natts) return -1;
+
+    int max_attnum = m->t[t].max_attnum;
+    for (int a = 0; a < max_attnum; a++) col_of[a] = -1;
+
+    int distinct = 0;
+    for (int c = 0; c < ncols; c++) {
+        int attnum = PQftablecol(res, c);
+        if (PQftable(res, c) != oid || attnum <= 0 || attnum > max_attnum) return -1;
+        if (col_of[attnum - 1] < 0) distinct++;
+        col_of[attnum - 1] = c;
+    }
+    return distinct == m->t[t].natts ? t : -1;
+}
+
+// ============================================================================
+// Rows
+// ============================================================================
+
+static rc_row_t* build_row(const PGresult *res, int r, int table, int nattrs, const int *col_of,
+                           int64_t id, const rc_snapshot_t *snap) {
+    size_t data_len = 0;
+    for (int a = 0; a < nattrs; a++) {
+        if (col_of[a] >= 0 && !PQgetisnull(res, r, col_of[a])) {
+            data_len += (size_t)PQgetlength(res, r, col_of[a]);
+        }
+    }
+    if (data_len > ROW_CACHE_MAX_ROW_BYTES) return NULL;
+
+    size_t offsets_at = (sizeof(rc_row_t) + 7) & ~(size_t)7;
+    size_t nulls_at = offsets_at + sizeof(uint32_t) * (size_t)(nattrs + 1);
+    size_t data_at = nulls_at + (size_t)nattrs;
+    rc_row_t *row = malloc(data_at + data_len + 1);
+    if (!row) return NULL;
+    row->bytes = data_at + data_len + 1;
+
+    row->table = table;
+    row->id = id;
+    row->gen = snap->gens[table];
+    row->all_gen = snap->all_gen;
+    row->schema = snap->schema;
+    row->created_ms = get_time_ms();
+    row->nattrs = nattrs;
+    row->offsets = (uint32_t *)((char *)row + offsets_at);
+    row->nulls = (uint8_t *)row + nulls_at;
+    row->data = (char *)row + data_at;
+
+    uint32_t off = 0;
+    for (int a = 0; a < nattrs; a++) {
+        row->offsets[a] = off;
+        // Dropped attributes (no result column) read as NULL
+        row->nulls[a] = col_of[a] < 0 || PQgetisnull(res, r, col_of[a]);
+        if (!row->nulls[a]) {
+            int len = PQgetlength(res, r, col_of[a]);
+            memcpy(row->data + off, PQgetvalue(res, r, col_of[a]), (size_t)len);
+            off += (uint32_t)len;
+        }
+    }
+    row->offsets[nattrs] = off;
+    row->data[off] = '\0';
+    return row;
+}
+
+// Drop the cached row for (table, id), if any
+static void remove_row(int table, int64_t id) {
+    uint32_t slot = row_slot(table, id);
+    rc_row_t *old = NULL;
+    pthread_rwlock_wrlock(&slots_rwlock);
+    if (slots[slot] && slots[slot]->table == table && slots[slot]->id == id) {
+        old = slots[slot];
+        slots[slot] = NULL;
+    }
+    pthread_rwlock_unlock(&slots_rwlock);
+    if (old) pg_mem_charge(PG_MEM_ROW_CACHE, -(ssize_t)old->bytes);
+    free(old);
+}
+
+static uint32_t shrink_cursor = 0;  // slots_rwlock (write)
+
+// pg_mem shrinker - the global cache budget is over. Drops rows from a
+// rotating cursor so repeated reclaims don't keep hitting the same slots.
+static size_t rc_shrink(size_t bytes) {
+    size_t freed = 0;
+    pthread_rwlock_wrlock(&slots_rwlock);
+    for (int n = 0; n < ROW_CACHE_SLOTS && freed < bytes; n++) {
+        uint32_t slot = shrink_cursor;
+        shrink_cursor = (shrink_cursor + 1) & (ROW_CACHE_SLOTS - 1);
+        if (!slots[slot]) continue;
+        freed += slots[slot]->bytes;
+        free(slots[slot]);
+        slots[slot] = NULL;
+    }
+    pthread_rwlock_unlock(&slots_rwlock);
+    pg_mem_charge(PG_MEM_ROW_CACHE, -(ssize_t)freed);
+    return freed;
+}
+
+static pthread_once_t shrinker_once = PTHREAD_ONCE_INIT;
+
+static void register_shrinker(void) {
+    pg_mem_register_shrinker(PG_MEM_ROW_CACHE, rc_shrink);
+}
+
+static void invalidate_table_index(int table) {
+    if (table >= 0) atomic_fetch_add(&table_gen[table], 1);
+}
+
+// ============================================================================
+// Shapes
+// ============================================================================
+
+// Analyze (once per SQL) and return the shape slot's table, -1 if not a
+// point lookup. *keyed (optional) = 1 for any single-key lookup. Caller
+// holds no lock.
+static int shape_table(const char *sql, uint64_t sql_hash, int *keyed) {
+    uint32_t idx = (uint32_t)sql_hash & (ROW_CACHE_SHAPES - 1);
+    int table = -2;
+    int is_keyed = 0;
+
+    pthread_rwlock_rdlock(&shapes_rwlock);
+    if (shapes[idx].sql_hash == sql_hash) {
+        table = shapes[idx].table;
+        is_keyed = shapes[idx].keyed;
+    }
+    pthread_rwlock_unlock(&shapes_rwlock);
+    if (table == -2) {
+        rc_key_lookup_t k;
+        is_keyed = analyze_key_lookup(sql, &k);
+        table = is_keyed && strcmp(k.column, "id") == 0 ? hot_table_index(k.table) : -1;
+
+        PGresult *old = NULL;
+        pthread_rwlock_wrlock(&shapes_rwlock);
+        old = shapes[idx].attrs;
+        shapes[idx].sql_hash = sql_hash;
+        shapes[idx].table = table;
+        shapes[idx].keyed = is_keyed;
+        shapes[idx].schema = 0;
+        shapes[idx].attrs = NULL;
+        pthread_rwlock_unlock(&shapes_rwlock);
+        if (old) PQclear(old);
+    }
+    if (keyed) *keyed = is_keyed;
+    return table;
+}
+
+// Stop batching a key lookup whose batch query can't be used
+static void shape_unkey(uint64_t sql_hash) {
+    uint32_t idx = (uint32_t)sql_hash & (ROW_CACHE_SHAPES - 1);
+    pthread_rwlock_wrlock(&shapes_rwlock);
+    if (shapes[idx].sql_hash == sql_hash) shapes[idx].keyed = 0;
+    pthread_rwlock_unlock(&shapes_rwlock);
+}
+
+// Remember a point lookup's column attributes (served results reuse them)
+static void record_shape(uint64_t sql_hash, int table, const rc_meta_t *m, const PGresult *res) {
+    uint32_t idx = (uint32_t)sql_hash & (ROW_CACHE_SHAPES - 1);
+    for (int c = 0; c < PQnfields(res); c++) {
+        int attnum = PQftablecol(res, c);
+        if (PQftable(res, c) != m->t[table].oid || attnum <= 0 || attnum > m->t[table].max_attnum) return;
+    }
+
+    PGresult *attrs = PQcopyResult(res, PG_COPYRES_ATTRS);
+    if (!attrs) return;
+    pthread_rwlock_wrlock(&shapes_rwlock);
+    if (shapes[idx].sql_hash == sql_hash && shapes[idx].table == table &&
+        (!shapes[idx].attrs || shapes[idx].schema != m->schema)) {
+        PGresult *old = shapes[idx].attrs;
+        shapes[idx].attrs = attrs;
+        shapes[idx].schema = m->schema;
+        attrs = old;
+    }
+    pthread_rwlock_unlock(&shapes_rwlock);
+    if (attrs) PQclear(attrs);
+}
+
+static uint64_t stmt_sql_hash(pg_stmt_t *stmt) {
+    return stmt->sql_hash ? stmt->sql_hash : pg_hash_sql(stmt->pg_sql);
+}
+
+// ============================================================================
+// Storing
+// ============================================================================
+
+static void take_snapshot(rc_snapshot_t *snap) {
+    snap->valid = 1;
+    snap->schema = pg_query_cache_schema_version();
+    snap->all_gen = atomic_load(&all_gen);
+    for (int t = 0; t < RC_TABLES; t++) {
+        snap->versions[t] = pg_query_cache_table_version(HOT_TABLES[t]);
+        snap->gens[t] = atomic_load(&table_gen[t]);
+    }
+}
+
+// Cache the complete hot-table rows of a result read under snap.
+// Returns the number of rows stored.
+static int store_full_rows(const rc_meta_t *m, const PGresult *result, const rc_snapshot_t *snap) {
+    int col_of[RC_MAX_ATTNUM];
+    int table = full_row_table(m, result, col_of);
+    if (table < 0) return 0;
+
+    int nattrs = m->t[table].max_attnum;
+    int id_col = col_of[m->t[table].id_attnum - 1];
+    int nrows = PQntuples(result);
+    if (nrows > ROW_CACHE_MAX_STORE_ROWS) nrows = ROW_CACHE_MAX_STORE_ROWS;
+
+    rc_row_t *rows[ROW_CACHE_MAX_STORE_ROWS];
+    int n = 0;
+    for (int r = 0; r < nrows; r++) {
+        int64_t id;
+        if (PQgetisnull(result, r, id_col) || !parse_id(PQgetvalue(result, r, id_col), &id)) continue;
+        rc_row_t *row = build_row(result, r, table, nattrs, col_of, id, snap);
+        if (row) rows[n++] = row;
+    }
+    if (n == 0) return 0;
+
+    // Version check and insert under the slot lock (see file header)
+    int stored = 0;
+    ssize_t delta = 0;
+    pthread_rwlock_wrlock(&slots_rwlock);
+    if (pg_query_cache_table_version(HOT_TABLES[table]) == snap->versions[table]) {
+        for (int i = 0; i < n; i++) {
+            uint32_t slot = row_slot(table, rows[i]->id);
+            rc_row_t *old = slots[slot];
+            slots[slot] = rows[i];
+            delta += (ssize_t)rows[i]->bytes - (old ? (ssize_t)old->bytes : 0);
+            rows[i] = old;  // Freed below
+        }
+        stored = n;
+    }
+    pthread_rwlock_unlock(&slots_rwlock);
+
+    for (int i = 0; i < n; i++) free(rows[i]);
+    if (stored) {
+        atomic_fetch_add(&total_stored, (uint64_t)stored);
+        pthread_once(&shrinker_once, register_shrinker);
+        pg_mem_charge(PG_MEM_ROW_CACHE, delta);
+        pg_mem_check();
+    }
+    return stored;
+}
+
+// One-row result for (table, id) with the lookup's recorded attributes.
+// *known = 0 if the lookup's attributes aren't recorded yet.
+static PGresult* serve_row(uint64_t sql_hash, int table, int64_t id, int *known) {
+    uint32_t idx = (uint32_t)sql_hash & (ROW_CACHE_SHAPES - 1);
+    uint64_t schema = pg_query_cache_schema_version();
+    PGresult *res = NULL;
+
+    pthread_rwlock_rdlock(&shapes_rwlock);
+    const PGresult *attrs = shapes[idx].sql_hash == sql_hash && shapes[idx].schema == schema
+                            ? shapes[idx].attrs : NULL;
+    if (attrs) {
+        pthread_rwlock_rdlock(&slots_rwlock);
+        rc_row_t *row = slots[row_slot(table, id)];
+        if (row && row->table == table && row->id == id && row_is_valid(row)) {
+            res = PQcopyResult(attrs, PG_COPYRES_ATTRS);
+            for (int c = 0; res && c < PQnfields(res); c++) {
+                int a = PQftablecol(res, c) - 1;
+                int ok = a < row->nattrs && (row->nulls[a]
+                    ? PQsetvalue(res, 0, c, NULL, -1)
+                    : PQsetvalue(res, 0, c, row->data + row->offsets[a],
+                                 (int)(row->offsets[a + 1] - row->offsets[a])));
+                if (!ok) {
+                    PQclear(res);
+                    res = NULL;
+                }
+            }
+        }
+        pthread_rwlock_unlock(&slots_rwlock);
+    }
+    pthread_rwlock_unlock(&shapes_rwlock);
+
+    *known = attrs != NULL;
+    return res;
+}
+
+// ============================================================================
+// Loop Detection and N+1 Batching
+// ============================================================================
+// Plex runs some reads in tight loops (OnDeck with many views: one child
+// query per row of a parent result, thousands per second). Every read that
+// isn't answered by the query cache passes the one loop detector below once
+// per execution; a read repeated ROW_CACHE_LOOP_LOG_RUNS times within
+// ROW_CACHE_LOOP_WINDOW_MS on a thread is logged as a loop.
+//
+// Loops of single-key lookups are batched. Once one lookup missed
+// ROW_CACHE_LOOP_MISSES times within the window, a miss instead fetches the
+// missing key and the keys the loop will ask for next in one query:
+// - Point lookups on hot tables run
+//       SELECT * FROM <table> WHERE id = ANY($1::bigint[])
+//   and store the rows, so any lookup of those ids is answered
+// - Any other "SELECT <cols> FROM <table> WHERE <col> = $1" runs its own
+//   SQL with the key appended to the column list,
+//       SELECT <cols>, <col> FROM <table> WHERE <col> = ANY($1)
+//   and keeps the result on the thread (ROW_CACHE_LOOP_WINDOW_MS, while the
+//   table's version is unchanged); each lookup is served the rows whose key
+//   matches, without the key column
+// Upcoming keys come from the parent: a recent multi-row result on this
+// thread whose current row holds the missing key - the same column of its
+// following rows has the next ones. Without a parent, a constant stride in
+// the recent integer keys is extrapolated.
+
+#define RC_LOOP_SLOTS 16
+#define RC_KEY_LEN 64                        // Longer keys aren't batched
+
+typedef struct {
+    uint64_t sql_hash;
+    uint64_t runs_start_ms;                  // Loop logging window
+    int runs;
+    uint64_t window_start_ms;                // Batching window
+    int misses;
+    int64_t recent[3];                       // Last integer keys looked up (stride)
+    int nrecent;
+    uint64_t batched[ROW_CACHE_BATCH_IDS];   // Key hashes requested by the last batch
+    int nbatched;
+    PGresult *batch;                         // Generic key lookups: last batch result
+    uint64_t batch_ms;
+    char batch_table[64];
+    uint64_t batch_version;                  // Table version, schema, all_gen when fetched
+    uint64_t batch_schema;
+    uint64_t batch_all_gen;
+    int batch_limit1;
+} rc_loop_t;
+
+static __thread rc_loop_t loops[RC_LOOP_SLOTS];
+
+// Recent multi-row results on this thread. Refs are held until replaced,
+// the statement is reset or finalized (pg_row_cache_forget, or lazily via
+// stmt->finalized when that happens on another thread) or the thread exits.
+typedef struct {
+    pg_stmt_t *stmts[ROW_CACHE_PARENTS];
+    int next;
+    int registered;
+} rc_parents_t;
+
+static __thread rc_parents_t parents;
+static pthread_key_t thread_key;
+static pthread_once_t thread_key_once = PTHREAD_ONCE_INIT;
+
+static void drop_batch(rc_loop_t *l) {
+    if (l->batch) PQclear(l->batch);
+    l->batch = NULL;
+}
+
+// Thread exit: parent refs and batch results
+static void release_thread(void *arg) {
+    rc_parents_t *ps = (rc_parents_t *)arg;
+    for (int i = 0; i < ROW_CACHE_PARENTS; i++) {
+        if (ps->stmts[i]) pg_stmt_unref(ps->stmts[i]);
+        ps->stmts[i] = NULL;
+    }
+    for (int i = 0; i < RC_LOOP_SLOTS; i++) drop_batch(&loops[i]);
+}
+
+static void create_thread_key(void) {
+    pthread_key_create(&thread_key, release_thread);
+}
+
+static void register_thread(void) {
+    if (parents.registered) return;
+    // Non-NULL value so release_thread() runs at thread exit
+    pthread_once(&thread_key_once, create_thread_key);
+    pthread_setspecific(thread_key, &parents);
+    parents.registered = 1;
+}
+
+// Drop parents finalized on other threads
+static void drop_finalized_parents(void) {
+    for (int i = 0; i < ROW_CACHE_PARENTS; i++) {
+        pg_stmt_t *p = parents.stmts[i];
+        if (p && atomic_load(&p->finalized)) {
+            parents.stmts[i] = NULL;
+            pg_stmt_unref(p);
+        }
+    }
+}
+
+// The loop detector: one call per execution of a read. Returns the read's
+// loop state (batching below).
+static rc_loop_t* loop_note_run(uint64_t sql_hash, const char *sql) {
+    uint64_t now = get_time_ms();
+    for (int i = 0; i < RC_LOOP_SLOTS; i++) {
+        if (loops[i].batch && now - loops[i].batch_ms >= ROW_CACHE_LOOP_WINDOW_MS) drop_batch(&loops[i]);
+    }
+
+    rc_loop_t *l = &loops[sql_hash % RC_LOOP_SLOTS];
+    if (l->sql_hash != sql_hash) {
+        drop_batch(l);
+        memset(l, 0, sizeof(*l));
+        l->sql_hash = sql_hash;
+    }
+    if (now - l->runs_start_ms >= ROW_CACHE_LOOP_WINDOW_MS) {
+        l->runs_start_ms = now;
+        l->runs = 0;
+    }
+    if (++l->runs >= ROW_CACHE_LOOP_LOG_RUNS) {
+        // Only log every 10th detection to reduce spam
+        static __thread int log_counter = 0;
+        if (log_counter++ % 10 == 0) {
+            LOG_ERROR("LOOP DETECTED: query called %d times in %llu ms (logged 1/10): %.100s",
+                      l->runs, (unsigned long long)(now - l->runs_start_ms), sql);
+        }
+        l->runs_start_ms = now;
+        l->runs = 0;
+    }
+    return l;
+}
+
+// Record an integer key for stride prediction
+static void loop_note_id(rc_loop_t *l, int64_t id) {
+    if (l->nrecent == 3) memmove(l->recent, l->recent + 1, sizeof(l->recent[0]) * 2);
+    l->recent[l->nrecent == 3 ? 2 : l->nrecent++] = id;
+}
+
+// Count a miss of key; 1 if the loop should batch now
+static int loop_should_batch(rc_loop_t *l, const char *key, pg_connection_t *conn) {
+    uint64_t now = get_time_ms();
+    if (now - l->window_start_ms >= ROW_CACHE_LOOP_WINDOW_MS) {
+        l->window_start_ms = now;
+        l->misses = 0;
+        l->nbatched = 0;
+    }
+    if (++l->misses < ROW_CACHE_LOOP_MISSES || !conn || !conn->conn) return 0;
+    l->window_start_ms = now;  // Loop still running - keep batching
+
+    // Asked for by the last batch and still missing: no such row (or it
+    // changed since) - don't batch again for it
+    uint64_t h = pg_hash_sql(key);
+    for (int i = 0; i < l->nbatched; i++) {
+        if (l->batched[i] == h) return 0;
+    }
+    return 1;
+}
+
+static const char* parent_cell(const pg_stmt_t *p, int row, int col) {
+    if (p->cached_result) return cached_cell_value(p->cached_result, row, col);
+    return PQgetisnull(p->result, row, col) ? NULL : PQgetvalue(p->result, row, col);
+}
+
+// Keys in the rows after parent p's current row, from the column whose
+// current value is key. Returns the number written to out.
+static int parent_keys(pg_stmt_t *p, const char *key, char (*out)[RC_KEY_LEN], int max) {
+    if (pg_bias_trylock(&p->lock) != 0) return 0;  // Never wait on another statement
+
+    int n = 0;
+    int row = p->current_row;
+    if ((p->result || p->cached_result) && row >= 0 && row < p->num_rows) {
+        for (int c = 0; c < p->num_cols && n == 0; c++) {
+            const char *v = parent_cell(p, row, c);
+            if (!v || strcmp(v, key) != 0) continue;
+            for (int r = row + 1; r < p->num_rows && n < max; r++) {
+                const char *next = parent_cell(p, r, c);
+                if (next && *next && strlen(next) < RC_KEY_LEN && strcmp(next, key) != 0) {
+                    strcpy(out[n++], next);
+                }
+            }
+        }
+    }
+    pg_bias_unlock(&p->lock);
+    return n;
+}
+
+// key plus the keys the loop will ask for next, into keys[0..]. Returns the
+// count, 0 if there is nothing to gain over the plain query.
+static int loop_keys(pg_stmt_t *stmt, rc_loop_t *l, const char *key, char (*keys)[RC_KEY_LEN]) {
+    int n = 0;
+    strcpy(keys[n++], key);
+    drop_finalized_parents();
+    for (int i = 1; i <= ROW_CACHE_PARENTS && n == 1; i++) {
+        pg_stmt_t *p = parents.stmts[(parents.next + ROW_CACHE_PARENTS - i) % ROW_CACHE_PARENTS];
+        if (p && p != stmt) n += parent_keys(p, key, keys + 1, ROW_CACHE_BATCH_IDS - 1);
+    }
+    int64_t id;
+    if (n == 1 && l->nrecent == 3 && parse_id(key, &id) && l->recent[2] == id &&
+        l->recent[2] - l->recent[1] == l->recent[1] - l->recent[0]) {
+        int64_t stride = l->recent[2] - l->recent[1];
+        for (int i = 1; stride != 0 && i < ROW_CACHE_BATCH_IDS; i++) {
+            snprintf(keys[n++], RC_KEY_LEN, "%lld", (long long)(id + stride * i));
+        }
+    }
+    if (n < 2) return 0;
+
+    for (int i = 0; i < n; i++) l->batched[i] = pg_hash_sql(keys[i]);
+    l->nbatched = n;
+    return n;
+}
+
+// Run one hot-table batch query and cache its rows. Returns 1 if any row was stored.
+static int prefetch_rows(int table, const int64_t *ids, int n, pg_connection_t *conn) {
+    rc_meta_t *m = get_meta(conn);
+    if (!m || !m->t[table].oid) return 0;
+
+    char array[ROW_CACHE_BATCH_IDS * 21 + 4];
+    int off = snprintf(array, sizeof(array), "{");
+    for (int i = 0; i < n; i++) {
+        off += snprintf(array + off, sizeof(array) - off, "%s%lld", i ? "," : "", (long long)ids[i]);
+    }
+    snprintf(array + off, sizeof(array) - off, "}");
+
+    char sql[128];
+    snprintf(sql, sizeof(sql), "SELECT * FROM %s WHERE id = ANY($1::bigint[])", HOT_TABLES[table]);
+    const char *params[1] = { array };
+
+    rc_snapshot_t snap;
+    take_snapshot(&snap);
+
+    PGresult *res = NULL;
+    pthread_mutex_lock(&conn->mutex);
+    if (PQstatus(conn->conn) == CONNECTION_OK && !PQisBusy(conn->conn)) {
+        res = PQexecParams(conn->conn, sql, 1, NULL, params, NULL, NULL, 0);
+    }
+    pthread_mutex_unlock(&conn->mutex);
+    if (!res) return 0;
+
+    int stored = 0;
+    if (PQresultStatus(res) == PGRES_TUPLES_OK) {
+        stored = store_full_rows(m, res, &snap);
+        atomic_fetch_add(&total_batches, 1);
+        LOG_DEBUG("ROW_CACHE BATCH: %s ids=%d rows=%d stored=%d",
+                  HOT_TABLES[table], n, PQntuples(res), stored);
+    } else {
+        LOG_ERROR("ROW_CACHE BATCH failed: %s", PQerrorMessage(conn->conn));
+    }
+    PQclear(res);
+    return stored > 0;
+}
+
+// Miss of a hot-table point lookup in a detected loop: prefetch this id and
+// the predicted next ones
+static int batch_miss(pg_stmt_t *stmt, rc_loop_t *l, int table, int64_t id, pg_connection_t *conn) {
+    char key[RC_KEY_LEN];
+    snprintf(key, sizeof(key), "%lld", (long long)id);
+    if (!loop_should_batch(l, key, conn)) return 0;
+
+    char (*keys)[RC_KEY_LEN] = malloc(sizeof(*keys) * ROW_CACHE_BATCH_IDS);
+    if (!keys) return 0;
+    int n = loop_keys(stmt, l, key, keys);
+    int64_t ids[ROW_CACHE_BATCH_IDS];
+    int nids = 0;
+    for (int i = 0; i < n; i++) {
+        if (parse_id(keys[i], &ids[nids])) nids++;
+    }
+    free(keys);
+    if (nids < 2) return 0;
+    return prefetch_rows(table, ids, nids, conn);
+}
+
+// "SELECT <cols>, <key> FROM <table> [alias] WHERE <key> = ANY($1) LIMIT n"
+// for a key lookup (caller frees)
+static char* batch_sql(const char *sql, const rc_key_lookup_t *k) {
+    int cols_end = k->from;
+    while (cols_end > 0 && isspace((unsigned char)sql[cols_end - 1])) cols_end--;
+    size_t len = strlen(sql) + (size_t)k->key_len * 2 + 64;
+    char *out = malloc(len);
+    if (!out) return NULL;
+    snprintf(out, len, "%.*s, %.*s %.*sWHERE %.*s = ANY($1) LIMIT %d",
+             cols_end, sql, k->key_len, sql + k->key, k->where - k->from, sql + k->from,
+             k->key_len, sql + k->key, ROW_CACHE_BATCH_ROWS + 1);
+    return out;
+}
+
+// Array literal {"k1","k2",...} (caller frees)
+static char* key_array(char (*keys)[RC_KEY_LEN], int n) {
+    char *out = malloc((size_t)n * (RC_KEY_LEN * 2 + 3) + 3);
+    if (!out) return NULL;
+    char *o = out;
+    *o++ = '{';
+    for (int i = 0; i < n; i++) {
+        if (i) *o++ = ',';
+        *o++ = '"';
+        for (const char *c = keys[i]; *c; c++) {
+            if (*c == '"' || *c == '\\') *o++ = '\\';
+            *o++ = *c;
+        }
+        *o++ = '"';
+    }
+    *o++ = '}';
+    *o = '\0';
+    return out;
+}
+
+// Key types whose text form is canonical (a matching cell is equal to the
+// parameter): int2, int4, int8, text, varchar
+static int batch_key_type_ok(Oid type) {
+    return type == 21 || type == 23 || type == 20 || type == 25 || type == 1043;
+}
+
+// Run a generic key lookup's batch query and keep the result on l
+static void fetch_batch(pg_stmt_t *stmt, uint64_t sql_hash, rc_loop_t *l,
+                        char (*keys)[RC_KEY_LEN], int n, pg_connection_t *conn) {
+    rc_key_lookup_t k;
+    if (!analyze_key_lookup(stmt->pg_sql, &k)) return;
+    char *sql = batch_sql(stmt->pg_sql, &k);
+    char *array = key_array(keys, n);
+    if (!sql || !array) {
+        free(sql);
+        free(array);
+        return;
+    }
+    const char *params[1] = { array };
+
+    // Versions before the query: a write while it runs makes it stale
+    uint64_t version = pg_query_cache_table_version(k.table);
+    uint64_t schema = pg_query_cache_schema_version();
+    uint64_t gen = atomic_load(&all_gen);
+
+    // An error inside a transaction block would abort the application's
+    // transaction - only batch outside one
+    PGresult *res = NULL;
+    pthread_mutex_lock(&conn->mutex);
+    if (PQstatus(conn->conn) == CONNECTION_OK && !PQisBusy(conn->conn) &&
+        PQtransactionStatus(conn->conn) == PQTRANS_IDLE) {
+        res = PQexecParams(conn->conn, sql, 1, NULL, params, NULL, NULL, 0);
+    }
+    pthread_mutex_unlock(&conn->mutex);
+    free(array);
+
+    if (res && PQresultStatus(res) == PGRES_TUPLES_OK) {
+        int nfields = PQnfields(res);
+        if (nfields < 2 || !batch_key_type_ok(PQftype(res, nfields - 1)) ||
+            PQntuples(res) > ROW_CACHE_BATCH_ROWS) {
+            LOG_INFO("ROW_CACHE BATCH: not batching (key type %u, %d rows): %.100s",
+                     nfields ? PQftype(res, nfields - 1) : 0, PQntuples(res), stmt->pg_sql);
+            shape_unkey(sql_hash);
+        } else {
+            drop_batch(l);
+            l->batch = res;
+            l->batch_ms = get_time_ms();
+            snprintf(l->batch_table, sizeof(l->batch_table), "%s", k.table);
+            l->batch_version = version;
+            l->batch_schema = schema;
+            l->batch_all_gen = gen;
+            l->batch_limit1 = k.limit1;
+            res = NULL;
+            atomic_fetch_add(&total_batches, 1);
+            LOG_DEBUG("ROW_CACHE BATCH: %s.%s keys=%d rows=%d", k.table, k.column, n, PQntuples(l->batch));
+        }
+    } else if (res) {
+        // Syntax/type errors (e.g. a key type ANY() can't take) repeat every
+        // time; anything else may be transient
+        const char *state = PQresultErrorField(res, PG_DIAG_SQLSTATE);
+        if (state && (strncmp(state, "42", 2) == 0 || strncmp(state, "22", 2) == 0)) shape_unkey(sql_hash);
+        LOG_ERROR("ROW_CACHE BATCH failed (sqlstate=%s): %s", state ? state : "none",
+                  PQerrorMessage(conn->conn));
+    }
+    if (res) PQclear(res);
+    free(sql);
+}
+
+// Rows of l's batch for key, without the key column. NULL if there is no
+// current batch or no row matches.
+static PGresult* serve_batch(rc_loop_t *l, const char *key) {
+    if (!l->batch) return NULL;
+    if (get_time_ms() - l->batch_ms >= ROW_CACHE_LOOP_WINDOW_MS ||
+        pg_query_cache_table_version(l->batch_table) != l->batch_version ||
+        pg_query_cache_schema_version() != l->batch_schema ||
+        atomic_load(&all_gen) != l->batch_all_gen) {
+        drop_batch(l);
+        return NULL;
+    }
+
+    const PGresult *b = l->batch;
+    int ncols = PQnfields(b) - 1;
+    int nrows = PQntuples(b);
+    int r = 0;
+    while (r < nrows && (PQgetisnull(b, r, ncols) || strcmp(PQgetvalue(b, r, ncols), key) != 0)) r++;
+    if (r == nrows) return NULL;
+
+    PGresAttDesc *attrs = calloc((size_t)ncols, sizeof(PGresAttDesc));
+    PGresult *res = attrs ? PQmakeEmptyPGresult(NULL, PGRES_TUPLES_OK) : NULL;
+    for (int c = 0; c < ncols && res; c++) {
+        attrs[c].name = PQfname(b, c);
+        attrs[c].tableid = PQftable(b, c);
+        attrs[c].columnid = PQftablecol(b, c);
+        attrs[c].format = PQfformat(b, c);
+        attrs[c].typid = PQftype(b, c);
+        attrs[c].typlen = PQfsize(b, c);
+        attrs[c].atttypmod = PQfmod(b, c);
+    }
+    if (res && !PQsetResultAttrs(res, ncols, attrs)) {
+        PQclear(res);
+        res = NULL;
+    }
+    free(attrs);
+
+    int out = 0;
+    for (; res && r < nrows; r++) {
+        if (PQgetisnull(b, r, ncols) || strcmp(PQgetvalue(b, r, ncols), key) != 0) continue;
+        for (int c = 0; c < ncols; c++) {
+            int ok = PQgetisnull(b, r, c)
+                ? PQsetvalue(res, out, c, NULL, -1)
+                : PQsetvalue(res, out, c, PQgetvalue(b, r, c), PQgetlength(b, r, c));
+            if (!ok) {
+                PQclear(res);
+                res = NULL;
+                break;
+            }
+        }
+        out++;
+        if (l->batch_limit1) break;
+    }
+    return res;
+}
+
+// Key lookup on any table (not a hot-table point lookup): served from the
+// loop's batch, batching on a miss in a detected loop
+static PGresult* keyed_lookup(pg_stmt_t *stmt, uint64_t sql_hash, rc_loop_t *l, pg_connection_t *conn) {
+    const char *key = stmt->param_values[0];
+    if (!*key || strlen(key) >= RC_KEY_LEN) return NULL;
+    int64_t id;
+    if (parse_id(key, &id)) {
+        loop_note_id(l, id);
+    } else {
+        l->nrecent = 0;
+    }
+
+    PGresult *res = serve_batch(l, key);
+    if (!res && loop_should_batch(l, key, conn)) {
+        char (*keys)[RC_KEY_LEN] = malloc(sizeof(*keys) * ROW_CACHE_BATCH_IDS);
+        int n = keys ? loop_keys(stmt, l, key, keys) : 0;
+        if (n) {
+            register_thread();
+            fetch_batch(stmt, sql_hash, l, keys, n, conn);
+            res = serve_batch(l, key);
+        }
+        free(keys);
+    }
+    if (!res) {
+        atomic_fetch_add(&total_misses, 1);
+        return NULL;
+    }
+    uint64_t hits = atomic_fetch_add(&total_hits, 1) + 1;
+    if (hits % 100 == 1) {
+        LOG_DEBUG("ROW_CACHE BATCH HIT #%llu: %s key=%s", (unsigned long long)hits, l->batch_table, key);
+    }
+    return res;
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+PGresult* pg_row_cache_lookup(pg_stmt_t *stmt, pg_connection_t *conn) {
+    if (!stmt || !stmt->pg_sql) return NULL;
+    uint64_t sql_hash = stmt_sql_hash(stmt);
+    rc_loop_t *loop = loop_note_run(sql_hash, stmt->pg_sql);
+
+    if (stmt->param_count != 1 || !stmt->param_values[0] || stmt->param_types[0] == PG_OID_BYTEA) {
+        return NULL;
+    }
+    int keyed;
+    int table = shape_table(stmt->pg_sql, sql_hash, &keyed);
+    if (table < 0) return keyed ? keyed_lookup(stmt, sql_hash, loop, conn) : NULL;
+
+    int64_t id;
+    if (!parse_id(stmt->param_values[0], &id)) return NULL;
+
+    int known;
+    PGresult *res = serve_row(sql_hash, table, id, &known);
+    if (!known) return NULL;  // Shape not known yet - not counted as a miss
+
+    loop_note_id(loop, id);
+    if (!res && batch_miss(stmt, loop, table, id, conn)) {
+        res = serve_row(sql_hash, table, id, &known);
+    }
+    if (!res) {
+        atomic_fetch_add(&total_misses, 1);
+        return NULL;
+    }
+    uint64_t hits = atomic_fetch_add(&total_hits, 1) + 1;
+    pg_mem_hit(PG_MEM_ROW_CACHE);
+    if (hits % 100 == 1) {
+        LOG_DEBUG("ROW_CACHE HIT #%llu: %s id=%lld", (unsigned long long)hits,
+                  HOT_TABLES[table], (long long)id);
+    }
+    return res;
+}
+
+void pg_row_cache_begin_read(void) {
+    take_snapshot(&snapshot);
+}
+
+void pg_row_cache_note_result(pg_stmt_t *stmt) {
+    if (!stmt) return;
+    drop_finalized_parents();
+    for (int i = 0; i < ROW_CACHE_PARENTS; i++) {
+        if (parents.stmts[i] == stmt) return;
+    }
+    register_thread();
+    pg_stmt_ref(stmt);
+    pg_stmt_t *old = parents.stmts[parents.next];
+    parents.stmts[parents.next] = stmt;
+    parents.next = (parents.next + 1) % ROW_CACHE_PARENTS;
+    if (old) pg_stmt_unref(old);
+}
+
+void pg_row_cache_forget(pg_stmt_t *stmt) {
+    if (!stmt) return;
+    for (int i = 0; i < ROW_CACHE_PARENTS; i++) {
+        if (parents.stmts[i] == stmt) {
+            parents.stmts[i] = NULL;
+            pg_stmt_unref(stmt);
+        }
+    }
+}
+
+void pg_row_cache_store(pg_stmt_t *stmt, pg_connection_t *conn, const PGresult *result) {
+    if (!snapshot.valid) return;
+    snapshot.valid = 0;
+    if (!stmt || !stmt->pg_sql || !result || PQresultStatus(result) != PGRES_TUPLES_OK) return;
+    if (PQnfields(result) == 0 || PQftable(result, 0) == InvalidOid) return;
+
+    rc_meta_t *m = get_meta(conn);
+    if (!m || m->schema != snapshot.schema) return;
+
+    uint64_t sql_hash = stmt_sql_hash(stmt);
+    int shape = shape_table(stmt->pg_sql, sql_hash, NULL);
+    if (shape >= 0 && m->t[shape].oid) record_shape(sql_hash, shape, m, result);
+
+    int stored = store_full_rows(m, result, &snapshot);
+    if (stored) {
+        LOG_DEBUG("ROW_CACHE STORE: rows=%d sql=%.60s", stored, stmt->pg_sql);
+    }
+}
+
+void pg_row_cache_invalidate_write(const char *sql, pg_stmt_t *stmt) {
+    if (!sql) return;
+
+    // One statement only - anything else drops everything
+    const char *p = sql;
+    int in_quote = 0;
+    for (const char *s = sql; *s; s++) {
+        if (*s == '\'') in_quote = !in_quote;
+        if (*s == ';' && !in_quote && *rc_skip_ws(s + 1)) {
+            pg_row_cache_invalidate_all();
+            return;
+        }
+    }
+
+    char name[64];
+    int table;
+    if (rc_keyword(&p, "insert")) {
+        // A plain INSERT adds rows that can't be cached yet; an upsert may
+        // rewrite an existing one
+        if (!rc_keyword(&p, "into")) goto unparsed;
+        p = rc_skip_ws(p);
+        if (!rc_read_ident(&p, name, sizeof(name))) goto unparsed;
+        table = hot_table_index(name);
+        if (table >= 0 && safe_strcasestr(p, "on conflict")) invalidate_table_index(table);
+        return;
+    } else if (rc_keyword(&p, "update")) {
+        rc_keyword(&p, "only");
+    } else if (rc_keyword(&p, "delete")) {
+        if (!rc_keyword(&p, "from")) goto unparsed;
+    } else {
+        goto unparsed;
+    }
+
+    p = rc_skip_ws(p);
+    if (!rc_read_ident(&p, name, sizeof(name))) goto unparsed;
+    table = hot_table_index(name);
+    if (table < 0) return;
+
+    // Precise: ... WHERE [q.]id = <literal or $N> (single table, nothing else)
+    const char *where = find_where(p);
+    int param = 0;
+    int64_t id = 0;
+    if (where && !safe_strcasestr(p, " from ") && !safe_strcasestr(p, " using ") &&
+        parse_id_predicate(where, &param, &id)) {
+        if (param == 0 ||
+            (stmt && param <= stmt->param_count && stmt->param_values[param - 1] &&
+             stmt->param_types[param - 1] != PG_OID_BYTEA &&
+             parse_id(stmt->param_values[param - 1], &id))) {
+            remove_row(table, id);
+            return;
+        }
+    }
+    invalidate_table_index(table);
+    return;
+
+unparsed:
+    pg_row_cache_invalidate_all();
+}
+
+void pg_row_cache_invalidate_table(const char *table) {
+    if (!table) return;
+    char name[64];
+    const char *p = table;
+    if (!rc_read_ident(&p, name, sizeof(name))) return;
+    invalidate_table_index(hot_table_index(name));
+}
+
+void pg_row_cache_invalidate_all(void) {
+    atomic_fetch_add(&all_gen, 1);
+}
+
+void pg_row_cache_stats(uint64_t *hits, uint64_t *misses, uint64_t *rows_stored, uint64_t *batches) {
+    if (hits) *hits = atomic_load(&total_hits);
+    if (misses) *misses = atomic_load(&total_misses);
+    if (rows_stored) *rows_stored = atomic_load(&total_stored);
+    if (batches) *batches = atomic_load(&total_batches);
+}
+
+// Called in child after fork(): locks may have been held by parent threads
+void pg_row_cache_reset_after_fork(void) {
+    pthread_rwlock_init(&slots_rwlock, NULL);
+    pthread_rwlock_init(&shapes_rwlock, NULL);
+    pthread_mutex_init(&meta_mutex, NULL);
+    snapshot.valid = 0;
+}
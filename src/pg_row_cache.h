@@ -0,0 +1,94 @@
+/*
+ * PostgreSQL Shim - Primary Key Row Cache
+ *
+ * Plex re-reads the same rows of a few hot tables by id all the time
+ * (metadata_items for every hub entry, media_items/media_parts for every
+ * play decision, tags for every filter chip). The query result cache only
+ * helps when the exact same SQL + parameters repeat; this cache keeps the
+ * rows themselves so any full-row read can populate them and any
+ *     SELECT <columns> FROM <hot table> WHERE id = $1
+ * is answered from memory, whatever columns it selects.
+ *
+ * Design:
+ * - Rows are only stored from results whose column provenance
+ *   (PQftable/PQftablecol) shows every live column of one hot table, so a
+ *   cached row is always a complete copy
+ * - Fixed-size, direct-mapped slot array keyed by (table, id), one rwlock
+ * - Point lookups are answered with a synthesized PGresult carrying the
+ *   original statement's column attributes, so the column_* paths are
+ *   unchanged
+ * - Freshness: rows are stored only if the table's version
+ *   (pg_query_cache_table_version) didn't change while the query ran.
+ *   Local UPDATE/DELETE ... WHERE id = X drop just that row; any other
+ *   write to a hot table, writes from other processes and DDL drop all of
+ *   the table's rows (generation bump). Plain INSERTs can't change a
+ *   cached row.
+ * - Rows also expire like query cache entries: after ROW_CACHE_TTL_MS when
+ *   no invalidation listener is running (other processes' writes are
+ *   invisible), ROW_CACHE_LISTEN_TTL_MS as a backstop when one is
+ * - Loop detection: every read not answered by the query cache passes one
+ *   per-thread loop detector, which logs reads repeated in tight loops
+ * - N+1 batching: when the same single-key lookup keeps missing on a thread
+ *   (a child query per row of a parent result), one key = ANY($1) query
+ *   fetches the rows the loop will ask for next - into the row cache for
+ *   hot-table point lookups, as a short-lived per-thread result split by
+ *   key for lookups on any other table or column (see pg_row_cache.c)
+ */
+
+#ifndef PG_ROW_CACHE_H
+#define PG_ROW_CACHE_H
+
+#include <libpq-fe.h>
+#include "pg_types.h"  // For pg_stmt_t, pg_connection_t
+
+#define ROW_CACHE_SLOTS 8192                 // Cached rows (power of 2, direct-mapped)
+#define ROW_CACHE_SHAPES 512                 // Per-SQL point-lookup analysis (power of 2)
+#define ROW_CACHE_MAX_ROW_BYTES (16 * 1024)  // Larger rows aren't cached
+#define ROW_CACHE_MAX_STORE_ROWS 256         // Rows taken from one result (big scans would flush the cache)
+#define ROW_CACHE_LOOP_MISSES 4              // Misses of one lookup within the window before batching
+#define ROW_CACHE_LOOP_WINDOW_MS 1000
+#define ROW_CACHE_LOOP_LOG_RUNS 100          // Runs of one read within the window logged as a loop
+#define ROW_CACHE_BATCH_IDS 64               // Keys fetched by one batch query
+#define ROW_CACHE_BATCH_ROWS 1024            // Larger generic batch results aren't used
+#define ROW_CACHE_PARENTS 4                  // Recent multi-row results searched for upcoming ids
+#define ROW_CACHE_TTL_MS 10000               // Row lifetime without a listener (writes by other processes)
+#define ROW_CACHE_LISTEN_TTL_MS 60000        // Row lifetime while cross-process invalidation is live
+
+// Call once per execution of a read the query cache didn't answer (loop
+// detection). Answers a point lookup from cached rows, or a key lookup from
+// the thread's batch result. Returns a PGresult with at least one row
+// (caller owns it, PQclear as usual) or NULL if the statement isn't a key
+// lookup or its rows aren't cached. conn (optional, must not be locked by
+// the caller) runs the batch query when a lookup loop is detected.
+PGresult* pg_row_cache_lookup(pg_stmt_t *stmt, pg_connection_t *conn);
+
+// Snapshot hot table versions BEFORE a read executes (consumed by store())
+void pg_row_cache_begin_read(void);
+
+// Cache complete hot-table rows from a read result. Loads table metadata on
+// first use through conn (must not be locked by the caller).
+void pg_row_cache_store(pg_stmt_t *stmt, pg_connection_t *conn, const PGresult *result);
+
+// Remember a multi-row read result on this thread - a loop of point lookups
+// over its rows gets its upcoming ids from it
+void pg_row_cache_note_result(pg_stmt_t *stmt);
+
+// Stop using stmt as a parent on this thread (reset/finalize; drops the ref).
+// Must not hold stmt->lock.
+void pg_row_cache_forget(pg_stmt_t *stmt);
+
+// Write invalidation - call AFTER pg_query_cache_invalidate_write() for the
+// same write. stmt (optional) supplies $N parameter values.
+void pg_row_cache_invalidate_write(const char *sql, pg_stmt_t *stmt);
+
+// Drop all rows of a table / of every table (other processes' writes)
+void pg_row_cache_invalidate_table(const char *table);
+void pg_row_cache_invalidate_all(void);
+
+// Get stats (for logging)
+void pg_row_cache_stats(uint64_t *hits, uint64_t *misses, uint64_t *rows_stored, uint64_t *batches);
+
+// Fork safety - reinitialize locks in the child after fork()
+void pg_row_cache_reset_after_fork(void);
+
+#endif // PG_ROW_CACHE_H
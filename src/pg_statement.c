@@ -7,35 +7,110 @@
 #include "pg_logging.h"
 #include "pg_config.h"
 #include "pg_query_cache.h"
+#include "pg_mem.h"
 #include "sql_translator.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <strings.h>
 #include <ctype.h>
+#include <sched.h>
 
 // ============================================================================
 // Static State
 // ============================================================================
 
-// Statement registry with hash table for O(1) lookup
+// Statement registry: sqlite3_stmt* -> pg_stmt_t*, looked up on every
+// bind/step/column call from 150+ threads.
+//
+// STMT_SHARDS independent chained hash tables, each on its own cache line.
+// Writers (prepare/finalize) serialize per shard on a mutex and bump the
+// shard's sequence number around each change; readers take no lock - they
+// walk the chain and retry if the sequence moved (seqlock). Entries come
+// from per-shard chunks and go back on the shard's free list on unregister.
+// Chunks are never freed, so a reader racing a recycle only ever reads a
+// live entry and retries; the registry has no size limit.
 typedef struct stmt_entry {
-    sqlite3_stmt *sqlite_stmt;
-    pg_stmt_t *pg_stmt;
-    struct stmt_entry *next;  // For hash collision chaining
+    _Atomic(sqlite3_stmt *) sqlite_stmt;
+    _Atomic(pg_stmt_t *) pg_stmt;
+    _Atomic(struct stmt_entry *) next;  // Bucket chain, or free list when unused
 } stmt_entry_t;
 
-#define HASH_BUCKETS 256  // Power of 2 for fast modulo
+#define STMT_SHARD_BITS 6
+#define STMT_SHARDS (1 << STMT_SHARD_BITS)             // 64 shards
+#define STMT_SHARD_BUCKET_BITS 6
+#define STMT_SHARD_BUCKETS (1 << STMT_SHARD_BUCKET_BITS) // 4096 buckets in total
+#define STMT_ENTRY_CHUNK 64                             // Entries allocated at a time
+
+typedef struct {
+    _Alignas(64) atomic_uint seq;    // Odd while a writer is mid-change
+    pthread_mutex_t write_lock;
+    _Atomic(stmt_entry_t *) buckets[STMT_SHARD_BUCKETS];
+    stmt_entry_t *free_list;         // write_lock
+    int count;                       // Registered entries (write_lock)
+    int allocated;                   // Entries ever allocated (write_lock)
+} stmt_shard_t;
+
+static stmt_shard_t stmt_shards[STMT_SHARDS];
+static pthread_once_t stmt_shards_once = PTHREAD_ONCE_INIT;
+
+static void init_stmt_shards(void) {
+    for (int i = 0; i < STMT_SHARDS; i++) {
+        pthread_mutex_init(&stmt_shards[i].write_lock, NULL);
+    }
+}
+
+// Pointer mix: statements are heap addresses with equal low bits, so take
+// shard and bucket from the top of a multiplicative hash
+static inline unsigned int hash_ptr(const void *ptr) {
+    uint64_t h = ((uint64_t)(uintptr_t)ptr >> 4) * 0x9E3779B97F4A7C15ULL;
+    return (unsigned int)(h >> (64 - STMT_SHARD_BITS - STMT_SHARD_BUCKET_BITS));
+}
 
-static stmt_entry_t *stmt_hash[HASH_BUCKETS];  // Hash table buckets
-static stmt_entry_t stmt_pool[MAX_STATEMENTS]; // Pre-allocated entries
-static int stmt_pool_next = 0;
-static pthread_rwlock_t stmt_map_rwlock = PTHREAD_RWLOCK_INITIALIZER;
+static inline stmt_shard_t* shard_of(unsigned int h) {
+    return &stmt_shards[h >> STMT_SHARD_BUCKET_BITS];
+}
+
+static inline unsigned int bucket_of(unsigned int h) {
+    return h & (STMT_SHARD_BUCKETS - 1);
+}
+
+static inline void shard_write_begin(stmt_shard_t *sh) {
+    pthread_mutex_lock(&sh->write_lock);
+    unsigned int seq = atomic_load_explicit(&sh->seq, memory_order_relaxed);
+    atomic_store_explicit(&sh->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+static inline void shard_write_end(stmt_shard_t *sh) {
+    unsigned int seq = atomic_load_explicit(&sh->seq, memory_order_relaxed);
+    atomic_store_explicit(&sh->seq, seq + 1, memory_order_release);
+    pthread_mutex_unlock(&sh->write_lock);
+}
+
+static stmt_entry_t* shard_alloc_entry(stmt_shard_t *sh) {
+    if (!sh->free_list) {
+        stmt_entry_t *chunk = calloc(STMT_ENTRY_CHUNK, sizeof(stmt_entry_t));
+        if (!chunk) return NULL;
+        for (int i = 0; i < STMT_ENTRY_CHUNK; i++) {
+            atomic_store_explicit(&chunk[i].next, i + 1 < STMT_ENTRY_CHUNK ? &chunk[i + 1] : NULL,
+                                  memory_order_relaxed);
+        }
+        sh->free_list = chunk;
+        sh->allocated += STMT_ENTRY_CHUNK;
+    }
+    stmt_entry_t *e = sh->free_list;
+    sh->free_list = atomic_load_explicit(&e->next, memory_order_relaxed);
+    return e;
+}
 
-// Simple hash function for pointers
-static inline unsigned int hash_ptr(void *ptr) {
-    uintptr_t p = (uintptr_t)ptr;
-    return (unsigned int)((p >> 4) ^ (p >> 12)) & (HASH_BUCKETS - 1);
+// Free-list push happens after the unlink, inside the same write section,
+// so readers that saw the entry retry on the sequence check
+static void shard_free_entry(stmt_shard_t *sh, stmt_entry_t *e) {
+    atomic_store_explicit(&e->sqlite_stmt, NULL, memory_order_relaxed);
+    atomic_store_explicit(&e->pg_stmt, NULL, memory_order_relaxed);
+    atomic_store_explicit(&e->next, sh->free_list, memory_order_relaxed);
+    sh->free_list = e;
 }
 
 // TLS key for cached statements
@@ -43,10 +118,31 @@ static pthread_key_t cached_stmts_key;
 static pthread_once_t cached_stmts_key_once = PTHREAD_ONCE_INIT;
 static volatile int cached_stmts_key_valid = 0;
 
-// Fake sqlite3_value pool (lock-free with atomic index)
-#define MAX_PG_VALUES 4096
-static pg_value_t pg_values[MAX_PG_VALUES];
-static atomic_int pg_value_idx = 0;
+// Fake sqlite3_value arenas. Every thread hands out values from its own ring
+// of chunks - no shared counter, no lock - and a value is only reused after
+// its statement released it (next step/reset/finalize), so a busy process
+// can't wrap onto a value still in use. Chunks are carved from one static
+// pool, which keeps "is this ours" a range check, and are never freed: a
+// statement may release a value after the thread that handed it out exited,
+// when that thread's chunks have gone to the orphan list for the next thread.
+#define PG_VALUE_CHUNK 64                      // Values per chunk
+#define PG_VALUE_CHUNKS 1024                   // 64K values, ~2.5MB (untouched pages stay virtual)
+#define PG_VALUE_NO_CHUNK -1
+static pg_value_t pg_values[PG_VALUE_CHUNKS * PG_VALUE_CHUNK];
+static int pg_value_chunk_next[PG_VALUE_CHUNKS];  // Ring of a thread's chunks
+static atomic_int pg_value_chunks_used = 0;
+static int pg_value_orphans = PG_VALUE_NO_CHUNK;  // Rings of exited threads, under the mutex
+static pthread_mutex_t pg_value_orphan_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t pg_value_key;
+static pthread_once_t pg_value_key_once = PTHREAD_ONCE_INIT;
+
+typedef struct {
+    int chunk;    // Current chunk, PG_VALUE_NO_CHUNK until the first value
+    int slot;     // Next slot to try in it
+    int chunks;   // Chunks in this thread's ring
+} pg_value_arena_t;
+
+static __thread pg_value_arena_t value_arena = { PG_VALUE_NO_CHUNK, 0, 0 };
 
 static volatile int statement_initialized = 0;
 static pthread_once_t statement_init_once = PTHREAD_ONCE_INIT;
@@ -58,13 +154,15 @@ static pthread_once_t statement_init_once = PTHREAD_ONCE_INIT;
 static void free_thread_cached_stmts(void *ptr) {
     thread_cached_stmts_t *tcs = (thread_cached_stmts_t *)ptr;
     if (tcs) {
-        for (int i = 0; i < tcs->count; i++) {
-            pg_stmt_t *pg_stmt = tcs->entries[i].pg_stmt;
-            if (pg_stmt) {
+        for (int i = 0; i < tcs->cap; i++) {
+            sqlite3_stmt *key = tcs->slots[i].sqlite_stmt;
+            pg_stmt_t *pg_stmt = tcs->slots[i].pg_stmt;
+            if (key != PG_TLS_STMT_EMPTY && key != PG_TLS_STMT_TOMBSTONE && pg_stmt) {
                 // CRITICAL FIX: Use unref to handle reference counting properly
                 pg_stmt_unref(pg_stmt);
             }
         }
+        free(tcs->slots);
         free(tcs);
     }
 }
@@ -102,9 +200,7 @@ static thread_cached_stmts_t* get_thread_cached_stmts(void) {
 // ============================================================================
 
 static void do_statement_init(void) {
-    memset(stmt_hash, 0, sizeof(stmt_hash));
-    memset(stmt_pool, 0, sizeof(stmt_pool));
-    stmt_pool_next = 0;
+    pthread_once(&stmt_shards_once, init_stmt_shards);
     statement_initialized = 1;
     LOG_DEBUG("pg_statement initialized with hash table");
 }
@@ -114,18 +210,40 @@ void pg_statement_init(void) {
 }
 
 void pg_statement_cleanup(void) {
-    pthread_rwlock_wrlock(&stmt_map_rwlock);
-    for (int i = 0; i < stmt_pool_next; i++) {
-        if (stmt_pool[i].pg_stmt) {
-            // CRITICAL FIX: Use unref for consistent reference counting
-            pg_stmt_unref(stmt_pool[i].pg_stmt);
-            stmt_pool[i].pg_stmt = NULL;
+    pthread_once(&stmt_shards_once, init_stmt_shards);
+    for (int s = 0; s < STMT_SHARDS; s++) {
+        stmt_shard_t *sh = &stmt_shards[s];
+        stmt_entry_t *detached[STMT_SHARD_BUCKETS];
+
+        // Unlink everything first, unref outside the write section (freeing
+        // a statement must not run while readers of this shard spin)
+        shard_write_begin(sh);
+        for (int b = 0; b < STMT_SHARD_BUCKETS; b++) {
+            detached[b] = atomic_load_explicit(&sh->buckets[b], memory_order_relaxed);
+            atomic_store_explicit(&sh->buckets[b], NULL, memory_order_relaxed);
+        }
+        sh->count = 0;
+        shard_write_end(sh);
+
+        for (int b = 0; b < STMT_SHARD_BUCKETS; b++) {
+            for (stmt_entry_t *e = detached[b]; e; e = atomic_load_explicit(&e->next, memory_order_relaxed)) {
+                pg_stmt_t *pg_stmt = atomic_load_explicit(&e->pg_stmt, memory_order_relaxed);
+                // CRITICAL FIX: Use unref for consistent reference counting
+                if (pg_stmt) pg_stmt_unref(pg_stmt);
+            }
+        }
+
+        shard_write_begin(sh);
+        for (int b = 0; b < STMT_SHARD_BUCKETS; b++) {
+            stmt_entry_t *e = detached[b];
+            while (e) {
+                stmt_entry_t *next = atomic_load_explicit(&e->next, memory_order_relaxed);
+                shard_free_entry(sh, e);
+                e = next;
+            }
         }
+        shard_write_end(sh);
     }
-    memset(stmt_hash, 0, sizeof(stmt_hash));
-    memset(stmt_pool, 0, sizeof(stmt_pool));
-    stmt_pool_next = 0;
-    pthread_rwlock_unlock(&stmt_map_rwlock);
     statement_initialized = 0;
 }
 
@@ -135,83 +253,87 @@ void pg_statement_cleanup(void) {
 
 void pg_register_stmt(sqlite3_stmt *sqlite_stmt, pg_stmt_t *pg_stmt) {
     if (!sqlite_stmt || !pg_stmt) return;
+    pthread_once(&stmt_shards_once, init_stmt_shards);
 
-    pthread_rwlock_wrlock(&stmt_map_rwlock);
+    unsigned int h = hash_ptr(sqlite_stmt);
+    stmt_shard_t *sh = shard_of(h);
+    _Atomic(stmt_entry_t *) *bucket = &sh->buckets[bucket_of(h)];
 
-    stmt_entry_t *entry = NULL;
-
-    // First, try to find a freed slot (sqlite_stmt == NULL)
-    for (int i = 0; i < stmt_pool_next; i++) {
-        if (stmt_pool[i].sqlite_stmt == NULL) {
-            entry = &stmt_pool[i];
-            break;
-        }
-    }
-
-    // If no freed slot, get a new one from the pool
+    shard_write_begin(sh);
+    stmt_entry_t *entry = shard_alloc_entry(sh);
     if (!entry) {
-        if (stmt_pool_next >= MAX_STATEMENTS) {
-            pthread_rwlock_unlock(&stmt_map_rwlock);
-            LOG_ERROR("Statement pool full! MAX_STATEMENTS=%d", MAX_STATEMENTS);
-            return;
-        }
-        entry = &stmt_pool[stmt_pool_next++];
+        shard_write_end(sh);
+        LOG_ERROR("pg_register_stmt: out of memory for stmt=%p", (void*)sqlite_stmt);
+        return;
     }
-
-    entry->sqlite_stmt = sqlite_stmt;
-    entry->pg_stmt = pg_stmt;
-
-    // Insert into hash bucket
-    unsigned int bucket = hash_ptr(sqlite_stmt);
-    entry->next = stmt_hash[bucket];
-    stmt_hash[bucket] = entry;
-
-    pthread_rwlock_unlock(&stmt_map_rwlock);
+    atomic_store_explicit(&entry->sqlite_stmt, sqlite_stmt, memory_order_relaxed);
+    atomic_store_explicit(&entry->pg_stmt, pg_stmt, memory_order_relaxed);
+    atomic_store_explicit(&entry->next, atomic_load_explicit(bucket, memory_order_relaxed),
+                          memory_order_relaxed);
+    atomic_store_explicit(bucket, entry, memory_order_relaxed);
+    sh->count++;
+    shard_write_end(sh);
 }
 
 void pg_unregister_stmt(sqlite3_stmt *sqlite_stmt) {
     if (!sqlite_stmt) return;
+    pthread_once(&stmt_shards_once, init_stmt_shards);
 
-    pthread_rwlock_wrlock(&stmt_map_rwlock);
-
-    unsigned int bucket = hash_ptr(sqlite_stmt);
-    stmt_entry_t **prev = &stmt_hash[bucket];
-    stmt_entry_t *entry = stmt_hash[bucket];
+    unsigned int h = hash_ptr(sqlite_stmt);
+    stmt_shard_t *sh = shard_of(h);
+    _Atomic(stmt_entry_t *) *prev = &sh->buckets[bucket_of(h)];
 
+    shard_write_begin(sh);
+    stmt_entry_t *entry = atomic_load_explicit(prev, memory_order_relaxed);
     while (entry) {
-        if (entry->sqlite_stmt == sqlite_stmt) {
-            // Remove from hash chain (mark as deleted, don't actually remove from pool)
-            *prev = entry->next;
-            entry->sqlite_stmt = NULL;
-            entry->pg_stmt = NULL;
+        stmt_entry_t *next = atomic_load_explicit(&entry->next, memory_order_relaxed);
+        if (atomic_load_explicit(&entry->sqlite_stmt, memory_order_relaxed) == sqlite_stmt) {
+            atomic_store_explicit(prev, next, memory_order_relaxed);
+            shard_free_entry(sh, entry);
+            sh->count--;
             break;
         }
         prev = &entry->next;
-        entry = entry->next;
+        entry = next;
     }
-
-    pthread_rwlock_unlock(&stmt_map_rwlock);
+    shard_write_end(sh);
 }
 
 pg_stmt_t* pg_find_stmt(sqlite3_stmt *stmt) {
     if (!stmt) return NULL;
 
-    pthread_rwlock_rdlock(&stmt_map_rwlock);  // Read lock - multiple readers allowed
+    unsigned int h = hash_ptr(stmt);
+    stmt_shard_t *sh = shard_of(h);
+    _Atomic(stmt_entry_t *) *bucket = &sh->buckets[bucket_of(h)];
 
-    unsigned int bucket = hash_ptr(stmt);
-    stmt_entry_t *entry = stmt_hash[bucket];
+    for (int spins = 0;; spins++) {
+        unsigned int seq = atomic_load_explicit(&sh->seq, memory_order_acquire);
+        if (seq & 1) {
+            // Writer mid-change - a handful of stores, unless it got preempted
+            if (spins >= 64) sched_yield();
+            continue;
+        }
 
-    while (entry) {
-        if (entry->sqlite_stmt == stmt) {
-            pg_stmt_t *result = entry->pg_stmt;
-            pthread_rwlock_unlock(&stmt_map_rwlock);
-            return result;
+        pg_stmt_t *result = NULL;
+        int torn = 0;
+        stmt_entry_t *entry = atomic_load_explicit(bucket, memory_order_relaxed);
+        while (entry) {
+            if (atomic_load_explicit(&entry->sqlite_stmt, memory_order_relaxed) == stmt) {
+                result = atomic_load_explicit(&entry->pg_stmt, memory_order_relaxed);
+                break;
+            }
+            entry = atomic_load_explicit(&entry->next, memory_order_relaxed);
+            // A recycled entry can send us down the wrong chain (even round
+            // in a loop) - give up as soon as a writer has been through
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&sh->seq, memory_order_relaxed) != seq) {
+                torn = 1;
+                break;
+            }
         }
-        entry = entry->next;
+        atomic_thread_fence(memory_order_acquire);
+        if (!torn && atomic_load_explicit(&sh->seq, memory_order_relaxed) == seq) return result;
     }
-
-    pthread_rwlock_unlock(&stmt_map_rwlock);
-    return NULL;
 }
 
 pg_stmt_t* pg_find_any_stmt(sqlite3_stmt *stmt) {
@@ -228,17 +350,26 @@ pg_stmt_t* pg_find_any_stmt(sqlite3_stmt *stmt) {
 
 int pg_is_our_stmt(void *ptr) {
     if (!ptr) return 0;
-
-    // Note: This still needs O(n) scan since we're searching by pg_stmt, not sqlite_stmt
-    // But it's called much less frequently than pg_find_stmt
-    pthread_rwlock_rdlock(&stmt_map_rwlock);  // Read lock
-    for (int i = 0; i < stmt_pool_next; i++) {
-        if (stmt_pool[i].pg_stmt == ptr) {
-            pthread_rwlock_unlock(&stmt_map_rwlock);
-            return 1;
+    pthread_once(&stmt_shards_once, init_stmt_shards);
+
+    // Searching by pg_stmt, not sqlite_stmt - O(n) over every shard, but
+    // called much less frequently than pg_find_stmt
+    for (int s = 0; s < STMT_SHARDS; s++) {
+        stmt_shard_t *sh = &stmt_shards[s];
+        int found = 0;
+        pthread_mutex_lock(&sh->write_lock);
+        for (int b = 0; b < STMT_SHARD_BUCKETS && !found; b++) {
+            for (stmt_entry_t *e = atomic_load_explicit(&sh->buckets[b], memory_order_relaxed); e;
+                 e = atomic_load_explicit(&e->next, memory_order_relaxed)) {
+                if (atomic_load_explicit(&e->pg_stmt, memory_order_relaxed) == ptr) {
+                    found = 1;
+                    break;
+                }
+            }
         }
+        pthread_mutex_unlock(&sh->write_lock);
+        if (found) return 1;
     }
-    pthread_rwlock_unlock(&stmt_map_rwlock);
     return 0;
 }
 
@@ -246,21 +377,135 @@ int pg_is_our_stmt(void *ptr) {
 // TLS Cached Statement Management
 // ============================================================================
 
+// Home slot: top bits of the same multiplicative mix as hash_ptr
+static inline int tls_slot_of(const sqlite3_stmt *stmt, int cap) {
+    uint64_t h = ((uint64_t)(uintptr_t)stmt >> 4) * 0x9E3779B97F4A7C15ULL;
+    return (int)(h >> 32) & (cap - 1);
+}
+
+// Slot holding sqlite_stmt, or -1
+static int tls_find_slot(const thread_cached_stmts_t *tcs, sqlite3_stmt *sqlite_stmt) {
+    if (tcs->count == 0 || !sqlite_stmt) return -1;
+    int mask = tcs->cap - 1;
+    for (int i = tls_slot_of(sqlite_stmt, tcs->cap); ; i = (i + 1) & mask) {
+        sqlite3_stmt *key = tcs->slots[i].sqlite_stmt;
+        if (key == sqlite_stmt) return i;
+        if (key == PG_TLS_STMT_EMPTY) return -1;  // Half load at most - always reached
+    }
+}
+
+// Rehash into cap slots, dropping tombstones. Returns 0 on allocation failure
+// (table unchanged).
+static int tls_rehash(thread_cached_stmts_t *tcs, int cap) {
+    cached_stmt_entry_t *slots = calloc((size_t)cap, sizeof(cached_stmt_entry_t));
+    if (!slots) return 0;
+    for (int i = 0; i < tcs->cap; i++) {
+        sqlite3_stmt *key = tcs->slots[i].sqlite_stmt;
+        if (key == PG_TLS_STMT_EMPTY || key == PG_TLS_STMT_TOMBSTONE) continue;
+        int j = tls_slot_of(key, cap);
+        while (slots[j].sqlite_stmt != PG_TLS_STMT_EMPTY) j = (j + 1) & (cap - 1);
+        slots[j] = tcs->slots[i];
+    }
+    free(tcs->slots);
+    tcs->slots = slots;
+    tcs->cap = cap;
+    tcs->used = tcs->count;
+    return 1;
+}
+
+// Remove the entry in slot i, returning its pg_stmt (not unreferenced)
+static pg_stmt_t* tls_remove_slot(thread_cached_stmts_t *tcs, int i) {
+    pg_stmt_t *old = tcs->slots[i].pg_stmt;
+    if (tcs->last_stmt == tcs->slots[i].sqlite_stmt) {
+        tcs->last_stmt = NULL;
+        tcs->last_pg_stmt = NULL;
+    }
+    // A following empty slot ends every probe chain through i - no tombstone needed
+    int next = (i + 1) & (tcs->cap - 1);
+    if (tcs->slots[next].sqlite_stmt == PG_TLS_STMT_EMPTY) {
+        tcs->slots[i].sqlite_stmt = PG_TLS_STMT_EMPTY;
+        tcs->used--;
+    } else {
+        tcs->slots[i].sqlite_stmt = PG_TLS_STMT_TOMBSTONE;
+    }
+    tcs->slots[i].pg_stmt = NULL;
+    tcs->count--;
+    return old;
+}
+
+// Remove the entry in slot i and drop the table's references. A TLS-only
+// statement (is_cached) has no other owner, so its creation ref goes too -
+// the same two unrefs finalize does.
+static void tls_drop_slot(thread_cached_stmts_t *tcs, int i) {
+    pg_stmt_t *old = tls_remove_slot(tcs, i);
+    if (!old) return;
+    int owned = old->is_cached;
+    pg_stmt_unref(old);
+    if (owned) pg_stmt_unref(old);
+}
+
+// Nothing to lose by forgetting it: no rows being walked, no step running.
+// A finished write also needs to have gone a whole sweep without a lookup,
+// so an immediate re-step is still caught by write_executed.
+static int tls_entry_idle(const thread_cached_stmts_t *tcs, const cached_stmt_entry_t *e) {
+    pg_stmt_t *p = e->pg_stmt;
+    if (pg_bias_trylock(&p->lock) != 0) return 0;  // In use on some thread
+    int idle = !p->result && !p->cached_result && !atomic_load(&p->in_step) &&
+               (!p->write_executed || e->seen != tcs->sweeps);
+    pg_bias_unlock(&p->lock);
+    return idle;
+}
+
+// Drop entries finalized elsewhere and idle ones. Their statements may
+// have been finalized on a thread that couldn't see this table; if not,
+// the next step recreates the entry.
+static void tls_sweep(thread_cached_stmts_t *tcs) {
+    int before = tcs->count;
+    for (int i = 0; i < tcs->cap; i++) {
+        sqlite3_stmt *key = tcs->slots[i].sqlite_stmt;
+        if (key == PG_TLS_STMT_EMPTY || key == PG_TLS_STMT_TOMBSTONE || key == tcs->last_stmt) continue;
+        pg_stmt_t *p = tcs->slots[i].pg_stmt;
+        if (!p || atomic_load(&p->finalized) || tls_entry_idle(tcs, &tcs->slots[i])) {
+            tls_drop_slot(tcs, i);
+        }
+    }
+    tcs->sweeps++;
+    // At least double the survivors before the next sweep - amortized O(1)
+    tcs->sweep_at = tcs->count * 2 > PG_TLS_STMT_SWEEP_AT ? tcs->count * 2 : PG_TLS_STMT_SWEEP_AT;
+    LOG_DEBUG("TLS_STMT_CACHE: sweep dropped %d of %d entries", before - tcs->count, before);
+}
+
 void pg_register_cached_stmt(sqlite3_stmt *sqlite_stmt, pg_stmt_t *pg_stmt) {
     thread_cached_stmts_t *tcs = get_thread_cached_stmts();
     if (!tcs) return;
 
     // Check if already registered - replace
-    for (int i = 0; i < tcs->count; i++) {
-        if (tcs->entries[i].sqlite_stmt == sqlite_stmt) {
-            pg_stmt_t *old = tcs->entries[i].pg_stmt;
-            if (old && old != pg_stmt) {
-                // CRITICAL FIX: Use unref instead of free for proper refcounting
-                pg_stmt_unref(old);
-            }
-            // CRITICAL FIX: Increment ref count when caching
-            pg_stmt_ref(pg_stmt);
-            tcs->entries[i].pg_stmt = pg_stmt;
+    int i = tls_find_slot(tcs, sqlite_stmt);
+    if (i >= 0) {
+        pg_stmt_t *old = tcs->slots[i].pg_stmt;
+        if (old && old != pg_stmt) {
+            // CRITICAL FIX: Use unref instead of free for proper refcounting
+            pg_stmt_unref(old);
+        }
+        // CRITICAL FIX: Increment ref count when caching
+        pg_stmt_ref(pg_stmt);
+        tcs->slots[i].pg_stmt = pg_stmt;
+        tcs->slots[i].seen = tcs->sweeps;
+        if (tcs->last_stmt == sqlite_stmt) tcs->last_pg_stmt = pg_stmt;
+        return;
+    }
+
+    if (tcs->count >= (tcs->sweep_at ? tcs->sweep_at : PG_TLS_STMT_SWEEP_AT)) tls_sweep(tcs);
+
+    // Keep load (tombstones included) at or under half; grow only if live
+    // entries need it, otherwise rehash in place to clear tombstones
+    if (!tcs->slots || (tcs->used + 1) * 2 > tcs->cap) {
+        int cap = tcs->cap ? tcs->cap : PG_TLS_STMT_INITIAL_CAP;
+        while ((tcs->count + 1) * 2 > cap) cap *= 2;
+        if (!tls_rehash(tcs, cap)) {
+            // Nothing registered - callers still have the global registry
+            LOG_ERROR("TLS_STMT_CACHE: out of memory growing to %d slots, %p not cached",
+                      cap, (void*)sqlite_stmt);
             return;
         }
     }
@@ -268,58 +513,51 @@ void pg_register_cached_stmt(sqlite3_stmt *sqlite_stmt, pg_stmt_t *pg_stmt) {
     // CRITICAL FIX: Increment ref count when caching new entry
     pg_stmt_ref(pg_stmt);
 
-    // Add new entry
-    if (tcs->count < MAX_CACHED_STMTS_PER_THREAD) {
-        tcs->entries[tcs->count].sqlite_stmt = sqlite_stmt;
-        tcs->entries[tcs->count].pg_stmt = pg_stmt;
-        tcs->count++;
-    } else {
-        // Evict oldest entry
-        pg_stmt_t *old = tcs->entries[0].pg_stmt;
-        // CRITICAL FIX: Use unref instead of free for proper refcounting
-        if (old) pg_stmt_unref(old);
-
-        memmove(&tcs->entries[0], &tcs->entries[1],
-                (MAX_CACHED_STMTS_PER_THREAD - 1) * sizeof(cached_stmt_entry_t));
-        tcs->entries[MAX_CACHED_STMTS_PER_THREAD - 1].sqlite_stmt = sqlite_stmt;
-        tcs->entries[MAX_CACHED_STMTS_PER_THREAD - 1].pg_stmt = pg_stmt;
+    int mask = tcs->cap - 1;
+    for (i = tls_slot_of(sqlite_stmt, tcs->cap); ; i = (i + 1) & mask) {
+        sqlite3_stmt *key = tcs->slots[i].sqlite_stmt;
+        if (key == PG_TLS_STMT_EMPTY || key == PG_TLS_STMT_TOMBSTONE) break;
     }
+    if (tcs->slots[i].sqlite_stmt == PG_TLS_STMT_EMPTY) tcs->used++;
+    tcs->slots[i].sqlite_stmt = sqlite_stmt;
+    tcs->slots[i].pg_stmt = pg_stmt;
+    tcs->slots[i].seen = tcs->sweeps;
+    tcs->count++;
 }
 
 pg_stmt_t* pg_find_cached_stmt(sqlite3_stmt *sqlite_stmt) {
     thread_cached_stmts_t *tcs = get_thread_cached_stmts();
     if (!tcs) return NULL;
 
-    for (int i = 0; i < tcs->count; i++) {
-        if (tcs->entries[i].sqlite_stmt == sqlite_stmt) {
-            return tcs->entries[i].pg_stmt;
-        }
+    if (sqlite_stmt && tcs->last_stmt == sqlite_stmt &&
+        !(tcs->last_pg_stmt && atomic_load(&tcs->last_pg_stmt->finalized))) {
+        return tcs->last_pg_stmt;
     }
-    return NULL;
+
+    int i = tls_find_slot(tcs, sqlite_stmt);
+    if (i < 0) return NULL;
+    pg_stmt_t *p = tcs->slots[i].pg_stmt;
+    if (p && atomic_load(&p->finalized)) {
+        // Finalized on another thread - the address may already be a new statement
+        tls_drop_slot(tcs, i);
+        return NULL;
+    }
+    tcs->slots[i].seen = tcs->sweeps;
+    tcs->last_stmt = sqlite_stmt;
+    tcs->last_pg_stmt = p;
+    return p;
 }
 
 void pg_clear_cached_stmt(sqlite3_stmt *sqlite_stmt) {
     thread_cached_stmts_t *tcs = get_thread_cached_stmts();
     if (!tcs) return;
 
-    for (int i = 0; i < tcs->count; i++) {
-        if (tcs->entries[i].sqlite_stmt == sqlite_stmt) {
-            pg_stmt_t *old = tcs->entries[i].pg_stmt;
-
-            // Clear entry pointer FIRST
-            tcs->entries[i].pg_stmt = NULL;
-
-            // Shift remaining entries
-            for (int j = i; j < tcs->count - 1; j++) {
-                tcs->entries[j] = tcs->entries[j + 1];
-            }
-            tcs->count--;
+    int i = tls_find_slot(tcs, sqlite_stmt);
+    if (i < 0) return;
 
-            // Unref AFTER removing from list (for TLS destructor ownership)
-            if (old) pg_stmt_unref(old);
-            return;
-        }
-    }
+    // Remove entry FIRST, unref AFTER (for TLS destructor ownership)
+    pg_stmt_t *old = tls_remove_slot(tcs, i);
+    if (old) pg_stmt_unref(old);
 }
 
 // CRITICAL FIX: Weak clear - removes from cache without unreferencing
@@ -328,34 +566,116 @@ void pg_clear_cached_stmt_weak(sqlite3_stmt *sqlite_stmt) {
     thread_cached_stmts_t *tcs = get_thread_cached_stmts();
     if (!tcs) return;
 
-    for (int i = 0; i < tcs->count; i++) {
-        if (tcs->entries[i].sqlite_stmt == sqlite_stmt) {
-            // Just remove from array - DON'T unref (weak reference)
-            tcs->entries[i].pg_stmt = NULL;
-            for (int j = i; j < tcs->count - 1; j++) {
-                tcs->entries[j] = tcs->entries[j + 1];
-            }
-            tcs->count--;
-            return;
-        }
-    }
+    int i = tls_find_slot(tcs, sqlite_stmt);
+    if (i >= 0) tls_remove_slot(tcs, i);  // DON'T unref (weak reference)
 }
 
 // ============================================================================
 // Statement Lifecycle
 // ============================================================================
 
+// Parameter / column arrays: one block each, inline in pg_stmt_t up to
+// PG_STMT_INLINE_PARAMS / PG_STMT_INLINE_COLS, one heap block beyond that.
+// 8-byte members first so every array stays aligned for any n.
+
+static void layout_params(pg_stmt_t *stmt, unsigned char *p, int n) {
+    stmt->param_values = (char **)p;               p += n * sizeof(char *);
+    stmt->param_native = (pg_param_native_t *)p;   p += n * sizeof(pg_param_native_t);
+    stmt->param_lengths = (int *)p;                p += n * sizeof(int);
+    stmt->param_formats = (int *)p;                p += n * sizeof(int);
+    stmt->param_types = (Oid *)p;                  p += n * sizeof(Oid);
+    stmt->param_server_types = (Oid *)p;           p += n * sizeof(Oid);
+    stmt->param_buffers = (char (*)[32])p;         p += n * 32;
+    stmt->param_wire = (char (*)[8])p;
+    stmt->param_cap = n;
+}
+
+static void layout_cols(pg_stmt_t *stmt, unsigned char *p, int n) {
+    stmt->decoded_blobs = (void **)p;              p += n * sizeof(void *);
+    stmt->cached_blob = (void **)p;                p += n * sizeof(void *);
+    stmt->col_table_names = (char **)p;            p += n * sizeof(char *);
+    stmt->decoded_blob_lens = (int *)p;            p += n * sizeof(int);
+    stmt->cached_blob_len = (int *)p;
+    stmt->col_cap = n;
+}
+
+int pg_stmt_reserve_params(pg_stmt_t *stmt, int n) {
+    if (n <= stmt->param_cap) return 1;
+    if (n > MAX_PARAMS) return 0;
+
+    unsigned char *block = calloc((size_t)n, PG_PARAM_SLOT_BYTES);
+    if (!block) return 0;
+
+    int old_n = stmt->param_cap;
+    char **values = stmt->param_values;
+    pg_param_native_t *native = stmt->param_native;
+    int *lengths = stmt->param_lengths, *formats = stmt->param_formats;
+    Oid *types = stmt->param_types, *server_types = stmt->param_server_types;
+    char (*buffers)[32] = stmt->param_buffers;
+    char (*wire)[8] = stmt->param_wire;
+
+    layout_params(stmt, block, n);
+    memcpy(stmt->param_native, native, old_n * sizeof(*native));
+    memcpy(stmt->param_lengths, lengths, old_n * sizeof(int));
+    memcpy(stmt->param_formats, formats, old_n * sizeof(int));
+    memcpy(stmt->param_types, types, old_n * sizeof(Oid));
+    memcpy(stmt->param_server_types, server_types, old_n * sizeof(Oid));
+    memcpy(stmt->param_buffers, buffers, old_n * sizeof(*buffers));
+    memcpy(stmt->param_wire, wire, old_n * sizeof(*wire));
+    for (int i = 0; i < old_n; i++) {
+        // Int/double binds point into their own param_buffers slot
+        int in_buffer = values[i] >= buffers[i] && values[i] < buffers[i] + 32;
+        stmt->param_values[i] = in_buffer ? stmt->param_buffers[i] : values[i];
+    }
+
+    free(stmt->param_heap);
+    stmt->param_heap = block;
+    return 1;
+}
+
+int pg_stmt_reserve_cols(pg_stmt_t *stmt, int n) {
+    if (n <= stmt->col_cap) return 1;
+    if (n > MAX_PARAMS) return 0;
+
+    unsigned char *block = calloc((size_t)n, PG_COL_SLOT_BYTES);
+    if (!block) return 0;
+
+    int old_n = stmt->col_cap;
+    void **decoded = stmt->decoded_blobs, **cached = stmt->cached_blob;
+    char **tables = stmt->col_table_names;
+    int *decoded_lens = stmt->decoded_blob_lens, *cached_lens = stmt->cached_blob_len;
+
+    layout_cols(stmt, block, n);
+    memcpy(stmt->decoded_blobs, decoded, old_n * sizeof(void *));
+    memcpy(stmt->cached_blob, cached, old_n * sizeof(void *));
+    memcpy(stmt->col_table_names, tables, old_n * sizeof(char *));
+    memcpy(stmt->decoded_blob_lens, decoded_lens, old_n * sizeof(int));
+    memcpy(stmt->cached_blob_len, cached_lens, old_n * sizeof(int));
+
+    free(stmt->col_heap);
+    stmt->col_heap = block;
+    return 1;
+}
+
+int pg_stmt_set_param_count(pg_stmt_t *stmt, int n) {
+    if (n < 0) n = 0;
+    if (!pg_stmt_reserve_params(stmt, n)) {
+        LOG_ERROR("pg_stmt: %d params not supported (max %d), truncating: %.100s",
+                  n, MAX_PARAMS, stmt->sql ? stmt->sql : "NULL");
+        n = stmt->param_cap;
+    }
+    stmt->param_count = n;
+    return n;
+}
+
 pg_stmt_t* pg_stmt_create(pg_connection_t *conn, const char *sql, sqlite3_stmt *shadow_stmt) {
     pg_stmt_t *stmt = calloc(1, sizeof(pg_stmt_t));
     if (!stmt) return NULL;
 
     // CRITICAL FIX: Use recursive mutex to prevent deadlock when bind/reset
-    // operations internally trigger column functions on the same statement
-    pthread_mutexattr_t attr;
-    pthread_mutexattr_init(&attr);
-    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
-    pthread_mutex_init(&stmt->mutex, &attr);
-    pthread_mutexattr_destroy(&attr);
+    // operations internally trigger column functions on the same statement.
+    // Biased to the thread driving the statement (pg_bias_lock.h)
+    pg_bias_lock_init(&stmt->lock);
     atomic_store(&stmt->ref_count, 1);  // CRITICAL FIX: Initialize ref count
     stmt->conn = conn;
     stmt->shadow_stmt = shadow_stmt;
@@ -363,6 +683,9 @@ pg_stmt_t* pg_stmt_create(pg_connection_t *conn, const char *sql, sqlite3_stmt *
     stmt->current_row = -1;
     stmt->cached_row = -1;     // CRITICAL FIX: Prevent false cache hits on row 0
     stmt->decoded_blob_row = -1;  // CRITICAL FIX: Also init decoded blob row
+    stmt->decoded_row = -1;
+    layout_params(stmt, stmt->param_inline, PG_STMT_INLINE_PARAMS);
+    layout_cols(stmt, stmt->col_inline, PG_STMT_INLINE_COLS);
     stmt->write_executed = 0;  // Initialize write execution guard
     stmt->read_done = 0;       // Initialize read completion guard
 
@@ -439,9 +762,9 @@ void pg_stmt_free(pg_stmt_t *stmt) {
     // Validate param_count to prevent out-of-bounds access
     int safe_param_count = stmt->param_count;
     if (safe_param_count < 0) safe_param_count = 0;
-    if (safe_param_count > MAX_PARAMS) safe_param_count = MAX_PARAMS;
+    if (safe_param_count > stmt->param_cap) safe_param_count = stmt->param_cap;
 
-    for (int i = 0; i < safe_param_count; i++) {
+    for (int i = 0; i < stmt->param_cap; i++) {
         // Only free if not pointing to pre-allocated buffer
         if (stmt->param_values[i] && !is_preallocated_buffer(stmt, i)) {
             LOG_DEBUG("pg_stmt_free: freeing param_values[%d]=%p", i, (void*)stmt->param_values[i]);
@@ -467,7 +790,7 @@ void pg_stmt_free(pg_stmt_t *stmt) {
     }
 
     // Free decoded blob cache
-    for (int i = 0; i < MAX_PARAMS; i++) {
+    for (int i = 0; i < stmt->col_cap; i++) {
         if (stmt->decoded_blobs[i]) {
             LOG_DEBUG("pg_stmt_free: freeing decoded_blobs[%d]=%p", i, (void*)stmt->decoded_blobs[i]);
             free(stmt->decoded_blobs[i]);
@@ -475,13 +798,8 @@ void pg_stmt_free(pg_stmt_t *stmt) {
         }
     }
 
-    // Free cached text and blob
-    for (int i = 0; i < MAX_PARAMS; i++) {
-        if (stmt->cached_text[i]) {
-            LOG_DEBUG("pg_stmt_free: freeing cached_text[%d]=%p", i, (void*)stmt->cached_text[i]);
-            free(stmt->cached_text[i]);
-            stmt->cached_text[i] = NULL;
-        }
+    // Free cached blobs
+    for (int i = 0; i < stmt->col_cap; i++) {
         if (stmt->cached_blob[i]) {
             LOG_DEBUG("pg_stmt_free: freeing cached_blob[%d]=%p", i, (void*)stmt->cached_blob[i]);
             free(stmt->cached_blob[i]);
@@ -490,19 +808,42 @@ void pg_stmt_free(pg_stmt_t *stmt) {
     }
 
     // Free resolved column table names
-    for (int i = 0; i < MAX_PARAMS; i++) {
+    for (int i = 0; i < stmt->col_cap; i++) {
         if (stmt->col_table_names[i]) {
             free(stmt->col_table_names[i]);
             stmt->col_table_names[i] = NULL;
         }
     }
+    free(stmt->param_heap);
+    free(stmt->col_heap);
+    pg_shape_release(stmt->shape);
+    stmt->shape = NULL;
+    if (stmt->row_cells) {
+        pg_mem_charge(PG_MEM_COLUMN_BUFFERS, -(ssize_t)(stmt->row_cells_cap * sizeof(pg_row_cell_t)));
+        free(stmt->row_cells);
+        stmt->row_cells = NULL;
+    }
+
+    pg_stmt_release_values(stmt);
+    pg_stmt_text_free(stmt);
 
     LOG_DEBUG("pg_stmt_free: destroying mutex and freeing stmt=%p", (void*)stmt);
-    pthread_mutex_destroy(&stmt->mutex);
+    pg_bias_lock_destroy(&stmt->lock);
     free(stmt);
     LOG_DEBUG("pg_stmt_free: DONE");
 }
 
+// Called by sqlite3_finalize before dropping its references. Other threads
+// may still hold one (TLS tables, row cache parents) until they notice the
+// flag; the result they would keep alive is released here.
+void pg_stmt_mark_finalized(pg_stmt_t *stmt) {
+    if (!stmt) return;
+    pg_bias_lock(&stmt->lock);
+    atomic_store(&stmt->finalized, 1);
+    pg_stmt_clear_result(stmt);
+    pg_bias_unlock(&stmt->lock);
+}
+
 void pg_stmt_clear_result(pg_stmt_t *stmt) {
     if (!stmt) return;
     if (stmt->result) {
@@ -514,14 +855,17 @@ void pg_stmt_clear_result(pg_stmt_t *stmt) {
         pg_query_cache_release(stmt->cached_result);
         stmt->cached_result = NULL;
     }
+    pg_stmt_release_values(stmt);
+    pg_stmt_text_reset(stmt);
     stmt->current_row = -1;
+    stmt->decoded_row = -1;
     stmt->num_rows = 0;
     stmt->num_cols = 0;
     stmt->write_executed = 0;  // Reset write execution guard
     stmt->read_done = 0;       // Reset read completion guard
 
     // Clear decoded blob cache
-    for (int i = 0; i < MAX_PARAMS; i++) {
+    for (int i = 0; i < stmt->col_cap; i++) {
         if (stmt->decoded_blobs[i]) {
             free(stmt->decoded_blobs[i]);
             stmt->decoded_blobs[i] = NULL;
@@ -530,12 +874,8 @@ void pg_stmt_clear_result(pg_stmt_t *stmt) {
     }
     stmt->decoded_blob_row = -1;
 
-    // Free cached text and blob on clear
-    for (int i = 0; i < MAX_PARAMS; i++) {
-        if (stmt->cached_text[i]) {
-            free(stmt->cached_text[i]);
-            stmt->cached_text[i] = NULL;
-        }
+    // Free cached blobs on clear
+    for (int i = 0; i < stmt->col_cap; i++) {
         if (stmt->cached_blob[i]) {
             free(stmt->cached_blob[i]);
             stmt->cached_blob[i] = NULL;
@@ -545,6 +885,237 @@ void pg_stmt_clear_result(pg_stmt_t *stmt) {
     stmt->cached_row = -1;
 }
 
+// The step/column paths used to strstr() the SQL for these on every call;
+// the text never changes after prepare, so look once
+void pg_stmt_classify(pg_stmt_t *stmt) {
+    if (!stmt) return;
+    const char *sql = stmt->sql;
+    const char *pg_sql = stmt->pg_sql;
+    unsigned int flags = 0;
+
+    if (sql) {
+        if (strncasecmp(sql, "INSERT", 6) == 0) flags |= PG_STMT_F_INSERT;
+        if (strcasestr(sql, "INSERT INTO metadata_items")) flags |= PG_STMT_F_METADATA_ITEMS_INSERT;
+        if (strcasestr(sql, "play_queue_generators")) flags |= PG_STMT_F_PLAY_QUEUE_GENERATORS;
+    }
+    if (pg_sql) {
+        if (strstr(pg_sql, "COUNT(") || strstr(pg_sql, "SUM(") || strstr(pg_sql, "MAX(")) {
+            flags |= PG_STMT_F_AGGREGATE;
+        }
+        if (strstr(pg_sql, "play_queue")) flags |= PG_STMT_F_PLAY_QUEUE;
+        if (strstr(pg_sql, "play_queue_generators")) flags |= PG_STMT_F_PLAY_QUEUE_GENERATORS;
+        if (strcasestr(pg_sql, "statistics_media")) flags |= PG_STMT_F_STATISTICS_MEDIA;
+        if (strstr(pg_sql, "parents.parent_id,count(*)")) flags |= PG_STMT_F_COUNT_TRACE;
+    }
+    stmt->flags = flags;
+}
+
+// ============================================================================
+// Statement Templates (shared per-SQL description)
+// ============================================================================
+// Everything PQdescribePrepared reports - $N parameter types and the result
+// column layout - depends only on the SQL text, so one describe per SQL
+// covers every connection and every statement handle. Keyed by sql_hash,
+// direct-mapped: a collision simply replaces the slot and costs one more
+// describe later. Entries are immutable once stored; readers copy out
+// under the read lock.
+//
+// The template also carries the result shape (pg_shape_t) the column
+// metadata calls derive from the description plus source tables and the
+// decltype table. Shapes are refcounted so statements keep using theirs
+// while the slot is replaced.
+
+#define STMT_TEMPLATE_CACHE_SIZE 1024  // Power of 2 for fast modulo
+#define STMT_TEMPLATE_CACHE_MASK (STMT_TEMPLATE_CACHE_SIZE - 1)
+
+typedef struct {
+    uint64_t sql_hash;   // 0 = empty slot
+    int described;       // 1 once nparams/param_types/desc are filled
+    int nparams;
+    Oid *param_types;    // Server-resolved $N types
+    PGresult *desc;      // Column attributes only (0 rows)
+    pg_shape_t *shape;   // Resolved result shape (template's ref)
+} stmt_template_t;
+
+static stmt_template_t stmt_templates[STMT_TEMPLATE_CACHE_SIZE];
+static pthread_rwlock_t stmt_template_rwlock = PTHREAD_RWLOCK_INITIALIZER;
+
+// Approximate heap size of a template (libpq doesn't expose PGresult sizes)
+static ssize_t template_bytes(int nparams, const PGresult *desc) {
+    ssize_t bytes = (ssize_t)nparams * (ssize_t)sizeof(Oid) + 256;  // + PGresult header
+    int nfields = PQnfields(desc);
+    for (int i = 0; i < nfields; i++) bytes += 32 + (ssize_t)strlen(PQfname(desc, i)) + 1;
+    return bytes;
+}
+
+int pg_template_param_types(uint64_t sql_hash, int nparams, Oid *out) {
+    if (sql_hash == 0) return 0;
+    int found = 0;
+    pthread_rwlock_rdlock(&stmt_template_rwlock);
+    stmt_template_t *t = &stmt_templates[sql_hash & STMT_TEMPLATE_CACHE_MASK];
+    if (t->sql_hash == sql_hash && t->described && t->nparams == nparams &&
+        (nparams == 0 || t->param_types)) {
+        if (nparams > 0) memcpy(out, t->param_types, (size_t)nparams * sizeof(Oid));
+        found = 1;
+    }
+    pthread_rwlock_unlock(&stmt_template_rwlock);
+    return found;
+}
+
+PGresult* pg_template_description(uint64_t sql_hash) {
+    if (sql_hash == 0) return NULL;
+    PGresult *copy = NULL;
+    pthread_rwlock_rdlock(&stmt_template_rwlock);
+    stmt_template_t *t = &stmt_templates[sql_hash & STMT_TEMPLATE_CACHE_MASK];
+    if (t->sql_hash == sql_hash && t->desc) {
+        copy = PQcopyResult(t->desc, PG_COPYRES_ATTRS);
+    }
+    pthread_rwlock_unlock(&stmt_template_rwlock);
+    return copy;
+}
+
+void pg_template_store_description(uint64_t sql_hash, const PGresult *desc) {
+    if (sql_hash == 0 || PQresultStatus(desc) != PGRES_COMMAND_OK) return;
+
+    int nparams = PQnparams(desc);
+    Oid *types = NULL;
+    if (nparams > 0) {
+        types = malloc((size_t)nparams * sizeof(Oid));
+        if (!types) return;
+        for (int i = 0; i < nparams; i++) types[i] = PQparamtype(desc, i);
+    }
+    PGresult *attrs = PQcopyResult(desc, PG_COPYRES_ATTRS);
+    if (!attrs) {
+        free(types);
+        return;
+    }
+    ssize_t bytes = template_bytes(nparams, attrs);
+
+    pthread_rwlock_wrlock(&stmt_template_rwlock);
+    stmt_template_t *t = &stmt_templates[sql_hash & STMT_TEMPLATE_CACHE_MASK];
+    Oid *old_types = t->param_types;
+    PGresult *old_desc = t->desc;
+    int old_nparams = t->nparams;
+    pg_shape_t *old_shape = NULL;
+    if (t->sql_hash != sql_hash) {
+        old_shape = t->shape;  // Collision - the shape belongs to the evicted SQL
+        t->shape = NULL;
+    }
+    t->sql_hash = sql_hash;
+    t->described = 1;
+    t->nparams = nparams;
+    t->param_types = types;
+    t->desc = attrs;
+    pthread_rwlock_unlock(&stmt_template_rwlock);
+
+    if (old_desc) bytes -= template_bytes(old_nparams, old_desc);  // Attr copies carry no params
+    free(old_types);
+    if (old_desc) PQclear(old_desc);
+    pg_shape_release(old_shape);
+    pg_mem_charge(PG_MEM_TEMPLATES, bytes);
+}
+
+// Single allocation: header, then pointer/OID/int arrays, then the name and
+// table strings
+static size_t shape_bytes(int num_cols, const char *const *names, const char *const *tables) {
+    size_t bytes = sizeof(pg_shape_t) +
+                   (size_t)num_cols * (3 * sizeof(char *) + sizeof(Oid) + sizeof(int));
+    for (int i = 0; i < num_cols; i++) {
+        bytes += strlen(names[i] ? names[i] : "") + 1;
+        if (tables[i]) bytes += strlen(tables[i]) + 1;
+    }
+    return bytes;
+}
+
+pg_shape_t* pg_shape_create(int num_cols, const char *const *names, const Oid *oids,
+                            const char *const *tables) {
+    if (num_cols < 0) return NULL;
+    size_t bytes = shape_bytes(num_cols, names, tables);
+    pg_shape_t *shape = calloc(1, bytes);
+    if (!shape) return NULL;
+
+    char *p = (char *)(shape + 1);
+    shape->names = (const char **)p;      p += (size_t)num_cols * sizeof(char *);
+    shape->decltypes = (const char **)p;  p += (size_t)num_cols * sizeof(char *);
+    shape->tables = (const char **)p;     p += (size_t)num_cols * sizeof(char *);
+    shape->oids = (Oid *)p;               p += (size_t)num_cols * sizeof(Oid);
+    shape->sqlite_types = (int *)p;       p += (size_t)num_cols * sizeof(int);
+
+    for (int i = 0; i < num_cols; i++) {
+        size_t len = strlen(names[i] ? names[i] : "") + 1;
+        memcpy(p, names[i] ? names[i] : "", len);
+        shape->names[i] = p;
+        p += len;
+        if (tables[i]) {
+            len = strlen(tables[i]) + 1;
+            memcpy(p, tables[i], len);
+            shape->tables[i] = p;
+            p += len;
+        }
+        shape->oids[i] = oids[i];
+        shape->sqlite_types[i] = pg_oid_to_sqlite_type(oids[i]);
+    }
+    shape->num_cols = num_cols;
+    atomic_init(&shape->ref_count, 1);
+    pg_mem_charge(PG_MEM_TEMPLATES, (ssize_t)bytes);
+    return shape;
+}
+
+void pg_shape_ref(pg_shape_t *shape) {
+    if (shape) atomic_fetch_add(&shape->ref_count, 1);
+}
+
+void pg_shape_release(pg_shape_t *shape) {
+    if (!shape || atomic_fetch_sub(&shape->ref_count, 1) != 1) return;
+    pg_mem_charge(PG_MEM_TEMPLATES, -(ssize_t)shape_bytes(shape->num_cols, shape->names, shape->tables));
+    free(shape);
+}
+
+pg_shape_t* pg_template_shape(uint64_t sql_hash) {
+    if (sql_hash == 0) return NULL;
+    pg_shape_t *shape = NULL;
+    pthread_rwlock_rdlock(&stmt_template_rwlock);
+    stmt_template_t *t = &stmt_templates[sql_hash & STMT_TEMPLATE_CACHE_MASK];
+    if (t->sql_hash == sql_hash && t->shape) {
+        shape = t->shape;
+        pg_shape_ref(shape);
+    }
+    pthread_rwlock_unlock(&stmt_template_rwlock);
+    return shape;
+}
+
+void pg_template_store_shape(uint64_t sql_hash, pg_shape_t *shape) {
+    if (sql_hash == 0 || !shape) return;
+    pg_shape_ref(shape);
+
+    Oid *old_types = NULL;
+    PGresult *old_desc = NULL;
+    int old_nparams = 0;
+    pthread_rwlock_wrlock(&stmt_template_rwlock);
+    stmt_template_t *t = &stmt_templates[sql_hash & STMT_TEMPLATE_CACHE_MASK];
+    pg_shape_t *old_shape = t->shape;
+    if (t->sql_hash != sql_hash) {
+        // Executed without a describe (or collision) - the slot starts over
+        old_types = t->param_types;
+        old_desc = t->desc;
+        old_nparams = t->nparams;
+        t->sql_hash = sql_hash;
+        t->described = 0;
+        t->nparams = 0;
+        t->param_types = NULL;
+        t->desc = NULL;
+    }
+    t->shape = shape;
+    pthread_rwlock_unlock(&stmt_template_rwlock);
+
+    if (old_desc) {
+        pg_mem_charge(PG_MEM_TEMPLATES, -template_bytes(old_nparams, old_desc));
+        PQclear(old_desc);
+    }
+    free(old_types);
+    pg_shape_release(old_shape);
+}
+
 // ============================================================================
 // SQL Transformation Helpers
 // ============================================================================
@@ -673,29 +1244,241 @@ const char* pg_oid_to_sqlite_decltype(Oid oid) {
     }
 }
 
-sqlite3_value* pg_create_column_value(pg_stmt_t *stmt, int col_idx) {
-    // Lock-free slot allocation using atomic increment
-    int slot = atomic_fetch_add(&pg_value_idx, 1) & (MAX_PG_VALUES - 1);
-    pg_value_t *pv = &pg_values[slot];
+// ============================================================================
+// Fake sqlite3_value Arenas
+// ============================================================================
 
-    pv->magic = PG_VALUE_MAGIC;
-    pv->stmt = stmt;
-    pv->col_idx = col_idx;
+// Thread exit: the ring goes to the orphan list. Values in it may still be
+// live; whoever adopts the ring skips them until their statements release.
+static void pg_value_arena_orphan(void *arg) {
+    (void)arg;
+    if (value_arena.chunk == PG_VALUE_NO_CHUNK) return;
+    pthread_mutex_lock(&pg_value_orphan_mutex);
+    // Splice our ring in front of the orphan rings (one list of rings)
+    int first = pg_value_chunk_next[value_arena.chunk];
+    pg_value_chunk_next[value_arena.chunk] = pg_value_orphans;
+    pg_value_orphans = first;
+    pthread_mutex_unlock(&pg_value_orphan_mutex);
+    value_arena.chunk = PG_VALUE_NO_CHUNK;
+    value_arena.chunks = 0;
+}
 
-    // Determine type
-    if (!stmt || !stmt->result || stmt->current_row < 0 ||
-        stmt->current_row >= stmt->num_rows ||
-        PQgetisnull(stmt->result, stmt->current_row, col_idx)) {
-        pv->type = SQLITE_NULL;
+static void pg_value_key_create(void) {
+    pthread_key_create(&pg_value_key, pg_value_arena_orphan);
+}
+
+// Add a chunk to this thread's ring: an orphan if there is one, else a new
+// one from the pool. Returns 0 when the pool is exhausted.
+static int pg_value_arena_grow(void) {
+    int chunk = PG_VALUE_NO_CHUNK;
+
+    if (pg_value_orphans != PG_VALUE_NO_CHUNK) {  // Racy peek, checked under the mutex
+        pthread_mutex_lock(&pg_value_orphan_mutex);
+        chunk = pg_value_orphans;
+        if (chunk != PG_VALUE_NO_CHUNK) pg_value_orphans = pg_value_chunk_next[chunk];
+        pthread_mutex_unlock(&pg_value_orphan_mutex);
+    }
+    if (chunk == PG_VALUE_NO_CHUNK) {
+        int n = atomic_fetch_add(&pg_value_chunks_used, 1);
+        if (n >= PG_VALUE_CHUNKS) {
+            atomic_fetch_sub(&pg_value_chunks_used, 1);
+            return 0;
+        }
+        chunk = n;
+        for (int i = 0; i < PG_VALUE_CHUNK; i++) {
+            pg_value_t *pv = &pg_values[chunk * PG_VALUE_CHUNK + i];
+            pv->magic = PG_VALUE_MAGIC;
+            atomic_store_explicit(&pv->stmt, NULL, memory_order_relaxed);
+        }
+        pg_mem_charge(PG_MEM_VALUES, PG_VALUE_CHUNK * sizeof(pg_value_t));
+    }
+
+    if (value_arena.chunk == PG_VALUE_NO_CHUNK) {
+        pthread_once(&pg_value_key_once, pg_value_key_create);
+        pthread_setspecific(pg_value_key, &value_arena);  // Non-NULL so the destructor runs
+        pg_value_chunk_next[chunk] = chunk;
     } else {
-        pv->type = pg_oid_to_sqlite_type(PQftype(stmt->result, col_idx));
+        pg_value_chunk_next[chunk] = pg_value_chunk_next[value_arena.chunk];
+        pg_value_chunk_next[value_arena.chunk] = chunk;
     }
+    value_arena.chunk = chunk;
+    value_arena.slot = 0;
+    value_arena.chunks++;
+    return 1;
+}
 
+// Next free value of this thread's ring, growing the ring when every value
+// in it is still live. NULL when the pool is exhausted.
+static pg_value_t* pg_value_arena_take(void) {
+    if (value_arena.chunk != PG_VALUE_NO_CHUNK) {
+        int scanned = 0;
+        int total = value_arena.chunks * PG_VALUE_CHUNK;
+        while (scanned < total) {
+            pg_value_t *pv = &pg_values[value_arena.chunk * PG_VALUE_CHUNK + value_arena.slot];
+            scanned++;
+            if (++value_arena.slot == PG_VALUE_CHUNK) {
+                value_arena.slot = 0;
+                value_arena.chunk = pg_value_chunk_next[value_arena.chunk];
+            }
+            if (!atomic_load_explicit(&pv->stmt, memory_order_acquire)) return pv;
+        }
+    }
+    // Fresh chunks are all free; adopted ones may still hold live values
+    while (pg_value_arena_grow()) {
+        int chunk = value_arena.chunk;
+        for (int i = 0; i < PG_VALUE_CHUNK; i++) {
+            pg_value_t *pv = &pg_values[chunk * PG_VALUE_CHUNK + i];
+            if (atomic_load_explicit(&pv->stmt, memory_order_acquire)) continue;
+            value_arena.slot = i + 1;
+            if (value_arena.slot == PG_VALUE_CHUNK) {
+                value_arena.slot = 0;
+                value_arena.chunk = pg_value_chunk_next[chunk];
+            }
+            return pv;
+        }
+    }
+    return NULL;
+}
+
+sqlite3_value* pg_create_column_value(pg_stmt_t *stmt, int col_idx) {
+    pg_value_t *pv = pg_value_arena_take();
+    if (!pv) {
+        static atomic_int exhausted_logged = 0;
+        if (!atomic_exchange(&exhausted_logged, 1)) {
+            LOG_ERROR("sqlite3_value arenas exhausted (%d values live), returning NULL",
+                      PG_VALUE_CHUNKS * PG_VALUE_CHUNK);
+        }
+        return NULL;
+    }
+
+    pv->generation = stmt->value_gen;
+    pv->col_idx = col_idx;
+    pv->row_idx = stmt->current_row;
+    pv->next = stmt->values;
+    stmt->values = pv;
+    atomic_store_explicit(&pv->stmt, stmt, memory_order_release);
     return (sqlite3_value*)pv;
 }
 
-int pg_is_our_value(sqlite3_value *val) {
-    if (!val) return 0;
+void pg_stmt_release_values(pg_stmt_t *stmt) {
+    pg_value_t *pv = stmt->values;
+    while (pv) {
+        pg_value_t *next = pv->next;
+        pv->next = NULL;
+        atomic_store_explicit(&pv->stmt, NULL, memory_order_release);
+        pv = next;
+    }
+    stmt->values = NULL;
+    stmt->value_gen++;
+}
+
+pg_value_t* pg_value_from(sqlite3_value *val) {
+    uintptr_t p = (uintptr_t)val;
+    if (p < (uintptr_t)&pg_values[0] ||
+        p >= (uintptr_t)&pg_values[PG_VALUE_CHUNKS * PG_VALUE_CHUNK]) return NULL;
     pg_value_t *pv = (pg_value_t*)val;
-    return pv->magic == PG_VALUE_MAGIC;
+    return pv->magic == PG_VALUE_MAGIC ? pv : NULL;
+}
+
+int pg_value_live(const pg_value_t *pv, const pg_stmt_t *stmt) {
+    return atomic_load_explicit(&pv->stmt, memory_order_relaxed) == stmt &&
+           pv->generation == stmt->value_gen;
+}
+
+// ============================================================================
+// Statement Text Arena
+// ============================================================================
+// column_text and friends must return pointers that stay valid until the
+// next step/reset/finalize - exactly a statement's row lifetime. Copies are
+// bump-allocated from blocks owned by the statement; a reset keeps one block
+// sized to what the last row needed, so steady-state rows allocate nothing.
+
+#define PG_TEXT_BLOCK_SIZE 4096           // Smallest block
+#define PG_TEXT_KEEP_MAX (64 * 1024)      // Largest block kept across rows
+
+static pg_text_block_t* text_block_new(size_t cap) {
+    pg_text_block_t *b = malloc(sizeof(pg_text_block_t) + cap);
+    if (!b) return NULL;
+    b->next = NULL;
+    b->cap = cap;
+    b->used = 0;
+    pg_mem_charge(PG_MEM_COLUMN_BUFFERS, (ssize_t)(sizeof(pg_text_block_t) + cap));
+    return b;
+}
+
+static void text_block_free(pg_text_block_t *b) {
+    pg_mem_charge(PG_MEM_COLUMN_BUFFERS, -(ssize_t)(sizeof(pg_text_block_t) + b->cap));
+    free(b);
+}
+
+char* pg_stmt_text_alloc(pg_stmt_t *stmt, size_t size) {
+    size = (size + 7) & ~(size_t)7;
+    pg_text_block_t *head = stmt->text_arena;
+    if (head && head->cap - head->used >= size) {
+        char *p = head->data + head->used;
+        head->used += size;
+        return p;
+    }
+
+    if (head && size > PG_TEXT_BLOCK_SIZE / 4) {
+        // Large value: its own block behind the head, which keeps filling
+        pg_text_block_t *b = text_block_new(size);
+        if (!b) return NULL;
+        b->used = size;
+        b->next = head->next;
+        head->next = b;
+        return b->data;
+    }
+
+    pg_text_block_t *b = text_block_new(size > PG_TEXT_BLOCK_SIZE ? size : PG_TEXT_BLOCK_SIZE);
+    if (!b) return NULL;
+    b->used = size;
+    b->next = head;
+    stmt->text_arena = b;
+    pg_mem_check();
+    return b->data;
+}
+
+void pg_stmt_text_reset(pg_stmt_t *stmt) {
+    pg_text_block_t *head = stmt->text_arena;
+    stmt->decoded_row = -1;  // Cells hold copies from the arena
+    if (!head) return;
+
+    size_t row_bytes = 0;
+    for (pg_text_block_t *b = head; b; b = b->next) row_bytes += b->used;
+    pg_text_block_t *b = head->next;
+    while (b) {
+        pg_text_block_t *next = b->next;
+        text_block_free(b);
+        b = next;
+    }
+    head->next = NULL;
+    head->used = 0;
+
+    // One block for what this row needed, if that is worth keeping
+    if (row_bytes > head->cap) {
+        size_t cap = (row_bytes + PG_TEXT_BLOCK_SIZE - 1) & ~(size_t)(PG_TEXT_BLOCK_SIZE - 1);
+        if (cap <= PG_TEXT_KEEP_MAX) {
+            pg_text_block_t *bigger = text_block_new(cap);
+            if (bigger) {
+                text_block_free(head);
+                head = bigger;
+            }
+        }
+    }
+    if (head->cap > PG_TEXT_KEEP_MAX) {  // One huge value - don't hold on to it
+        text_block_free(head);
+        head = NULL;
+    }
+    stmt->text_arena = head;
+}
+
+void pg_stmt_text_free(pg_stmt_t *stmt) {
+    pg_text_block_t *b = stmt->text_arena;
+    while (b) {
+        pg_text_block_t *next = b->next;
+        text_block_free(b);
+        b = next;
+    }
+    stmt->text_arena = NULL;
 }
@@ -31,14 +31,59 @@ void pg_stmt_free(pg_stmt_t *stmt);  // Internal - prefer pg_stmt_unref
 void pg_stmt_ref(pg_stmt_t *stmt);   // CRITICAL FIX: Increment reference count
 void pg_stmt_unref(pg_stmt_t *stmt); // CRITICAL FIX: Decrement ref count, free if 0
 void pg_stmt_clear_result(pg_stmt_t *stmt);
+void pg_stmt_mark_finalized(pg_stmt_t *stmt);  // Frees the result now; refs may outlive finalize
+// Grow the param / column arrays to at least n slots (never shrinks).
+// Returns 0 if n > MAX_PARAMS or out of memory; the old arrays stay valid.
+int pg_stmt_reserve_params(pg_stmt_t *stmt, int n);
+int pg_stmt_reserve_cols(pg_stmt_t *stmt, int n);
+int pg_stmt_set_param_count(pg_stmt_t *stmt, int n);  // Reserves; returns the count actually set
+void pg_stmt_classify(pg_stmt_t *stmt);  // Fill stmt->flags from sql/pg_sql (call once pg_sql is final)
+
+// Shared statement templates (process-wide, keyed by sql_hash)
+// Filled from PQdescribePrepared; answer param-type and column metadata
+// lookups for every later statement with the same SQL
+int pg_template_param_types(uint64_t sql_hash, int nparams, Oid *out);
+PGresult* pg_template_description(uint64_t sql_hash);  // Caller owns (PQclear) the copy
+void pg_template_store_description(uint64_t sql_hash, const PGresult *desc);
+
+// Result shape of a template: everything the column metadata calls report,
+// resolved once per SQL. Immutable and refcounted, one allocation.
+typedef struct pg_shape {
+    atomic_int ref_count;
+    uint64_t version;          // Decltype source version the decltypes were resolved at
+    int num_cols;
+    const char **names;        // Column names
+    Oid *oids;                 // Column type OIDs
+    int *sqlite_types;         // pg_oid_to_sqlite_type(oids[i])
+    const char **decltypes;    // column_decltype answers (static strings)
+    const char **tables;       // Source table per column, NULL = computed/unknown
+} pg_shape_t;
+
+pg_shape_t* pg_shape_create(int num_cols, const char *const *names, const Oid *oids,
+                            const char *const *tables);  // decltypes left NULL, ref 1
+void pg_shape_ref(pg_shape_t *shape);
+void pg_shape_release(pg_shape_t *shape);
+pg_shape_t* pg_template_shape(uint64_t sql_hash);  // Caller owns a ref (pg_shape_release)
+void pg_template_store_shape(uint64_t sql_hash, pg_shape_t *shape);  // Template takes its own ref
 
 // Helpers for SQL transformation
 char* convert_metadata_settings_insert_to_upsert(const char *sql);
 sqlite3_int64 extract_metadata_id_from_generator_sql(const char *sql);
 
-// Fake sqlite3_value helpers
-sqlite3_value* pg_create_column_value(pg_stmt_t *stmt, int col_idx);
-int pg_is_our_value(sqlite3_value *val);
+// Fake sqlite3_value helpers (per-thread arenas, see pg_statement.c).
+// Caller holds stmt->lock for create/release; values stay valid until the
+// statement's next step/reset/finalize calls pg_stmt_release_values().
+sqlite3_value* pg_create_column_value(pg_stmt_t *stmt, int col_idx);  // Current row; NULL if arenas exhausted
+void pg_stmt_release_values(pg_stmt_t *stmt);
+pg_value_t* pg_value_from(sqlite3_value *val);  // NULL if not one of ours (released values still are)
+int pg_value_live(const pg_value_t *pv, const pg_stmt_t *stmt);  // Under stmt->lock
+
+// Per-statement text arena for column_text / value_text / value_blob copies.
+// Caller holds stmt->lock. Memory stays valid until pg_stmt_text_reset(),
+// which every step/reset calls (it also invalidates the decoded row).
+char* pg_stmt_text_alloc(pg_stmt_t *stmt, size_t size);  // NULL on OOM
+void pg_stmt_text_reset(pg_stmt_t *stmt);
+void pg_stmt_text_free(pg_stmt_t *stmt);
 int pg_oid_to_sqlite_type(Oid oid);
 const char* pg_oid_to_sqlite_decltype(Oid oid);
 
@@ -12,16 +12,29 @@
 #include <pthread.h>
 #include <stdatomic.h>
 
+#include "pg_bias_lock.h"
+
 // ============================================================================
 // Constants
 // ============================================================================
 
 #define MAX_CONNECTIONS 512
 #define MAX_PARAMS 256
-#define MAX_STATEMENTS 1024
-#define MAX_CACHED_STMTS_PER_THREAD 64
+#define PG_STMT_INLINE_PARAMS 8    // Params stored inside pg_stmt_t (covers most Plex SQL)
+#define PG_STMT_INLINE_COLS 8      // Columns stored inside pg_stmt_t
+#define PG_PARAM_DESCRIBE_TRIES 3  // Transient param type describe failures before text-only
+#define PG_TLS_STMT_INITIAL_CAP 16   // Per-thread cached statement table, grows by doubling
+#define PG_TLS_STMT_SWEEP_AT 64      // Drop dead/idle entries once the table holds this many
 #define PG_VALUE_MAGIC 0x50475641  // "PGVA" - identifies our fake sqlite3_value
 
+// PostgreSQL type OIDs used for binary parameter transfer (from pg_type.h)
+#define PG_OID_BYTEA  17
+#define PG_OID_INT8   20
+#define PG_OID_INT2   21
+#define PG_OID_INT4   23
+#define PG_OID_FLOAT4 700
+#define PG_OID_FLOAT8 701
+
 // Log file path
 #define LOG_FILE "/tmp/plex_redirect_pg.log"
 #define FALLBACK_LOG_FILE "/tmp/plex_pg_fallbacks.log"
@@ -123,29 +136,105 @@ typedef struct pg_connection {
 // Query Result Cache Types (for OnDeck optimization)
 // ============================================================================
 
-// Cached row data
-typedef struct {
-    char **values;          // Array of string values (NULL for NULL values)
-    int *lengths;           // Length of each value
-    int *is_null;           // 1 if value is NULL
-} cached_row_t;
-
 // Cached query result
+// All column metadata and cell data live in one arena allocated with the
+// entry. Cell i = row * num_cols + col holds bytes
+// [cell_offsets[i], cell_offsets[i + 1]) of cell_data: the value followed
+// by its '\0' terminator, or nothing when the cell is NULL (null_bitmap).
+// Values are UTF-8 validated once when the entry is built (utf8_bad_bitmap).
+// BYTEA (OID 17) cells hold the decoded bytes, not PostgreSQL's "\x" hex.
+// Use cached_cell_value()/cached_cell_length()/cached_cell_is_null().
 typedef struct cached_result {
     uint64_t cache_key;     // Hash of SQL + params
     uint64_t created_ms;    // Timestamp when cached
     atomic_int ref_count;   // Reference count - don't free while > 0
     int num_rows;
     int num_cols;
-    Oid *col_types;         // PostgreSQL type OIDs per column
-    char **col_names;       // Column names
-    cached_row_t *rows;     // Array of cached rows
-    int hit_count;          // Number of cache hits (for stats)
+    Oid *col_types;         // PostgreSQL type OIDs per column (in arena)
+    char **col_names;       // Column names (in arena)
+    uint32_t *cell_offsets; // num_rows * num_cols + 1 offsets into cell_data
+    uint8_t *null_bitmap;   // Bit i set = cell i is NULL
+    uint8_t *utf8_bad_bitmap; // Bit i set = cell i is not valid UTF-8
+    char *cell_data;        // Packed cell bytes
+    atomic_int hit_count;   // Number of cache hits (for stats)
 } cached_result_t;
 
+static inline int cached_cell_is_null(const cached_result_t *r, int row, int col) {
+    int i = row * r->num_cols + col;
+    return (r->null_bitmap[i >> 3] >> (i & 7)) & 1;
+}
+
+// NUL-terminated value, or NULL for a NULL cell
+static inline const char* cached_cell_value(const cached_result_t *r, int row, int col) {
+    int i = row * r->num_cols + col;
+    if ((r->null_bitmap[i >> 3] >> (i & 7)) & 1) return NULL;
+    return r->cell_data + r->cell_offsets[i];
+}
+
+static inline int cached_cell_utf8_valid(const cached_result_t *r, int row, int col) {
+    int i = row * r->num_cols + col;
+    return !((r->utf8_bad_bitmap[i >> 3] >> (i & 7)) & 1);
+}
+
+// Value length in bytes, excluding the terminator (0 for NULL)
+static inline int cached_cell_length(const cached_result_t *r, int row, int col) {
+    int i = row * r->num_cols + col;
+    uint32_t span = r->cell_offsets[i + 1] - r->cell_offsets[i];
+    return span ? (int)span - 1 : 0;
+}
+
+// Native value of a bound int/double parameter (see param_types)
+typedef union {
+    sqlite3_int64 i;
+    double d;
+} pg_param_native_t;
+
+// Bytes per slot of the pg_stmt_t parameter / column arrays (see pg_stmt_t)
+#define PG_PARAM_SLOT_BYTES (sizeof(char *) + sizeof(pg_param_native_t) + 2 * sizeof(int) + \
+                             2 * sizeof(Oid) + 32 + 8)
+#define PG_COL_SLOT_BYTES (3 * sizeof(void *) + 2 * sizeof(int))
+
+// Block of a statement's text arena (pg_stmt_text_alloc)
+typedef struct pg_text_block {
+    struct pg_text_block *next;
+    size_t cap;
+    size_t used;
+    char data[];
+} pg_text_block_t;
+
+// One column of the current row, decoded once per step (db_interpose_column.c)
+// so the column_* accessors are array loads. Column info is fixed for the
+// statement's SQL; the rest points into the current PGresult/cached result.
+#define PG_CELL_METADATA_TYPE  0x01  // metadata_type column (type 18 workaround)
+#define PG_CELL_AGGREGATE_INT  0x02  // count/sum/... integer (column_text reformat)
+typedef struct {
+    int affinity;                    // pg_oid_to_sqlite_type() of the column
+    Oid oid;
+    int flags;                       // PG_CELL_*
+    int type;                        // affinity, or SQLITE_NULL for a NULL cell
+    int len;                         // Raw value length
+    int utf8_valid;                  // Raw value is valid UTF-8 (checked once per row)
+    const char *text;                // Raw NUL-terminated value, NULL for NULL
+    const char *copy;                // column_text copy in the text arena, NULL = not yet
+    const char *name;                // Column name
+    sqlite3_int64 i;                 // Integer value (INTEGER/FLOAT columns)
+    double d;                        // Double value (INTEGER/FLOAT columns)
+} pg_row_cell_t;
+
+// Statement classification bits (pg_stmt_t.flags), derived from the SQL
+// text once at prepare time by pg_stmt_classify()
+#define PG_STMT_F_INSERT                0x01  // sql starts with INSERT
+#define PG_STMT_F_AGGREGATE             0x02  // pg_sql has COUNT( / SUM( / MAX(
+#define PG_STMT_F_PLAY_QUEUE            0x04  // pg_sql mentions play_queue*
+#define PG_STMT_F_PLAY_QUEUE_GENERATORS 0x08  // play_queue_generators
+#define PG_STMT_F_METADATA_ITEMS_INSERT 0x10  // INSERT INTO metadata_items
+#define PG_STMT_F_STATISTICS_MEDIA      0x20  // pg_sql mentions statistics_media
+#define PG_STMT_F_COUNT_TRACE           0x40  // parents.parent_id,count(*) (ULTRA_DEBUG traces)
+
 typedef struct pg_stmt {
-    pthread_mutex_t mutex;           // Protect against concurrent access from multiple threads
+    pg_bias_lock_t lock;             // Protect against concurrent access from multiple threads (biased to the driving thread)
     atomic_int ref_count;            // CRITICAL FIX: Reference count to prevent double-free
+    atomic_int finalized;            // Set by finalize - holders on other threads drop their refs lazily
     pg_connection_t *conn;
     sqlite3_stmt *shadow_stmt;       // Real SQLite statement handle (for mapping)
     char *sql;                       // Original SQL
@@ -156,6 +245,7 @@ typedef struct pg_stmt {
     // Prepared statement support
     uint64_t sql_hash;               // FNV-1a hash of pg_sql for cache lookup
     char stmt_name[32];              // "ps_<hash>" - PostgreSQL statement name
+    unsigned int flags;              // PG_STMT_F_* - set with sql_hash at prepare
     int use_prepared;                // 1 = use prepared statements for this query
     int current_row;
     int num_rows;
@@ -170,54 +260,117 @@ typedef struct pg_stmt {
     pthread_t executing_thread;      // Thread currently executing this statement (for debug)
     pg_connection_t *result_conn;    // Connection that the current result belongs to
 
-    char *param_values[MAX_PARAMS];
-    int param_lengths[MAX_PARAMS];
-    int param_formats[MAX_PARAMS];   // 0 = text, 1 = binary
+    // Parameter and column arrays are sized to the statement, not MAX_PARAMS:
+    // the first PG_STMT_INLINE_PARAMS / PG_STMT_INLINE_COLS slots live in
+    // param_inline / col_inline below, larger statements move each set to one
+    // heap block (pg_stmt_reserve_params / pg_stmt_reserve_cols). Invariant:
+    // param_cap >= param_count.
+    char **param_values;             // param_cap slots
+    int *param_lengths;              // Wire lengths (raw byte length for BYTEA binds)
+    int *param_formats;              // 0 = text, 1 = binary (filled per execution)
     int param_count;
+    int param_cap;                   // Slots in the param arrays
     char **param_names;              // Named parameter names (for mapping :name to $N)
-    char param_buffers[MAX_PARAMS][32]; // Pre-allocated buffers for int/double (avoid malloc)
+    char (*param_buffers)[32];       // Pre-allocated buffers for int/double (avoid malloc)
+    void *param_heap;                // Heap block behind the param arrays, NULL = inline
+
+    // Binary parameter transfer: bind records the native value and its type,
+    // execution sends it in binary when the server-side parameter type matches
+    Oid *param_types;                // PG_OID_INT8/FLOAT8/BYTEA for native binds, 0 = text
+    pg_param_native_t *param_native; // Native int64/double behind param_types
+    char (*param_wire)[8];           // Network-order images sent with paramFormats=1
+    Oid *param_server_types;         // Server-resolved $N types (PQdescribePrepared)
+    int param_server_types_known;    // 1 if param_server_types is valid for this SQL, -1 = text-only
+    int param_describe_failures;     // Transient describe failures (-1 after PG_PARAM_DESCRIBE_TRIES)
+
+    // Per-column arrays, col_cap slots (idx >= col_cap = nothing cached)
+    int col_cap;
+    void *col_heap;                  // Heap block behind the column arrays, NULL = inline
 
     // Decoded BYTEA blob cache (per-row, freed on step/reset)
-    void *decoded_blobs[MAX_PARAMS]; // Decoded binary data per column
-    int decoded_blob_lens[MAX_PARAMS]; // Length of decoded data per column
+    void **decoded_blobs;            // Decoded binary data per column
+    int *decoded_blob_lens;          // Length of decoded data per column
     int decoded_blob_row;            // Row for which blobs are cached (-1 = none)
 
-    // Cached text/blob values to ensure pointer validity per SQLite contract
+    // Cached blob values to ensure pointer validity per SQLite contract
     // These remain valid until step()/reset()/finalize()
-    char *cached_text[MAX_PARAMS];   // Cached strdup'd text per column
-    void *cached_blob[MAX_PARAMS];   // Cached blob data per column
-    int cached_blob_len[MAX_PARAMS]; // Length of cached blob per column
+    void **cached_blob;              // Cached blob data per column
+    int *cached_blob_len;            // Length of cached blob per column
     int cached_row;                  // Row for which values are cached (-1 = none)
 
     // Resolved table names for each column (for decltype lookup of bare columns)
     // Populated at query execution time using PQftable/PQftablecol
-    char *col_table_names[MAX_PARAMS]; // Source table name for each column (NULL if unknown)
+    char **col_table_names;            // Source table name for each column (NULL if unknown)
     int col_tables_resolved;           // 1 if table names have been resolved
+
+    // Result shape shared with the statement template (pg_statement.h)
+    struct pg_shape *shape;            // Ref held, NULL until first resolved
+
+    // Current row decoded once (every step() resets decoded_row)
+    pg_row_cell_t *row_cells;          // row_cells_cap cells
+    int row_cells_cap;
+    int row_cells_cols;                // Columns with column info filled, 0 = none
+    int decoded_row;                   // Row held in row_cells, -1 = none
+
+    // sqlite3_column_value() results handed out since the last step/reset
+    // (pg_create_column_value). Released, and value_gen bumped, by the next
+    // step/reset/finalize - the sqlite3_value lifetime SQLite documents.
+    struct pg_value *values;           // Linked through pg_value_t.next
+    unsigned int value_gen;
+
+    // Copies returned by column_text / value_text / value_blob, valid until
+    // the next step/reset/finalize (pg_stmt_text_alloc / pg_stmt_text_reset)
+    struct pg_text_block *text_arena;  // Current block first
+
+    // Small-statement storage for the arrays above
+    _Alignas(8) unsigned char param_inline[PG_STMT_INLINE_PARAMS * PG_PARAM_SLOT_BYTES];
+    _Alignas(8) unsigned char col_inline[PG_STMT_INLINE_COLS * PG_COL_SLOT_BYTES];
 } pg_stmt_t;
 
 // ============================================================================
 // Thread-Local Storage Structures
 // ============================================================================
 
+// Per-thread sqlite3_stmt -> pg_stmt table (pg_register_cached_stmt).
+// Open addressing with linear probing, doubled at half load. A statement
+// may be finalized on another thread, which can't see this table, so
+// entries are also dropped here: finalized ones on lookup, and finalized
+// or idle ones by a sweep once count reaches sweep_at.
+#define PG_TLS_STMT_EMPTY NULL
+#define PG_TLS_STMT_TOMBSTONE ((sqlite3_stmt *)(uintptr_t)1)
+
 typedef struct {
-    sqlite3_stmt *sqlite_stmt;
+    sqlite3_stmt *sqlite_stmt;       // PG_TLS_STMT_EMPTY / PG_TLS_STMT_TOMBSTONE / key
     pg_stmt_t *pg_stmt;
+    unsigned int seen;               // Value of sweeps at the last register/lookup
 } cached_stmt_entry_t;
 
 typedef struct {
-    cached_stmt_entry_t entries[MAX_CACHED_STMTS_PER_THREAD];
-    int count;
+    cached_stmt_entry_t *slots;      // cap slots, NULL until the first register
+    int cap;                         // Power of two
+    int count;                       // Live entries
+    int used;                        // Live entries + tombstones
+    int sweep_at;                    // Sweep when count reaches this (0 = PG_TLS_STMT_SWEEP_AT)
+    unsigned int sweeps;
+    // Last successful lookup - column_* calls hit one statement back to back
+    sqlite3_stmt *last_stmt;
+    pg_stmt_t *last_pg_stmt;
 } thread_cached_stmts_t;
 
 // ============================================================================
 // Fake sqlite3_value for PostgreSQL columns
 // ============================================================================
 
+// Handed out from per-thread arenas (pg_statement.c). magic is set once when
+// the arena chunk is carved and never cleared, so a released value is still
+// recognised as ours and never passed to the real sqlite3_value_* functions.
 typedef struct pg_value {
-    unsigned int magic;              // PG_VALUE_MAGIC to identify our values
-    pg_stmt_t *stmt;                 // Parent statement
+    uint32_t magic;                  // PG_VALUE_MAGIC to identify our values
+    uint32_t generation;             // stmt->value_gen when handed out
+    _Atomic(pg_stmt_t *) stmt;       // Parent statement, NULL = free
     int col_idx;                     // Column index
-    int type;                        // SQLite type (SQLITE_INTEGER, etc)
+    int row_idx;                     // Row at the time of sqlite3_column_value
+    struct pg_value *next;           // Parent's list of live values
 } pg_value_t;
 
 // ============================================================================
@@ -0,0 +1,375 @@
+/*
+ * PostgreSQL Shim - UTF-8 Validation Implementation
+ *
+ * The SIMD paths follow Keiser & Lemire, "Validating UTF-8 In Less Than One
+ * Instruction Per Byte" (the simdjson "lookup" algorithm). For each byte and
+ * the byte before it, three table lookups - high nibble of the previous
+ * byte, low nibble of the previous byte, high nibble of the current byte -
+ * each give a set of error classes that pair could belong to; the AND of
+ * the three is the set it actually belongs to. The only class that is not
+ * an error is "two continuations in a row", which must line up exactly with
+ * the continuations a 3- or 4-byte lead two or three bytes earlier requires.
+ * A sequence cut off by the end of the input is caught by the final
+ * "incomplete" check (the tail is zero padded, which is ASCII).
+ */
+
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "pg_utf8.h"
+#include "pg_cpu.h"
+
+#ifdef PG_UTF8_X86
+#include <immintrin.h>
+#endif
+#ifdef PG_UTF8_NEON
+#include <arm_neon.h>
+#endif
+
+// Strings shorter than this go straight to the scalar loop
+#define UTF8_SIMD_MIN_LEN 16
+
+// ============================================================================
+// Scalar
+// ============================================================================
+
+static int is_valid_utf8_char(const unsigned char *s, size_t len, size_t *char_len) {
+    unsigned char c = s[0];
+
+    // 2-byte UTF-8 (110xxxxx 10xxxxxx)
+    if ((c & 0xE0) == 0xC0) {
+        if (len < 2) return 0;
+        if ((s[1] & 0xC0) != 0x80) return 0;
+        if (c < 0xC2) return 0;  // Overlong
+        *char_len = 2;
+        return 1;
+    }
+
+    // 3-byte UTF-8 (1110xxxx 10xxxxxx 10xxxxxx)
+    if ((c & 0xF0) == 0xE0) {
+        if (len < 3) return 0;
+        if ((s[1] & 0xC0) != 0x80) return 0;
+        if ((s[2] & 0xC0) != 0x80) return 0;
+        if (c == 0xE0 && s[1] < 0xA0) return 0;   // Overlong
+        if (c == 0xED && s[1] >= 0xA0) return 0;  // Surrogates U+D800..U+DFFF
+        *char_len = 3;
+        return 1;
+    }
+
+    // 4-byte UTF-8 (11110xxx 10xxxxxx 10xxxxxx 10xxxxxx)
+    if ((c & 0xF8) == 0xF0) {
+        if (len < 4) return 0;
+        if ((s[1] & 0xC0) != 0x80) return 0;
+        if ((s[2] & 0xC0) != 0x80) return 0;
+        if ((s[3] & 0xC0) != 0x80) return 0;
+        if (c == 0xF0 && s[1] < 0x90) return 0;   // Overlong
+        if (c == 0xF4 && s[1] >= 0x90) return 0;  // Above U+10FFFF
+        if (c >= 0xF5) return 0;
+        *char_len = 4;
+        return 1;
+    }
+
+    return 0;  // Continuation or invalid lead byte
+}
+
+int pg_utf8_valid_scalar(const char *s, size_t len) {
+    const unsigned char *p = (const unsigned char *)s;
+    size_t i = 0;
+    while (i < len) {
+        // ASCII run, 8 bytes at a time
+        while (i + 8 <= len) {
+            uint64_t w;
+            memcpy(&w, p + i, 8);
+            if (w & 0x8080808080808080ULL) break;
+            i += 8;
+        }
+        if (i >= len) break;
+        if (p[i] < 0x80) {
+            i++;
+            continue;
+        }
+        size_t char_len;
+        if (!is_valid_utf8_char(p + i, len - i, &char_len)) return 0;
+        i += char_len;
+    }
+    return 1;
+}
+
+// ============================================================================
+// Lookup Tables (shared by the SIMD paths)
+// ============================================================================
+
+#define TOO_SHORT      (1 << 0)  // 11______ 0_______ / 11______ 11______
+#define TOO_LONG       (1 << 1)  // 0_______ 10______
+#define OVERLONG_3     (1 << 2)  // 11100000 100_____
+#define TOO_LARGE      (1 << 3)  // 11110100 1001____ / 11110100 101_____ / 11110101+
+#define SURROGATE      (1 << 4)  // 11101101 101_____
+#define OVERLONG_2     (1 << 5)  // 1100000_ 10______
+#define TOO_LARGE_1000 (1 << 6)  // 11110101+ 1000____
+#define OVERLONG_4     (1 << 6)  // 11110000 1000____
+#define TWO_CONTS      (1 << 7)  // 10______ 10______
+#define CARRY (TOO_SHORT | TOO_LONG | TWO_CONTS)
+
+#if defined(PG_UTF8_X86) || defined(PG_UTF8_NEON)
+
+// High nibble of the previous byte
+static const uint8_t byte_1_high[16] = {
+    TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,               // 0_______ ASCII
+    TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+    TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,           // 10______ continuation
+    TOO_SHORT | OVERLONG_2,                               // 1100____
+    TOO_SHORT,                                            // 1101____
+    TOO_SHORT | OVERLONG_3 | SURROGATE,                   // 1110____
+    TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4   // 1111____
+};
+
+// Low nibble of the previous byte
+static const uint8_t byte_1_low[16] = {
+    CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,         // ____0000
+    CARRY | OVERLONG_2,                                   // ____0001
+    CARRY, CARRY,                                         // ____001_
+    CARRY | TOO_LARGE,                                    // ____0100
+    CARRY | TOO_LARGE | TOO_LARGE_1000,                   // ____0101
+    CARRY | TOO_LARGE | TOO_LARGE_1000,                   // ____011_
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,                   // ____1___
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,       // ____1101
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000
+};
+
+// High nibble of the current byte
+static const uint8_t byte_2_high[16] = {
+    TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,           // 0_______ ASCII
+    TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,  // 1000____
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,                    // 1001____
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,                     // 101_____
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+    TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT            // 11______ lead
+};
+
+#endif
+
+// ============================================================================
+// x86-64: SSE4.1 / AVX2
+// ============================================================================
+
+#ifdef PG_UTF8_X86
+
+__attribute__((target("sse4.1")))
+int pg_utf8_valid_sse4(const char *s, size_t len) {
+    const __m128i t1 = _mm_loadu_si128((const __m128i *)byte_1_high);
+    const __m128i t2 = _mm_loadu_si128((const __m128i *)byte_1_low);
+    const __m128i t3 = _mm_loadu_si128((const __m128i *)byte_2_high);
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    const __m128i third_min = _mm_set1_epi8((char)(0xE0 - 0x80));
+    const __m128i fourth_min = _mm_set1_epi8((char)(0xF0 - 0x80));
+    const __m128i high_bit = _mm_set1_epi8((char)0x80);
+    // Last bytes that still need continuations: >= 0xC0 / 0xE0 / 0xF0 at 15 / 14 / 13
+    const __m128i max_complete = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1,
+                                               -1, -1, -1, -1, -1, (char)(0xF0 - 1),
+                                               (char)(0xE0 - 1), (char)(0xC0 - 1));
+
+    __m128i prev_input = _mm_setzero_si128();
+    __m128i prev_incomplete = _mm_setzero_si128();
+    __m128i error = _mm_setzero_si128();
+    unsigned char tail[16];
+
+    for (size_t i = 0; i < len; i += 16) {
+        __m128i input;
+        if (len - i >= 16) {
+            input = _mm_loadu_si128((const __m128i *)(s + i));
+        } else {
+            memset(tail, 0, sizeof(tail));
+            memcpy(tail, s + i, len - i);
+            input = _mm_loadu_si128((const __m128i *)tail);
+        }
+
+        if (_mm_movemask_epi8(input) == 0) {  // All ASCII
+            error = _mm_or_si128(error, prev_incomplete);
+            prev_incomplete = _mm_setzero_si128();
+            prev_input = input;
+            continue;
+        }
+
+        __m128i prev1 = _mm_alignr_epi8(input, prev_input, 15);
+        __m128i b1h = _mm_shuffle_epi8(t1, _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble));
+        __m128i b1l = _mm_shuffle_epi8(t2, _mm_and_si128(prev1, nibble));
+        __m128i b2h = _mm_shuffle_epi8(t3, _mm_and_si128(_mm_srli_epi16(input, 4), nibble));
+        __m128i special = _mm_and_si128(_mm_and_si128(b1h, b1l), b2h);
+
+        __m128i prev2 = _mm_alignr_epi8(input, prev_input, 14);
+        __m128i prev3 = _mm_alignr_epi8(input, prev_input, 13);
+        __m128i must23 = _mm_or_si128(_mm_subs_epu8(prev2, third_min),
+                                      _mm_subs_epu8(prev3, fourth_min));
+        error = _mm_or_si128(error, _mm_xor_si128(_mm_and_si128(must23, high_bit), special));
+
+        prev_incomplete = _mm_subs_epu8(input, max_complete);
+        prev_input = input;
+    }
+    error = _mm_or_si128(error, prev_incomplete);
+    return _mm_testz_si128(error, error);
+}
+
+__attribute__((target("avx2")))
+int pg_utf8_valid_avx2(const char *s, size_t len) {
+    const __m256i t1 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)byte_1_high));
+    const __m256i t2 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)byte_1_low));
+    const __m256i t3 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)byte_2_high));
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    const __m256i third_min = _mm256_set1_epi8((char)(0xE0 - 0x80));
+    const __m256i fourth_min = _mm256_set1_epi8((char)(0xF0 - 0x80));
+    const __m256i high_bit = _mm256_set1_epi8((char)0x80);
+    const __m256i max_complete = _mm256_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1,
+                                                  -1, -1, -1, -1, -1, -1, -1, -1,
+                                                  -1, -1, -1, -1, -1, -1, -1, -1,
+                                                  -1, -1, -1, -1, -1, (char)(0xF0 - 1),
+                                                  (char)(0xE0 - 1), (char)(0xC0 - 1));
+
+    __m256i prev_input = _mm256_setzero_si256();
+    __m256i prev_incomplete = _mm256_setzero_si256();
+    __m256i error = _mm256_setzero_si256();
+    unsigned char tail[32];
+
+    for (size_t i = 0; i < len; i += 32) {
+        __m256i input;
+        if (len - i >= 32) {
+            input = _mm256_loadu_si256((const __m256i *)(s + i));
+        } else {
+            memset(tail, 0, sizeof(tail));
+            memcpy(tail, s + i, len - i);
+            input = _mm256_loadu_si256((const __m256i *)tail);
+        }
+
+        if (_mm256_movemask_epi8(input) == 0) {  // All ASCII
+            error = _mm256_or_si256(error, prev_incomplete);
+            prev_incomplete = _mm256_setzero_si256();
+            prev_input = input;
+            continue;
+        }
+
+        // Bytes 16..31 of prev_input followed by input, so alignr can reach
+        // across the 128-bit lanes
+        __m256i shifted = _mm256_permute2x128_si256(prev_input, input, 0x21);
+        __m256i prev1 = _mm256_alignr_epi8(input, shifted, 15);
+        __m256i b1h = _mm256_shuffle_epi8(t1, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble));
+        __m256i b1l = _mm256_shuffle_epi8(t2, _mm256_and_si256(prev1, nibble));
+        __m256i b2h = _mm256_shuffle_epi8(t3, _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble));
+        __m256i special = _mm256_and_si256(_mm256_and_si256(b1h, b1l), b2h);
+
+        __m256i prev2 = _mm256_alignr_epi8(input, shifted, 14);
+        __m256i prev3 = _mm256_alignr_epi8(input, shifted, 13);
+        __m256i must23 = _mm256_or_si256(_mm256_subs_epu8(prev2, third_min),
+                                         _mm256_subs_epu8(prev3, fourth_min));
+        error = _mm256_or_si256(error, _mm256_xor_si256(_mm256_and_si256(must23, high_bit), special));
+
+        prev_incomplete = _mm256_subs_epu8(input, max_complete);
+        prev_input = input;
+    }
+    error = _mm256_or_si256(error, prev_incomplete);
+    return _mm256_testz_si256(error, error);
+}
+
+#endif // PG_UTF8_X86
+
+// ============================================================================
+// aarch64: NEON
+// ============================================================================
+
+#ifdef PG_UTF8_NEON
+
+int pg_utf8_valid_neon(const char *s, size_t len) {
+    const uint8x16_t t1 = vld1q_u8(byte_1_high);
+    const uint8x16_t t2 = vld1q_u8(byte_1_low);
+    const uint8x16_t t3 = vld1q_u8(byte_2_high);
+    const uint8x16_t nibble = vdupq_n_u8(0x0F);
+    const uint8x16_t third_min = vdupq_n_u8(0xE0 - 0x80);
+    const uint8x16_t fourth_min = vdupq_n_u8(0xF0 - 0x80);
+    const uint8x16_t high_bit = vdupq_n_u8(0x80);
+    static const uint8_t max_complete_bytes[16] = {
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1
+    };
+    const uint8x16_t max_complete = vld1q_u8(max_complete_bytes);
+
+    uint8x16_t prev_input = vdupq_n_u8(0);
+    uint8x16_t prev_incomplete = vdupq_n_u8(0);
+    uint8x16_t error = vdupq_n_u8(0);
+    uint8_t tail[16];
+
+    for (size_t i = 0; i < len; i += 16) {
+        uint8x16_t input;
+        if (len - i >= 16) {
+            input = vld1q_u8((const uint8_t *)s + i);
+        } else {
+            memset(tail, 0, sizeof(tail));
+            memcpy(tail, s + i, len - i);
+            input = vld1q_u8(tail);
+        }
+
+        if (vmaxvq_u8(input) < 0x80) {  // All ASCII
+            error = vorrq_u8(error, prev_incomplete);
+            prev_incomplete = vdupq_n_u8(0);
+            prev_input = input;
+            continue;
+        }
+
+        uint8x16_t prev1 = vextq_u8(prev_input, input, 15);
+        uint8x16_t b1h = vqtbl1q_u8(t1, vshrq_n_u8(prev1, 4));
+        uint8x16_t b1l = vqtbl1q_u8(t2, vandq_u8(prev1, nibble));
+        uint8x16_t b2h = vqtbl1q_u8(t3, vshrq_n_u8(input, 4));
+        uint8x16_t special = vandq_u8(vandq_u8(b1h, b1l), b2h);
+
+        uint8x16_t prev2 = vextq_u8(prev_input, input, 14);
+        uint8x16_t prev3 = vextq_u8(prev_input, input, 13);
+        uint8x16_t must23 = vorrq_u8(vqsubq_u8(prev2, third_min), vqsubq_u8(prev3, fourth_min));
+        error = vorrq_u8(error, veorq_u8(vandq_u8(must23, high_bit), special));
+
+        prev_incomplete = vqsubq_u8(input, max_complete);
+        prev_input = input;
+    }
+    error = vorrq_u8(error, prev_incomplete);
+    return vmaxvq_u8(error) == 0;
+}
+
+#endif // PG_UTF8_NEON
+
+// ============================================================================
+// Dispatch
+// ============================================================================
+
+static int (*utf8_impl)(const char *, size_t) = pg_utf8_valid_scalar;
+static const char *utf8_impl_name = "scalar";
+static pthread_once_t utf8_once = PTHREAD_ONCE_INIT;
+
+static void utf8_select(void) {
+#ifdef PG_UTF8_X86
+    if (pg_cpu_has_avx2()) {
+        utf8_impl = pg_utf8_valid_avx2;
+        utf8_impl_name = "avx2";
+    } else if (pg_cpu_has_sse41()) {
+        utf8_impl = pg_utf8_valid_sse4;
+        utf8_impl_name = "sse4.1";
+    }
+#elif defined(PG_UTF8_NEON)
+    utf8_impl = pg_utf8_valid_neon;
+    utf8_impl_name = "neon";
+#endif
+}
+
+int pg_utf8_valid(const char *s, size_t len) {
+    if (len < UTF8_SIMD_MIN_LEN) return pg_utf8_valid_scalar(s, len);
+    pthread_once(&utf8_once, utf8_select);
+    return utf8_impl(s, len);
+}
+
+const char* pg_utf8_impl_name(void) {
+    pthread_once(&utf8_once, utf8_select);
+    return utf8_impl_name;
+}
@@ -0,0 +1,46 @@
+/*
+ * PostgreSQL Shim - UTF-8 Validation
+ *
+ * Boost.Locale in Plex may be sensitive to invalid UTF-8, so column_text
+ * never returns it. Cells are validated once - when a row is decoded or a
+ * result enters the query cache - and the accessors read the stored bit.
+ *
+ * Design:
+ * - Keiser/Lemire lookup validator: three 16-entry nibble tables classify
+ *   every byte pair, plus a check that 3-/4-byte leads are followed by
+ *   enough continuations, 16 or 32 bytes per step
+ * - AVX2 or SSE4.1 on x86-64 (chosen at runtime with cpuid), NEON on
+ *   aarch64, scalar elsewhere and for short strings (pg_cpu.h)
+ * - Whole-block ASCII fast path (no high bit set anywhere)
+ * - Same acceptance as the old byte-by-byte check: RFC 3629 UTF-8, no
+ *   overlongs, no surrogates, nothing above U+10FFFF
+ */
+
+#ifndef PG_UTF8_H
+#define PG_UTF8_H
+
+#include <stddef.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PG_UTF8_X86 1
+#elif defined(__aarch64__)
+#define PG_UTF8_NEON 1
+#endif
+
+// 1 if s[0..len) is valid UTF-8. Best implementation for this CPU.
+int pg_utf8_valid(const char *s, size_t len);
+
+// Name of the implementation pg_utf8_valid() uses ("avx2", "sse4.1", ...)
+const char* pg_utf8_impl_name(void);
+
+// Individual implementations (tests and benchmarks)
+int pg_utf8_valid_scalar(const char *s, size_t len);
+#ifdef PG_UTF8_X86
+int pg_utf8_valid_sse4(const char *s, size_t len);   // Requires pg_cpu_has_sse41()
+int pg_utf8_valid_avx2(const char *s, size_t len);   // Requires pg_cpu_has_avx2()
+#endif
+#ifdef PG_UTF8_NEON
+int pg_utf8_valid_neon(const char *s, size_t len);
+#endif
+
+#endif // PG_UTF8_H
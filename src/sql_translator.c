@@ -15,7 +15,9 @@
 #include "sql_translator.h"
 #include "sql_translator_internal.h"
 #include "pg_logging.h"
+#include "pg_mem.h"
 #include <stdint.h>
+#include <pthread.h>
 
 // ============================================================================
 // Thread-Local Translation Cache (lock-free, ~500x speedup for cache hits)
@@ -35,6 +37,31 @@ typedef struct {
 static __thread trans_cache_entry_t trans_cache[TRANS_CACHE_SIZE];
 static __thread int trans_cache_initialized = 0;
 
+// Entries are freed (and un-charged from pg_mem) when their thread exits
+static pthread_key_t trans_cache_key;
+static pthread_once_t trans_cache_key_once = PTHREAD_ONCE_INIT;
+
+static size_t entry_bytes(const trans_cache_entry_t *entry) {
+    return (entry->input_sql ? strlen(entry->input_sql) + 1 : 0) +
+           (entry->output_sql ? strlen(entry->output_sql) + 1 : 0);
+}
+
+static void free_trans_cache(void *arg) {
+    trans_cache_entry_t *cache = arg;
+    size_t bytes = 0;
+    for (int i = 0; i < TRANS_CACHE_SIZE; i++) {
+        bytes += entry_bytes(&cache[i]);
+        free(cache[i].input_sql);
+        free(cache[i].output_sql);
+        memset(&cache[i], 0, sizeof(cache[i]));
+    }
+    pg_mem_charge(PG_MEM_TRANSLATIONS, -(ssize_t)bytes);
+}
+
+static void create_trans_cache_key(void) {
+    pthread_key_create(&trans_cache_key, free_trans_cache);
+}
+
 // FNV-1a hash
 static uint64_t hash_sql(const char *sql) {
     uint64_t h = 14695981039346656037ULL;
@@ -75,41 +102,47 @@ static sql_translation_t* cache_lookup(const char *sql, uint64_t hash) {
 
 // Add to thread-local cache
 static void cache_store(const char *input_sql, uint64_t hash, const char *output_sql, int param_count) {
+    if (!trans_cache_initialized) {
+        pthread_once(&trans_cache_key_once, create_trans_cache_key);
+        pthread_setspecific(trans_cache_key, trans_cache);
+        trans_cache_initialized = 1;
+    }
+
     int start_idx = (int)(hash & TRANS_CACHE_MASK);
     int oldest_idx = start_idx;
+    trans_cache_entry_t *entry = NULL;
     
     for (int probe = 0; probe < 8; probe++) {
         int idx = (start_idx + probe) & TRANS_CACHE_MASK;
-        trans_cache_entry_t *entry = &trans_cache[idx];
+        trans_cache_entry_t *e = &trans_cache[idx];
         
-        if (entry->hash == 0) {
-            // Empty slot - use it
-            entry->hash = hash;
-            entry->input_sql = strdup(input_sql);
-            entry->output_sql = strdup(output_sql);
-            entry->param_count = param_count;
-            return;
+        if (e->hash == 0) {
+            entry = e;  // Empty slot - use it
+            break;
         }
         
-        if (entry->hash == hash && entry->input_sql && strcmp(entry->input_sql, input_sql) == 0) {
-            // Already exists - update it
-            free(entry->output_sql);
-            entry->output_sql = strdup(output_sql);
-            entry->param_count = param_count;
-            return;
+        if (e->hash == hash && e->input_sql && strcmp(e->input_sql, input_sql) == 0) {
+            entry = e;  // Already exists - update it
+            break;
         }
         
         oldest_idx = idx;  // Keep track of last slot for eviction
     }
     
     // No free slot in probe range - evict oldest (last probed)
-    trans_cache_entry_t *entry = &trans_cache[oldest_idx];
+    if (!entry) entry = &trans_cache[oldest_idx];
+
+    ssize_t delta = -(ssize_t)entry_bytes(entry);
     free(entry->input_sql);
     free(entry->output_sql);
     entry->hash = hash;
     entry->input_sql = strdup(input_sql);
     entry->output_sql = strdup(output_sql);
     entry->param_count = param_count;
+    delta += (ssize_t)entry_bytes(entry);
+
+    pg_mem_charge(PG_MEM_TRANSLATIONS, delta);
+    pg_mem_check();
 }
 
 // Standard translation: call function, swap result
@@ -339,6 +372,7 @@ sql_translation_t sql_translate(const char *sqlite_sql) {
     sql_translation_t *cached = cache_lookup(sqlite_sql, hash);
     if (cached) {
         // Cache hit - return copy of cached result
+        pg_mem_hit(PG_MEM_TRANSLATIONS);
         result.sql = strdup(cached->sql);  // Caller expects to free this
         result.param_count = cached->param_count;
         result.param_names = NULL;  // Not cached
@@ -6,6 +6,8 @@
  * 2. Hash function performance
  * 3. String replacement performance
  * 4. Cache lookup simulation
+ * 5. Full query pipeline
+ * 6. Statement lock cost of a 30-column row read
  */
 
 #include <stdio.h>
@@ -14,9 +16,13 @@
 #include <stdint.h>
 #include <time.h>
 #include <sys/time.h>
+#include <pthread.h>
 
 // Include translator
 #include "sql_translator.h"
+#include "pg_bias_lock.h"
+#include "pg_utf8.h"
+#include "pg_hex.h"
 
 // Get time in microseconds
 static uint64_t get_time_us(void) {
@@ -232,6 +238,139 @@ static void bench_full_pipeline(void) {
     printf("  \033[32m%.2f µs per query | %.0f queries/sec\033[0m\n", per_query, qps);
 }
 
+// ============================================================================
+// Benchmark: Statement lock per row read
+// ============================================================================
+
+// Reading a row locks the statement once per sqlite3_column_* call; a
+// 30-column row with type + value per column is 60 lock/unlock pairs.
+#define ROW_COLS 30
+#define ROW_CALLS (ROW_COLS * 2)
+
+static void bench_stmt_lock(void) {
+    printf("\n\033[1m[6] Statement Lock per 30-Column Row (%d lock/unlock pairs)\033[0m\n", ROW_CALLS);
+
+    int rows = 1000000;
+    volatile int sink = 0;
+
+    // Before: recursive pthread mutex
+    pthread_mutex_t mutex;
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+
+    uint64_t start = get_time_us();
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < ROW_CALLS; c++) {
+            pthread_mutex_lock(&mutex);
+            sink += c;
+            pthread_mutex_unlock(&mutex);
+        }
+    }
+    uint64_t mutex_us = get_time_us() - start;
+    pthread_mutex_destroy(&mutex);
+
+    // After: biased lock (owner fast path once biased)
+    pg_bias_lock_t lock;
+    pg_bias_lock_init(&lock);
+
+    start = get_time_us();
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < ROW_CALLS; c++) {
+            pg_bias_lock(&lock);
+            sink += c;
+            pg_bias_unlock(&lock);
+        }
+    }
+    uint64_t bias_us = get_time_us() - start;
+    pg_bias_lock_destroy(&lock);
+
+    double mutex_ns = (double)mutex_us / rows * 1000;
+    double bias_ns = (double)bias_us / rows * 1000;
+    printf("  recursive mutex: %.1f ns per row\n", mutex_ns);
+    printf("  biased lock:     %.1f ns per row%s\n", bias_ns,
+           pg_bias_lock_enabled() ? "" : " (membarrier unavailable - mutex path)");
+    printf("  \033[32m%.1fx faster\033[0m\n", bias_ns > 0 ? mutex_ns / bias_ns : 0.0);
+}
+
+// ============================================================================
+// Benchmark 7: UTF-8 Validation
+// ============================================================================
+
+static double utf8_mb_per_s(int (*fn)(const char *, size_t), const char *buf, size_t len, int iters) {
+    volatile int sink = 0;
+    uint64_t start = get_time_us();
+    for (int i = 0; i < iters; i++) sink += fn(buf, len);
+    uint64_t us = get_time_us() - start;
+    (void)sink;
+    return us ? (double)len * iters / us : 0.0;  // bytes/us == MB/s
+}
+
+static void bench_utf8(void) {
+    printf("\n\033[1m[7] UTF-8 Validation (%s)\033[0m\n", pg_utf8_impl_name());
+
+    // Titles/summaries: mostly Latin with accents, some CJK and emoji
+    static const char *pieces[] = { "The Movie Title ", "Am\xC3\xA9lie ", "\xE5\x8D\x83\xE3\x81\xA8 ",
+                                    "Caf\xC3\xA9 ", "\xF0\x9F\x8E\xAC ", "Season 1 Episode 2 " };
+    size_t sizes[] = { 64, 1024, 16384 };
+    char *buf = malloc(16384 + 32);
+    for (size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+        size_t len = 0;
+        for (int p = 0; len + 32 < sizes[k]; p = (p + 1) % 6) {
+            size_t plen = strlen(pieces[p]);
+            memcpy(buf + len, pieces[p], plen);
+            len += plen;
+        }
+        int iters = (int)(200000000 / sizes[k]);
+
+        double scalar = utf8_mb_per_s(pg_utf8_valid_scalar, buf, len, iters);
+        double best = utf8_mb_per_s(pg_utf8_valid, buf, len, iters);
+        printf("  %5zu bytes: scalar %7.0f MB/s, %s %7.0f MB/s  \033[32m%.1fx\033[0m\n",
+               len, scalar, pg_utf8_impl_name(), best, scalar > 0 ? best / scalar : 0.0);
+    }
+    free(buf);
+}
+
+// ============================================================================
+// Benchmark 8: BYTEA Hex Codec
+// ============================================================================
+
+static void bench_hex(void) {
+    printf("\n\033[1m[8] BYTEA Hex Encode/Decode, 4MB blob (%s)\033[0m\n", pg_hex_impl_name());
+
+    size_t len = 4 * 1024 * 1024;
+    int iters = 20;
+    unsigned char *bin = malloc(len);
+    char *hex = malloc(len * 2);
+    for (size_t i = 0; i < len; i++) bin[i] = (unsigned char)(i * 131 + (i >> 7));
+    volatile int sink = 0;
+
+    uint64_t start = get_time_us();
+    for (int i = 0; i < iters; i++) pg_hex_encode_scalar(hex, bin, len);
+    uint64_t enc_scalar = get_time_us() - start;
+    start = get_time_us();
+    for (int i = 0; i < iters; i++) pg_hex_encode(hex, bin, len);
+    uint64_t enc_simd = get_time_us() - start;
+
+    start = get_time_us();
+    for (int i = 0; i < iters; i++) sink += pg_hex_decode_scalar(bin, hex, len);
+    uint64_t dec_scalar = get_time_us() - start;
+    start = get_time_us();
+    for (int i = 0; i < iters; i++) sink += pg_hex_decode(bin, hex, len);
+    uint64_t dec_simd = get_time_us() - start;
+    (void)sink;
+
+    double mb = (double)len * iters;  // bytes/us == MB/s (binary side)
+    printf("  encode: scalar %6.0f MB/s, %s %6.0f MB/s  \033[32m%.1fx\033[0m\n",
+           mb / enc_scalar, pg_hex_impl_name(), mb / enc_simd, (double)enc_scalar / enc_simd);
+    printf("  decode: scalar %6.0f MB/s, %s %6.0f MB/s  \033[32m%.1fx\033[0m\n",
+           mb / dec_scalar, pg_hex_impl_name(), mb / dec_simd, (double)dec_scalar / dec_simd);
+    free(bin);
+    free(hex);
+}
+
 // ============================================================================
 // Main
 // ============================================================================
@@ -246,6 +385,9 @@ int main(void) {
     bench_string_replace();
     bench_cache_lookup();
     bench_full_pipeline();
+    bench_stmt_lock();
+    bench_utf8();
+    bench_hex();
 
     sql_translator_cleanup();
 
@@ -254,6 +396,7 @@ int main(void) {
     printf("Typical query latency breakdown:\n");
     printf("  - SQL translation:  ~10-50 µs\n");
     printf("  - Cache lookup:     ~10-50 ns\n");
+    printf("  - Statement locks:  ~0.1-1 µs per row\n");
     printf("  - PostgreSQL query: ~1-10 ms (network + query)\n");
     printf("\nShim overhead is <1%% of total query time.\n\n");
 
@@ -0,0 +1,375 @@
+/*
+ * Unit tests for the biased statement lock (pg_bias_lock.c)
+ *
+ * Links the real module.
+ *
+ * Tests:
+ * 1. Recursive locking on the mutex path and the biased path
+ * 2. Lock biases to a thread after two acquisitions in a row
+ * 3. Another thread revokes the bias and gets the lock
+ * 4. Revocation waits for the owner's critical section
+ * 5. Mutual exclusion under contention (shared counter)
+ * 6. trylock: EBUSY for a lock biased to / held by another thread
+ * 7. Locks revoked PG_BIAS_MAX_REVOKES times stay unbiased
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#include "pg_bias_lock.h"
+
+// Test counters
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST(name) printf("  Testing: %s... ", name)
+#define PASS() do { printf("\033[32mPASS\033[0m\n"); tests_passed++; } while(0)
+#define FAIL(msg) do { printf("\033[31mFAIL: %s\033[0m\n", msg); tests_failed++; } while(0)
+
+static int is_biased_to_me(pg_bias_lock_t *l) {
+    return atomic_load(&l->owner) == (uintptr_t)pthread_self();
+}
+
+static void *lock_unlock_once(void *arg) {
+    pg_bias_lock_t *l = arg;
+    pg_bias_lock(l);
+    pg_bias_unlock(l);
+    return NULL;
+}
+
+static void run_in_thread(void *(*fn)(void *), void *arg) {
+    pthread_t t;
+    pthread_create(&t, NULL, fn, arg);
+    pthread_join(t, NULL);
+}
+
+// ============================================================================
+// Test 1: Recursion
+// ============================================================================
+
+static void test_recursion(void) {
+    TEST("Recursive lock on mutex and biased paths");
+
+    pg_bias_lock_t l;
+    pg_bias_lock_init(&l);
+
+    for (int round = 0; round < 4; round++) {
+        pg_bias_lock(&l);
+        pg_bias_lock(&l);
+        pg_bias_lock(&l);
+        pg_bias_unlock(&l);
+        pg_bias_unlock(&l);
+        pg_bias_unlock(&l);
+    }
+
+    // Fully released - another thread can take it
+    run_in_thread(lock_unlock_once, &l);
+    if (pg_bias_trylock(&l) != 0) {
+        FAIL("lock not free after balanced lock/unlock");
+        pg_bias_lock_destroy(&l);
+        return;
+    }
+    pg_bias_unlock(&l);
+    if (atomic_load(&l.depth) != 0) {
+        FAIL("depth not back to 0");
+        pg_bias_lock_destroy(&l);
+        return;
+    }
+
+    pg_bias_lock_destroy(&l);
+    PASS();
+}
+
+// ============================================================================
+// Test 2: Biasing
+// ============================================================================
+
+static void test_bias_after_two(void) {
+    TEST("Bias after two acquisitions by the same thread");
+
+    pg_bias_lock_t l;
+    pg_bias_lock_init(&l);
+
+    pg_bias_lock(&l);
+    pg_bias_unlock(&l);
+    if (is_biased_to_me(&l)) {
+        FAIL("biased after a single acquisition");
+        pg_bias_lock_destroy(&l);
+        return;
+    }
+
+    pg_bias_lock(&l);  // Biased here, still holding the mutex
+    pg_bias_unlock(&l);
+    if (!is_biased_to_me(&l)) {
+        FAIL("not biased after two acquisitions");
+        pg_bias_lock_destroy(&l);
+        return;
+    }
+
+    // Fast path from now on - the mutex stays with us, depth counts
+    pg_bias_lock(&l);
+    int depth = atomic_load(&l.depth);
+    pg_bias_unlock(&l);
+    if (depth != 1 || atomic_load(&l.depth) != 0) {
+        FAIL("biased path did not count depth");
+        pg_bias_lock_destroy(&l);
+        return;
+    }
+
+    pg_bias_lock_destroy(&l);
+    PASS();
+}
+
+// ============================================================================
+// Test 3: Revocation
+// ============================================================================
+
+static void bias_to_self(pg_bias_lock_t *l) {
+    for (int i = 0; i < 3; i++) {
+        pg_bias_lock(l);
+        pg_bias_unlock(l);
+    }
+}
+
+static void test_revoke(void) {
+    TEST("Another thread revokes the bias");
+
+    pg_bias_lock_t l;
+    pg_bias_lock_init(&l);
+    bias_to_self(&l);
+    if (!is_biased_to_me(&l)) {
+        FAIL("setup: not biased");
+        pg_bias_lock_destroy(&l);
+        return;
+    }
+
+    run_in_thread(lock_unlock_once, &l);
+    if (atomic_load(&l.owner) != 0 || l.revocations != 1) {
+        FAIL("bias not revoked");
+        pg_bias_lock_destroy(&l);
+        return;
+    }
+
+    // We still get the lock (mutex path), and it re-biases to us
+    bias_to_self(&l);
+    if (!is_biased_to_me(&l)) {
+        FAIL("did not re-bias to the original thread");
+        pg_bias_lock_destroy(&l);
+        return;
+    }
+
+    pg_bias_lock_destroy(&l);
+    PASS();
+}
+
+// ============================================================================
+// Test 4: Revocation waits for the owner's critical section
+// ============================================================================
+
+typedef struct {
+    pg_bias_lock_t *lock;
+    atomic_int in_section;
+    atomic_int got_lock_while_held;
+} revoke_wait_arg_t;
+
+static void *revoker_thread(void *p) {
+    revoke_wait_arg_t *a = p;
+    pg_bias_lock(a->lock);
+    if (atomic_load(&a->in_section)) atomic_store(&a->got_lock_while_held, 1);
+    pg_bias_unlock(a->lock);
+    return NULL;
+}
+
+static void test_revoke_waits(void) {
+    TEST("Revocation waits for the owner to unlock");
+
+    pg_bias_lock_t l;
+    pg_bias_lock_init(&l);
+    bias_to_self(&l);
+
+    revoke_wait_arg_t a = { .lock = &l };
+    pg_bias_lock(&l);  // Biased path
+    atomic_store(&a.in_section, 1);
+
+    pthread_t t;
+    pthread_create(&t, NULL, revoker_thread, &a);
+    usleep(20000);
+    atomic_store(&a.in_section, 0);
+    pg_bias_unlock(&l);
+    pthread_join(t, NULL);
+
+    if (atomic_load(&a.got_lock_while_held)) {
+        FAIL("revoker entered while the owner held the lock");
+        pg_bias_lock_destroy(&l);
+        return;
+    }
+
+    pg_bias_lock_destroy(&l);
+    PASS();
+}
+
+// ============================================================================
+// Test 5: Mutual exclusion under contention
+// ============================================================================
+
+#define STRESS_THREADS 4
+#define STRESS_ITERS 20000
+
+typedef struct {
+    pg_bias_lock_t *lock;
+    long *counter;
+    int burst;  // Consecutive acquisitions before yielding (lets biases form)
+} stress_arg_t;
+
+static void *stress_thread(void *p) {
+    stress_arg_t *a = p;
+    for (int i = 0; i < STRESS_ITERS; i++) {
+        pg_bias_lock(a->lock);
+        pg_bias_lock(a->lock);  // Nested, like bind -> column
+        long v = *a->counter;
+        *a->counter = v + 1;
+        pg_bias_unlock(a->lock);
+        pg_bias_unlock(a->lock);
+        if (i % a->burst == 0) sched_yield();
+    }
+    return NULL;
+}
+
+static void test_mutual_exclusion(void) {
+    TEST("Mutual exclusion under contention");
+
+    pg_bias_lock_t l;
+    pg_bias_lock_init(&l);
+    long counter = 0;
+
+    pthread_t threads[STRESS_THREADS];
+    stress_arg_t args[STRESS_THREADS];
+    for (int i = 0; i < STRESS_THREADS; i++) {
+        args[i] = (stress_arg_t){ &l, &counter, 1 + i * 500 };
+        pthread_create(&threads[i], NULL, stress_thread, &args[i]);
+    }
+    for (int i = 0; i < STRESS_THREADS; i++) pthread_join(threads[i], NULL);
+
+    if (counter != (long)STRESS_THREADS * STRESS_ITERS) {
+        char msg[96];
+        snprintf(msg, sizeof(msg), "counter=%ld, expected %ld", counter, (long)STRESS_THREADS * STRESS_ITERS);
+        FAIL(msg);
+        pg_bias_lock_destroy(&l);
+        return;
+    }
+
+    pg_bias_lock_destroy(&l);
+    PASS();
+}
+
+// ============================================================================
+// Test 6: trylock
+// ============================================================================
+
+static void *trylock_thread(void *p) {
+    pg_bias_lock_t *l = p;
+    int rc = pg_bias_trylock(l);
+    if (rc == 0) pg_bias_unlock(l);
+    return (void *)(intptr_t)rc;
+}
+
+static void test_trylock(void) {
+    TEST("trylock never waits or revokes");
+
+    pg_bias_lock_t l;
+    pg_bias_lock_init(&l);
+    bias_to_self(&l);
+
+    // Biased to us, not held: another thread gets EBUSY and the bias survives
+    pthread_t t;
+    void *rc;
+    pthread_create(&t, NULL, trylock_thread, &l);
+    pthread_join(t, &rc);
+    if ((intptr_t)rc != EBUSY || !is_biased_to_me(&l)) {
+        FAIL("trylock on a lock biased to another thread");
+        pg_bias_lock_destroy(&l);
+        return;
+    }
+
+    // Owner's trylock takes the fast path
+    if (pg_bias_trylock(&l) != 0) {
+        FAIL("owner trylock failed");
+        pg_bias_lock_destroy(&l);
+        return;
+    }
+    pg_bias_unlock(&l);
+
+    // Unbiased and held by us: EBUSY from the mutex
+    run_in_thread(lock_unlock_once, &l);  // Revoke
+    pg_bias_lock(&l);
+    pthread_create(&t, NULL, trylock_thread, &l);
+    pthread_join(t, &rc);
+    pg_bias_unlock(&l);
+    if ((intptr_t)rc != EBUSY) {
+        FAIL("trylock on a held mutex did not return EBUSY");
+        pg_bias_lock_destroy(&l);
+        return;
+    }
+
+    pg_bias_lock_destroy(&l);
+    PASS();
+}
+
+// ============================================================================
+// Test 7: Revocation limit
+// ============================================================================
+
+static void test_revoke_limit(void) {
+    TEST("Stays unbiased after PG_BIAS_MAX_REVOKES revocations");
+
+    pg_bias_lock_t l;
+    pg_bias_lock_init(&l);
+
+    for (int i = 0; i < PG_BIAS_MAX_REVOKES + 2; i++) {
+        bias_to_self(&l);
+        run_in_thread(lock_unlock_once, &l);
+    }
+    bias_to_self(&l);
+
+    if (is_biased_to_me(&l) || l.revocations != PG_BIAS_MAX_REVOKES) {
+        char msg[96];
+        snprintf(msg, sizeof(msg), "biased=%d revocations=%d", is_biased_to_me(&l), l.revocations);
+        FAIL(msg);
+        pg_bias_lock_destroy(&l);
+        return;
+    }
+
+    pg_bias_lock_destroy(&l);
+    PASS();
+}
+
+// ============================================================================
+// Main
+// ============================================================================
+
+int main(void) {
+    printf("\n\033[1m=== Biased Statement Lock Tests ===\033[0m\n\n");
+
+    if (!pg_bias_lock_enabled()) {
+        // No membarrier here: nothing biases, the lock is a recursive mutex
+        printf("  (membarrier unavailable - testing the plain mutex path only)\n\n");
+        test_recursion();
+        test_mutual_exclusion();
+    } else {
+        test_recursion();
+        test_bias_after_two();
+        test_revoke();
+        test_revoke_waits();
+        test_mutual_exclusion();
+        test_trylock();
+        test_revoke_limit();
+    }
+
+    printf("\n\033[1mResults: %d passed, %d failed\033[0m\n\n", tests_passed, tests_failed);
+    return tests_failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,481 @@
+/*
+ * Unit tests for Binary Parameter Transfer
+ *
+ * Tests:
+ * 1. Network-order encoding of int8/int4/int2
+ * 2. float8/float4 encoding round-trips through the IEEE bit image
+ * 3. int binds narrow to int4/int2 only when the value fits
+ * 4. Unmatched server types fall back to text
+ * 5. Blob binds stay raw for bytea, hex text otherwise
+ * 6. Param arrays start inline and keep bound values when they grow
+ * 7. Describe failures: parse/type errors pin text-only, transient ones retry
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <arpa/inet.h>
+
+// Test counters
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST(name) printf("  Testing: %s... ", name)
+#define PASS() do { printf("\033[32mPASS\033[0m\n"); tests_passed++; } while(0)
+#define FAIL(msg) do { printf("\033[31mFAIL: %s\033[0m\n", msg); tests_failed++; } while(0)
+
+// ============================================================================
+// Replicate encoding logic from db_interpose_bind.c
+// ============================================================================
+
+#define PG_OID_BYTEA  17
+#define PG_OID_INT8   20
+#define PG_OID_INT2   21
+#define PG_OID_INT4   23
+#define PG_OID_TEXT   25
+#define PG_OID_FLOAT4 700
+#define PG_OID_FLOAT8 701
+
+typedef union {
+    int64_t i;
+    double d;
+} native_t;
+
+static inline void put_be16(char *dst, uint16_t v) {
+    dst[0] = (char)(v >> 8);
+    dst[1] = (char)v;
+}
+
+static inline void put_be32(char *dst, uint32_t v) {
+    dst[0] = (char)(v >> 24);
+    dst[1] = (char)(v >> 16);
+    dst[2] = (char)(v >> 8);
+    dst[3] = (char)v;
+}
+
+static inline void put_be64(char *dst, uint64_t v) {
+    put_be32(dst, (uint32_t)(v >> 32));
+    put_be32(dst + 4, (uint32_t)v);
+}
+
+static int encode_binary_param(unsigned bound, native_t v, unsigned server_type, char *wire) {
+    if (bound == PG_OID_INT8) {
+        switch (server_type) {
+            case PG_OID_INT8:
+                put_be64(wire, (uint64_t)v.i);
+                return 8;
+            case PG_OID_INT4:
+                if (v.i < INT32_MIN || v.i > INT32_MAX) return 0;
+                put_be32(wire, (uint32_t)(int32_t)v.i);
+                return 4;
+            case PG_OID_INT2:
+                if (v.i < INT16_MIN || v.i > INT16_MAX) return 0;
+                put_be16(wire, (uint16_t)(int16_t)v.i);
+                return 2;
+            case PG_OID_FLOAT8: {
+                double d = (double)v.i;
+                uint64_t bits;
+                memcpy(&bits, &d, sizeof(bits));
+                put_be64(wire, bits);
+                return 8;
+            }
+            default:
+                return 0;
+        }
+    }
+    if (bound == PG_OID_FLOAT8) {
+        if (server_type == PG_OID_FLOAT8) {
+            uint64_t bits;
+            memcpy(&bits, &v.d, sizeof(bits));
+            put_be64(wire, bits);
+            return 8;
+        }
+        if (server_type == PG_OID_FLOAT4) {
+            float f = (float)v.d;
+            uint32_t bits;
+            memcpy(&bits, &f, sizeof(bits));
+            put_be32(wire, bits);
+            return 4;
+        }
+    }
+    return 0;
+}
+
+// Decoders mirror PostgreSQL's int8recv/int4recv/float8recv
+static int64_t get_be64(const char *src) {
+    uint32_t hi, lo;
+    memcpy(&hi, src, 4);
+    memcpy(&lo, src + 4, 4);
+    return (int64_t)(((uint64_t)ntohl(hi) << 32) | ntohl(lo));
+}
+
+static int32_t get_be32(const char *src) {
+    uint32_t v;
+    memcpy(&v, src, 4);
+    return (int32_t)ntohl(v);
+}
+
+static int16_t get_be16(const char *src) {
+    uint16_t v;
+    memcpy(&v, src, 2);
+    return (int16_t)ntohs(v);
+}
+
+// ============================================================================
+// Integer Tests
+// ============================================================================
+
+static void test_int8_roundtrip(void) {
+    TEST("int8 - network order round-trip");
+
+    int64_t samples[] = {0, 1, -1, 42, INT64_MAX, INT64_MIN, 1234567890123LL};
+    char wire[8];
+    for (size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); i++) {
+        native_t v = {.i = samples[i]};
+        if (encode_binary_param(PG_OID_INT8, v, PG_OID_INT8, wire) != 8 ||
+            get_be64(wire) != samples[i]) {
+            FAIL("int8 value did not round-trip");
+            return;
+        }
+    }
+    PASS();
+}
+
+static void test_int8_byte_order(void) {
+    TEST("int8 - most significant byte first");
+
+    native_t v = {.i = 0x0102030405060708LL};
+    char wire[8];
+    encode_binary_param(PG_OID_INT8, v, PG_OID_INT8, wire);
+    if (wire[0] == 0x01 && wire[7] == 0x08) {
+        PASS();
+    } else {
+        FAIL("wrong byte order");
+    }
+}
+
+static void test_int4_narrowing(void) {
+    TEST("int4 - narrows when value fits");
+
+    native_t v = {.i = -123456};
+    char wire[8];
+    if (encode_binary_param(PG_OID_INT8, v, PG_OID_INT4, wire) == 4 && get_be32(wire) == -123456) {
+        PASS();
+    } else {
+        FAIL("int4 narrowing failed");
+    }
+}
+
+static void test_int4_overflow_falls_back(void) {
+    TEST("int4 - out-of-range value falls back to text");
+
+    native_t v = {.i = (int64_t)INT32_MAX + 1};
+    char wire[8];
+    if (encode_binary_param(PG_OID_INT8, v, PG_OID_INT4, wire) == 0) {
+        PASS();
+    } else {
+        FAIL("should not encode out-of-range int4");
+    }
+}
+
+static void test_int2_narrowing(void) {
+    TEST("int2 - narrows when value fits, text otherwise");
+
+    native_t small = {.i = -300};
+    native_t big = {.i = 70000};
+    char wire[8];
+    int ok = encode_binary_param(PG_OID_INT8, small, PG_OID_INT2, wire) == 2 && get_be16(wire) == -300;
+    ok = ok && encode_binary_param(PG_OID_INT8, big, PG_OID_INT2, wire) == 0;
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("int2 narrowing wrong");
+    }
+}
+
+static void test_int_to_text_column(void) {
+    TEST("int bound against TEXT param stays text");
+
+    native_t v = {.i = 5};
+    char wire[8];
+    if (encode_binary_param(PG_OID_INT8, v, PG_OID_TEXT, wire) == 0 &&
+        encode_binary_param(PG_OID_INT8, v, 0, wire) == 0) {
+        PASS();
+    } else {
+        FAIL("int should not be sent binary to text/unknown param");
+    }
+}
+
+// ============================================================================
+// Float Tests
+// ============================================================================
+
+static void test_float8_roundtrip(void) {
+    TEST("float8 - IEEE bits round-trip");
+
+    native_t v = {.d = 3.141592653589793};
+    char wire[8];
+    if (encode_binary_param(PG_OID_FLOAT8, v, PG_OID_FLOAT8, wire) != 8) {
+        FAIL("float8 not encoded");
+        return;
+    }
+    int64_t bits = get_be64(wire);
+    double d;
+    memcpy(&d, &bits, sizeof(d));
+    if (d == v.d) {
+        PASS();
+    } else {
+        FAIL("float8 value changed");
+    }
+}
+
+static void test_float4_roundtrip(void) {
+    TEST("float4 - encodes single precision");
+
+    native_t v = {.d = 1.5};
+    char wire[8];
+    if (encode_binary_param(PG_OID_FLOAT8, v, PG_OID_FLOAT4, wire) != 4) {
+        FAIL("float4 not encoded");
+        return;
+    }
+    int32_t bits = get_be32(wire);
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    if (f == 1.5f) {
+        PASS();
+    } else {
+        FAIL("float4 value changed");
+    }
+}
+
+static void test_int_to_float8(void) {
+    TEST("int bound against float8 param");
+
+    native_t v = {.i = 1000};
+    char wire[8];
+    if (encode_binary_param(PG_OID_INT8, v, PG_OID_FLOAT8, wire) != 8) {
+        FAIL("int -> float8 not encoded");
+        return;
+    }
+    int64_t bits = get_be64(wire);
+    double d;
+    memcpy(&d, &bits, sizeof(d));
+    if (d == 1000.0) {
+        PASS();
+    } else {
+        FAIL("int -> float8 value wrong");
+    }
+}
+
+static void test_double_to_int_stays_text(void) {
+    TEST("double bound against int param stays text");
+
+    native_t v = {.d = 2.5};
+    char wire[8];
+    if (encode_binary_param(PG_OID_FLOAT8, v, PG_OID_INT8, wire) == 0) {
+        PASS();
+    } else {
+        FAIL("double must not be truncated into int8");
+    }
+}
+
+// ============================================================================
+// Blob Tests
+// ============================================================================
+
+// Replicates the bytea decision in pg_build_exec_params
+static int blob_goes_binary(int types_known, unsigned server_type) {
+    return types_known && server_type == PG_OID_BYTEA;
+}
+
+static void test_blob_binary_for_bytea(void) {
+    TEST("blob - raw bytes when server param is bytea");
+
+    if (blob_goes_binary(1, PG_OID_BYTEA) && !blob_goes_binary(0, 0) &&
+        !blob_goes_binary(1, PG_OID_TEXT)) {
+        PASS();
+    } else {
+        FAIL("blob format decision wrong");
+    }
+}
+
+// ============================================================================
+// Param Storage Tests
+// ============================================================================
+
+// Replicates layout_params / pg_stmt_reserve_params from pg_statement.c
+#define MAX_PARAMS 256
+#define INLINE_PARAMS 8
+#define SLOT_BYTES (sizeof(char *) + sizeof(native_t) + 2 * sizeof(int) + 2 * sizeof(unsigned) + 32 + 8)
+
+typedef struct {
+    char **values;
+    native_t *native;
+    int *lengths;
+    int *formats;
+    unsigned *types;
+    unsigned *server_types;
+    char (*buffers)[32];
+    char (*wire)[8];
+    int cap;
+    void *heap;
+    _Alignas(8) unsigned char inline_slots[INLINE_PARAMS * SLOT_BYTES];
+} params_t;
+
+static void layout(params_t *s, unsigned char *p, int n) {
+    s->values = (char **)p;             p += n * sizeof(char *);
+    s->native = (native_t *)p;          p += n * sizeof(native_t);
+    s->lengths = (int *)p;              p += n * sizeof(int);
+    s->formats = (int *)p;              p += n * sizeof(int);
+    s->types = (unsigned *)p;           p += n * sizeof(unsigned);
+    s->server_types = (unsigned *)p;    p += n * sizeof(unsigned);
+    s->buffers = (char (*)[32])p;       p += n * 32;
+    s->wire = (char (*)[8])p;
+    s->cap = n;
+}
+
+static int reserve(params_t *s, int n) {
+    if (n <= s->cap) return 1;
+    if (n > MAX_PARAMS) return 0;
+    unsigned char *block = calloc((size_t)n, SLOT_BYTES);
+    if (!block) return 0;
+
+    int old_n = s->cap;
+    char **values = s->values;
+    native_t *native = s->native;
+    unsigned *types = s->types;
+    char (*buffers)[32] = s->buffers;
+
+    layout(s, block, n);
+    memcpy(s->native, native, old_n * sizeof(*native));
+    memcpy(s->types, types, old_n * sizeof(unsigned));
+    memcpy(s->buffers, buffers, old_n * sizeof(*buffers));
+    for (int i = 0; i < old_n; i++) {
+        int in_buffer = values[i] >= buffers[i] && values[i] < buffers[i] + 32;
+        s->values[i] = in_buffer ? s->buffers[i] : values[i];
+    }
+    free(s->heap);
+    s->heap = block;
+    return 1;
+}
+
+static void bind_int(params_t *s, int i, int64_t v) {
+    snprintf(s->buffers[i], 32, "%lld", (long long)v);
+    s->values[i] = s->buffers[i];
+    s->native[i].i = v;
+    s->types[i] = PG_OID_INT8;
+}
+
+static void test_param_storage_growth(void) {
+    TEST("param arrays - inline up to 8, values survive growth");
+
+    params_t s;
+    memset(&s, 0, sizeof(s));
+    layout(&s, s.inline_slots, INLINE_PARAMS);
+
+    char *text = strdup("title");
+    bind_int(&s, 0, 42);
+    s.values[1] = text;
+    bind_int(&s, 7, -7);
+    int ok = reserve(&s, 8) && s.heap == NULL;                  // Still inline
+
+    ok = ok && reserve(&s, 20) && s.heap != NULL && s.cap == 20;
+    ok = ok && s.values[0] == s.buffers[0] && strcmp(s.values[0], "42") == 0;
+    ok = ok && s.values[1] == text;                             // Heap value kept as-is
+    ok = ok && s.values[7] == s.buffers[7] && s.native[7].i == -7 && s.types[7] == PG_OID_INT8;
+    ok = ok && s.values[19] == NULL && s.types[19] == 0;        // New slots zeroed
+    ok = ok && ((uintptr_t)s.native % 8) == 0;                  // Still aligned for int64
+    ok = ok && !reserve(&s, MAX_PARAMS + 1) && s.cap == 20;     // Over the limit - unchanged
+
+    free(text);
+    free(s.heap);
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("param slots not preserved across growth");
+    }
+}
+
+// ============================================================================
+// Describe failures (replicates describe_error_is_permanent / describe_failed)
+// ============================================================================
+
+#define PG_PARAM_DESCRIBE_TRIES 3
+
+static int describe_error_is_permanent(const char *state) {
+    if (!state || strncmp(state, "42", 2) != 0) return 0;
+    return strcmp(state, "42P01") != 0 && strcmp(state, "42703") != 0 && strcmp(state, "42704") != 0;
+}
+
+typedef struct {
+    int known;
+    int failures;
+} describe_state_t;
+
+static void describe_failed(describe_state_t *d, const char *state) {
+    if (describe_error_is_permanent(state) || ++d->failures >= PG_PARAM_DESCRIBE_TRIES) d->known = -1;
+}
+
+static void test_describe_failures(void) {
+    TEST("describe failures - only parse/type errors pin text-only");
+
+    describe_state_t syntax = {0}, types = {0}, conn = {0}, ddl = {0}, timeout = {0};
+    describe_failed(&syntax, "42601");       // syntax_error
+    describe_failed(&types, "42P18");        // indeterminate_datatype
+    describe_failed(&conn, NULL);            // Connection lost - no SQLSTATE
+    describe_failed(&ddl, "42P01");          // Table dropped/recreated concurrently
+    describe_failed(&timeout, "57014");      // statement timeout
+    int ok = syntax.known == -1 && types.known == -1 &&
+             conn.known == 0 && ddl.known == 0 && timeout.known == 0;
+
+    // Transient failures are retried, but not forever
+    describe_failed(&conn, "08006");
+    ok = ok && conn.known == 0;
+    describe_failed(&conn, NULL);
+    ok = ok && conn.known == -1 && conn.failures == PG_PARAM_DESCRIBE_TRIES;
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("wrong retry/pin decision");
+    }
+}
+
+// ============================================================================
+// Main
+// ============================================================================
+
+int main(void) {
+    printf("\n\033[1m=== Binary Parameter Tests ===\033[0m\n\n");
+
+    printf("\033[1mIntegers:\033[0m\n");
+    test_int8_roundtrip();
+    test_int8_byte_order();
+    test_int4_narrowing();
+    test_int4_overflow_falls_back();
+    test_int2_narrowing();
+    test_int_to_text_column();
+
+    printf("\n\033[1mFloats:\033[0m\n");
+    test_float8_roundtrip();
+    test_float4_roundtrip();
+    test_int_to_float8();
+    test_double_to_int_stays_text();
+
+    printf("\n\033[1mBlobs:\033[0m\n");
+    test_blob_binary_for_bytea();
+
+    printf("\n\033[1mParam Storage:\033[0m\n");
+    test_param_storage_growth();
+
+    printf("\n\033[1mParam Type Describe:\033[0m\n");
+    test_describe_failures();
+
+    printf("\n\033[1m=== Results ===\033[0m\n");
+    printf("Passed: \033[32m%d\033[0m\n", tests_passed);
+    printf("Failed: \033[31m%d\033[0m\n", tests_failed);
+    printf("\n");
+
+    return tests_failed > 0 ? 1 : 0;
+}
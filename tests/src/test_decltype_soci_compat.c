@@ -21,6 +21,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <strings.h>  // for strcasecmp
+#include <stdint.h>
 
 // Test counters
 static int tests_passed = 0;
@@ -587,6 +588,318 @@ static void test_plex_types_maintain_consistency(void) {
     }
 }
 
+// ============================================================================
+// Test 6: Decltype table perfect hash (replicates db_interpose_column.c)
+// Every metadata row must be found - the old 1024-slot table with 8 probes
+// silently dropped rows on collision
+// ============================================================================
+
+#define DECLTYPE_EMPTY UINT32_MAX
+#define DECLTYPE_MAX_DISPLACEMENT 4096
+#define DECLTYPE_HASH_INIT 14695981039346656037ULL
+
+typedef struct {
+    uint32_t key;
+    uint32_t raw;
+} ph_slot_t;
+
+typedef struct {
+    uint32_t bucket_mask;
+    uint32_t slot_mask;
+    uint32_t *displacement;
+    ph_slot_t *slots;
+    const char *strings;
+} ph_table_t;
+
+typedef struct {
+    uint32_t key;
+    uint32_t raw;
+    uint64_t hash;
+} ph_key_t;
+
+static uint64_t ph_hash_part(uint64_t h, const char *s, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static uint64_t ph_hash_final(uint64_t h) {
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+static uint32_t ph_slot_of(uint64_t h, uint32_t d, uint32_t mask) {
+    return ((uint32_t)h + d * ((uint32_t)(h >> 40) | 1)) & mask;
+}
+
+static uint32_t ph_bucket_of(uint64_t h, uint32_t mask) {
+    return (uint32_t)(h >> 32) & mask;
+}
+
+static uint32_t ph_pow2(uint32_t n) {
+    uint32_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+// Largest buckets first, each gets the first displacement that fits
+static int ph_place(ph_table_t *t, const ph_key_t *keys, int n) {
+    uint32_t nbuckets = t->bucket_mask + 1;
+    for (uint32_t i = 0; i <= t->slot_mask; i++) t->slots[i].key = DECLTYPE_EMPTY;
+    int *size = calloc(nbuckets, sizeof(int));
+    int (*members)[64] = calloc(nbuckets, sizeof(*members));
+    for (int i = 0; i < n; i++) {
+        uint32_t b = ph_bucket_of(keys[i].hash, t->bucket_mask);
+        if (size[b] == 64) {
+            free(size);
+            free(members);
+            return 0;
+        }
+        members[b][size[b]++] = i;
+    }
+    int ok = 1;
+    for (int want = 64; want > 0 && ok; want--) {
+        for (uint32_t b = 0; b < nbuckets && ok; b++) {
+            if (size[b] != want) continue;
+            ok = 0;
+            uint32_t placed[64];
+            for (uint32_t d = 0; d < DECLTYPE_MAX_DISPLACEMENT && !ok; d++) {
+                int fits = 1;
+                for (int m = 0; m < want && fits; m++) {
+                    uint32_t slot = ph_slot_of(keys[members[b][m]].hash, d, t->slot_mask);
+                    if (t->slots[slot].key != DECLTYPE_EMPTY) fits = 0;
+                    for (int q = 0; q < m && fits; q++) {
+                        if (placed[q] == slot) fits = 0;
+                    }
+                    placed[m] = slot;
+                }
+                if (!fits) continue;
+                t->displacement[b] = d;
+                for (int m = 0; m < want; m++) {
+                    t->slots[placed[m]].key = keys[members[b][m]].key;
+                    t->slots[placed[m]].raw = keys[members[b][m]].raw;
+                }
+                ok = 1;
+            }
+        }
+    }
+    free(size);
+    free(members);
+    return ok;
+}
+
+static const char *ph_sort_strings;
+
+static int ph_key_cmp(const void *a, const void *b) {
+    const ph_key_t *ka = a, *kb = b;
+    int c = strcmp(ph_sort_strings + ka->key, ph_sort_strings + kb->key);
+    return c ? c : (ka->raw > kb->raw) - (ka->raw < kb->raw);  // Earlier row first
+}
+
+// rows: n triples of (table, column, declared type). Returns unique keys.
+static int ph_build(ph_table_t *t, const char *(*rows)[3], int n, char *strings) {
+    ph_key_t *keys = malloc((size_t)n * sizeof(*keys));
+    size_t off = 1;
+    strings[0] = '\0';
+    for (int i = 0; i < n; i++) {
+        keys[i].key = (uint32_t)off;
+        off += (size_t)sprintf(strings + off, "%s_%s", rows[i][0], rows[i][1]) + 1;
+        keys[i].raw = (uint32_t)off;
+        off += (size_t)sprintf(strings + off, "%s", rows[i][2]) + 1;
+        keys[i].hash = ph_hash_final(ph_hash_part(DECLTYPE_HASH_INIT, strings + keys[i].key,
+                                                  strlen(strings + keys[i].key)));
+    }
+    ph_sort_strings = strings;
+    qsort(keys, (size_t)n, sizeof(*keys), ph_key_cmp);
+    int unique = 0;
+    for (int i = 0; i < n; i++) {
+        if (unique > 0 && strcmp(strings + keys[unique - 1].key, strings + keys[i].key) == 0) continue;
+        keys[unique++] = keys[i];
+    }
+
+    uint32_t nbuckets = ph_pow2((uint32_t)(unique / 4 + 1));
+    uint32_t nslots = ph_pow2((uint32_t)(unique * 2 + 16));
+    int ok = 0;
+    for (int attempt = 0; attempt < 4 && !ok; attempt++, nslots <<= 1, nbuckets <<= 1) {
+        t->bucket_mask = nbuckets - 1;
+        t->slot_mask = nslots - 1;
+        t->displacement = calloc(nbuckets, sizeof(uint32_t));
+        t->slots = calloc(nslots, sizeof(ph_slot_t));
+        t->strings = strings;
+        ok = ph_place(t, keys, unique);
+        if (!ok) {
+            free(t->displacement);
+            free(t->slots);
+        }
+    }
+    free(keys);
+    return ok ? unique : -1;
+}
+
+static const char* ph_find(const ph_table_t *t, const char *table, const char *column) {
+    size_t tlen = table ? strlen(table) : 0;
+    uint64_t h = DECLTYPE_HASH_INIT;
+    if (table) {
+        h = ph_hash_part(h, table, tlen);
+        h = ph_hash_part(h, "_", 1);
+    }
+    h = ph_hash_final(ph_hash_part(h, column, strlen(column)));
+    const ph_slot_t *slot = &t->slots[ph_slot_of(h, t->displacement[ph_bucket_of(h, t->bucket_mask)],
+                                                  t->slot_mask)];
+    if (slot->key == DECLTYPE_EMPTY) return NULL;
+    const char *key = t->strings + slot->key;
+    if (table) {
+        if (memcmp(key, table, tlen) != 0 || key[tlen] != '_') return NULL;
+        key += tlen + 1;
+    }
+    return strcmp(key, column) == 0 ? t->strings + slot->raw : NULL;
+}
+
+static void test_decltype_perfect_hash(void) {
+    printf("\n\033[1mTest 6: Decltype table perfect hash\033[0m\n");
+
+    // Bigger than the old 1024-slot table could ever hold
+    enum { N = 3000 };
+    static char names[N][2][32];
+    static const char *rows[N + 1][3];
+    for (int i = 0; i < N; i++) {
+        snprintf(names[i][0], sizeof(names[i][0]), "table%d", i / 20);
+        snprintf(names[i][1], sizeof(names[i][1]), "col_%d", i % 20);
+        rows[i][0] = names[i][0];
+        rows[i][1] = names[i][1];
+        rows[i][2] = (i % 3 == 0) ? "boolean" : (i % 3 == 1) ? "dt_integer(8)" : "varchar(255)";
+    }
+    rows[N][0] = "table0";  // Duplicate of row 0 - the first row wins
+    rows[N][1] = "col_0";
+    rows[N][2] = "blob";
+
+    ph_table_t t;
+    char *strings = malloc((size_t)(N + 1) * 96);
+    int unique = ph_build(&t, rows, N + 1, strings);
+
+    TEST("3000 keys + 1 duplicate -> 3000 placed");
+    if (unique == N) {
+        PASS();
+    } else {
+        FAIL("wrong unique count or no perfect hash");
+        free(strings);
+        return;
+    }
+
+    TEST("Every key found (zero drops), split and joined");
+    {
+        int missing = 0;
+        char joined[64];
+        for (int i = 0; i < N; i++) {
+            snprintf(joined, sizeof(joined), "%s_%s", rows[i][0], rows[i][1]);
+            const char *a = ph_find(&t, rows[i][0], rows[i][1]);
+            const char *b = ph_find(&t, NULL, joined);
+            if (!a || a != b || strcmp(a, rows[i][2]) != 0) missing++;
+        }
+        if (missing == 0) {
+            PASS();
+        } else {
+            char msg[64];
+            snprintf(msg, sizeof(msg), "%d keys not found", missing);
+            FAIL(msg);
+        }
+    }
+
+    TEST("Duplicate row - first one wins");
+    {
+        const char *v = ph_find(&t, "table0", "col_0");
+        if (v && strcmp(v, "boolean") == 0) {
+            PASS();
+        } else {
+            FAIL(v ? v : "(null)");
+        }
+    }
+
+    TEST("Unknown keys not found");
+    {
+        int false_hits = 0;
+        char col[32];
+        for (int i = 0; i < 1000; i++) {
+            snprintf(col, sizeof(col), "nocol_%d", i);
+            if (ph_find(&t, "table1", col)) false_hits++;
+        }
+        if (ph_find(&t, "table", "0_col_0")) false_hits++;  // "table_0_col_0" - not a key
+        if (ph_find(&t, NULL, "table0")) false_hits++;
+        if (false_hits == 0) {
+            PASS();
+        } else {
+            FAIL("unknown key matched");
+        }
+    }
+
+    free(t.displacement);
+    free(t.slots);
+    free(strings);
+}
+
+// ============================================================================
+// Test 7: Decoded row - one decode per step answers every accessor the way
+// the old per-call parsing did (replicates decode_current_row())
+// ============================================================================
+
+static long long decode_int(const char *val) {
+    if (val[0] == 't' && val[1] == '\0') return 1;
+    if (val[0] == 'f' && val[1] == '\0') return 0;
+    return atoll(val);
+}
+
+static double decode_double(const char *val) {
+    if (val[0] == 't' && val[1] == '\0') return 1.0;
+    if (val[0] == 'f' && val[1] == '\0') return 0.0;
+    return atof(val);
+}
+
+static void test_decoded_row(void) {
+    printf("\n\033[1mTest 7: Decoded row matches per-call parsing\033[0m\n");
+
+    static const struct { unsigned int oid; const char *val; } cells[] = {
+        { 23, "42" }, { 20, "9007199254740993" }, { 16, "t" }, { 16, "f" },
+        { 21, "-7" }, { 701, "3.75" }, { 1700, "1e5" }, { 700, "-0.5" },
+        { 25, "123abc" }, { 25, "t" }, { 1043, "" },
+    };
+    int n = (int)(sizeof(cells) / sizeof(cells[0]));
+
+    TEST("int/int64/double/type from one decode");
+    int ok = 1;
+    for (int c = 0; c < n && ok; c++) {
+        const char *val = cells[c].val;
+        int affinity = pg_oid_to_sqlite_type(cells[c].oid);
+        int numeric = affinity == SQLITE_INTEGER || affinity == SQLITE_FLOAT;
+        long long i = numeric ? decode_int(val) : 0;
+        double d = affinity == SQLITE_INTEGER ? (double)i : numeric ? decode_double(val) : 0.0;
+
+        // What the accessors return from the decoded cell
+        int as_int = (int)(numeric ? i : decode_int(val));
+        long long as_int64 = numeric ? i : decode_int(val);
+        double as_double = numeric ? d : decode_double(val);
+
+        // Old per-call parsing
+        int old_int = (val[0] == 't' && !val[1]) ? 1 : (val[0] == 'f' && !val[1]) ? 0 : atoi(val);
+        long long old_int64 = (val[0] == 't' && !val[1]) ? 1 : (val[0] == 'f' && !val[1]) ? 0 : atoll(val);
+        double old_double = (val[0] == 't' && !val[1]) ? 1.0 : (val[0] == 'f' && !val[1]) ? 0.0 : atof(val);
+
+        ok = as_int == old_int && as_int64 == old_int64 && as_double == old_double;
+        if (!ok) {
+            char msg[128];
+            snprintf(msg, sizeof(msg), "oid=%u val='%s'", cells[c].oid, val);
+            FAIL(msg);
+            return;
+        }
+    }
+    PASS();
+}
+
 // ============================================================================
 // Main
 // ============================================================================
@@ -600,6 +913,8 @@ int main(void) {
     test_column_decltype_plex_custom_types();
     test_integer_column_not_treated_as_text();
     test_plex_types_maintain_consistency();
+    test_decltype_perfect_hash();
+    test_decoded_row();
 
     printf("\n\033[1m=== Results ===\033[0m\n");
     printf("Passed: \033[32m%d\033[0m\n", tests_passed);
@@ -0,0 +1,323 @@
+/*
+ * Tests for the sequence ID block allocator (pg_id_block.c)
+ *
+ * Links the real module against a fake libpq defined here: PQexecParams
+ * "runs" the nextval() ... generate_series query on an in-process sequence
+ * per name and counts round trips.
+ *
+ * Tests:
+ * 1. One round trip per block, ids unique and in order
+ * 2. Exhausted block is refilled on the next call
+ * 3. Short block (server returns fewer rows) and failed refill
+ * 4. A refill in flight for one sequence doesn't block another
+ * 5. Concurrent callers on one sequence - no duplicates, no wasted blocks
+ * 6. Reset drops the reserved ids
+ * 7. After fork the child never hands out the parent's reserved ids
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/wait.h>
+
+#include "pg_id_block.h"
+
+// Test counters
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST(name) printf("  Testing: %s... ", name)
+#define PASS() do { printf("\033[32mPASS\033[0m\n"); tests_passed++; } while(0)
+#define FAIL(msg) do { printf("\033[31mFAIL: %s\033[0m\n", msg); tests_failed++; } while(0)
+
+#define BLOCK 8
+
+// ============================================================================
+// Fake libpq
+// ============================================================================
+
+struct pg_conn { int unused; };
+
+struct pg_result {
+    ExecStatusType status;
+    int n;
+    char (*vals)[24];
+};
+
+typedef struct {
+    char name[128];
+    sqlite3_int64 last;          // Last value handed out by "nextval"
+    int round_trips;
+} fake_seq_t;
+
+static fake_seq_t seqs[8];
+static int seq_count = 0;
+static pthread_mutex_t seq_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static atomic_int short_rows = 0;        // > 0: next refill returns this many rows
+static atomic_int fail_next = 0;         // Next refill fails
+static atomic_int hold_refill = 0;       // Refills of "plex.slow_seq" wait for release
+static atomic_int refill_started = 0;
+static atomic_int refill_release = 0;
+static atomic_int refill_done = 0;
+
+static fake_seq_t* fake_seq(const char *name) {
+    for (int i = 0; i < seq_count; i++) {
+        if (strcmp(seqs[i].name, name) == 0) return &seqs[i];
+    }
+    fake_seq_t *s = &seqs[seq_count++];
+    snprintf(s->name, sizeof(s->name), "%s", name);
+    s->last = 1000 * seq_count;
+    return s;
+}
+
+PGresult *PQexecParams(PGconn *conn, const char *command, int nParams,
+                       const Oid *paramTypes, const char *const *paramValues,
+                       const int *paramLengths, const int *paramFormats, int resultFormat) {
+    (void)conn; (void)command; (void)nParams; (void)paramTypes;
+    (void)paramLengths; (void)paramFormats; (void)resultFormat;
+
+    PGresult *res = calloc(1, sizeof(PGresult));
+    if (atomic_exchange(&fail_next, 0)) {
+        res->status = PGRES_FATAL_ERROR;
+        return res;
+    }
+    if (atomic_load(&hold_refill) && strcmp(paramValues[0], "plex.slow_seq") == 0) {
+        atomic_store(&refill_started, 1);
+        for (int i = 0; i < 2000 && !atomic_load(&refill_release); i++) usleep(1000);
+        atomic_store(&refill_done, 1);
+    }
+
+    int n = atoi(paramValues[1]);
+    int rows = atomic_exchange(&short_rows, 0);
+    if (rows > 0 && rows < n) n = rows;
+
+    res->status = PGRES_TUPLES_OK;
+    res->n = n;
+    res->vals = calloc((size_t)n, sizeof(*res->vals));
+    pthread_mutex_lock(&seq_mutex);
+    fake_seq_t *s = fake_seq(paramValues[0]);
+    s->round_trips++;
+    for (int i = 0; i < n; i++) snprintf(res->vals[i], sizeof(res->vals[i]), "%lld", (long long)++s->last);
+    pthread_mutex_unlock(&seq_mutex);
+    return res;
+}
+
+ExecStatusType PQresultStatus(const PGresult *res) { return res ? res->status : PGRES_FATAL_ERROR; }
+int PQntuples(const PGresult *res) { return res ? res->n : 0; }
+char *PQgetvalue(const PGresult *res, int row, int col) { (void)col; return res->vals[row]; }
+char *PQerrorMessage(const PGconn *conn) { (void)conn; return "fake failure"; }
+void PQclear(PGresult *res) {
+    if (!res) return;
+    free(res->vals);
+    free(res);
+}
+
+static int round_trips(const char *name) {
+    pthread_mutex_lock(&seq_mutex);
+    int n = fake_seq(name)->round_trips;
+    pthread_mutex_unlock(&seq_mutex);
+    return n;
+}
+
+static PGconn conn;
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+static void test_one_round_trip_per_block(void) {
+    TEST("One round trip per block, ids in order");
+
+    sqlite3_int64 prev = 0;
+    for (int i = 0; i < BLOCK; i++) {
+        sqlite3_int64 id = pg_id_block_next(&conn, "plex.a_seq");
+        if (id <= prev) {
+            FAIL("ids not increasing");
+            return;
+        }
+        prev = id;
+    }
+    if (round_trips("plex.a_seq") != 1) {
+        FAIL("expected exactly one round trip");
+        return;
+    }
+    PASS();
+}
+
+static void test_refill_on_exhaustion(void) {
+    TEST("Exhausted block is refilled");
+
+    // Block from test 1 is used up
+    sqlite3_int64 id = pg_id_block_next(&conn, "plex.a_seq");
+    if (id != 1000 + BLOCK + 1 || round_trips("plex.a_seq") != 2) {
+        FAIL("no refill after the block ran out");
+        return;
+    }
+    PASS();
+}
+
+static void test_short_and_failed_refill(void) {
+    TEST("Short block and failed refill");
+
+    pg_id_block_reset();
+    int before = round_trips("plex.a_seq");
+    atomic_store(&short_rows, 2);
+    sqlite3_int64 a = pg_id_block_next(&conn, "plex.a_seq");
+    sqlite3_int64 b = pg_id_block_next(&conn, "plex.a_seq");
+    if (!a || b != a + 1 || round_trips("plex.a_seq") != before + 1) {
+        FAIL("short block not used");
+        return;
+    }
+    atomic_store(&fail_next, 1);
+    if (pg_id_block_next(&conn, "plex.a_seq") != 0) {
+        FAIL("failed refill returned an id");
+        return;
+    }
+    sqlite3_int64 c = pg_id_block_next(&conn, "plex.a_seq");
+    if (c <= b) {
+        FAIL("no retry after a failed refill");
+        return;
+    }
+    PASS();
+}
+
+static void* slow_refill_thread(void *arg) {
+    (void)arg;
+    return (void *)(intptr_t)pg_id_block_next(&conn, "plex.slow_seq");
+}
+
+static void test_refill_doesnt_block_others(void) {
+    TEST("Refill of one sequence doesn't block another");
+
+    pg_id_block_next(&conn, "plex.b_seq");  // Block for b is now full
+    atomic_store(&hold_refill, 1);
+    pthread_t t;
+    pthread_create(&t, NULL, slow_refill_thread, NULL);
+    for (int i = 0; i < 2000 && !atomic_load(&refill_started); i++) usleep(1000);
+
+    sqlite3_int64 id = pg_id_block_next(&conn, "plex.b_seq");
+    int blocked = !atomic_load(&refill_started) || atomic_load(&refill_done);
+    atomic_store(&refill_release, 1);
+    void *slow_id;
+    pthread_join(t, &slow_id);
+    atomic_store(&hold_refill, 0);
+
+    if (blocked || !id) {
+        FAIL("other sequence waited for the round trip");
+        return;
+    }
+    if (!slow_id) {
+        FAIL("slow refill produced no id");
+        return;
+    }
+    PASS();
+}
+
+#define THREADS 8
+#define PER_THREAD 500
+
+static sqlite3_int64 taken[THREADS * PER_THREAD];
+
+static void* taker_thread(void *arg) {
+    int t = (int)(intptr_t)arg;
+    for (int i = 0; i < PER_THREAD; i++) taken[t * PER_THREAD + i] = pg_id_block_next(&conn, "plex.c_seq");
+    return NULL;
+}
+
+static int cmp_id(const void *a, const void *b) {
+    sqlite3_int64 x = *(const sqlite3_int64 *)a, y = *(const sqlite3_int64 *)b;
+    return (x > y) - (x < y);
+}
+
+static void test_concurrent(void) {
+    TEST("Concurrent callers - no duplicates, no wasted blocks");
+
+    pthread_t th[THREADS];
+    for (int t = 0; t < THREADS; t++) pthread_create(&th[t], NULL, taker_thread, (void *)(intptr_t)t);
+    for (int t = 0; t < THREADS; t++) pthread_join(th[t], NULL);
+
+    qsort(taken, THREADS * PER_THREAD, sizeof(taken[0]), cmp_id);
+    for (int i = 0; i < THREADS * PER_THREAD; i++) {
+        if (!taken[i] || (i > 0 && taken[i] == taken[i - 1])) {
+            FAIL("zero or duplicate id");
+            return;
+        }
+    }
+    // Waiters reuse the block another thread just fetched
+    if (round_trips("plex.c_seq") != THREADS * PER_THREAD / BLOCK) {
+        char msg[64];
+        snprintf(msg, sizeof(msg), "%d round trips for %d ids", round_trips("plex.c_seq"), THREADS * PER_THREAD);
+        FAIL(msg);
+        return;
+    }
+    PASS();
+}
+
+static void test_reset(void) {
+    TEST("Reset drops reserved ids");
+
+    sqlite3_int64 a = pg_id_block_next(&conn, "plex.d_seq");
+    pg_id_block_reset();
+    sqlite3_int64 b = pg_id_block_next(&conn, "plex.d_seq");
+    if (b != a + BLOCK || round_trips("plex.d_seq") != 2) {
+        FAIL("reserved ids handed out after reset");
+        return;
+    }
+    PASS();
+}
+
+static void test_fork(void) {
+    TEST("Child after fork doesn't reuse parent's ids");
+
+    sqlite3_int64 parent_first = pg_id_block_next(&conn, "plex.e_seq");
+    int parent_trips = round_trips("plex.e_seq");
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        pg_id_block_reset_after_fork();
+        sqlite3_int64 id = pg_id_block_next(&conn, "plex.e_seq");
+        int ok = id > parent_first + BLOCK - 1 && round_trips("plex.e_seq") == parent_trips + 1;
+        _exit(ok ? 0 : 1);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        FAIL("child handed out one of the parent's reserved ids");
+        return;
+    }
+    // Parent keeps its block
+    if (pg_id_block_next(&conn, "plex.e_seq") != parent_first + 1) {
+        FAIL("parent lost its block");
+        return;
+    }
+    PASS();
+}
+
+// ============================================================================
+// Main
+// ============================================================================
+
+int main(void) {
+    printf("\n\033[1m=== ID Block Allocator Tests ===\033[0m\n\n");
+
+    setenv(ENV_PG_ID_BLOCK_SIZE, "8", 1);
+    pg_id_block_init();
+
+    test_one_round_trip_per_block();
+    test_refill_on_exhaustion();
+    test_short_and_failed_refill();
+    test_refill_doesnt_block_others();
+    test_concurrent();
+    test_reset();
+    test_fork();
+
+    printf("\n\033[1m=== Results ===\033[0m\n");
+    printf("Passed: \033[32m%d\033[0m\n", tests_passed);
+    printf("Failed: \033[31m%d\033[0m\n", tests_failed);
+
+    return tests_failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,307 @@
+/*
+ * Tests for cross-process cache invalidation (LISTEN/NOTIFY)
+ *
+ * Runs the listener protocol from pg_invalidation.c against a local
+ * PostgreSQL (PLEX_PG_HOST/PORT/DATABASE/USER/PASSWORD, defaults
+ * localhost:5432 plex/plex). Skips cleanly when no server is reachable.
+ *
+ * Tests:
+ * 1. Outbox array literal - quoting, dedup, unsafe names fall back to "*"
+ * 2. Notification from another session is delivered with its backend PID
+ * 3. Notifications from our own session carry our PID (listener skips them)
+ * 4. One flush delivers every table in the batch, in order
+ * 5. A batch whose NOTIFY failed goes back into the outbox, merged with
+ *    writes queued meanwhile
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <poll.h>
+#include <libpq-fe.h>
+
+// Test counters
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST(name) printf("  Testing: %s... ", name)
+#define PASS() do { printf("\033[32mPASS\033[0m\n"); tests_passed++; } while(0)
+#define FAIL(msg) do { printf("\033[31mFAIL: %s\033[0m\n", msg); tests_failed++; } while(0)
+
+// Must match pg_invalidation.h
+#define PG_INVAL_CHANNEL "plex_shim_inval"
+#define PG_INVAL_ALL "*"
+#define PG_INVAL_SCHEMA "#schema"
+#define PG_INVAL_MAX_PENDING 64
+
+// ============================================================================
+// Outbox (replicates pg_inval_publish() / flush_outbox())
+// ============================================================================
+
+typedef struct {
+    char tables[PG_INVAL_MAX_PENDING][64];
+    int count;
+    int all;
+    int schema;
+} outbox_t;
+
+static void outbox_publish(outbox_t *o, const char *table) {
+    if (!table || !table[0]) return;
+    if (strcmp(table, PG_INVAL_SCHEMA) == 0) {
+        o->schema = 1;
+    } else if (strcmp(table, PG_INVAL_ALL) == 0 || strlen(table) >= sizeof(o->tables[0]) ||
+               strpbrk(table, "\"\\{},")) {
+        o->all = 1;
+    } else if (!o->all) {
+        for (int i = 0; i < o->count; i++) {
+            if (strcmp(o->tables[i], table) == 0) return;
+        }
+        if (o->count < PG_INVAL_MAX_PENDING) {
+            strcpy(o->tables[o->count++], table);
+        } else {
+            o->all = 1;
+        }
+    }
+}
+
+static void outbox_array(const outbox_t *o, char *array, size_t size) {
+    int off = snprintf(array, size, "{");
+    if (o->schema) off += snprintf(array + off, size - off, "\"%s\"", PG_INVAL_SCHEMA);
+    if (o->all) off += snprintf(array + off, size - off, "%s\"%s\"", off > 1 ? "," : "", PG_INVAL_ALL);
+    for (int i = 0; i < o->count && !o->all; i++) {
+        off += snprintf(array + off, size - off, "%s\"%s\"", off > 1 ? "," : "", o->tables[i]);
+    }
+    snprintf(array + off, size - off, "}");
+}
+
+// Take the batch (flush_outbox() empties the outbox before sending)
+static outbox_t outbox_take(outbox_t *o) {
+    outbox_t batch = *o;
+    memset(o, 0, sizeof(*o));
+    return batch;
+}
+
+// NOTIFY failed - put the batch back
+static void outbox_requeue(outbox_t *o, const outbox_t *batch) {
+    if (batch->schema) outbox_publish(o, PG_INVAL_SCHEMA);
+    if (batch->all) outbox_publish(o, PG_INVAL_ALL);
+    for (int i = 0; i < batch->count && !batch->all; i++) outbox_publish(o, batch->tables[i]);
+}
+
+static void test_outbox_array(void) {
+    TEST("Outbox - quoting, dedup and unsafe names");
+
+    char array[1024];
+    outbox_t o = {0};
+    outbox_publish(&o, "metadata_items");
+    outbox_publish(&o, "tags");
+    outbox_publish(&o, "metadata_items");
+    outbox_array(&o, array, sizeof(array));
+    int ok = strcmp(array, "{\"metadata_items\",\"tags\"}") == 0;
+
+    outbox_t o2 = {0};
+    outbox_publish(&o2, PG_INVAL_SCHEMA);
+    outbox_publish(&o2, "taggings");
+    outbox_publish(&o2, "we\"ird");
+    outbox_array(&o2, array, sizeof(array));
+    ok = ok && strcmp(array, "{\"#schema\",\"*\"}") == 0;
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL(array);
+    }
+}
+
+static void test_outbox_requeue(void) {
+    TEST("Outbox - failed batch is requeued");
+
+    char array[1024];
+    outbox_t o = {0};
+    outbox_publish(&o, "metadata_items");
+    outbox_publish(&o, "tags");
+    outbox_t batch = outbox_take(&o);
+    outbox_publish(&o, "taggings");          // Written while the NOTIFY was in flight
+    outbox_publish(&o, "tags");
+    outbox_requeue(&o, &batch);
+    outbox_array(&o, array, sizeof(array));
+    int ok = strcmp(array, "{\"taggings\",\"tags\",\"metadata_items\"}") == 0;
+
+    outbox_t o2 = {0};
+    outbox_publish(&o2, PG_INVAL_SCHEMA);
+    outbox_publish(&o2, "we\"ird");
+    batch = outbox_take(&o2);
+    outbox_publish(&o2, "tags");
+    outbox_requeue(&o2, &batch);
+    outbox_array(&o2, array, sizeof(array));
+    ok = ok && strcmp(array, "{\"#schema\",\"*\"}") == 0;
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL(array);
+    }
+}
+
+// ============================================================================
+// Protocol Tests (need PostgreSQL)
+// ============================================================================
+
+static PGconn* connect_pg(void) {
+    const char *host = getenv("PLEX_PG_HOST") ?: "localhost";
+    const char *port = getenv("PLEX_PG_PORT") ?: "5432";
+    const char *db = getenv("PLEX_PG_DATABASE") ?: "plex";
+    const char *user = getenv("PLEX_PG_USER") ?: "plex";
+    const char *password = getenv("PLEX_PG_PASSWORD") ?: "";
+
+    char conninfo[512];
+    snprintf(conninfo, sizeof(conninfo),
+             "host=%s port=%s dbname=%s user=%s password=%s connect_timeout=3",
+             host, port, db, user, password);
+    PGconn *conn = PQconnectdb(conninfo);
+    if (PQstatus(conn) != CONNECTION_OK) {
+        PQfinish(conn);
+        return NULL;
+    }
+    return conn;
+}
+
+static int exec_ok(PGconn *conn, const char *sql) {
+    PGresult *res = PQexec(conn, sql);
+    ExecStatusType st = PQresultStatus(res);
+    PQclear(res);
+    return st == PGRES_COMMAND_OK || st == PGRES_TUPLES_OK;
+}
+
+// The listener's flush query
+static int send_batch(PGconn *conn, const char *array) {
+    const char *params[2] = { PG_INVAL_CHANNEL, array };
+    PGresult *res = PQexecParams(conn, "SELECT pg_notify($1, t) FROM unnest($2::text[]) t",
+                                 2, NULL, params, NULL, NULL, 0);
+    int ok = PQresultStatus(res) == PGRES_TUPLES_OK;
+    PQclear(res);
+    return ok;
+}
+
+// Wait up to timeout_ms for the next notification
+static PGnotify* wait_notify(PGconn *conn, int timeout_ms) {
+    PGnotify *n = PQnotifies(conn);
+    while (!n && timeout_ms > 0) {
+        struct pollfd pfd = { .fd = PQsocket(conn), .events = POLLIN, .revents = 0 };
+        if (poll(&pfd, 1, 50) > 0 && !PQconsumeInput(conn)) return NULL;
+        n = PQnotifies(conn);
+        timeout_ms -= 50;
+    }
+    return n;
+}
+
+static void drain(PGconn *conn) {
+    PGnotify *n;
+    PQconsumeInput(conn);
+    while ((n = PQnotifies(conn)) != NULL) PQfreemem(n);
+}
+
+static void test_remote_notification(PGconn *listener, PGconn *writer) {
+    TEST("Protocol - other session's notification carries its PID");
+    drain(listener);
+
+    if (!send_batch(writer, "{\"metadata_items\"}")) {
+        FAIL("pg_notify failed");
+        return;
+    }
+    PGnotify *n = wait_notify(listener, 2000);
+    if (!n) {
+        FAIL("no notification received");
+        return;
+    }
+    int ok = strcmp(n->relname, PG_INVAL_CHANNEL) == 0 &&
+             strcmp(n->extra, "metadata_items") == 0 &&
+             n->be_pid == PQbackendPID(writer) && n->be_pid != PQbackendPID(listener);
+    PQfreemem(n);
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("wrong channel, payload or PID");
+    }
+}
+
+static void test_own_notification(PGconn *listener) {
+    TEST("Protocol - own notifications carry own PID (skipped)");
+    drain(listener);
+
+    if (!send_batch(listener, "{\"tags\"}")) {
+        FAIL("pg_notify failed");
+        return;
+    }
+    PGnotify *n = wait_notify(listener, 2000);
+    if (!n) {
+        FAIL("no notification received");
+        return;
+    }
+    int ok = n->be_pid == PQbackendPID(listener);
+    PQfreemem(n);
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("own notification has foreign PID");
+    }
+}
+
+static void test_batch_delivery(PGconn *listener, PGconn *writer) {
+    TEST("Protocol - one flush delivers the whole batch in order");
+    drain(listener);
+
+    const char *expected[] = { "#schema", "metadata_items", "media_items", "taggings" };
+    if (!send_batch(writer, "{\"#schema\",\"metadata_items\",\"media_items\",\"taggings\"}")) {
+        FAIL("pg_notify failed");
+        return;
+    }
+
+    int ok = 1;
+    for (int i = 0; i < 4 && ok; i++) {
+        PGnotify *n = wait_notify(listener, 2000);
+        ok = n && strcmp(n->extra, expected[i]) == 0;
+        if (n) PQfreemem(n);
+    }
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("missing or out-of-order payloads");
+    }
+}
+
+// ============================================================================
+// Main
+// ============================================================================
+
+int main(void) {
+    printf("\n\033[1m=== Cross-Process Invalidation Tests ===\033[0m\n\n");
+
+    printf("\033[1mOutbox:\033[0m\n");
+    test_outbox_array();
+    test_outbox_requeue();
+
+    printf("\n\033[1mLISTEN/NOTIFY Protocol:\033[0m\n");
+    PGconn *listener = connect_pg();
+    PGconn *writer = listener ? connect_pg() : NULL;
+    if (!listener || !writer) {
+        printf("  \033[33mSKIP: PostgreSQL not reachable (set PLEX_PG_HOST etc.)\033[0m\n");
+    } else if (!exec_ok(listener, "LISTEN " PG_INVAL_CHANNEL)) {
+        FAIL("LISTEN failed");
+    } else {
+        test_remote_notification(listener, writer);
+        test_own_notification(listener);
+        test_batch_delivery(listener, writer);
+    }
+    if (listener) PQfinish(listener);
+    if (writer) PQfinish(writer);
+
+    printf("\n\033[1m=== Results ===\033[0m\n");
+    printf("Passed: \033[32m%d\033[0m\n", tests_passed);
+    printf("Failed: \033[31m%d\033[0m\n", tests_failed);
+
+    return tests_failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,287 @@
+/*
+ * Tests for cache memory accounting (pg_mem.c)
+ *
+ * Links the real module; the shrinkers here are fake caches that just
+ * credit what they "free".
+ *
+ * Tests:
+ * 1. Budget comes from PLEX_PG_CACHE_MB
+ * 2. Charges and credits add up per kind and in total
+ * 3. Under budget - no shrinker runs
+ * 4. Over budget - lowest hits per byte is shrunk first, and only as much
+ *    as needed to get under PG_MEM_RECLAIM_TARGET
+ * 5. Reclaim moves on to the next cache when the first can't free enough
+ * 6. Per-thread (non-evictable) usage over budget doesn't loop or crash
+ * 7. Stats line names every kind
+ * 8. Per-thread usage alone over budget - shared caches are not emptied
+ * 9. Per-thread usage over the target - shared caches keep half the headroom
+ * 10. Reclaims are rate-limited to one per PG_MEM_RECLAIM_INTERVAL_MS
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "pg_mem.h"
+
+// Test counters
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST(name) printf("  Testing: %s... ", name)
+#define PASS() do { printf("\033[32mPASS\033[0m\n"); tests_passed++; } while(0)
+#define FAIL(msg) do { printf("\033[31mFAIL: %s\033[0m\n", msg); tests_failed++; } while(0)
+
+#define MB (1024 * 1024)
+#define BUDGET_MB 16
+
+// ============================================================================
+// Fake caches
+// ============================================================================
+
+typedef struct {
+    pg_mem_kind_t kind;
+    size_t held;           // Bytes the fake cache holds
+    size_t max_free;       // Most it can give back per call (0 = all)
+    int calls;
+    int order;             // Call order across fakes (1-based)
+} fake_cache_t;
+
+static fake_cache_t fake_query = { PG_MEM_QUERY_CACHE, 0, 0, 0, 0 };
+static fake_cache_t fake_row = { PG_MEM_ROW_CACHE, 0, 0, 0, 0 };
+static int call_seq = 0;
+
+static size_t fake_shrink(fake_cache_t *c, size_t bytes) {
+    size_t n = bytes < c->held ? bytes : c->held;
+    if (c->max_free && n > c->max_free) n = c->max_free;
+    c->held -= n;
+    c->calls++;
+    c->order = ++call_seq;
+    pg_mem_charge(c->kind, -(ssize_t)n);
+    return n;
+}
+
+static size_t shrink_query(size_t bytes) { return fake_shrink(&fake_query, bytes); }
+static size_t shrink_row(size_t bytes) { return fake_shrink(&fake_row, bytes); }
+
+static void fill(fake_cache_t *c, size_t bytes) {
+    c->held += bytes;
+    pg_mem_charge(c->kind, (ssize_t)bytes);
+}
+
+// Let the reclaim rate limit expire
+static void wait_reclaim_interval(void) {
+    usleep((PG_MEM_RECLAIM_INTERVAL_MS + 20) * 1000);
+}
+
+// Drop everything charged so far so each test starts at zero
+static void reset_all(void) {
+    wait_reclaim_interval();
+    pg_mem_stats_t st;
+    pg_mem_stats(&st);
+    for (int k = 0; k < PG_MEM_KINDS; k++) pg_mem_charge((pg_mem_kind_t)k, -(ssize_t)st.bytes[k]);
+    fake_query.held = fake_row.held = 0;
+    fake_query.max_free = fake_row.max_free = 0;
+    fake_query.calls = fake_row.calls = 0;
+    fake_query.order = fake_row.order = 0;
+    call_seq = 0;
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+static void test_budget(void) {
+    TEST("Budget from PLEX_PG_CACHE_MB");
+    if (pg_mem_budget() == (size_t)BUDGET_MB * MB) {
+        PASS();
+    } else {
+        FAIL("budget not taken from environment");
+    }
+}
+
+static void test_charge(void) {
+    TEST("Charges and credits add up");
+    reset_all();
+    pg_mem_charge(PG_MEM_TRANSLATIONS, 1000);
+    pg_mem_charge(PG_MEM_COLUMN_BUFFERS, 5000);
+    pg_mem_charge(PG_MEM_TRANSLATIONS, -400);
+
+    pg_mem_stats_t st;
+    pg_mem_stats(&st);
+    if (st.bytes[PG_MEM_TRANSLATIONS] == 600 && st.bytes[PG_MEM_COLUMN_BUFFERS] == 5000 &&
+        st.total == 5600 && pg_mem_total() == 5600) {
+        PASS();
+    } else {
+        FAIL("wrong per-kind or total bytes");
+    }
+}
+
+static void test_under_budget(void) {
+    TEST("Under budget - nothing reclaimed");
+    reset_all();
+    fill(&fake_query, 4 * MB);
+    fill(&fake_row, 4 * MB);
+    pg_mem_check();
+    if (fake_query.calls == 0 && fake_row.calls == 0 && pg_mem_total() == 8 * MB) {
+        PASS();
+    } else {
+        FAIL("shrinker ran under budget");
+    }
+}
+
+static void test_lowest_benefit_first(void) {
+    TEST("Over budget - lowest hits/byte shrunk first, just enough");
+    reset_all();
+    fill(&fake_query, 10 * MB);
+    fill(&fake_row, 8 * MB);
+    for (int i = 0; i < 1000; i++) pg_mem_hit(PG_MEM_ROW_CACHE);     // Row cache earns its keep
+    for (int i = 0; i < 10; i++) pg_mem_hit(PG_MEM_QUERY_CACHE);
+    pg_mem_check();
+
+    size_t target = (size_t)(BUDGET_MB * MB * PG_MEM_RECLAIM_TARGET);
+    int ok = fake_query.calls == 1 && fake_row.calls == 0 &&
+             pg_mem_total() <= target && pg_mem_total() > target - 1024 &&
+             fake_row.held == 8 * MB;
+
+    pg_mem_stats_t st;
+    pg_mem_stats(&st);
+    ok = ok && st.reclaims >= 1 && st.reclaimed_bytes > 0;
+    if (ok) {
+        PASS();
+    } else {
+        char msg[128];
+        snprintf(msg, sizeof(msg), "query calls=%d row calls=%d total=%zu",
+                 fake_query.calls, fake_row.calls, pg_mem_total());
+        FAIL(msg);
+    }
+}
+
+static void test_next_cache(void) {
+    TEST("Reclaim moves on when the first cache can't free enough");
+    reset_all();
+    fill(&fake_query, 10 * MB);
+    fill(&fake_row, 10 * MB);
+    for (int i = 0; i < 10; i++) pg_mem_hit(PG_MEM_ROW_CACHE);  // Row cache is now the cheaper one
+    for (int i = 0; i < 1000; i++) pg_mem_hit(PG_MEM_QUERY_CACHE);
+    fake_row.max_free = 1 * MB;
+    pg_mem_check();
+
+    size_t target = (size_t)(BUDGET_MB * MB * PG_MEM_RECLAIM_TARGET);
+    if (fake_row.calls == 1 && fake_query.calls == 1 && fake_row.order < fake_query.order &&
+        pg_mem_total() <= target) {
+        PASS();
+    } else {
+        FAIL("wrong shrink order or still over target");
+    }
+}
+
+static void test_unevictable(void) {
+    TEST("Per-thread usage over budget - no loop, no crash");
+    reset_all();
+    pg_mem_charge(PG_MEM_COLUMN_BUFFERS, 20 * MB);  // No shrinker for this kind
+    pg_mem_check();
+    pg_mem_check();
+    if (pg_mem_total() == 20 * MB && fake_query.calls == 0 && fake_row.calls == 0) {
+        PASS();
+    } else {
+        FAIL("unexpected reclaim");
+    }
+}
+
+static void test_format(void) {
+    TEST("Stats line names every kind");
+    reset_all();
+    pg_mem_charge(PG_MEM_ROW_CACHE, 2048);
+    pg_mem_hit(PG_MEM_ROW_CACHE);
+
+    char buf[512];
+    pg_mem_format_stats(buf, sizeof(buf));
+    int ok = strstr(buf, "budget=16MB") && strstr(buf, "row_cache=2KB/");
+    for (int k = 0; k < PG_MEM_KINDS && ok; k++) {
+        ok = strstr(buf, pg_mem_kind_name((pg_mem_kind_t)k)) != NULL;
+    }
+    if (ok) {
+        PASS();
+    } else {
+        FAIL(buf);
+    }
+}
+
+static void test_unevictable_over_budget(void) {
+    TEST("Per-thread usage alone over budget - shared caches kept");
+    reset_all();
+    fill(&fake_query, 2 * MB);
+    pg_mem_charge(PG_MEM_COLUMN_BUFFERS, 17 * MB);
+    pg_mem_check();
+    if (fake_query.calls == 0 && fake_query.held == 2 * MB) {
+        PASS();
+    } else {
+        FAIL("shared cache emptied for nothing");
+    }
+}
+
+static void test_unevictable_over_target(void) {
+    TEST("Per-thread usage over target - shared caches keep half the headroom");
+    reset_all();
+    fill(&fake_query, 4 * MB);
+    pg_mem_charge(PG_MEM_COLUMN_BUFFERS, 15 * MB);  // Above the 14.4MB target
+    pg_mem_check();
+    if (fake_query.calls == 1 && fake_query.held == MB / 2 &&
+        pg_mem_total() <= (size_t)BUDGET_MB * MB) {
+        PASS();
+    } else {
+        char msg[96];
+        snprintf(msg, sizeof(msg), "query cache holds %zuKB", fake_query.held / 1024);
+        FAIL(msg);
+    }
+}
+
+static void test_rate_limit(void) {
+    TEST("Reclaims rate-limited");
+    reset_all();
+    fill(&fake_query, 20 * MB);
+    pg_mem_check();
+    int first = fake_query.calls;
+    fill(&fake_query, 4 * MB);    // Over budget again right away
+    pg_mem_check();
+    int second = fake_query.calls;
+    wait_reclaim_interval();
+    pg_mem_check();
+    if (first == 1 && second == 1 && fake_query.calls == 2 &&
+        pg_mem_total() <= (size_t)(BUDGET_MB * MB * PG_MEM_RECLAIM_TARGET)) {
+        PASS();
+    } else {
+        FAIL("reclaim ran inside the interval or not after it");
+    }
+}
+
+// ============================================================================
+// Main
+// ============================================================================
+
+int main(void) {
+    printf("\n\033[1m=== Cache Memory Accounting Tests ===\033[0m\n\n");
+
+    setenv("PLEX_PG_CACHE_MB", "16", 1);
+    pg_mem_register_shrinker(PG_MEM_QUERY_CACHE, shrink_query);
+    pg_mem_register_shrinker(PG_MEM_ROW_CACHE, shrink_row);
+
+    test_budget();
+    test_charge();
+    test_under_budget();
+    test_lowest_benefit_first();
+    test_next_cache();
+    test_unevictable();
+    test_format();
+    test_unevictable_over_budget();
+    test_unevictable_over_target();
+    test_rate_limit();
+
+    printf("\n\033[1m=== Results ===\033[0m\n");
+    printf("Passed: \033[32m%d\033[0m\n", tests_passed);
+    printf("Failed: \033[31m%d\033[0m\n", tests_failed);
+
+    return tests_failed > 0 ? 1 : 0;
+}
@@ -16,6 +16,14 @@
  * 12. Prepared statement cache - miss on different queries
  * 13. Prepared statement cache - LRU eviction when full
  * 14. Cache key includes bound parameter types
+ * 15. Table dependencies - FROM/JOIN/comma lists, aliases, schema qualifiers
+ * 16. Write targets - INSERT/UPDATE/DELETE, upsert DO UPDATE ignored
+ * 17. Views map to their base table
+ * 18. Version snapshot - write during execution makes the entry stale
+ * 19. Columnar arena - packed cells, offsets and null bitmap round-trip
+ * 20. Stale-while-revalidate - serve/refresh/execute decision
+ * 21. Negative cache - empty-result fingerprint dies on a write to a read table
+ * 22. Columnar arena - BYTEA read back from a hit is the decoded blob
  */
 
 #include <stdio.h>
@@ -25,6 +33,7 @@
 #include <time.h>
 #include <unistd.h>
 #include <ctype.h>
+#include <strings.h>
 
 // Test counters
 static int tests_passed = 0;
@@ -1017,6 +1026,588 @@ static void test_cache_key_includes_params(void) {
     }
 }
 
+// ============================================================================
+// Table Dependency Tests (replicates SQL analysis from pg_query_cache.c)
+// ============================================================================
+
+#define MAX_TABLES 16
+
+static const struct { const char *prefix; const char *base; } VIEW_BASE_TABLES[] = {
+    {"fts4_metadata_titles", "metadata_items"},
+    {"fts4_tag_titles", "tags"},
+    {NULL, NULL}
+};
+
+static const char *CLAUSE_KEYWORDS[] = {
+    "where", "group", "order", "limit", "offset", "join", "inner", "left", "right",
+    "full", "cross", "natural", "on", "using", "union", "except", "intersect",
+    "having", "window", "returning", "set", "values", "select", "default", "for",
+    NULL
+};
+
+static uint32_t table_id(const char *name) {
+    for (int i = 0; VIEW_BASE_TABLES[i].prefix; i++) {
+        if (strncmp(name, VIEW_BASE_TABLES[i].prefix, strlen(VIEW_BASE_TABLES[i].prefix)) == 0) {
+            name = VIEW_BASE_TABLES[i].base;
+            break;
+        }
+    }
+    return (uint32_t)fnv1a_hash(name, strlen(name));
+}
+
+static int qc_ident_char(char c) {
+    return isalnum((unsigned char)c) || c == '_' || c == '$';
+}
+
+static int read_identifier(const char **pp, char *out, size_t outsz) {
+    const char *p = *pp;
+    size_t n = 0;
+    for (;;) {
+        n = 0;
+        if (*p == '"') {
+            p++;
+            while (*p && *p != '"') {
+                if (n + 1 < outsz) out[n++] = (char)tolower((unsigned char)*p);
+                p++;
+            }
+            if (*p == '"') p++;
+        } else if (qc_ident_char(*p)) {
+            while (qc_ident_char(*p)) {
+                if (n + 1 < outsz) out[n++] = (char)tolower((unsigned char)*p);
+                p++;
+            }
+        } else {
+            break;
+        }
+        if (*p != '.') break;
+        p++;
+    }
+    out[n] = '\0';
+    *pp = p;
+    return n > 0;
+}
+
+static int is_clause_keyword(const char *word) {
+    for (int i = 0; CLAUSE_KEYWORDS[i]; i++) {
+        if (strcmp(word, CLAUSE_KEYWORDS[i]) == 0) return 1;
+    }
+    return 0;
+}
+
+static int add_table(uint32_t *ids, int n, const char *name) {
+    if (n < 0) return n;
+    uint32_t id = table_id(name);
+    for (int i = 0; i < n; i++) {
+        if (ids[i] == id) return n;
+    }
+    if (n >= MAX_TABLES) return -1;
+    ids[n] = id;
+    return n + 1;
+}
+
+static const char* qc_skip_ws(const char *p) {
+    while (*p && isspace((unsigned char)*p)) p++;
+    return p;
+}
+
+static int parse_table_list(const char **pp, uint32_t *ids, int n) {
+    const char *p = *pp;
+    char name[128];
+    for (;;) {
+        p = qc_skip_ws(p);
+        if (*p == '(') break;
+        if (!read_identifier(&p, name, sizeof(name))) break;
+        if (is_clause_keyword(name)) break;
+        n = add_table(ids, n, name);
+
+        p = qc_skip_ws(p);
+        const char *save = p;
+        char alias[128];
+        if (read_identifier(&p, alias, sizeof(alias))) {
+            if (strcmp(alias, "as") == 0) {
+                p = qc_skip_ws(p);
+                read_identifier(&p, alias, sizeof(alias));
+            } else if (is_clause_keyword(alias)) {
+                p = save;
+            }
+        }
+        p = qc_skip_ws(p);
+        if (*p != ',') break;
+        p++;
+    }
+    *pp = p;
+    return n;
+}
+
+#define QC_MAX_DEPTH 32
+
+// Keywords that end a FROM clause at the current nesting level
+static const char *FROM_TERMINATORS[] = {
+    "where", "group", "order", "limit", "offset", "having", "window", "union",
+    "except", "intersect", "returning", "set", "values", "for", NULL
+};
+
+static int is_from_terminator(const char *word) {
+    for (int i = 0; FROM_TERMINATORS[i]; i++) {
+        if (strcmp(word, FROM_TERMINATORS[i]) == 0) return 1;
+    }
+    return 0;
+}
+
+static int collect_tables(const char *sql, int mode, uint32_t *ids) {
+    int n = 0;
+    const char *p = sql;
+    char word[32];
+    int depth = 0;
+    unsigned char in_from[QC_MAX_DEPTH] = {0};
+
+    while (*p && n >= 0) {
+        if (*p == '\'') {
+            p++;
+            while (*p && *p != '\'') p++;
+            if (*p) p++;
+            continue;
+        }
+        if (*p == '(') {
+            // Subquery or function call - tracked per nesting level so a
+            // comma inside it never looks like a FROM list continuation
+            if (depth < QC_MAX_DEPTH - 1) in_from[++depth] = 0;
+            p++;
+            continue;
+        }
+        if (*p == ')') {
+            if (depth > 0) depth--;
+            p++;
+            continue;
+        }
+        if (*p == ',' && mode == 0 && in_from[depth]) {
+            // "FROM a JOIN b ON ..., c" - the comma continues the FROM list
+            p++;
+            n = parse_table_list(&p, ids, n);
+            continue;
+        }
+        if (!qc_ident_char(*p) && *p != '"') {
+            p++;
+            continue;
+        }
+        if (!read_identifier(&p, word, sizeof(word))) {
+            p++;
+            continue;
+        }
+
+        if (mode == 0) {
+            if (strcmp(word, "from") == 0 || strcmp(word, "join") == 0) {
+                n = parse_table_list(&p, ids, n);
+                in_from[depth] = 1;
+            } else if (is_from_terminator(word)) {
+                in_from[depth] = 0;
+            }
+        } else if (strcmp(word, "into") == 0 || strcmp(word, "update") == 0 ||
+                   strcmp(word, "delete") == 0 || strcmp(word, "truncate") == 0) {
+            const char *q = qc_skip_ws(p);
+            char name[128];
+            if (!read_identifier(&q, name, sizeof(name))) continue;
+            if (strcmp(name, "from") == 0 || strcmp(name, "table") == 0) {
+                q = qc_skip_ws(q);
+                if (!read_identifier(&q, name, sizeof(name))) continue;
+            } else if (strcmp(name, "or") == 0) {
+                q = qc_skip_ws(q);
+                if (!read_identifier(&q, name, sizeof(name))) continue;
+                q = qc_skip_ws(q);
+                if (!read_identifier(&q, name, sizeof(name))) continue;
+            }
+            if (strcmp(name, "set") == 0) continue;
+            n = add_table(ids, n, name);
+            p = q;
+        }
+    }
+    return n;
+}
+
+static int has_table(const uint32_t *ids, int n, const char *name) {
+    uint32_t id = table_id(name);
+    for (int i = 0; i < n; i++) {
+        if (ids[i] == id) return 1;
+    }
+    return 0;
+}
+
+static void test_tables_from_join(void) {
+    TEST("Tables - FROM, JOIN, comma list, aliases, schema");
+
+    uint32_t ids[MAX_TABLES];
+    int n = collect_tables(
+        "SELECT m.id FROM plex.metadata_items m "
+        "LEFT JOIN \"media_items\" AS mi ON mi.metadata_item_id = m.id, taggings t "
+        "WHERE m.id IN (SELECT metadata_item_id FROM media_parts) AND m.title = 'from tags'",
+        0, ids);
+
+    if (n == 4 && has_table(ids, n, "metadata_items") && has_table(ids, n, "media_items") &&
+        has_table(ids, n, "taggings") && has_table(ids, n, "media_parts") &&
+        !has_table(ids, n, "tags")) {
+        PASS();
+    } else {
+        FAIL("wrong read-table set");
+    }
+}
+
+static void test_tables_write_targets(void) {
+    TEST("Tables - write targets, upsert DO UPDATE ignored");
+
+    uint32_t ids[MAX_TABLES];
+    int ok = collect_tables("UPDATE metadata_items SET title = $1 WHERE id = $2", 1, ids) == 1 &&
+             has_table(ids, 1, "metadata_items");
+    ok = ok && collect_tables("DELETE FROM plex.taggings WHERE id = 1", 1, ids) == 1 &&
+               has_table(ids, 1, "taggings");
+    ok = ok && collect_tables("INSERT OR REPLACE INTO tags (id) VALUES (1)", 1, ids) == 1 &&
+               has_table(ids, 1, "tags");
+    ok = ok && collect_tables("INSERT INTO prefs (k, v) VALUES ($1, $2) "
+                              "ON CONFLICT (k) DO UPDATE SET v = EXCLUDED.v", 1, ids) == 1 &&
+               has_table(ids, 1, "prefs");
+    ok = ok && collect_tables("VACUUM", 1, ids) == 0;  // Caller invalidates everything
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("wrong write-table set");
+    }
+}
+
+static void test_tables_view_maps_to_base(void) {
+    TEST("Tables - FTS views depend on their base table");
+
+    uint32_t ids[MAX_TABLES];
+    int n = collect_tables("SELECT docid FROM fts4_metadata_titles_icu WHERE title MATCH $1", 0, ids);
+    if (n == 1 && ids[0] == table_id("metadata_items")) {
+        PASS();
+    } else {
+        FAIL("view should map to metadata_items");
+    }
+}
+
+// Version snapshot semantics: lookup() snapshots before the query runs,
+// writes bump after they commit
+static void test_version_snapshot_race(void) {
+    TEST("Versions - write during execution leaves entry stale");
+
+    uint64_t version = 7;              // Table version counter
+    uint64_t snapshot = version;       // Taken by lookup() on miss
+    version++;                         // Concurrent write commits and bumps
+    uint64_t stored = snapshot;        // store() uses the pre-execution snapshot
+
+    int fresh_after_race = (stored == version);
+
+    uint64_t snapshot2 = version;      // Next miss, no concurrent write
+    int fresh_no_race = (snapshot2 == version);
+
+    if (!fresh_after_race && fresh_no_race) {
+        PASS();
+    } else {
+        FAIL("snapshot must predate execution");
+    }
+}
+
+// ============================================================================
+// Columnar Arena Tests (replicates build_entry() and cached_cell_* accessors)
+// ============================================================================
+
+typedef struct {
+    int num_rows;
+    int num_cols;
+    uint32_t *cell_offsets;
+    uint8_t *null_bitmap;
+    char *cell_data;
+} mock_arena_t;
+
+static int arena_is_null(const mock_arena_t *r, int row, int col) {
+    int i = row * r->num_cols + col;
+    return (r->null_bitmap[i >> 3] >> (i & 7)) & 1;
+}
+
+static const char* arena_value(const mock_arena_t *r, int row, int col) {
+    int i = row * r->num_cols + col;
+    if ((r->null_bitmap[i >> 3] >> (i & 7)) & 1) return NULL;
+    return r->cell_data + r->cell_offsets[i];
+}
+
+static int arena_length(const mock_arena_t *r, int row, int col) {
+    int i = row * r->num_cols + col;
+    uint32_t span = r->cell_offsets[i + 1] - r->cell_offsets[i];
+    return span ? (int)span - 1 : 0;
+}
+
+static int hex_nibble(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    c = (char)(c | 0x20);
+    return (c >= 'a' && c <= 'f') ? c - 'a' + 10 : -1;
+}
+
+// Hex-format BYTEA cell, stored decoded
+static int arena_hex_bytea(unsigned int oid, const char *value) {
+    return oid == 17 && value[0] == '\\' && value[1] == 'x';
+}
+
+// cells[] holds row-major values, NULL = SQL NULL; oids[] the column types
+// (NULL = all text). Returns one allocation, or NULL on bad BYTEA hex.
+static char* arena_build(mock_arena_t *r, const char **cells, const unsigned int *oids,
+                         int rows, int cols) {
+    size_t ncells = (size_t)rows * cols;
+    size_t data_len = 0;
+    for (size_t i = 0; i < ncells; i++) {
+        if (!cells[i]) continue;
+        size_t len = strlen(cells[i]);
+        data_len += (oids && arena_hex_bytea(oids[i % cols], cells[i])) ? (len - 2) / 2 + 1 : len + 1;
+    }
+
+    size_t off_offsets = 0;
+    size_t off_bitmap = off_offsets + (ncells + 1) * sizeof(uint32_t);
+    size_t off_data = off_bitmap + (ncells + 7) / 8;
+    char *base = malloc(off_data + data_len);
+    if (!base) return NULL;
+    memset(base, 0, off_data);
+
+    r->num_rows = rows;
+    r->num_cols = cols;
+    r->cell_offsets = (uint32_t *)(base + off_offsets);
+    r->null_bitmap = (uint8_t *)(base + off_bitmap);
+    r->cell_data = base + off_data;
+
+    uint32_t pos = 0;
+    for (size_t i = 0; i < ncells; i++) {
+        r->cell_offsets[i] = pos;
+        if (!cells[i]) {
+            r->null_bitmap[i >> 3] |= (uint8_t)(1 << (i & 7));
+            continue;
+        }
+        size_t len = strlen(cells[i]);
+        if (oids && arena_hex_bytea(oids[i % cols], cells[i])) {
+            size_t bin_len = (len - 2) / 2;
+            for (size_t b = 0; b < bin_len; b++) {
+                int hi = hex_nibble(cells[i][2 + b * 2]);
+                int lo = hex_nibble(cells[i][3 + b * 2]);
+                if (hi < 0 || lo < 0) {
+                    free(base);
+                    return NULL;
+                }
+                r->cell_data[pos + b] = (char)((hi << 4) | lo);
+            }
+            r->cell_data[pos + bin_len] = '\0';
+            pos += bin_len + 1;
+            continue;
+        }
+        memcpy(r->cell_data + pos, cells[i], len + 1);
+        pos += len + 1;
+    }
+    r->cell_offsets[ncells] = pos;
+    return base;
+}
+
+static void test_arena_round_trip(void) {
+    TEST("Arena - values, lengths and NULLs round-trip");
+
+    // 3 rows x 4 cols: NULLs on both sides of byte boundaries, empty string
+    const char *cells[] = {
+        "1",  "Movie", NULL,  "2024-01-01",
+        "22", "",      "x",   NULL,
+        NULL, "Show",  "yy",  "t",
+    };
+    mock_arena_t r;
+    char *base = arena_build(&r, cells, NULL, 3, 4);
+    if (!base) {
+        FAIL("allocation failed");
+        return;
+    }
+
+    int ok = 1;
+    for (int row = 0; row < 3 && ok; row++) {
+        for (int col = 0; col < 4 && ok; col++) {
+            const char *want = cells[row * 4 + col];
+            const char *got = arena_value(&r, row, col);
+            if (!want) {
+                ok = arena_is_null(&r, row, col) && !got && arena_length(&r, row, col) == 0;
+            } else {
+                ok = !arena_is_null(&r, row, col) && got && strcmp(got, want) == 0 &&
+                     arena_length(&r, row, col) == (int)strlen(want);
+            }
+        }
+    }
+    free(base);
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("cell mismatch");
+    }
+}
+
+static void test_arena_bytea_hit(void) {
+    TEST("Arena - BYTEA from a cache hit reads back as the decoded blob");
+
+    // id | thumb (bytea) | title; blob holds NUL and high bytes, plus empty
+    // and NULL blobs and a text cell that merely looks like hex
+    static const unsigned int oids[] = { 23, 17, 25 };
+    const char *cells[] = {
+        "1", "\\x0089504e470d0a1a0aFF00", "\\x41",
+        "2", "\\x",                      "t",
+        "3", NULL,                       NULL,
+    };
+    static const unsigned char blob[] = { 0x00, 0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0xff, 0x00 };
+
+    mock_arena_t r;
+    char *base = arena_build(&r, cells, oids, 3, 3);
+    if (!base) {
+        FAIL("allocation failed");
+        return;
+    }
+
+    // What column_blob / column_bytes return on the hit
+    const char *got = arena_value(&r, 0, 1);
+    int ok = got && arena_length(&r, 0, 1) == (int)sizeof(blob) &&
+             memcmp(got, blob, sizeof(blob)) == 0;
+    ok = ok && arena_length(&r, 1, 1) == 0 && arena_value(&r, 1, 1) && !arena_is_null(&r, 1, 1);
+    ok = ok && arena_is_null(&r, 2, 1) && !arena_value(&r, 2, 1);
+    // Non-BYTEA columns keep their text
+    ok = ok && strcmp(arena_value(&r, 0, 2), "\\x41") == 0 && strcmp(arena_value(&r, 1, 0), "2") == 0;
+    free(base);
+
+    // Invalid hex is never cached
+    const char *bad[] = { "1", "\\x0g", "a" };
+    char *bad_base = arena_build(&r, bad, oids, 1, 3);
+    ok = ok && !bad_base;
+    free(bad_base);
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("blob mismatch");
+    }
+}
+
+// ============================================================================
+// Stale-While-Revalidate Tests (replicates pg_query_cache_lookup() policy)
+// ============================================================================
+
+#define SWR_SOFT_TTL_MS 2000
+#define SWR_HARD_TTL_MS 10000
+#define SWR_MIN_HITS 2
+
+typedef enum { SWR_EXECUTE, SWR_SERVE, SWR_SERVE_AND_REFRESH } swr_action_t;
+
+// versions_match = no write to a dependent table since the snapshot
+static swr_action_t swr_decide(uint64_t created, uint64_t now, int hits_after,
+                               int versions_match, int *refreshing) {
+    if (now >= created + SWR_HARD_TTL_MS || !versions_match) return SWR_EXECUTE;
+    if (now >= created + SWR_SOFT_TTL_MS && hits_after >= SWR_MIN_HITS) {
+        if (*refreshing) return SWR_SERVE;  // One refresh per entry
+        *refreshing = 1;
+        return SWR_SERVE_AND_REFRESH;
+    }
+    return SWR_SERVE;
+}
+
+static void test_swr_policy(void) {
+    TEST("SWR - soft expiry serves and refreshes once, hard expiry executes");
+
+    uint64_t t0 = 1000000;
+    int refreshing = 0;
+    int ok = swr_decide(t0, t0 + 500, 5, 1, &refreshing) == SWR_SERVE;
+    ok = ok && swr_decide(t0, t0 + 3000, 1, 1, &refreshing) == SWR_SERVE;        // Not hot yet
+    ok = ok && swr_decide(t0, t0 + 3000, 2, 1, &refreshing) == SWR_SERVE_AND_REFRESH;
+    ok = ok && swr_decide(t0, t0 + 3100, 3, 1, &refreshing) == SWR_SERVE;        // Already queued
+    ok = ok && swr_decide(t0, t0 + 3200, 4, 0, &refreshing) == SWR_EXECUTE;      // Write invalidated
+    ok = ok && swr_decide(t0, t0 + SWR_HARD_TTL_MS, 9, 1, &refreshing) == SWR_EXECUTE;
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("wrong SWR decision");
+    }
+}
+
+// ============================================================================
+// Negative Cache Tests (replicates neg_lookup()/neg_store() fingerprints)
+// ============================================================================
+
+#define NEG_SLOTS 16
+#define NEG_TABLE_SLOTS 64
+
+typedef struct {
+    uint64_t key;
+    uint64_t check;
+    uint64_t version_sum;
+} mock_neg_t;
+
+static uint64_t neg_versions[NEG_TABLE_SLOTS];
+static uint64_t neg_epoch;
+static mock_neg_t neg_slots[NEG_SLOTS];
+
+static uint64_t neg_sum(const uint32_t *tables, int n) {
+    uint64_t sum = neg_epoch;
+    for (int i = 0; i < n; i++) sum += neg_versions[tables[i] % NEG_TABLE_SLOTS];
+    return sum;
+}
+
+static uint64_t neg_check(const char *sql, const char *param) {
+    uint64_t hash = 0x9e3779b97f4a7c15ULL;
+    for (const char *p = sql; *p; p++) { hash ^= (uint8_t)*p; hash *= 0x100000001b3ULL; }
+    for (const char *p = param; *p; p++) { hash ^= (uint8_t)*p; hash *= 0x100000001b3ULL; }
+    return hash;
+}
+
+static uint64_t neg_key(const char *sql, const char *param) {
+    return fnv1a_hash(sql, strlen(sql)) ^ fnv1a_hash(param, strlen(param));
+}
+
+static void neg_remember(const char *sql, const char *param, uint64_t snapshot_sum) {
+    uint64_t key = neg_key(sql, param);
+    mock_neg_t *n = &neg_slots[key % NEG_SLOTS];
+    n->key = key;
+    n->check = neg_check(sql, param);
+    n->version_sum = snapshot_sum;
+}
+
+static int neg_hit(const char *sql, const char *param, const uint32_t *tables, int ntables) {
+    uint64_t key = neg_key(sql, param);
+    const mock_neg_t *n = &neg_slots[key % NEG_SLOTS];
+    return n->key == key && n->version_sum == neg_sum(tables, ntables) &&
+           n->check == neg_check(sql, param);
+}
+
+static void test_negative_cache(void) {
+    TEST("Negative cache - empty result served until a read table is written");
+
+    const char *sql = "SELECT id FROM taggings WHERE tag_id = $1";
+    uint32_t tables[] = { 3 };         // taggings
+    uint32_t other = 9;                // unrelated table
+
+    uint64_t snapshot = neg_sum(tables, 1);   // lookup() miss snapshot
+    neg_remember(sql, "42", snapshot);
+
+    int ok = neg_hit(sql, "42", tables, 1);
+    ok = ok && !neg_hit(sql, "43", tables, 1);                 // Other params
+    neg_versions[other]++;
+    ok = ok && neg_hit(sql, "42", tables, 1);                  // Unrelated write
+    neg_versions[tables[0]]++;
+    ok = ok && !neg_hit(sql, "42", tables, 1);                 // INSERT into taggings
+
+    // Write between snapshot and store: fingerprint is born stale
+    snapshot = neg_sum(tables, 1);
+    neg_versions[tables[0]]++;
+    neg_remember(sql, "42", snapshot);
+    ok = ok && !neg_hit(sql, "42", tables, 1);
+
+    // Global invalidation (epoch) kills every fingerprint
+    neg_remember(sql, "42", neg_sum(tables, 1));
+    neg_epoch++;
+    ok = ok && !neg_hit(sql, "42", tables, 1);
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("fingerprint served stale or missed fresh");
+    }
+}
+
 // ============================================================================
 // Main
 // ============================================================================
@@ -1063,6 +1654,22 @@ int main(void) {
     test_prepared_cache_eviction_lru();
     test_cache_key_includes_params();
 
+    printf("\n\033[1mTable Dependencies:\033[0m\n");
+    test_tables_from_join();
+    test_tables_write_targets();
+    test_tables_view_maps_to_base();
+    test_version_snapshot_race();
+
+    printf("\n\033[1mColumnar Arena:\033[0m\n");
+    test_arena_round_trip();
+    test_arena_bytea_hit();
+
+    printf("\n\033[1mStale-While-Revalidate:\033[0m\n");
+    test_swr_policy();
+
+    printf("\n\033[1mNegative Cache:\033[0m\n");
+    test_negative_cache();
+
     printf("\n\033[1m=== Results ===\033[0m\n");
     printf("Passed: \033[32m%d\033[0m\n", tests_passed);
     printf("Failed: \033[31m%d\033[0m\n", tests_failed);
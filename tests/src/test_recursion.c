@@ -27,7 +27,8 @@ static int tests_failed = 0;
 #define FAIL(msg) do { printf("\033[31mFAIL: %s\033[0m\n", msg); tests_failed++; } while(0)
 
 // ============================================================================
-// Replicate the loop detection mechanism from db_interpose_prepare.c
+// Replicate the loop detection mechanism (now the per-thread loop detector
+// in pg_row_cache.c, run once per read execution)
 // ============================================================================
 
 typedef struct {
@@ -0,0 +1,1005 @@
+/*
+ * Unit tests for the primary key row cache (pg_row_cache.c)
+ *
+ * Results are built with libpq's PQmakeEmptyPGresult/PQsetResultAttrs, so
+ * column provenance (PQftable/PQftablecol) is exercised without a server.
+ *
+ * Tests:
+ * 1. Point lookup detection - plain columns, aliases, qualifiers, LIMIT 1
+ * 2. Point lookup rejection - expressions, joins, other predicates, cold tables
+ * 3. Write classification - precise by literal / $N, coarse, upsert, multi-statement
+ * 4. Provenance - only results covering every live attribute are full rows
+ * 5. Row round-trip - packed row served as a PGresult with the lookup's columns
+ * 6. Version check - a write during execution prevents the store
+ * 7. Generations - coarse invalidation hides rows without touching them
+ * 8. N+1 batching - upcoming keys from the parent result's current column
+ * 9. N+1 batching - stride fallback, loop threshold, no re-batching of missing keys
+ * 10. Expiry - short TTL without a listener, backstop TTL with one
+ * 11. Key lookups - any table and column, offsets for the batch rewrite
+ * 12. Key lookup batches - rewritten SQL and quoted key array
+ * 13. Key lookup batches - rows split by key, key column dropped
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <errno.h>
+#include <libpq-fe.h>
+
+// Test counters
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST(name) printf("  Testing: %s... ", name)
+#define PASS() do { printf("\033[32mPASS\033[0m\n"); tests_passed++; } while(0)
+#define FAIL(msg) do { printf("\033[31mFAIL: %s\033[0m\n", msg); tests_failed++; } while(0)
+
+// ============================================================================
+// Replicated from pg_row_cache.c
+// ============================================================================
+
+static const char *HOT_TABLES[] = {
+    "metadata_items", "media_items", "media_parts", "tags", NULL
+};
+
+static int hot_table_index(const char *name) {
+    for (int i = 0; HOT_TABLES[i]; i++) {
+        if (strcmp(name, HOT_TABLES[i]) == 0) return i;
+    }
+    return -1;
+}
+
+static int parse_id(const char *s, int64_t *out) {
+    if (!s || !*s) return 0;
+    char *end;
+    errno = 0;
+    long long v = strtoll(s, &end, 10);
+    if (errno || *end) return 0;
+    *out = v;
+    return 1;
+}
+
+static inline int rc_ident_char(char c) {
+    return isalnum((unsigned char)c) || c == '_';
+}
+
+static const char* rc_skip_ws(const char *p) {
+    while (*p && isspace((unsigned char)*p)) p++;
+    return p;
+}
+
+static int rc_read_ident(const char **pp, char *out, size_t outsz) {
+    const char *p = *pp;
+    size_t n = 0;
+    for (;;) {
+        n = 0;
+        if (*p == '"') {
+            p++;
+            while (*p && *p != '"') {
+                if (n + 1 < outsz) out[n++] = (char)tolower((unsigned char)*p);
+                p++;
+            }
+            if (*p == '"') p++;
+        } else if (rc_ident_char(*p)) {
+            while (rc_ident_char(*p)) {
+                if (n + 1 < outsz) out[n++] = (char)tolower((unsigned char)*p);
+                p++;
+            }
+        } else {
+            break;
+        }
+        if (*p != '.') break;
+        p++;
+    }
+    out[n] = '\0';
+    *pp = p;
+    return n > 0;
+}
+
+static int rc_keyword(const char **pp, const char *kw) {
+    const char *p = rc_skip_ws(*pp);
+    size_t len = strlen(kw);
+    if (strncasecmp(p, kw, len) != 0 || rc_ident_char(p[len])) return 0;
+    *pp = p + len;
+    return 1;
+}
+
+static const char* find_where(const char *p) {
+    int depth = 0;
+    while (*p) {
+        if (*p == '\'' || *p == '"') {
+            char q = *p++;
+            while (*p && *p != q) p++;
+            if (*p) p++;
+        } else if (*p == '(') {
+            depth++;
+            p++;
+        } else if (*p == ')') {
+            depth--;
+            p++;
+        } else if (rc_ident_char(*p)) {
+            const char *w = p;
+            while (rc_ident_char(*p)) p++;
+            if (depth == 0 && p - w == 5 && strncasecmp(w, "where", 5) == 0) return p;
+        } else {
+            p++;
+        }
+    }
+    return NULL;
+}
+
+static int parse_id_predicate(const char *p, int *param, int64_t *literal) {
+    char name[64];
+    p = rc_skip_ws(p);
+    if (!rc_read_ident(&p, name, sizeof(name)) || strcmp(name, "id") != 0) return 0;
+    p = rc_skip_ws(p);
+    if (*p++ != '=') return 0;
+    p = rc_skip_ws(p);
+
+    *param = 0;
+    if (*p == '$') {
+        p++;
+        if (!isdigit((unsigned char)*p)) return 0;
+        while (isdigit((unsigned char)*p)) *param = *param * 10 + (*p++ - '0');
+    } else {
+        char *end;
+        errno = 0;
+        *literal = strtoll(p, &end, 10);
+        if (errno || end == p) return 0;
+        p = end;
+    }
+
+    p = rc_skip_ws(p);
+    if (rc_keyword(&p, "returning")) return 1;
+    if (*p == ';') p = rc_skip_ws(p + 1);
+    return *p == '\0';
+}
+
+typedef struct {
+    char table[64];
+    char column[64];
+    int from;
+    int where;
+    int key, key_len;
+    int limit1;
+} rc_key_lookup_t;
+
+static int analyze_key_lookup(const char *sql, rc_key_lookup_t *k) {
+    const char *p = sql;
+    if (!rc_keyword(&p, "select")) return 0;
+
+    const char *from = NULL;
+    while (*p && !from) {
+        if (*p == '(' || *p == '\'' || *p == ';') return 0;
+        if (*p == '"') {
+            p++;
+            while (*p && *p != '"') p++;
+            if (*p) p++;
+        } else if (rc_ident_char(*p)) {
+            const char *w = p;
+            while (rc_ident_char(*p)) p++;
+            if (p - w == 4 && strncasecmp(w, "from", 4) == 0) from = w;
+        } else {
+            p++;
+        }
+    }
+    if (!from) return 0;
+    k->from = (int)(from - sql);
+
+    char name[64];
+    p = rc_skip_ws(p);
+    if (!rc_read_ident(&p, k->table, sizeof(k->table))) return 0;
+
+    const char *where = rc_skip_ws(p);
+    if (!rc_keyword(&p, "where")) {
+        rc_keyword(&p, "as");
+        p = rc_skip_ws(p);
+        if (!rc_read_ident(&p, name, sizeof(name))) return 0;
+        where = rc_skip_ws(p);
+        if (!rc_keyword(&p, "where")) return 0;
+    }
+    k->where = (int)(where - sql);
+
+    p = rc_skip_ws(p);
+    const char *key = p;
+    if (!rc_read_ident(&p, k->column, sizeof(k->column))) return 0;
+    k->key = (int)(key - sql);
+    k->key_len = (int)(p - key);
+    p = rc_skip_ws(p);
+    if (*p++ != '=') return 0;
+    p = rc_skip_ws(p);
+    if (strncmp(p, "$1", 2) != 0 || isdigit((unsigned char)p[2])) return 0;
+    p += 2;
+
+    k->limit1 = 0;
+    if (rc_keyword(&p, "limit")) {
+        p = rc_skip_ws(p);
+        if (*p++ != '1' || isdigit((unsigned char)*p)) return 0;
+        k->limit1 = 1;
+    }
+    p = rc_skip_ws(p);
+    if (*p == ';') p = rc_skip_ws(p + 1);
+    return *p == '\0';
+}
+
+// shape_table(): hot table index for a point lookup by id, else -1
+static int analyze_point_lookup(const char *sql) {
+    rc_key_lookup_t k;
+    if (!analyze_key_lookup(sql, &k) || strcmp(k.column, "id") != 0) return -1;
+    return hot_table_index(k.table);
+}
+
+// pg_row_cache_invalidate_write() decisions, without the side effects
+enum { W_NONE, W_ROW, W_TABLE, W_ALL };
+
+static int classify_write(const char *sql, const char **params, int nparams, int *table_out, int64_t *id_out) {
+    const char *p = sql;
+    int in_quote = 0;
+    for (const char *s = sql; *s; s++) {
+        if (*s == '\'') in_quote = !in_quote;
+        if (*s == ';' && !in_quote && *rc_skip_ws(s + 1)) return W_ALL;
+    }
+
+    char name[64];
+    int table;
+    *table_out = -1;
+    if (rc_keyword(&p, "insert")) {
+        if (!rc_keyword(&p, "into")) return W_ALL;
+        p = rc_skip_ws(p);
+        if (!rc_read_ident(&p, name, sizeof(name))) return W_ALL;
+        table = hot_table_index(name);
+        *table_out = table;
+        return (table >= 0 && strcasestr(p, "on conflict")) ? W_TABLE : W_NONE;
+    } else if (rc_keyword(&p, "update")) {
+        rc_keyword(&p, "only");
+    } else if (rc_keyword(&p, "delete")) {
+        if (!rc_keyword(&p, "from")) return W_ALL;
+    } else {
+        return W_ALL;
+    }
+
+    p = rc_skip_ws(p);
+    if (!rc_read_ident(&p, name, sizeof(name))) return W_ALL;
+    table = hot_table_index(name);
+    *table_out = table;
+    if (table < 0) return W_NONE;
+
+    const char *where = find_where(p);
+    int param = 0;
+    int64_t id = 0;
+    if (where && !strcasestr(p, " from ") && !strcasestr(p, " using ") &&
+        parse_id_predicate(where, &param, &id)) {
+        if (param == 0 ||
+            (param <= nparams && params[param - 1] && parse_id(params[param - 1], &id))) {
+            *id_out = id;
+            return W_ROW;
+        }
+    }
+    return W_TABLE;
+}
+
+// ============================================================================
+// Point Lookup Tests
+// ============================================================================
+
+static void test_point_lookup_detection(void) {
+    TEST("Point lookup - plain columns, aliases, qualifiers, LIMIT 1");
+
+    int ok = analyze_point_lookup("SELECT * FROM metadata_items WHERE id = $1") == 0 &&
+             analyze_point_lookup("select id, title from media_items where id=$1") == 1 &&
+             analyze_point_lookup("SELECT m.id, m.\"index\" FROM plex.metadata_items m WHERE m.id = $1") == 0 &&
+             analyze_point_lookup("SELECT p.* FROM media_parts AS p WHERE p.id = $1 LIMIT 1") == 2 &&
+             analyze_point_lookup("SELECT tag FROM \"tags\" WHERE \"id\" = $1;") == 3;
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("point lookup not recognized");
+    }
+}
+
+static void test_point_lookup_rejection(void) {
+    TEST("Point lookup - expressions, joins, other predicates, cold tables");
+
+    const char *rejected[] = {
+        "SELECT count(*) FROM metadata_items WHERE id = $1",
+        "SELECT 'x', id FROM metadata_items WHERE id = $1",
+        "SELECT * FROM metadata_items m JOIN media_items mi ON mi.metadata_item_id = m.id WHERE m.id = $1",
+        "SELECT * FROM metadata_items WHERE id = $1 AND deleted_at IS NULL",
+        "SELECT * FROM metadata_items WHERE parent_id = $1",
+        "SELECT * FROM metadata_items WHERE id = $10",
+        "SELECT * FROM metadata_items WHERE id = $2",
+        "SELECT * FROM metadata_items WHERE id = $1 LIMIT 10",
+        "SELECT * FROM metadata_items WHERE id = $1 ORDER BY title",
+        "SELECT * FROM taggings WHERE id = $1",
+        "SELECT * FROM metadata_items WHERE id = 5",
+        NULL
+    };
+    for (int i = 0; rejected[i]; i++) {
+        if (analyze_point_lookup(rejected[i]) != -1) {
+            FAIL(rejected[i]);
+            return;
+        }
+    }
+    PASS();
+}
+
+// ============================================================================
+// Write Classification Tests
+// ============================================================================
+
+static void test_write_classification(void) {
+    TEST("Writes - precise by literal/$N, coarse, upsert, multi-statement");
+
+    const char *params[] = { "now", "42" };
+    int t;
+    int64_t id = 0;
+    int ok = 1;
+
+    ok = ok && classify_write("UPDATE metadata_items SET title = $1 WHERE id = $2", params, 2, &t, &id) == W_ROW &&
+               t == 0 && id == 42;
+    ok = ok && classify_write("DELETE FROM media_parts WHERE media_parts.id = 7", NULL, 0, &t, &id) == W_ROW &&
+               t == 2 && id == 7;
+    ok = ok && classify_write("UPDATE tags SET tag = 'where id = 1' WHERE id = 3 RETURNING id", NULL, 0, &t, &id) == W_ROW &&
+               t == 3 && id == 3;
+    // Predicate isn't just the id, or the id isn't known
+    ok = ok && classify_write("UPDATE metadata_items SET x = 1 WHERE parent_id = 5", NULL, 0, &t, &id) == W_TABLE;
+    ok = ok && classify_write("UPDATE metadata_items SET x = 1 WHERE id = 5 AND y = 2", NULL, 0, &t, &id) == W_TABLE;
+    ok = ok && classify_write("UPDATE metadata_items SET x = 1 WHERE id IN (1, 2)", NULL, 0, &t, &id) == W_TABLE;
+    ok = ok && classify_write("UPDATE metadata_items SET x = 1 WHERE id = $3", params, 2, &t, &id) == W_TABLE;
+    ok = ok && classify_write("UPDATE metadata_items SET x = (SELECT max(y) FROM tags) WHERE id = 5", NULL, 0, &t, &id) == W_TABLE;
+    ok = ok && classify_write("UPDATE metadata_items SET x = 1", NULL, 0, &t, &id) == W_TABLE;
+    // Inserts only matter as upserts
+    ok = ok && classify_write("INSERT INTO metadata_items (title) VALUES ($1)", params, 1, &t, &id) == W_NONE;
+    ok = ok && classify_write("INSERT INTO tags (id, tag) VALUES (1, 'a') ON CONFLICT (id) DO UPDATE SET tag = 'a'", NULL, 0, &t, &id) == W_TABLE;
+    // Cold tables, unknown statements, batches
+    ok = ok && classify_write("UPDATE taggings SET x = 1", NULL, 0, &t, &id) == W_NONE;
+    ok = ok && classify_write("WITH d AS (DELETE FROM tags RETURNING id) SELECT 1", NULL, 0, &t, &id) == W_ALL;
+    ok = ok && classify_write("UPDATE tags SET x = 1 WHERE id = 1; DELETE FROM tags", NULL, 0, &t, &id) == W_ALL;
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("wrong invalidation decision");
+    }
+}
+
+// ============================================================================
+// Provenance / Row Tests
+// ============================================================================
+
+#define TBL_OID 16400
+#define OTHER_OID 16500
+
+// Result with the given (table, attnum) columns and one row of values
+static PGresult* make_result(int ncols, const Oid *tables, const int *attnums,
+                             const char **names, const char **values) {
+    PGresult *res = PQmakeEmptyPGresult(NULL, PGRES_TUPLES_OK);
+    PGresAttDesc attrs[16];
+    memset(attrs, 0, sizeof(attrs));
+    for (int c = 0; c < ncols; c++) {
+        attrs[c].name = (char *)names[c];
+        attrs[c].tableid = tables[c];
+        attrs[c].columnid = attnums[c];
+        attrs[c].typid = 25;  // text
+        attrs[c].typlen = -1;
+        attrs[c].atttypmod = -1;
+    }
+    PQsetResultAttrs(res, ncols, attrs);
+    for (int c = 0; values && c < ncols; c++) {
+        PQsetvalue(res, 0, c, (char *)values[c], values[c] ? (int)strlen(values[c]) : -1);
+    }
+    return res;
+}
+
+// full_row_table() for a single table with natts live attributes, attnum 2 dropped
+static int is_full_row(const PGresult *res, int natts, int max_attnum, int *col_of) {
+    Oid oid = PQftable(res, 0);
+    if (oid != TBL_OID || PQnfields(res) < natts) return 0;
+    for (int a = 0; a < max_attnum; a++) col_of[a] = -1;
+    int distinct = 0;
+    for (int c = 0; c < PQnfields(res); c++) {
+        int attnum = PQftablecol(res, c);
+        if (PQftable(res, c) != oid || attnum <= 0 || attnum > max_attnum) return 0;
+        if (col_of[attnum - 1] < 0) distinct++;
+        col_of[attnum - 1] = c;
+    }
+    return distinct == natts;
+}
+
+static void test_provenance(void) {
+    TEST("Provenance - only complete single-table rows qualify");
+
+    // Table: attnums 1 (id), 3 (title), 4 (year); attnum 2 dropped
+    const char *names[] = { "id", "title", "year", "x" };
+    int col_of[8];
+    int ok = 1;
+
+    Oid t_full[] = { TBL_OID, TBL_OID, TBL_OID };
+    int a_full[] = { 3, 1, 4 };  // Any order
+    PGresult *res = make_result(3, t_full, a_full, names, NULL);
+    ok = ok && is_full_row(res, 3, 4, col_of) && col_of[0] == 1 && col_of[2] == 0 && col_of[1] == -1;
+    PQclear(res);
+
+    int a_partial[] = { 1, 3 };
+    res = make_result(2, t_full, a_partial, names, NULL);
+    ok = ok && !is_full_row(res, 3, 4, col_of);
+    PQclear(res);
+
+    int a_dup[] = { 1, 3, 3 };  // Same column twice isn't coverage
+    res = make_result(3, t_full, a_dup, names, NULL);
+    ok = ok && !is_full_row(res, 3, 4, col_of);
+    PQclear(res);
+
+    Oid t_join[] = { TBL_OID, TBL_OID, TBL_OID, OTHER_OID };
+    int a_join[] = { 1, 3, 4, 1 };
+    res = make_result(4, t_join, a_join, names, NULL);
+    ok = ok && !is_full_row(res, 3, 4, col_of);
+    PQclear(res);
+
+    Oid t_expr[] = { TBL_OID, TBL_OID, TBL_OID, 0 };
+    int a_expr[] = { 1, 3, 4, 0 };  // Computed column
+    res = make_result(4, t_expr, a_expr, names, NULL);
+    ok = ok && !is_full_row(res, 3, 4, col_of);
+    PQclear(res);
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("wrong full-row decision");
+    }
+}
+
+// Packed row as in build_row(): offsets, null flags, data
+typedef struct {
+    int nattrs;
+    uint32_t offsets[9];
+    uint8_t nulls[8];
+    char data[256];
+} test_row_t;
+
+static void pack_row(test_row_t *row, const PGresult *res, int nattrs, const int *col_of) {
+    uint32_t off = 0;
+    row->nattrs = nattrs;
+    for (int a = 0; a < nattrs; a++) {
+        row->offsets[a] = off;
+        row->nulls[a] = col_of[a] < 0 || PQgetisnull(res, 0, col_of[a]);
+        if (!row->nulls[a]) {
+            int len = PQgetlength(res, 0, col_of[a]);
+            memcpy(row->data + off, PQgetvalue(res, 0, col_of[a]), (size_t)len);
+            off += (uint32_t)len;
+        }
+    }
+    row->offsets[nattrs] = off;
+}
+
+static void test_row_round_trip(void) {
+    TEST("Row round-trip - served result has the lookup's columns");
+
+    const char *names[] = { "id", "title", "year" };
+    const char *values[] = { "42", "Alien", NULL };
+    Oid tables[] = { TBL_OID, TBL_OID, TBL_OID };
+    int attnums[] = { 1, 3, 4 };
+    PGresult *full = make_result(3, tables, attnums, names, values);
+
+    int col_of[8];
+    test_row_t row;
+    int ok = is_full_row(full, 3, 4, col_of);
+    pack_row(&row, full, 4, col_of);
+
+    // The point lookup selects "year, title" - serve from the packed row
+    const char *lk_names[] = { "year", "title" };
+    int lk_attnums[] = { 4, 3 };
+    PGresult *shape = make_result(2, tables, lk_attnums, lk_names, NULL);
+    PGresult *served = PQcopyResult(shape, PG_COPYRES_ATTRS);
+    for (int c = 0; c < PQnfields(served); c++) {
+        int a = PQftablecol(served, c) - 1;
+        ok = ok && (row.nulls[a]
+            ? PQsetvalue(served, 0, c, NULL, -1)
+            : PQsetvalue(served, 0, c, row.data + row.offsets[a], (int)(row.offsets[a + 1] - row.offsets[a])));
+    }
+
+    ok = ok && PQntuples(served) == 1 && PQnfields(served) == 2 &&
+         strcmp(PQfname(served, 1), "title") == 0 &&
+         PQftable(served, 0) == TBL_OID && PQftablecol(served, 0) == 4 &&
+         PQgetisnull(served, 0, 0) &&
+         strcmp(PQgetvalue(served, 0, 1), "Alien") == 0 && PQgetlength(served, 0, 1) == 5 &&
+         row.nulls[1];  // Dropped attribute
+
+    PQclear(full);
+    PQclear(shape);
+    PQclear(served);
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("served values or attributes differ");
+    }
+}
+
+// ============================================================================
+// Freshness Tests
+// ============================================================================
+
+static void test_version_check(void) {
+    TEST("Version check - write during execution skips the store");
+
+    uint64_t table_version = 7;
+
+    // Reader snapshots, then a writer commits and bumps before the store
+    uint64_t snap = table_version;
+    table_version++;
+    int stored = (table_version == snap);
+
+    // Reader without a concurrent write stores
+    uint64_t snap2 = table_version;
+    int stored2 = (table_version == snap2);
+
+    if (!stored && stored2) {
+        PASS();
+    } else {
+        FAIL("store decision wrong");
+    }
+}
+
+static void test_generations(void) {
+    TEST("Generations - coarse invalidation hides existing rows");
+
+    uint64_t table_gen = 3, all_gen = 1, schema = 2;
+    struct { uint64_t gen, all_gen, schema; } row = { table_gen, all_gen, schema };
+#define ROW_VALID() (row.gen == table_gen && row.all_gen == all_gen && row.schema == schema)
+
+    int ok = ROW_VALID();
+    table_gen++;                 // Remote or non-precise write to the table
+    ok = ok && !ROW_VALID();
+    row.gen = table_gen;
+    ok = ok && ROW_VALID();
+    all_gen++;                   // "*" from another process
+    ok = ok && !ROW_VALID();
+    row.all_gen = all_gen;
+    schema++;                    // DDL
+    ok = ok && !ROW_VALID();
+#undef ROW_VALID
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("stale row visible");
+    }
+}
+
+#define ROW_CACHE_TTL_MS 10000
+#define ROW_CACHE_LISTEN_TTL_MS 60000
+
+static int row_fresh(uint64_t created_ms, uint64_t now, int listening) {
+    uint64_t ttl = listening ? ROW_CACHE_LISTEN_TTL_MS : ROW_CACHE_TTL_MS;
+    return now - created_ms < ttl;
+}
+
+static void test_expiry(void) {
+    TEST("Expiry - rows age out, quickly when nobody notifies");
+
+    uint64_t created = 50000;
+    int ok = row_fresh(created, created, 0) && row_fresh(created, created + ROW_CACHE_TTL_MS - 1, 0);
+    // Listener down (pgbouncer, lost connection): scanner writes are unseen
+    ok = ok && !row_fresh(created, created + ROW_CACHE_TTL_MS, 0);
+    // Listener up: generations do the work, the TTL is a backstop
+    ok = ok && row_fresh(created, created + ROW_CACHE_TTL_MS, 1);
+    ok = ok && !row_fresh(created, created + ROW_CACHE_LISTEN_TTL_MS, 1);
+    // Stored while listening, listener then lost: the short TTL applies
+    ok = ok && !row_fresh(created, created + 2 * ROW_CACHE_TTL_MS, 0);
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("row served past its TTL");
+    }
+}
+
+// ============================================================================
+// N+1 Batching Tests
+// ============================================================================
+
+#define ROW_CACHE_LOOP_MISSES 4
+#define ROW_CACHE_BATCH_IDS 64
+#define ROW_CACHE_BATCH_ROWS 1024
+#define RC_KEY_LEN 64
+
+static uint64_t key_hash(const char *s) {
+    uint64_t hash = 14695981039346656037ULL;
+    while (*s) {
+        hash ^= (uint64_t)(unsigned char)*s++;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Parent result: column 0 = child id, column 1 = title
+static PGresult* make_parent(int nrows, const char **ids) {
+    PGresult *res = PQmakeEmptyPGresult(NULL, PGRES_TUPLES_OK);
+    PGresAttDesc attrs[2];
+    memset(attrs, 0, sizeof(attrs));
+    attrs[0].name = "metadata_item_id";
+    attrs[1].name = "title";
+    for (int c = 0; c < 2; c++) {
+        attrs[c].typid = 25;
+        attrs[c].typlen = -1;
+        attrs[c].atttypmod = -1;
+    }
+    PQsetResultAttrs(res, 2, attrs);
+    for (int r = 0; r < nrows; r++) {
+        PQsetvalue(res, r, 0, (char *)ids[r], ids[r] ? (int)strlen(ids[r]) : -1);
+        PQsetvalue(res, r, 1, "42", 2);  // Same text as an id, other column
+    }
+    return res;
+}
+
+// parent_keys() for a PGresult parent positioned at row
+static int parent_keys(const PGresult *res, int row, const char *key, char (*out)[RC_KEY_LEN], int max) {
+    int n = 0;
+    for (int c = 0; c < PQnfields(res) && n == 0; c++) {
+        const char *v = PQgetisnull(res, row, c) ? NULL : PQgetvalue(res, row, c);
+        if (!v || strcmp(v, key) != 0) continue;
+        for (int r = row + 1; r < PQntuples(res) && n < max; r++) {
+            const char *next = PQgetisnull(res, r, c) ? NULL : PQgetvalue(res, r, c);
+            if (next && *next && strlen(next) < RC_KEY_LEN && strcmp(next, key) != 0) {
+                strcpy(out[n++], next);
+            }
+        }
+    }
+    return n;
+}
+
+static void test_batch_parent_keys(void) {
+    TEST("N+1 batching - next keys from the parent's current column");
+
+    const char *ids[] = { "10", "11", NULL, "11", "15", "16", "guid://a" };
+    PGresult *parent = make_parent(7, ids);
+    char out[ROW_CACHE_BATCH_IDS][RC_KEY_LEN];
+
+    // Stepping row 1 (key 11): following rows, NULLs and repeats of 11 skipped
+    int n = parent_keys(parent, 1, "11", out, ROW_CACHE_BATCH_IDS);
+    int ok = n == 3 && strcmp(out[0], "15") == 0 && strcmp(out[1], "16") == 0 &&
+             strcmp(out[2], "guid://a") == 0;
+
+    // Capped at max
+    n = parent_keys(parent, 0, "10", out, 2);
+    ok = ok && n == 2 && strcmp(out[0], "11") == 0 && strcmp(out[1], "11") == 0;
+
+    // Key isn't in the current row: not this loop's parent
+    ok = ok && parent_keys(parent, 4, "99", out, ROW_CACHE_BATCH_IDS) == 0;
+
+    // Last row: nothing left to prefetch
+    ok = ok && parent_keys(parent, 6, "guid://a", out, ROW_CACHE_BATCH_IDS) == 0;
+    PQclear(parent);
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("wrong upcoming keys");
+    }
+}
+
+// loop_should_batch() + loop_keys() without parents, windows or I/O
+typedef struct {
+    int misses;
+    int64_t recent[3];
+    int nrecent;
+    uint64_t batched[ROW_CACHE_BATCH_IDS];
+    int nbatched;
+} loop_t;
+
+static void loop_note_id(loop_t *l, int64_t id) {
+    if (l->nrecent == 3) memmove(l->recent, l->recent + 1, sizeof(l->recent[0]) * 2);
+    l->recent[l->nrecent == 3 ? 2 : l->nrecent++] = id;
+}
+
+static int batch_keys(loop_t *l, const char *key, char (*keys)[RC_KEY_LEN]) {
+    if (++l->misses < ROW_CACHE_LOOP_MISSES) return 0;
+    uint64_t h = key_hash(key);
+    for (int i = 0; i < l->nbatched; i++) {
+        if (l->batched[i] == h) return 0;
+    }
+    int n = 0;
+    strcpy(keys[n++], key);
+    int64_t id;
+    if (l->nrecent == 3 && parse_id(key, &id) && l->recent[2] == id &&
+        l->recent[2] - l->recent[1] == l->recent[1] - l->recent[0]) {
+        int64_t stride = l->recent[2] - l->recent[1];
+        for (int i = 1; stride != 0 && i < ROW_CACHE_BATCH_IDS; i++) {
+            snprintf(keys[n++], RC_KEY_LEN, "%lld", (long long)(id + stride * i));
+        }
+    }
+    if (n < 2) return 0;
+    for (int i = 0; i < n; i++) l->batched[i] = key_hash(keys[i]);
+    l->nbatched = n;
+    return n;
+}
+
+static void test_batch_stride(void) {
+    TEST("N+1 batching - stride fallback, threshold, no re-batching");
+
+    loop_t l;
+    memset(&l, 0, sizeof(l));
+    char keys[ROW_CACHE_BATCH_IDS][RC_KEY_LEN];
+    char key[RC_KEY_LEN];
+    int ok = 1;
+
+    // Descending ids 100, 98, 96: below the threshold nothing is batched
+    for (int64_t id = 100; id > 94; id -= 2) {
+        loop_note_id(&l, id);
+        snprintf(key, sizeof(key), "%lld", (long long)id);
+        ok = ok && batch_keys(&l, key, keys) == 0;
+    }
+    // 4th miss: 94 plus 63 extrapolated ids
+    loop_note_id(&l, 94);
+    int n = batch_keys(&l, "94", keys);
+    ok = ok && n == ROW_CACHE_BATCH_IDS && strcmp(keys[0], "94") == 0 &&
+         strcmp(keys[1], "92") == 0 && strcmp(keys[63], "-32") == 0;
+
+    // 92 was requested but is still missing (no such row): plain query
+    loop_note_id(&l, 92);
+    ok = ok && batch_keys(&l, "92", keys) == 0;
+
+    // Irregular ids: nothing to extrapolate
+    loop_t l2;
+    memset(&l2, 0, sizeof(l2));
+    l2.misses = ROW_CACHE_LOOP_MISSES;
+    loop_note_id(&l2, 5);
+    loop_note_id(&l2, 9);
+    loop_note_id(&l2, 30);
+    ok = ok && batch_keys(&l2, "30", keys) == 0;
+
+    // Text keys: no stride
+    loop_t l3;
+    memset(&l3, 0, sizeof(l3));
+    l3.misses = ROW_CACHE_LOOP_MISSES;
+    ok = ok && batch_keys(&l3, "abc", keys) == 0;
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("wrong batching decision");
+    }
+}
+
+static void test_key_lookup_detection(void) {
+    TEST("Key lookups - any table and column, offsets, LIMIT 1");
+
+    rc_key_lookup_t k;
+    const char *sql = "SELECT t.tag, t.tag_type FROM taggings AS t WHERE t.metadata_item_id = $1 LIMIT 1";
+    int ok = analyze_key_lookup(sql, &k) &&
+             strcmp(k.table, "taggings") == 0 && strcmp(k.column, "metadata_item_id") == 0 &&
+             strncmp(sql + k.from, "FROM", 4) == 0 && strncmp(sql + k.where, "WHERE", 5) == 0 &&
+             k.key_len == 18 && strncmp(sql + k.key, "t.metadata_item_id", 18) == 0 && k.limit1;
+
+    ok = ok && analyze_key_lookup("select * from \"plex\".\"library_sections\" where uuid=$1", &k) &&
+         strcmp(k.table, "library_sections") == 0 && strcmp(k.column, "uuid") == 0 && !k.limit1;
+
+    // Hot tables by another column are key lookups, not point lookups
+    ok = ok && analyze_key_lookup("SELECT * FROM metadata_items WHERE parent_id = $1", &k) &&
+         analyze_point_lookup("SELECT * FROM metadata_items WHERE parent_id = $1") == -1;
+
+    const char *rejected[] = {
+        "SELECT count(*) FROM taggings WHERE tag_id = $1",
+        "SELECT * FROM taggings WHERE tag_id = $1 AND \"index\" = 0",
+        "SELECT * FROM taggings WHERE tag_id = $1 ORDER BY \"index\"",
+        "SELECT * FROM taggings t JOIN tags ON tags.id = t.tag_id WHERE t.metadata_item_id = $1",
+        "SELECT * FROM taggings WHERE tag_id = $2",
+        "SELECT * FROM taggings WHERE tag_id > $1",
+        "UPDATE taggings SET \"index\" = 1 WHERE id = $1",
+        NULL
+    };
+    for (int i = 0; ok && rejected[i]; i++) {
+        if (analyze_key_lookup(rejected[i], &k)) {
+            FAIL(rejected[i]);
+            return;
+        }
+    }
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("key lookup not recognized");
+    }
+}
+
+// batch_sql() and key_array()
+static char* batch_sql(const char *sql, const rc_key_lookup_t *k) {
+    int cols_end = k->from;
+    while (cols_end > 0 && isspace((unsigned char)sql[cols_end - 1])) cols_end--;
+    size_t len = strlen(sql) + (size_t)k->key_len * 2 + 64;
+    char *out = malloc(len);
+    if (!out) return NULL;
+    snprintf(out, len, "%.*s, %.*s %.*sWHERE %.*s = ANY($1) LIMIT %d",
+             cols_end, sql, k->key_len, sql + k->key, k->where - k->from, sql + k->from,
+             k->key_len, sql + k->key, ROW_CACHE_BATCH_ROWS + 1);
+    return out;
+}
+
+static char* key_array(char (*keys)[RC_KEY_LEN], int n) {
+    char *out = malloc((size_t)n * (RC_KEY_LEN * 2 + 3) + 3);
+    if (!out) return NULL;
+    char *o = out;
+    *o++ = '{';
+    for (int i = 0; i < n; i++) {
+        if (i) *o++ = ',';
+        *o++ = '"';
+        for (const char *c = keys[i]; *c; c++) {
+            if (*c == '"' || *c == '\\') *o++ = '\\';
+            *o++ = *c;
+        }
+        *o++ = '"';
+    }
+    *o++ = '}';
+    *o = '\0';
+    return out;
+}
+
+static void test_batch_sql(void) {
+    TEST("Key lookup batches - rewritten SQL and key array");
+
+    rc_key_lookup_t k;
+    int ok = 1;
+    char *sql = NULL;
+    if (analyze_key_lookup("SELECT t.tag, t.tag_type  FROM taggings AS t WHERE t.metadata_item_id = $1 LIMIT 1", &k)) {
+        sql = batch_sql("SELECT t.tag, t.tag_type  FROM taggings AS t WHERE t.metadata_item_id = $1 LIMIT 1", &k);
+    }
+    ok = sql && strcmp(sql, "SELECT t.tag, t.tag_type, t.metadata_item_id FROM taggings AS t "
+                            "WHERE t.metadata_item_id = ANY($1) LIMIT 1025") == 0;
+    free(sql);
+
+    sql = NULL;
+    if (analyze_key_lookup("select * from library_sections where \"uuid\"=$1;", &k)) {
+        sql = batch_sql("select * from library_sections where \"uuid\"=$1;", &k);
+    }
+    ok = ok && sql && strcmp(sql, "select *, \"uuid\" from library_sections "
+                                  "WHERE \"uuid\" = ANY($1) LIMIT 1025") == 0;
+    free(sql);
+
+    char keys[3][RC_KEY_LEN] = { "12", "a\"b", "c\\d,e" };
+    char *array = key_array(keys, 3);
+    ok = ok && array && strcmp(array, "{\"12\",\"a\\\"b\",\"c\\\\d,e\"}") == 0;
+    free(array);
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("wrong batch query");
+    }
+}
+
+// serve_batch() row selection, without validity checks
+static PGresult* split_batch(const PGresult *b, const char *key, int limit1) {
+    int ncols = PQnfields(b) - 1;
+    int nrows = PQntuples(b);
+    int r = 0;
+    while (r < nrows && (PQgetisnull(b, r, ncols) || strcmp(PQgetvalue(b, r, ncols), key) != 0)) r++;
+    if (r == nrows) return NULL;
+
+    PGresAttDesc *attrs = calloc((size_t)ncols, sizeof(PGresAttDesc));
+    PGresult *res = attrs ? PQmakeEmptyPGresult(NULL, PGRES_TUPLES_OK) : NULL;
+    for (int c = 0; c < ncols && res; c++) {
+        attrs[c].name = PQfname(b, c);
+        attrs[c].tableid = PQftable(b, c);
+        attrs[c].columnid = PQftablecol(b, c);
+        attrs[c].format = PQfformat(b, c);
+        attrs[c].typid = PQftype(b, c);
+        attrs[c].typlen = PQfsize(b, c);
+        attrs[c].atttypmod = PQfmod(b, c);
+    }
+    if (res && !PQsetResultAttrs(res, ncols, attrs)) {
+        PQclear(res);
+        res = NULL;
+    }
+    free(attrs);
+
+    int out = 0;
+    for (; res && r < nrows; r++) {
+        if (PQgetisnull(b, r, ncols) || strcmp(PQgetvalue(b, r, ncols), key) != 0) continue;
+        for (int c = 0; c < ncols; c++) {
+            int ok = PQgetisnull(b, r, c)
+                ? PQsetvalue(res, out, c, NULL, -1)
+                : PQsetvalue(res, out, c, PQgetvalue(b, r, c), PQgetlength(b, r, c));
+            if (!ok) {
+                PQclear(res);
+                res = NULL;
+                break;
+            }
+        }
+        out++;
+        if (limit1) break;
+    }
+    return res;
+}
+
+static void test_batch_split(void) {
+    TEST("Key lookup batches - rows split by key, key column dropped");
+
+    // tag, tag_type, appended key metadata_item_id
+    PGresult *b = PQmakeEmptyPGresult(NULL, PGRES_TUPLES_OK);
+    PGresAttDesc attrs[3];
+    memset(attrs, 0, sizeof(attrs));
+    const char *names[3] = { "tag", "tag_type", "metadata_item_id" };
+    const Oid types[3] = { 25, 23, 20 };
+    for (int c = 0; c < 3; c++) {
+        attrs[c].name = (char *)names[c];
+        attrs[c].tableid = TBL_OID + 1;
+        attrs[c].columnid = c + 1;
+        attrs[c].typid = types[c];
+        attrs[c].typlen = -1;
+        attrs[c].atttypmod = -1;
+    }
+    PQsetResultAttrs(b, 3, attrs);
+    const char *rows[][3] = {
+        { "Drama", "1", "7" }, { "Comedy", "1", "8" }, { NULL, "2", "7" }, { "Crime", "1", "70" },
+    };
+    for (int r = 0; r < 4; r++) {
+        for (int c = 0; c < 3; c++) {
+            PQsetvalue(b, r, c, (char *)rows[r][c], rows[r][c] ? (int)strlen(rows[r][c]) : -1);
+        }
+    }
+
+    PGresult *res = split_batch(b, "7", 0);
+    int ok = res && PQntuples(res) == 2 && PQnfields(res) == 2 &&
+             strcmp(PQfname(res, 1), "tag_type") == 0 && PQftype(res, 1) == 23 &&
+             PQftable(res, 0) == TBL_OID + 1 && PQftablecol(res, 1) == 2 &&
+             strcmp(PQgetvalue(res, 0, 0), "Drama") == 0 &&
+             PQgetisnull(res, 1, 0) && strcmp(PQgetvalue(res, 1, 1), "2") == 0;
+    PQclear(res);
+
+    // LIMIT 1: first match only
+    res = split_batch(b, "7", 1);
+    ok = ok && res && PQntuples(res) == 1;
+    PQclear(res);
+
+    // No row for the key: not served (the plain query runs)
+    ok = ok && split_batch(b, "9", 0) == NULL;
+    PQclear(b);
+
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("wrong rows served");
+    }
+}
+
+// ============================================================================
+// Main
+// ============================================================================
+
+int main(void) {
+    printf("\n\033[1m=== Row Cache Tests ===\033[0m\n\n");
+
+    printf("\033[1mPoint Lookups:\033[0m\n");
+    test_point_lookup_detection();
+    test_point_lookup_rejection();
+
+    printf("\n\033[1mWrite Invalidation:\033[0m\n");
+    test_write_classification();
+
+    printf("\n\033[1mRows:\033[0m\n");
+    test_provenance();
+    test_row_round_trip();
+
+    printf("\n\033[1mFreshness:\033[0m\n");
+    test_version_check();
+    test_generations();
+    test_expiry();
+
+    printf("\n\033[1mN+1 Batching:\033[0m\n");
+    test_batch_parent_keys();
+    test_batch_stride();
+    test_key_lookup_detection();
+    test_batch_sql();
+    test_batch_split();
+
+    printf("\n\033[1m=== Results ===\033[0m\n");
+    printf("Passed: \033[32m%d\033[0m\n", tests_passed);
+    printf("Failed: \033[31m%d\033[0m\n", tests_failed);
+
+    return tests_failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,339 @@
+/*
+ * Unit tests for the sharded statement registry (pg_statement.c)
+ *
+ * Replicates the seqlock-sharded hash map behind pg_register_stmt /
+ * pg_unregister_stmt / pg_find_stmt.
+ *
+ * Tests:
+ * 1. Register / find / unregister round trip
+ * 2. No statement cap - far more than the old MAX_STATEMENTS (1024)
+ * 3. Unregistered entries are recycled, not leaked
+ * 4. Newest registration of a reused address wins
+ * 5. Concurrent readers never see a wrong mapping while writers churn
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sched.h>
+
+// Test counters
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST(name) printf("  Testing: %s... ", name)
+#define PASS() do { printf("\033[32mPASS\033[0m\n"); tests_passed++; } while(0)
+#define FAIL(msg) do { printf("\033[31mFAIL: %s\033[0m\n", msg); tests_failed++; } while(0)
+
+// ============================================================================
+// Replicate the registry from pg_statement.c
+// ============================================================================
+
+typedef struct stmt_entry {
+    _Atomic(void *) sqlite_stmt;
+    _Atomic(void *) pg_stmt;
+    _Atomic(struct stmt_entry *) next;
+} stmt_entry_t;
+
+#define STMT_SHARD_BITS 6
+#define STMT_SHARDS (1 << STMT_SHARD_BITS)
+#define STMT_SHARD_BUCKET_BITS 6
+#define STMT_SHARD_BUCKETS (1 << STMT_SHARD_BUCKET_BITS)
+#define STMT_ENTRY_CHUNK 64
+
+typedef struct {
+    _Alignas(64) atomic_uint seq;
+    pthread_mutex_t write_lock;
+    _Atomic(stmt_entry_t *) buckets[STMT_SHARD_BUCKETS];
+    stmt_entry_t *free_list;
+    int count;
+    int allocated;
+} stmt_shard_t;
+
+static stmt_shard_t stmt_shards[STMT_SHARDS];
+
+static void init_stmt_shards(void) {
+    for (int i = 0; i < STMT_SHARDS; i++) {
+        pthread_mutex_init(&stmt_shards[i].write_lock, NULL);
+    }
+}
+
+static inline unsigned int hash_ptr(const void *ptr) {
+    uint64_t h = ((uint64_t)(uintptr_t)ptr >> 4) * 0x9E3779B97F4A7C15ULL;
+    return (unsigned int)(h >> (64 - STMT_SHARD_BITS - STMT_SHARD_BUCKET_BITS));
+}
+
+static inline stmt_shard_t* shard_of(unsigned int h) {
+    return &stmt_shards[h >> STMT_SHARD_BUCKET_BITS];
+}
+
+static inline unsigned int bucket_of(unsigned int h) {
+    return h & (STMT_SHARD_BUCKETS - 1);
+}
+
+static inline void shard_write_begin(stmt_shard_t *sh) {
+    pthread_mutex_lock(&sh->write_lock);
+    unsigned int seq = atomic_load_explicit(&sh->seq, memory_order_relaxed);
+    atomic_store_explicit(&sh->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+static inline void shard_write_end(stmt_shard_t *sh) {
+    unsigned int seq = atomic_load_explicit(&sh->seq, memory_order_relaxed);
+    atomic_store_explicit(&sh->seq, seq + 1, memory_order_release);
+    pthread_mutex_unlock(&sh->write_lock);
+}
+
+static stmt_entry_t* shard_alloc_entry(stmt_shard_t *sh) {
+    if (!sh->free_list) {
+        stmt_entry_t *chunk = calloc(STMT_ENTRY_CHUNK, sizeof(stmt_entry_t));
+        if (!chunk) return NULL;
+        for (int i = 0; i < STMT_ENTRY_CHUNK; i++) {
+            atomic_store_explicit(&chunk[i].next, i + 1 < STMT_ENTRY_CHUNK ? &chunk[i + 1] : NULL,
+                                  memory_order_relaxed);
+        }
+        sh->free_list = chunk;
+        sh->allocated += STMT_ENTRY_CHUNK;
+    }
+    stmt_entry_t *e = sh->free_list;
+    sh->free_list = atomic_load_explicit(&e->next, memory_order_relaxed);
+    return e;
+}
+
+static void shard_free_entry(stmt_shard_t *sh, stmt_entry_t *e) {
+    atomic_store_explicit(&e->sqlite_stmt, NULL, memory_order_relaxed);
+    atomic_store_explicit(&e->pg_stmt, NULL, memory_order_relaxed);
+    atomic_store_explicit(&e->next, sh->free_list, memory_order_relaxed);
+    sh->free_list = e;
+}
+
+static void register_stmt(void *sqlite_stmt, void *pg_stmt) {
+    unsigned int h = hash_ptr(sqlite_stmt);
+    stmt_shard_t *sh = shard_of(h);
+    _Atomic(stmt_entry_t *) *bucket = &sh->buckets[bucket_of(h)];
+
+    shard_write_begin(sh);
+    stmt_entry_t *entry = shard_alloc_entry(sh);
+    if (entry) {
+        atomic_store_explicit(&entry->sqlite_stmt, sqlite_stmt, memory_order_relaxed);
+        atomic_store_explicit(&entry->pg_stmt, pg_stmt, memory_order_relaxed);
+        atomic_store_explicit(&entry->next, atomic_load_explicit(bucket, memory_order_relaxed),
+                              memory_order_relaxed);
+        atomic_store_explicit(bucket, entry, memory_order_relaxed);
+        sh->count++;
+    }
+    shard_write_end(sh);
+}
+
+static void unregister_stmt(void *sqlite_stmt) {
+    unsigned int h = hash_ptr(sqlite_stmt);
+    stmt_shard_t *sh = shard_of(h);
+    _Atomic(stmt_entry_t *) *prev = &sh->buckets[bucket_of(h)];
+
+    shard_write_begin(sh);
+    stmt_entry_t *entry = atomic_load_explicit(prev, memory_order_relaxed);
+    while (entry) {
+        stmt_entry_t *next = atomic_load_explicit(&entry->next, memory_order_relaxed);
+        if (atomic_load_explicit(&entry->sqlite_stmt, memory_order_relaxed) == sqlite_stmt) {
+            atomic_store_explicit(prev, next, memory_order_relaxed);
+            shard_free_entry(sh, entry);
+            sh->count--;
+            break;
+        }
+        prev = &entry->next;
+        entry = next;
+    }
+    shard_write_end(sh);
+}
+
+static void* find_stmt(void *stmt) {
+    unsigned int h = hash_ptr(stmt);
+    stmt_shard_t *sh = shard_of(h);
+    _Atomic(stmt_entry_t *) *bucket = &sh->buckets[bucket_of(h)];
+
+    for (int spins = 0;; spins++) {
+        unsigned int seq = atomic_load_explicit(&sh->seq, memory_order_acquire);
+        if (seq & 1) {
+            if (spins >= 64) sched_yield();
+            continue;
+        }
+
+        void *result = NULL;
+        int torn = 0;
+        stmt_entry_t *entry = atomic_load_explicit(bucket, memory_order_relaxed);
+        while (entry) {
+            if (atomic_load_explicit(&entry->sqlite_stmt, memory_order_relaxed) == stmt) {
+                result = atomic_load_explicit(&entry->pg_stmt, memory_order_relaxed);
+                break;
+            }
+            entry = atomic_load_explicit(&entry->next, memory_order_relaxed);
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&sh->seq, memory_order_relaxed) != seq) {
+                torn = 1;
+                break;
+            }
+        }
+        atomic_thread_fence(memory_order_acquire);
+        if (!torn && atomic_load_explicit(&sh->seq, memory_order_relaxed) == seq) return result;
+    }
+}
+
+static int total_count(void) {
+    int n = 0;
+    for (int s = 0; s < STMT_SHARDS; s++) n += stmt_shards[s].count;
+    return n;
+}
+
+static int total_allocated(void) {
+    int n = 0;
+    for (int s = 0; s < STMT_SHARDS; s++) n += stmt_shards[s].allocated;
+    return n;
+}
+
+// Fake handles: distinct heap-like addresses, 16-byte aligned like malloc
+#define FAKE_STMT(i) ((void *)(uintptr_t)(0x7f0000100000ULL + (uint64_t)(i) * 0x130))
+#define FAKE_PG(i) ((void *)(uintptr_t)(0x5500000000ULL + (uint64_t)(i) * 0x40))
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+static void test_round_trip(void) {
+    TEST("register / find / unregister");
+    register_stmt(FAKE_STMT(1), FAKE_PG(1));
+    register_stmt(FAKE_STMT(2), FAKE_PG(2));
+    int ok = find_stmt(FAKE_STMT(1)) == FAKE_PG(1) && find_stmt(FAKE_STMT(2)) == FAKE_PG(2) &&
+             find_stmt(FAKE_STMT(3)) == NULL;
+    unregister_stmt(FAKE_STMT(1));
+    ok = ok && find_stmt(FAKE_STMT(1)) == NULL && find_stmt(FAKE_STMT(2)) == FAKE_PG(2);
+    unregister_stmt(FAKE_STMT(2));
+    ok = ok && total_count() == 0;
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("lookup mismatch");
+    }
+}
+
+static void test_no_cap(void) {
+    TEST("50000 live statements (old cap was 1024)");
+    const int n = 50000;
+    for (int i = 0; i < n; i++) register_stmt(FAKE_STMT(i), FAKE_PG(i));
+    int ok = total_count() == n;
+    for (int i = 0; i < n && ok; i++) ok = find_stmt(FAKE_STMT(i)) == FAKE_PG(i);
+    for (int i = 0; i < n; i++) unregister_stmt(FAKE_STMT(i));
+    ok = ok && total_count() == 0 && find_stmt(FAKE_STMT(n / 2)) == NULL;
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("missing or wrong entries");
+    }
+}
+
+static void test_recycling(void) {
+    TEST("prepare/finalize churn reuses entries");
+    int before = total_allocated();
+    for (int round = 0; round < 100; round++) {
+        for (int i = 0; i < 1000; i++) register_stmt(FAKE_STMT(100000 + round * 1000 + i), FAKE_PG(i));
+        for (int i = 0; i < 1000; i++) unregister_stmt(FAKE_STMT(100000 + round * 1000 + i));
+    }
+    // 100k registrations, but never more than the earlier peak allocated
+    if (total_allocated() == before && total_count() == 0) {
+        PASS();
+    } else {
+        char msg[96];
+        snprintf(msg, sizeof(msg), "allocated grew %d -> %d", before, total_allocated());
+        FAIL(msg);
+    }
+}
+
+static void test_newest_wins(void) {
+    TEST("re-registered address - newest mapping wins");
+    register_stmt(FAKE_STMT(7), FAKE_PG(70));
+    register_stmt(FAKE_STMT(7), FAKE_PG(71));
+    int ok = find_stmt(FAKE_STMT(7)) == FAKE_PG(71);
+    unregister_stmt(FAKE_STMT(7));
+    ok = ok && find_stmt(FAKE_STMT(7)) == FAKE_PG(70);
+    unregister_stmt(FAKE_STMT(7));
+    ok = ok && find_stmt(FAKE_STMT(7)) == NULL;
+    if (ok) {
+        PASS();
+    } else {
+        FAIL("wrong mapping after re-register");
+    }
+}
+
+// Stable statements must always be found with the right pg_stmt while
+// writers register/unregister others in the same shards
+#define STABLE 2048
+#define READERS 4
+#define WRITERS 2
+#define READER_LOOKUPS 2000000
+
+static atomic_int readers_done = 0;
+static atomic_int bad_lookups = 0;
+
+static void* reader_thread(void *arg) {
+    unsigned int x = (unsigned int)(uintptr_t)arg * 2654435761u + 1;
+    for (int i = 0; i < READER_LOOKUPS; i++) {
+        x = x * 1103515245u + 12345u;
+        int k = (int)((x >> 8) % STABLE);
+        if (find_stmt(FAKE_STMT(k)) != FAKE_PG(k)) atomic_fetch_add(&bad_lookups, 1);
+    }
+    atomic_fetch_add(&readers_done, 1);
+    return NULL;
+}
+
+static void* writer_thread(void *arg) {
+    int base = 1000000 + (int)(uintptr_t)arg * 100000;
+    while (atomic_load(&readers_done) < READERS) {
+        for (int i = 0; i < 256; i++) register_stmt(FAKE_STMT(base + i), FAKE_PG(base + i));
+        for (int i = 0; i < 256; i++) unregister_stmt(FAKE_STMT(base + i));
+    }
+    return NULL;
+}
+
+static void test_concurrent(void) {
+    TEST("readers vs churning writers - no wrong lookups");
+    for (int i = 0; i < STABLE; i++) register_stmt(FAKE_STMT(i), FAKE_PG(i));
+
+    pthread_t readers[READERS], writers[WRITERS];
+    for (int i = 0; i < WRITERS; i++) pthread_create(&writers[i], NULL, writer_thread, (void *)(uintptr_t)i);
+    for (int i = 0; i < READERS; i++) pthread_create(&readers[i], NULL, reader_thread, (void *)(uintptr_t)i);
+    for (int i = 0; i < READERS; i++) pthread_join(readers[i], NULL);
+    for (int i = 0; i < WRITERS; i++) pthread_join(writers[i], NULL);
+
+    for (int i = 0; i < STABLE; i++) unregister_stmt(FAKE_STMT(i));
+    int bad = atomic_load(&bad_lookups);
+    if (bad == 0 && total_count() == 0) {
+        PASS();
+    } else {
+        char msg[64];
+        snprintf(msg, sizeof(msg), "%d wrong lookups", bad);
+        FAIL(msg);
+    }
+}
+
+// ============================================================================
+// Main
+// ============================================================================
+
+int main(void) {
+    printf("\n\033[1m=== Statement Registry Tests ===\033[0m\n\n");
+    init_stmt_shards();
+
+    test_round_trip();
+    test_no_cap();
+    test_recycling();
+    test_newest_wins();
+    test_concurrent();
+
+    printf("\n\033[1m=== Results ===\033[0m\n");
+    printf("Passed: \033[32m%d\033[0m\n", tests_passed);
+    printf("Failed: \033[31m%d\033[0m\n", tests_failed);
+
+    return tests_failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,311 @@
+/*
+ * Unit tests for the per-statement text arena (pg_statement.c)
+ *
+ * Replicates pg_stmt_text_alloc / pg_stmt_text_reset / pg_stmt_text_free,
+ * which back column_text / value_text / value_blob copies.
+ *
+ * Tests:
+ * 1. Every copy of a row stays intact until reset (no 64-call ring)
+ * 2. Values far over the old 8KB buffers are copied whole
+ * 3. Reset keeps one block sized to the row - steady rows allocate nothing
+ * 4. A huge value's block is not kept across rows
+ * 5. Memory accounting balances after free
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+// Test counters
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST(name) printf("  Testing: %s... ", name)
+#define PASS() do { printf("\033[32mPASS\033[0m\n"); tests_passed++; } while(0)
+#define FAIL(msg) do { printf("\033[31mFAIL: %s\033[0m\n", msg); tests_failed++; } while(0)
+
+// ============================================================================
+// Replicate the arena from pg_statement.c
+// ============================================================================
+
+#define PG_TEXT_BLOCK_SIZE 4096
+#define PG_TEXT_KEEP_MAX (64 * 1024)
+
+typedef struct pg_text_block {
+    struct pg_text_block *next;
+    size_t cap;
+    size_t used;
+    char data[];
+} pg_text_block_t;
+
+typedef struct {
+    pg_text_block_t *text_arena;
+    int decoded_row;
+} pg_stmt_t;
+
+static ssize_t charged = 0;  // Stands in for pg_mem_charge(PG_MEM_COLUMN_BUFFERS)
+static int blocks_allocated = 0;
+
+static pg_text_block_t* text_block_new(size_t cap) {
+    pg_text_block_t *b = malloc(sizeof(pg_text_block_t) + cap);
+    if (!b) return NULL;
+    b->next = NULL;
+    b->cap = cap;
+    b->used = 0;
+    charged += (ssize_t)(sizeof(pg_text_block_t) + cap);
+    blocks_allocated++;
+    return b;
+}
+
+static void text_block_free(pg_text_block_t *b) {
+    charged -= (ssize_t)(sizeof(pg_text_block_t) + b->cap);
+    free(b);
+}
+
+static char* text_alloc(pg_stmt_t *stmt, size_t size) {
+    size = (size + 7) & ~(size_t)7;
+    pg_text_block_t *head = stmt->text_arena;
+    if (head && head->cap - head->used >= size) {
+        char *p = head->data + head->used;
+        head->used += size;
+        return p;
+    }
+
+    if (head && size > PG_TEXT_BLOCK_SIZE / 4) {
+        pg_text_block_t *b = text_block_new(size);
+        if (!b) return NULL;
+        b->used = size;
+        b->next = head->next;
+        head->next = b;
+        return b->data;
+    }
+
+    pg_text_block_t *b = text_block_new(size > PG_TEXT_BLOCK_SIZE ? size : PG_TEXT_BLOCK_SIZE);
+    if (!b) return NULL;
+    b->used = size;
+    b->next = head;
+    stmt->text_arena = b;
+    return b->data;
+}
+
+static void text_reset(pg_stmt_t *stmt) {
+    pg_text_block_t *head = stmt->text_arena;
+    stmt->decoded_row = -1;
+    if (!head) return;
+
+    size_t row_bytes = 0;
+    for (pg_text_block_t *b = head; b; b = b->next) row_bytes += b->used;
+    pg_text_block_t *b = head->next;
+    while (b) {
+        pg_text_block_t *next = b->next;
+        text_block_free(b);
+        b = next;
+    }
+    head->next = NULL;
+    head->used = 0;
+
+    if (row_bytes > head->cap) {
+        size_t cap = (row_bytes + PG_TEXT_BLOCK_SIZE - 1) & ~(size_t)(PG_TEXT_BLOCK_SIZE - 1);
+        if (cap <= PG_TEXT_KEEP_MAX) {
+            pg_text_block_t *bigger = text_block_new(cap);
+            if (bigger) {
+                text_block_free(head);
+                head = bigger;
+            }
+        }
+    }
+    if (head->cap > PG_TEXT_KEEP_MAX) {
+        text_block_free(head);
+        head = NULL;
+    }
+    stmt->text_arena = head;
+}
+
+static void text_free(pg_stmt_t *stmt) {
+    pg_text_block_t *b = stmt->text_arena;
+    while (b) {
+        pg_text_block_t *next = b->next;
+        text_block_free(b);
+        b = next;
+    }
+    stmt->text_arena = NULL;
+}
+
+static char* copy_text(pg_stmt_t *stmt, const char *s) {
+    size_t len = strlen(s);
+    char *buf = text_alloc(stmt, len + 1);
+    if (!buf) return NULL;
+    memcpy(buf, s, len + 1);
+    return buf;
+}
+
+// ============================================================================
+// Test 1: Copies stay intact until reset
+// ============================================================================
+
+static void test_row_copies_intact(void) {
+    TEST("200 copies of one row all intact until reset");
+
+    pg_stmt_t stmt = { NULL, 0 };
+    char *copies[200];
+    char expect[32];
+    for (int i = 0; i < 200; i++) {
+        snprintf(expect, sizeof(expect), "value-%d-%s", i, i % 3 ? "short" : "a-bit-longer-value");
+        copies[i] = copy_text(&stmt, expect);
+    }
+    for (int i = 0; i < 200; i++) {
+        snprintf(expect, sizeof(expect), "value-%d-%s", i, i % 3 ? "short" : "a-bit-longer-value");
+        if (!copies[i] || strcmp(copies[i], expect) != 0) {
+            FAIL("copy overwritten before reset");
+            text_free(&stmt);
+            return;
+        }
+    }
+    text_free(&stmt);
+    PASS();
+}
+
+// ============================================================================
+// Test 2: Large values copied whole
+// ============================================================================
+
+static void test_large_values(void) {
+    TEST("Values over 8KB copied whole");
+
+    pg_stmt_t stmt = { NULL, 0 };
+    size_t sizes[] = { 8191, 8192, 20000, 300000 };
+    char *small_before = copy_text(&stmt, "before");
+    for (size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+        char *src = malloc(sizes[k] + 1);
+        memset(src, 'a' + (int)k, sizes[k]);
+        src[sizes[k]] = '\0';
+        char *copy = copy_text(&stmt, src);
+        if (!copy || strlen(copy) != sizes[k] || memcmp(copy, src, sizes[k]) != 0) {
+            FAIL("large value truncated or corrupted");
+            free(src);
+            text_free(&stmt);
+            return;
+        }
+        free(src);
+    }
+    // Small allocations keep filling the head block around the large ones
+    char *small_after = copy_text(&stmt, "after");
+    if (strcmp(small_before, "before") != 0 || strcmp(small_after, "after") != 0) {
+        FAIL("small copies disturbed by large ones");
+        text_free(&stmt);
+        return;
+    }
+    text_free(&stmt);
+    PASS();
+}
+
+// ============================================================================
+// Test 3: Steady state
+// ============================================================================
+
+static void test_steady_state(void) {
+    TEST("Rows of the same size allocate nothing after the first");
+
+    pg_stmt_t stmt = { NULL, 0 };
+    char value[200];
+    memset(value, 'x', sizeof(value) - 1);
+    value[sizeof(value) - 1] = '\0';
+
+    // 30 columns x 200 bytes = 6000 bytes per row, more than one block
+    for (int row = 0; row < 3; row++) {
+        for (int c = 0; c < 30; c++) copy_text(&stmt, value);
+        text_reset(&stmt);
+    }
+    int before = blocks_allocated;
+    for (int row = 0; row < 1000; row++) {
+        for (int c = 0; c < 30; c++) copy_text(&stmt, value);
+        text_reset(&stmt);
+    }
+    if (blocks_allocated != before) {
+        char msg[80];
+        snprintf(msg, sizeof(msg), "%d blocks allocated in steady state", blocks_allocated - before);
+        FAIL(msg);
+        text_free(&stmt);
+        return;
+    }
+    if (stmt.decoded_row != -1) {
+        FAIL("reset did not invalidate the decoded row");
+        text_free(&stmt);
+        return;
+    }
+    text_free(&stmt);
+    PASS();
+}
+
+// ============================================================================
+// Test 4: Huge values not kept
+// ============================================================================
+
+static void test_huge_not_kept(void) {
+    TEST("Huge value's block released on reset");
+
+    pg_stmt_t stmt = { NULL, 0 };
+    char *big = malloc(1 << 20);
+    memset(big, 'b', (1 << 20) - 1);
+    big[(1 << 20) - 1] = '\0';
+    copy_text(&stmt, big);  // First allocation - becomes the head
+    free(big);
+    text_reset(&stmt);
+
+    ssize_t held = charged;
+    if (held > (ssize_t)(PG_TEXT_KEEP_MAX + sizeof(pg_text_block_t))) {
+        char msg[80];
+        snprintf(msg, sizeof(msg), "%zd bytes held after reset", held);
+        FAIL(msg);
+        text_free(&stmt);
+        return;
+    }
+    text_free(&stmt);
+    PASS();
+}
+
+// ============================================================================
+// Test 5: Accounting
+// ============================================================================
+
+static void test_accounting(void) {
+    TEST("Charged bytes return to zero after free");
+
+    pg_stmt_t stmt = { NULL, 0 };
+    for (int row = 0; row < 50; row++) {
+        for (int c = 0; c < row; c++) {
+            char v[64];
+            snprintf(v, sizeof(v), "%d:%d", row, c);
+            copy_text(&stmt, v);
+        }
+        if (row % 7 == 0) text_alloc(&stmt, 5000 + row);
+        text_reset(&stmt);
+    }
+    text_free(&stmt);
+    if (charged != 0) {
+        char msg[64];
+        snprintf(msg, sizeof(msg), "%zd bytes still charged", charged);
+        FAIL(msg);
+        return;
+    }
+    PASS();
+}
+
+// ============================================================================
+// Main
+// ============================================================================
+
+int main(void) {
+    printf("\n\033[1m=== Statement Text Arena Tests ===\033[0m\n\n");
+
+    test_row_copies_intact();
+    test_large_values();
+    test_steady_state();
+    test_huge_not_kept();
+    test_accounting();
+
+    printf("\n\033[1mResults: %d passed, %d failed\033[0m\n\n", tests_passed, tests_failed);
+    return tests_failed > 0 ? 1 : 0;
+}
@@ -6,6 +6,9 @@
  * 2. Cache invalidation on generation change
  * 3. Pool slot caching logic
  * 4. Connection cache hit/miss behavior
+ * 5. Cached statement table (pg_statement.c): growth past 64, removal,
+ *    tombstone reuse, last-lookup memo, dropping statements finalized on
+ *    another thread, idle sweep
  */
 
 #include <stdio.h>
@@ -377,6 +380,359 @@ static void test_conn_cache_miss_different_db(void) {
     }
 }
 
+// ============================================================================
+// Simulate the per-thread cached statement table from pg_statement.c
+// ============================================================================
+
+#define PG_TLS_STMT_INITIAL_CAP 16
+#define PG_TLS_STMT_SWEEP_AT 64
+#define PG_TLS_STMT_EMPTY NULL
+#define PG_TLS_STMT_TOMBSTONE ((void *)(uintptr_t)1)
+
+// The pg_stmt_t fields the table looks at
+typedef struct {
+    int finalized;
+    int busy;              // result / cached_result / in_step / locked elsewhere
+    int write_executed;
+    int is_cached;         // TLS-only - the table owns the creation ref too
+} fake_pg_stmt_t;
+
+typedef struct {
+    void *sqlite_stmt;
+    fake_pg_stmt_t *pg_stmt;
+    unsigned int seen;
+} cached_stmt_entry_t;
+
+typedef struct {
+    cached_stmt_entry_t *slots;
+    int cap;
+    int count;
+    int used;
+    int sweep_at;
+    unsigned int sweeps;
+    void *last_stmt;
+    fake_pg_stmt_t *last_pg_stmt;
+} thread_cached_stmts_t;
+
+static int stmt_refs = 0;  // Stands in for pg_stmt_ref / pg_stmt_unref
+
+static inline int tls_slot_of(const void *stmt, int cap) {
+    uint64_t h = ((uint64_t)(uintptr_t)stmt >> 4) * 0x9E3779B97F4A7C15ULL;
+    return (int)(h >> 32) & (cap - 1);
+}
+
+static int tls_find_slot(const thread_cached_stmts_t *tcs, void *sqlite_stmt) {
+    if (tcs->count == 0 || !sqlite_stmt) return -1;
+    int mask = tcs->cap - 1;
+    for (int i = tls_slot_of(sqlite_stmt, tcs->cap); ; i = (i + 1) & mask) {
+        void *key = tcs->slots[i].sqlite_stmt;
+        if (key == sqlite_stmt) return i;
+        if (key == PG_TLS_STMT_EMPTY) return -1;
+    }
+}
+
+static int tls_rehash(thread_cached_stmts_t *tcs, int cap) {
+    cached_stmt_entry_t *slots = calloc((size_t)cap, sizeof(cached_stmt_entry_t));
+    if (!slots) return 0;
+    for (int i = 0; i < tcs->cap; i++) {
+        void *key = tcs->slots[i].sqlite_stmt;
+        if (key == PG_TLS_STMT_EMPTY || key == PG_TLS_STMT_TOMBSTONE) continue;
+        int j = tls_slot_of(key, cap);
+        while (slots[j].sqlite_stmt != PG_TLS_STMT_EMPTY) j = (j + 1) & (cap - 1);
+        slots[j] = tcs->slots[i];
+    }
+    free(tcs->slots);
+    tcs->slots = slots;
+    tcs->cap = cap;
+    tcs->used = tcs->count;
+    return 1;
+}
+
+static fake_pg_stmt_t* tls_remove_slot(thread_cached_stmts_t *tcs, int i) {
+    fake_pg_stmt_t *old = tcs->slots[i].pg_stmt;
+    if (tcs->last_stmt == tcs->slots[i].sqlite_stmt) {
+        tcs->last_stmt = NULL;
+        tcs->last_pg_stmt = NULL;
+    }
+    int next = (i + 1) & (tcs->cap - 1);
+    if (tcs->slots[next].sqlite_stmt == PG_TLS_STMT_EMPTY) {
+        tcs->slots[i].sqlite_stmt = PG_TLS_STMT_EMPTY;
+        tcs->used--;
+    } else {
+        tcs->slots[i].sqlite_stmt = PG_TLS_STMT_TOMBSTONE;
+    }
+    tcs->slots[i].pg_stmt = NULL;
+    tcs->count--;
+    return old;
+}
+
+static void tls_drop_slot(thread_cached_stmts_t *tcs, int i) {
+    fake_pg_stmt_t *old = tls_remove_slot(tcs, i);
+    if (!old) return;
+    stmt_refs--;
+    if (old->is_cached) stmt_refs--;
+}
+
+static int tls_entry_idle(const thread_cached_stmts_t *tcs, const cached_stmt_entry_t *e) {
+    fake_pg_stmt_t *p = e->pg_stmt;
+    return !p->busy && (!p->write_executed || e->seen != tcs->sweeps);
+}
+
+static void tls_sweep(thread_cached_stmts_t *tcs) {
+    for (int i = 0; i < tcs->cap; i++) {
+        void *key = tcs->slots[i].sqlite_stmt;
+        if (key == PG_TLS_STMT_EMPTY || key == PG_TLS_STMT_TOMBSTONE || key == tcs->last_stmt) continue;
+        fake_pg_stmt_t *p = tcs->slots[i].pg_stmt;
+        if (!p || p->finalized || tls_entry_idle(tcs, &tcs->slots[i])) tls_drop_slot(tcs, i);
+    }
+    tcs->sweeps++;
+    tcs->sweep_at = tcs->count * 2 > PG_TLS_STMT_SWEEP_AT ? tcs->count * 2 : PG_TLS_STMT_SWEEP_AT;
+}
+
+static void register_stmt(thread_cached_stmts_t *tcs, void *sqlite_stmt, fake_pg_stmt_t *pg_stmt) {
+    int i = tls_find_slot(tcs, sqlite_stmt);
+    if (i >= 0) {
+        if (tcs->slots[i].pg_stmt && tcs->slots[i].pg_stmt != pg_stmt) stmt_refs--;
+        stmt_refs++;
+        tcs->slots[i].pg_stmt = pg_stmt;
+        tcs->slots[i].seen = tcs->sweeps;
+        if (tcs->last_stmt == sqlite_stmt) tcs->last_pg_stmt = pg_stmt;
+        return;
+    }
+    if (tcs->count >= (tcs->sweep_at ? tcs->sweep_at : PG_TLS_STMT_SWEEP_AT)) tls_sweep(tcs);
+    if (!tcs->slots || (tcs->used + 1) * 2 > tcs->cap) {
+        int cap = tcs->cap ? tcs->cap : PG_TLS_STMT_INITIAL_CAP;
+        while ((tcs->count + 1) * 2 > cap) cap *= 2;
+        if (!tls_rehash(tcs, cap)) return;
+    }
+    stmt_refs++;
+    int mask = tcs->cap - 1;
+    for (i = tls_slot_of(sqlite_stmt, tcs->cap); ; i = (i + 1) & mask) {
+        void *key = tcs->slots[i].sqlite_stmt;
+        if (key == PG_TLS_STMT_EMPTY || key == PG_TLS_STMT_TOMBSTONE) break;
+    }
+    if (tcs->slots[i].sqlite_stmt == PG_TLS_STMT_EMPTY) tcs->used++;
+    tcs->slots[i].sqlite_stmt = sqlite_stmt;
+    tcs->slots[i].pg_stmt = pg_stmt;
+    tcs->slots[i].seen = tcs->sweeps;
+    tcs->count++;
+}
+
+static fake_pg_stmt_t* find_stmt(thread_cached_stmts_t *tcs, void *sqlite_stmt) {
+    if (sqlite_stmt && tcs->last_stmt == sqlite_stmt &&
+        !(tcs->last_pg_stmt && tcs->last_pg_stmt->finalized)) {
+        return tcs->last_pg_stmt;
+    }
+    int i = tls_find_slot(tcs, sqlite_stmt);
+    if (i < 0) return NULL;
+    fake_pg_stmt_t *p = tcs->slots[i].pg_stmt;
+    if (p && p->finalized) {
+        tls_drop_slot(tcs, i);
+        return NULL;
+    }
+    tcs->slots[i].seen = tcs->sweeps;
+    tcs->last_stmt = sqlite_stmt;
+    tcs->last_pg_stmt = p;
+    return p;
+}
+
+static void clear_stmt(thread_cached_stmts_t *tcs, void *sqlite_stmt) {
+    int i = tls_find_slot(tcs, sqlite_stmt);
+    if (i < 0) return;
+    if (tls_remove_slot(tcs, i)) stmt_refs--;
+}
+
+#define FAKE_PG_STMTS 100000
+static fake_pg_stmt_t fake_pg_stmts[FAKE_PG_STMTS];
+
+// All statements start busy (mid-iteration), so sweeps keep them
+static void reset_fake_pg_stmts(void) {
+    memset(fake_pg_stmts, 0, sizeof(fake_pg_stmts));
+    for (int n = 0; n < FAKE_PG_STMTS; n++) fake_pg_stmts[n].busy = 1;
+}
+
+// Heap-like addresses: same low bits, 0x70 apart
+static void* fake_sqlite_stmt(int n) { return (void *)(uintptr_t)(0x55550000A000ULL + (uint64_t)n * 0x70); }
+static fake_pg_stmt_t* fake_pg_stmt(int n) { return &fake_pg_stmts[n]; }
+
+static void test_stmt_table_grows(void) {
+    TEST("Stmt table - 1000 statements, none lost");
+
+    thread_cached_stmts_t tcs = {0};
+    stmt_refs = 0;
+    reset_fake_pg_stmts();
+    for (int n = 0; n < 1000; n++) register_stmt(&tcs, fake_sqlite_stmt(n), fake_pg_stmt(n));
+
+    for (int n = 0; n < 1000; n++) {
+        if (find_stmt(&tcs, fake_sqlite_stmt(n)) != fake_pg_stmt(n)) {
+            char msg[64];
+            snprintf(msg, sizeof(msg), "statement %d lost", n);
+            FAIL(msg);
+            free(tcs.slots);
+            return;
+        }
+    }
+    if (tcs.count != 1000 || stmt_refs != 1000 || tcs.count * 2 > tcs.cap) {
+        FAIL("count/refs/load wrong after growth");
+        free(tcs.slots);
+        return;
+    }
+    free(tcs.slots);
+    PASS();
+}
+
+static void test_stmt_table_clear(void) {
+    TEST("Stmt table - clear keeps other chains intact");
+
+    thread_cached_stmts_t tcs = {0};
+    stmt_refs = 0;
+    reset_fake_pg_stmts();
+    for (int n = 0; n < 200; n++) register_stmt(&tcs, fake_sqlite_stmt(n), fake_pg_stmt(n));
+    for (int n = 0; n < 200; n += 2) clear_stmt(&tcs, fake_sqlite_stmt(n));
+
+    for (int n = 0; n < 200; n++) {
+        void *want = (n % 2) ? fake_pg_stmt(n) : NULL;
+        if (find_stmt(&tcs, fake_sqlite_stmt(n)) != want) {
+            char msg[64];
+            snprintf(msg, sizeof(msg), "statement %d wrong after clears", n);
+            FAIL(msg);
+            free(tcs.slots);
+            return;
+        }
+    }
+    if (tcs.count != 100 || stmt_refs != 100) {
+        FAIL("count or refs wrong after clears");
+        free(tcs.slots);
+        return;
+    }
+    free(tcs.slots);
+    PASS();
+}
+
+static void test_stmt_table_churn(void) {
+    TEST("Stmt table - prepare/finalize churn stays bounded");
+
+    thread_cached_stmts_t tcs = {0};
+    stmt_refs = 0;
+    reset_fake_pg_stmts();
+    // 20 long-lived statements plus a stream of short-lived ones
+    for (int n = 0; n < 20; n++) register_stmt(&tcs, fake_sqlite_stmt(n), fake_pg_stmt(n));
+    for (int n = 20; n < 100000; n++) {
+        register_stmt(&tcs, fake_sqlite_stmt(n), fake_pg_stmt(n));
+        find_stmt(&tcs, fake_sqlite_stmt(n));
+        clear_stmt(&tcs, fake_sqlite_stmt(n));
+    }
+    int ok = tcs.count == 20 && tcs.cap <= 64 && tcs.used * 2 <= tcs.cap;
+    for (int n = 0; n < 20 && ok; n++) ok = find_stmt(&tcs, fake_sqlite_stmt(n)) == fake_pg_stmt(n);
+    if (!ok) {
+        char msg[96];
+        snprintf(msg, sizeof(msg), "count=%d cap=%d used=%d", tcs.count, tcs.cap, tcs.used);
+        FAIL(msg);
+        free(tcs.slots);
+        return;
+    }
+    free(tcs.slots);
+    PASS();
+}
+
+static void test_stmt_table_memo(void) {
+    TEST("Stmt table - memo follows replace and clear");
+
+    thread_cached_stmts_t tcs = {0};
+    stmt_refs = 0;
+    reset_fake_pg_stmts();
+    void *s = fake_sqlite_stmt(1);
+    register_stmt(&tcs, s, fake_pg_stmt(1));
+    find_stmt(&tcs, s);
+    if (tcs.last_stmt != s) {
+        FAIL("lookup did not set the memo");
+        free(tcs.slots);
+        return;
+    }
+    register_stmt(&tcs, s, fake_pg_stmt(2));  // Re-register with a new pg_stmt
+    if (find_stmt(&tcs, s) != fake_pg_stmt(2)) {
+        FAIL("memo returned the replaced pg_stmt");
+        free(tcs.slots);
+        return;
+    }
+    clear_stmt(&tcs, s);
+    if (find_stmt(&tcs, s) != NULL || find_stmt(&tcs, NULL) != NULL) {
+        FAIL("memo returned a cleared statement");
+        free(tcs.slots);
+        return;
+    }
+    free(tcs.slots);
+    PASS();
+}
+
+static void test_stmt_table_finalized_elsewhere(void) {
+    TEST("Stmt table - statement finalized on another thread is dropped");
+
+    thread_cached_stmts_t tcs = {0};
+    stmt_refs = 0;
+    reset_fake_pg_stmts();
+    void *s = fake_sqlite_stmt(1);
+    fake_pg_stmt(1)->is_cached = 1;
+    stmt_refs++;  // Creation ref, owned by the table for TLS-only statements
+    register_stmt(&tcs, s, fake_pg_stmt(1));
+    find_stmt(&tcs, s);  // Memo now points at it
+
+    fake_pg_stmt(1)->finalized = 1;  // Finalized on another thread
+    if (find_stmt(&tcs, s) != NULL) {
+        FAIL("finalized statement returned from the memo");
+        free(tcs.slots);
+        return;
+    }
+    if (find_stmt(&tcs, s) != NULL || tcs.count != 0 || stmt_refs != 0) {
+        FAIL("finalized entry or its refs still held");
+        free(tcs.slots);
+        return;
+    }
+    // Address reused by a new statement
+    register_stmt(&tcs, s, fake_pg_stmt(2));
+    if (find_stmt(&tcs, s) != fake_pg_stmt(2)) {
+        FAIL("reused address mapped to the wrong statement");
+        free(tcs.slots);
+        return;
+    }
+    free(tcs.slots);
+    PASS();
+}
+
+static void test_stmt_table_sweep(void) {
+    TEST("Stmt table - sweep drops idle entries, keeps busy ones");
+
+    thread_cached_stmts_t tcs = {0};
+    stmt_refs = 0;
+    reset_fake_pg_stmts();
+    // 10 statements mid-iteration, 10 finished writes, then many idle ones
+    // that are never finalized on this thread
+    for (int n = 0; n < 10; n++) register_stmt(&tcs, fake_sqlite_stmt(n), fake_pg_stmt(n));
+    for (int n = 10; n < 20; n++) {
+        fake_pg_stmt(n)->busy = 0;
+        fake_pg_stmt(n)->write_executed = 1;
+        register_stmt(&tcs, fake_sqlite_stmt(n), fake_pg_stmt(n));
+    }
+    int max_count = 0;
+    for (int n = 20; n < 10000; n++) {
+        fake_pg_stmt(n)->busy = 0;
+        register_stmt(&tcs, fake_sqlite_stmt(n), fake_pg_stmt(n));
+        if (tcs.count > max_count) max_count = tcs.count;
+    }
+    int ok = max_count <= PG_TLS_STMT_SWEEP_AT && stmt_refs == tcs.count;
+    for (int n = 0; n < 10 && ok; n++) ok = find_stmt(&tcs, fake_sqlite_stmt(n)) == fake_pg_stmt(n);
+    for (int n = 10; n < 20 && ok; n++) ok = find_stmt(&tcs, fake_sqlite_stmt(n)) == NULL;
+    if (!ok) {
+        char msg[96];
+        snprintf(msg, sizeof(msg), "max_count=%d count=%d refs=%d", max_count, tcs.count, stmt_refs);
+        FAIL(msg);
+        free(tcs.slots);
+        return;
+    }
+    free(tcs.slots);
+    PASS();
+}
+
 // ============================================================================
 // Main
 // ============================================================================
@@ -399,6 +755,14 @@ int main(void) {
     test_conn_cache_hit();
     test_conn_cache_miss_different_db();
 
+    printf("\n\033[1mCached Statement Table:\033[0m\n");
+    test_stmt_table_grows();
+    test_stmt_table_clear();
+    test_stmt_table_churn();
+    test_stmt_table_memo();
+    test_stmt_table_finalized_elsewhere();
+    test_stmt_table_sweep();
+
     printf("\n\033[1m=== Results ===\033[0m\n");
     printf("Passed: \033[32m%d\033[0m\n", tests_passed);
     printf("Failed: \033[31m%d\033[0m\n", tests_failed);
@@ -0,0 +1,310 @@
+/*
+ * Unit tests for UTF-8 validation (pg_utf8.c)
+ *
+ * Links the real module. Every SIMD implementation this CPU supports is
+ * checked against the scalar validator.
+ *
+ * Tests:
+ * 1. Known valid and invalid sequences (overlongs, surrogates, > U+10FFFF)
+ * 2. Each bad sequence at every offset across a 64-byte window
+ * 3. Truncated multi-byte sequences at the end of input
+ * 4. Random byte strings and single-byte mutations of valid text
+ * 5. Dispatch picks an implementation and agrees with scalar
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pg_utf8.h"
+#include "pg_cpu.h"
+
+// Test counters
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST(name) printf("  Testing: %s... ", name)
+#define PASS() do { printf("\033[32mPASS\033[0m\n"); tests_passed++; } while(0)
+#define FAIL(msg) do { printf("\033[31mFAIL: %s\033[0m\n", msg); tests_failed++; } while(0)
+
+typedef int (*utf8_fn)(const char *, size_t);
+
+typedef struct {
+    const char *name;
+    utf8_fn fn;
+} impl_t;
+
+static impl_t impls[4];
+static int impl_count = 0;
+
+static void collect_impls(void) {
+    impls[impl_count++] = (impl_t){ "dispatch", pg_utf8_valid };
+#ifdef PG_UTF8_X86
+    if (pg_cpu_has_sse41()) impls[impl_count++] = (impl_t){ "sse4.1", pg_utf8_valid_sse4 };
+    if (pg_cpu_has_avx2()) impls[impl_count++] = (impl_t){ "avx2", pg_utf8_valid_avx2 };
+#endif
+#ifdef PG_UTF8_NEON
+    impls[impl_count++] = (impl_t){ "neon", pg_utf8_valid_neon };
+#endif
+}
+
+// Scalar result must match `expect`, and every other implementation must match scalar
+static int check_all(const char *s, size_t len, int expect, char *msg, size_t msg_size) {
+    int ref = pg_utf8_valid_scalar(s, len);
+    if (expect >= 0 && ref != expect) {
+        snprintf(msg, msg_size, "scalar returned %d, expected %d (len %zu)", ref, expect, len);
+        return 0;
+    }
+    for (int i = 0; i < impl_count; i++) {
+        int got = impls[i].fn(s, len);
+        if (got != ref) {
+            snprintf(msg, msg_size, "%s returned %d, scalar %d (len %zu)", impls[i].name, got, ref, len);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static const struct {
+    const char *bytes;
+    int valid;
+} vectors[] = {
+    { "", 1 },
+    { "plain ascii", 1 },
+    { "\xC2\xA9", 1 },                  // U+00A9
+    { "\xDF\xBF", 1 },                  // U+07FF
+    { "\xE0\xA0\x80", 1 },              // U+0800
+    { "\xED\x9F\xBF", 1 },              // U+D7FF
+    { "\xEE\x80\x80", 1 },              // U+E000
+    { "\xEF\xBF\xBF", 1 },              // U+FFFF
+    { "\xF0\x90\x80\x80", 1 },          // U+10000
+    { "\xF4\x8F\xBF\xBF", 1 },          // U+10FFFF
+    { "Beyonc\xC3\xA9 \xE2\x80\x94 \xE6\x97\xA5\xE6\x9C\xAC \xF0\x9F\x8E\xB5", 1 },
+    { "\x80", 0 },                      // Lone continuation
+    { "\xBF", 0 },
+    { "\xC0\x80", 0 },                  // Overlong NUL
+    { "\xC1\xBF", 0 },                  // Overlong
+    { "\xC2", 0 },                      // Truncated
+    { "\xC2\x41", 0 },                  // Missing continuation
+    { "\xE0\x80\x80", 0 },              // Overlong 3-byte
+    { "\xE0\x9F\xBF", 0 },
+    { "\xED\xA0\x80", 0 },              // Surrogate U+D800
+    { "\xED\xBF\xBF", 0 },              // Surrogate U+DFFF
+    { "\xE2\x82", 0 },                  // Truncated
+    { "\xF0\x80\x80\x80", 0 },          // Overlong 4-byte
+    { "\xF0\x8F\xBF\xBF", 0 },
+    { "\xF4\x90\x80\x80", 0 },          // U+110000
+    { "\xF5\x80\x80\x80", 0 },
+    { "\xF8\x88\x80\x80\x80", 0 },      // 5-byte form
+    { "\xFE", 0 },
+    { "\xFF", 0 },
+    { "\xC2\xA9\xA9", 0 },              // Extra continuation
+    { "\xE2\x82\xAC\x80", 0 },
+    { "\xF0\x9F\x8E", 0 },              // Truncated 4-byte
+};
+#define NUM_VECTORS (sizeof(vectors) / sizeof(vectors[0]))
+
+// ============================================================================
+// Test 1: Known vectors
+// ============================================================================
+
+static void test_vectors(void) {
+    TEST("Known valid and invalid sequences");
+
+    char msg[160];
+    for (size_t v = 0; v < NUM_VECTORS; v++) {
+        if (!check_all(vectors[v].bytes, strlen(vectors[v].bytes), vectors[v].valid, msg, sizeof(msg))) {
+            char full[200];
+            snprintf(full, sizeof(full), "vector %zu: %s", v, msg);
+            FAIL(full);
+            return;
+        }
+    }
+    PASS();
+}
+
+// ============================================================================
+// Test 2: Every offset
+// ============================================================================
+
+static void test_offsets(void) {
+    TEST("Each sequence at every offset in a 64-byte window");
+
+    char buf[128];
+    char msg[160];
+    for (size_t v = 0; v < NUM_VECTORS; v++) {
+        size_t vlen = strlen(vectors[v].bytes);
+        if (vlen == 0) continue;
+        for (size_t total = 16; total <= 96; total += 16) {
+            for (size_t off = 0; off + vlen <= total; off++) {
+                memset(buf, 'a', total);
+                memcpy(buf + off, vectors[v].bytes, vlen);
+                if (!check_all(buf, total, vectors[v].valid, msg, sizeof(msg))) {
+                    char full[220];
+                    snprintf(full, sizeof(full), "vector %zu at %zu/%zu: %s", v, off, total, msg);
+                    FAIL(full);
+                    return;
+                }
+            }
+        }
+    }
+    PASS();
+}
+
+// ============================================================================
+// Test 3: Truncation at the end
+// ============================================================================
+
+static void test_truncated_tail(void) {
+    TEST("Multi-byte sequence cut off by the end of input");
+
+    static const char *seqs[] = { "\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x8E\xB5" };
+    char buf[128];
+    char msg[160];
+    for (size_t s = 0; s < 3; s++) {
+        size_t slen = strlen(seqs[s]);
+        for (size_t prefix = 0; prefix < 100; prefix++) {
+            memset(buf, 'z', prefix);
+            memcpy(buf + prefix, seqs[s], slen);
+            // Whole sequence valid, every proper prefix invalid
+            for (size_t cut = 1; cut <= slen; cut++) {
+                if (!check_all(buf, prefix + cut, cut == slen, msg, sizeof(msg))) {
+                    char full[220];
+                    snprintf(full, sizeof(full), "seq %zu prefix %zu cut %zu: %s", s, prefix, cut, msg);
+                    FAIL(full);
+                    return;
+                }
+            }
+        }
+    }
+    PASS();
+}
+
+// ============================================================================
+// Test 4: Random and mutated input
+// ============================================================================
+
+static unsigned int rng_state = 12345;
+
+static unsigned int rng(void) {
+    rng_state = rng_state * 1103515245u + 12345u;
+    return rng_state >> 8;
+}
+
+static size_t append_codepoint(char *out, unsigned int cp) {
+    if (cp < 0x80) { out[0] = (char)cp; return 1; }
+    if (cp < 0x800) {
+        out[0] = (char)(0xC0 | (cp >> 6));
+        out[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = (char)(0xE0 | (cp >> 12));
+        out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (cp >> 18));
+    out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+static unsigned int random_codepoint(void) {
+    switch (rng() % 4) {
+        case 0: return rng() % 0x80;
+        case 1: return 0x80 + rng() % (0x800 - 0x80);
+        case 2: {
+            unsigned int cp = 0x800 + rng() % (0x10000 - 0x800);
+            return (cp >= 0xD800 && cp <= 0xDFFF) ? 0xE9 : cp;
+        }
+        default: return 0x10000 + rng() % (0x110000 - 0x10000);
+    }
+}
+
+static void test_random(void) {
+    TEST("Random bytes and mutated valid text agree with scalar");
+
+    char buf[300];
+    char msg[160];
+    for (int iter = 0; iter < 20000; iter++) {
+        size_t len = 0;
+        size_t target = rng() % 250;
+        while (len < target) len += append_codepoint(buf + len, random_codepoint());
+
+        if (!check_all(buf, len, 1, msg, sizeof(msg))) {
+            FAIL(msg);
+            return;
+        }
+
+        // Flip one byte - may or may not stay valid, but all must agree
+        if (len > 0) {
+            char saved_buf[300];
+            memcpy(saved_buf, buf, len);
+            buf[rng() % len] = (char)(rng() & 0xFF);
+            if (!check_all(buf, len, -1, msg, sizeof(msg))) {
+                FAIL(msg);
+                return;
+            }
+            memcpy(buf, saved_buf, len);
+        }
+
+        // Pure noise
+        size_t nlen = rng() % 200;
+        for (size_t i = 0; i < nlen; i++) buf[i] = (char)(rng() & 0xFF);
+        if (!check_all(buf, nlen, -1, msg, sizeof(msg))) {
+            FAIL(msg);
+            return;
+        }
+    }
+    PASS();
+}
+
+// ============================================================================
+// Test 5: Dispatch
+// ============================================================================
+
+static void test_dispatch(void) {
+    TEST("Dispatch selects an implementation");
+
+    const char *name = pg_utf8_impl_name();
+    if (!name || !*name) {
+        FAIL("no implementation name");
+        return;
+    }
+    printf("(%s) ", name);
+
+    // Long valid text with one bad byte at the very end
+    char buf[4096];
+    memset(buf, 'x', sizeof(buf));
+    if (!pg_utf8_valid(buf, sizeof(buf))) {
+        FAIL("long ASCII rejected");
+        return;
+    }
+    buf[sizeof(buf) - 1] = (char)0xC3;
+    if (pg_utf8_valid(buf, sizeof(buf))) {
+        FAIL("truncated sequence at the end of 4KB accepted");
+        return;
+    }
+    PASS();
+}
+
+// ============================================================================
+// Main
+// ============================================================================
+
+int main(void) {
+    printf("\n\033[1m=== UTF-8 Validation Tests ===\033[0m\n\n");
+
+    collect_impls();
+
+    test_vectors();
+    test_offsets();
+    test_truncated_tail();
+    test_random();
+    test_dispatch();
+
+    printf("\n\033[1mResults: %d passed, %d failed\033[0m\n\n", tests_passed, tests_failed);
+    return tests_failed > 0 ? 1 : 0;
+}
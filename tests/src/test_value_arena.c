@@ -0,0 +1,478 @@
+/*
+ * Unit tests for the per-thread sqlite3_value arenas (pg_statement.c)
+ *
+ * Replicates pg_create_column_value / pg_stmt_release_values /
+ * pg_value_from / pg_value_live with a cut-down statement.
+ *
+ * Tests:
+ * 1. Values stay valid until the statement releases them
+ * 2. No wrap: far more live values than the old 256/4096 rings
+ * 3. Released values are reused, the ring doesn't grow
+ * 4. Generation check rejects values of an earlier step
+ * 5. Threads never share a value (concurrent creation)
+ * 6. Exited threads' chunks are adopted, live values skipped
+ * 7. Pool exhaustion returns NULL instead of wrapping
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+// Test counters
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST(name) printf("  Testing: %s... ", name)
+#define PASS() do { printf("\033[32mPASS\033[0m\n"); tests_passed++; } while(0)
+#define FAIL(msg) do { printf("\033[31mFAIL: %s\033[0m\n", msg); tests_failed++; } while(0)
+
+// ============================================================================
+// Replicate the arenas from pg_statement.c
+// ============================================================================
+
+#define PG_VALUE_MAGIC 0x50475641
+#define PG_VALUE_CHUNK 64
+#define PG_VALUE_CHUNKS 128  // Smaller pool than the shim so exhaustion is testable
+#define PG_VALUE_NO_CHUNK -1
+
+typedef struct pg_stmt pg_stmt_t;
+
+typedef struct pg_value {
+    uint32_t magic;
+    uint32_t generation;
+    _Atomic(pg_stmt_t *) stmt;
+    int col_idx;
+    int row_idx;
+    struct pg_value *next;
+} pg_value_t;
+
+struct pg_stmt {
+    int current_row;
+    pg_value_t *values;
+    unsigned int value_gen;
+};
+
+static pg_value_t pg_values[PG_VALUE_CHUNKS * PG_VALUE_CHUNK];
+static int pg_value_chunk_next[PG_VALUE_CHUNKS];
+static atomic_int pg_value_chunks_used = 0;
+static int pg_value_orphans = PG_VALUE_NO_CHUNK;
+static pthread_mutex_t pg_value_orphan_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t pg_value_key;
+static pthread_once_t pg_value_key_once = PTHREAD_ONCE_INIT;
+
+typedef struct {
+    int chunk;
+    int slot;
+    int chunks;
+} pg_value_arena_t;
+
+static __thread pg_value_arena_t value_arena = { PG_VALUE_NO_CHUNK, 0, 0 };
+
+static void pg_value_arena_orphan(void *arg) {
+    (void)arg;
+    if (value_arena.chunk == PG_VALUE_NO_CHUNK) return;
+    pthread_mutex_lock(&pg_value_orphan_mutex);
+    int first = pg_value_chunk_next[value_arena.chunk];
+    pg_value_chunk_next[value_arena.chunk] = pg_value_orphans;
+    pg_value_orphans = first;
+    pthread_mutex_unlock(&pg_value_orphan_mutex);
+    value_arena.chunk = PG_VALUE_NO_CHUNK;
+    value_arena.chunks = 0;
+}
+
+static void pg_value_key_create(void) {
+    pthread_key_create(&pg_value_key, pg_value_arena_orphan);
+}
+
+static int pg_value_arena_grow(void) {
+    int chunk = PG_VALUE_NO_CHUNK;
+
+    if (pg_value_orphans != PG_VALUE_NO_CHUNK) {
+        pthread_mutex_lock(&pg_value_orphan_mutex);
+        chunk = pg_value_orphans;
+        if (chunk != PG_VALUE_NO_CHUNK) pg_value_orphans = pg_value_chunk_next[chunk];
+        pthread_mutex_unlock(&pg_value_orphan_mutex);
+    }
+    if (chunk == PG_VALUE_NO_CHUNK) {
+        int n = atomic_fetch_add(&pg_value_chunks_used, 1);
+        if (n >= PG_VALUE_CHUNKS) {
+            atomic_fetch_sub(&pg_value_chunks_used, 1);
+            return 0;
+        }
+        chunk = n;
+        for (int i = 0; i < PG_VALUE_CHUNK; i++) {
+            pg_value_t *pv = &pg_values[chunk * PG_VALUE_CHUNK + i];
+            pv->magic = PG_VALUE_MAGIC;
+            atomic_store_explicit(&pv->stmt, NULL, memory_order_relaxed);
+        }
+    }
+
+    if (value_arena.chunk == PG_VALUE_NO_CHUNK) {
+        pthread_once(&pg_value_key_once, pg_value_key_create);
+        pthread_setspecific(pg_value_key, &value_arena);
+        pg_value_chunk_next[chunk] = chunk;
+    } else {
+        pg_value_chunk_next[chunk] = pg_value_chunk_next[value_arena.chunk];
+        pg_value_chunk_next[value_arena.chunk] = chunk;
+    }
+    value_arena.chunk = chunk;
+    value_arena.slot = 0;
+    value_arena.chunks++;
+    return 1;
+}
+
+static pg_value_t* pg_value_arena_take(void) {
+    if (value_arena.chunk != PG_VALUE_NO_CHUNK) {
+        int scanned = 0;
+        int total = value_arena.chunks * PG_VALUE_CHUNK;
+        while (scanned < total) {
+            pg_value_t *pv = &pg_values[value_arena.chunk * PG_VALUE_CHUNK + value_arena.slot];
+            scanned++;
+            if (++value_arena.slot == PG_VALUE_CHUNK) {
+                value_arena.slot = 0;
+                value_arena.chunk = pg_value_chunk_next[value_arena.chunk];
+            }
+            if (!atomic_load_explicit(&pv->stmt, memory_order_acquire)) return pv;
+        }
+    }
+    // Fresh chunks are all free; adopted ones may still hold live values
+    while (pg_value_arena_grow()) {
+        int chunk = value_arena.chunk;
+        for (int i = 0; i < PG_VALUE_CHUNK; i++) {
+            pg_value_t *pv = &pg_values[chunk * PG_VALUE_CHUNK + i];
+            if (atomic_load_explicit(&pv->stmt, memory_order_acquire)) continue;
+            value_arena.slot = i + 1;
+            if (value_arena.slot == PG_VALUE_CHUNK) {
+                value_arena.slot = 0;
+                value_arena.chunk = pg_value_chunk_next[chunk];
+            }
+            return pv;
+        }
+    }
+    return NULL;
+}
+
+static pg_value_t* create_value(pg_stmt_t *stmt, int col_idx) {
+    pg_value_t *pv = pg_value_arena_take();
+    if (!pv) return NULL;
+    pv->generation = stmt->value_gen;
+    pv->col_idx = col_idx;
+    pv->row_idx = stmt->current_row;
+    pv->next = stmt->values;
+    stmt->values = pv;
+    atomic_store_explicit(&pv->stmt, stmt, memory_order_release);
+    return pv;
+}
+
+static void release_values(pg_stmt_t *stmt) {
+    pg_value_t *pv = stmt->values;
+    while (pv) {
+        pg_value_t *next = pv->next;
+        pv->next = NULL;
+        atomic_store_explicit(&pv->stmt, NULL, memory_order_release);
+        pv = next;
+    }
+    stmt->values = NULL;
+    stmt->value_gen++;
+}
+
+static pg_value_t* value_from(void *val) {
+    uintptr_t p = (uintptr_t)val;
+    if (p < (uintptr_t)&pg_values[0] ||
+        p >= (uintptr_t)&pg_values[PG_VALUE_CHUNKS * PG_VALUE_CHUNK]) return NULL;
+    pg_value_t *pv = (pg_value_t*)val;
+    return pv->magic == PG_VALUE_MAGIC ? pv : NULL;
+}
+
+static int value_live(const pg_value_t *pv, const pg_stmt_t *stmt) {
+    return atomic_load_explicit(&pv->stmt, memory_order_relaxed) == stmt &&
+           pv->generation == stmt->value_gen;
+}
+
+static int chunks_used(void) {
+    return atomic_load(&pg_value_chunks_used);
+}
+
+// ============================================================================
+// Test 1: Validity until release
+// ============================================================================
+
+static void test_valid_until_release(void) {
+    TEST("Values valid until the statement releases them");
+
+    pg_stmt_t stmt = { .current_row = 3 };
+    pg_value_t *vals[10];
+    for (int i = 0; i < 10; i++) vals[i] = create_value(&stmt, i);
+
+    for (int i = 0; i < 10; i++) {
+        if (value_from(vals[i]) != vals[i] || !value_live(vals[i], &stmt) ||
+            vals[i]->col_idx != i || vals[i]->row_idx != 3) {
+            FAIL("value not live/correct before release");
+            return;
+        }
+    }
+
+    release_values(&stmt);
+    for (int i = 0; i < 10; i++) {
+        if (value_from(vals[i]) != vals[i]) {
+            FAIL("released value no longer recognised as ours");
+            return;
+        }
+        if (value_live(vals[i], &stmt)) {
+            FAIL("value still live after release");
+            return;
+        }
+    }
+
+    int not_ours = 0;
+    if (value_from(&not_ours) != NULL) {
+        FAIL("foreign pointer accepted");
+        return;
+    }
+    PASS();
+}
+
+// ============================================================================
+// Test 2: No wrap
+// ============================================================================
+
+static void *no_wrap_thread(void *arg) {
+    (void)arg;
+    // 5000 live values on one statement - the old 4096 ring would have wrapped
+    static pg_stmt_t stmt;
+    long bad = 0;
+    pg_value_t **vals = malloc(5000 * sizeof(*vals));
+    for (int i = 0; i < 5000 && i < (PG_VALUE_CHUNKS - 4) * PG_VALUE_CHUNK; i++) {
+        vals[i] = create_value(&stmt, i);
+    }
+    int n = (PG_VALUE_CHUNKS - 4) * PG_VALUE_CHUNK < 5000 ? (PG_VALUE_CHUNKS - 4) * PG_VALUE_CHUNK : 5000;
+    for (int i = 0; i < n; i++) {
+        if (!vals[i] || !value_live(vals[i], &stmt) || vals[i]->col_idx != i) bad++;
+    }
+    release_values(&stmt);
+    free(vals);
+    return (void *)bad;
+}
+
+static void test_no_wrap(void) {
+    TEST("No wrap with thousands of live values");
+
+    // Separate thread so its chunks are orphaned (and reusable) afterwards
+    pthread_t t;
+    void *bad;
+    pthread_create(&t, NULL, no_wrap_thread, NULL);
+    pthread_join(t, &bad);
+    if ((long)bad != 0) {
+        char msg[64];
+        snprintf(msg, sizeof(msg), "%ld values overwritten while live", (long)bad);
+        FAIL(msg);
+        return;
+    }
+    PASS();
+}
+
+// ============================================================================
+// Test 3: Reuse after release
+// ============================================================================
+
+static void test_reuse(void) {
+    TEST("Released values reused without growing the ring");
+
+    pg_stmt_t stmt = { 0 };
+    create_value(&stmt, 0);  // Make sure this thread has a ring
+    release_values(&stmt);
+    int chunks_before = value_arena.chunks;
+
+    for (int step = 0; step < 10000; step++) {
+        for (int c = 0; c < 30; c++) create_value(&stmt, c);
+        release_values(&stmt);
+    }
+
+    if (value_arena.chunks != chunks_before) {
+        FAIL("ring grew although every value was released");
+        return;
+    }
+    PASS();
+}
+
+// ============================================================================
+// Test 4: Generation
+// ============================================================================
+
+static void test_generation(void) {
+    TEST("Generation mismatch is rejected");
+
+    pg_stmt_t stmt = { 0 };
+    pg_value_t *v = create_value(&stmt, 1);
+    if (!value_live(v, &stmt)) {
+        FAIL("fresh value not live");
+        return;
+    }
+    // A step that bumps the generation without walking the list
+    stmt.value_gen++;
+    if (value_live(v, &stmt)) {
+        FAIL("value of an earlier generation accepted");
+        return;
+    }
+    stmt.value_gen--;
+    release_values(&stmt);
+    PASS();
+}
+
+// ============================================================================
+// Test 5: Threads never share a value
+// ============================================================================
+
+#define SHARE_THREADS 4
+
+static void *share_thread(void *arg) {
+    pg_stmt_t *stmt = arg;
+    long bad = 0;
+    for (int step = 0; step < 20000; step++) {
+        pg_value_t *v[8];
+        for (int c = 0; c < 8; c++) v[c] = create_value(stmt, c);
+        for (int c = 0; c < 8; c++) {
+            if (!v[c] || atomic_load(&v[c]->stmt) != stmt || v[c]->col_idx != c) bad++;
+        }
+        release_values(stmt);
+    }
+    return (void *)bad;
+}
+
+static void test_threads_disjoint(void) {
+    TEST("Concurrent threads never hand out the same value");
+
+    pthread_t threads[SHARE_THREADS];
+    pg_stmt_t stmts[SHARE_THREADS];
+    memset(stmts, 0, sizeof(stmts));
+    for (int i = 0; i < SHARE_THREADS; i++) {
+        pthread_create(&threads[i], NULL, share_thread, &stmts[i]);
+    }
+    long bad = 0;
+    for (int i = 0; i < SHARE_THREADS; i++) {
+        void *r;
+        pthread_join(threads[i], &r);
+        bad += (long)r;
+    }
+    if (bad) {
+        char msg[64];
+        snprintf(msg, sizeof(msg), "%ld values clobbered by another thread", bad);
+        FAIL(msg);
+        return;
+    }
+    PASS();
+}
+
+// ============================================================================
+// Test 6: Orphan adoption
+// ============================================================================
+
+static pg_stmt_t orphan_stmt;
+static pg_value_t *orphan_live;
+
+static void *orphan_maker(void *arg) {
+    (void)arg;
+    orphan_live = create_value(&orphan_stmt, 7);  // Outlives this thread
+    return NULL;
+}
+
+static void *orphan_adopter(void *arg) {
+    (void)arg;
+    pg_stmt_t stmt = { 0 };
+    long bad = 0;
+    for (int i = 0; i < 4 * PG_VALUE_CHUNK; i++) {
+        if (create_value(&stmt, i) == orphan_live) bad++;
+    }
+    release_values(&stmt);
+    return (void *)bad;
+}
+
+static void test_orphans(void) {
+    TEST("Exited threads' chunks adopted, live values skipped");
+
+    pthread_t t;
+    pthread_create(&t, NULL, orphan_maker, NULL);
+    pthread_join(t, NULL);
+
+    int before = chunks_used();
+    void *bad;
+    pthread_create(&t, NULL, orphan_adopter, NULL);
+    pthread_join(t, &bad);
+
+    if ((long)bad != 0) {
+        FAIL("live value handed out again");
+        return;
+    }
+    if (chunks_used() != before) {
+        FAIL("new chunks carved although orphans were available");
+        return;
+    }
+    if (!value_live(orphan_live, &orphan_stmt) || orphan_live->col_idx != 7) {
+        FAIL("orphaned live value clobbered");
+        return;
+    }
+    release_values(&orphan_stmt);
+    PASS();
+}
+
+// ============================================================================
+// Test 7: Exhaustion
+// ============================================================================
+
+static void *exhaust_thread(void *arg) {
+    (void)arg;
+    static pg_stmt_t stmt;
+    long got = 0;
+    for (int i = 0; i < (PG_VALUE_CHUNKS + 1) * PG_VALUE_CHUNK; i++) {
+        if (!create_value(&stmt, i)) break;
+        got++;
+    }
+    // Every value handed out is still intact
+    long bad = 0;
+    for (pg_value_t *v = stmt.values; v; v = v->next) {
+        if (!value_live(v, &stmt)) bad++;
+    }
+    release_values(&stmt);
+    return (void *)(bad ? -1 : got);
+}
+
+static void test_exhaustion(void) {
+    TEST("Pool exhaustion returns NULL instead of wrapping");
+
+    pthread_t t;
+    void *r;
+    pthread_create(&t, NULL, exhaust_thread, NULL);
+    pthread_join(t, &r);
+    long got = (long)r;
+    if (got < 0) {
+        FAIL("values overwritten near exhaustion");
+        return;
+    }
+    if (got >= (long)(PG_VALUE_CHUNKS + 1) * PG_VALUE_CHUNK || got > (long)PG_VALUE_CHUNKS * PG_VALUE_CHUNK) {
+        FAIL("more values than the pool holds");
+        return;
+    }
+    PASS();
+}
+
+// ============================================================================
+// Main
+// ============================================================================
+
+int main(void) {
+    printf("\n\033[1m=== sqlite3_value Arena Tests ===\033[0m\n\n");
+
+    test_valid_until_release();
+    test_no_wrap();
+    test_reuse();
+    test_generation();
+    test_threads_disjoint();
+    test_orphans();
+    test_exhaustion();
+
+    printf("\n\033[1mResults: %d passed, %d failed\033[0m\n\n", tests_passed, tests_failed);
+    return tests_failed > 0 ? 1 : 0;
+}